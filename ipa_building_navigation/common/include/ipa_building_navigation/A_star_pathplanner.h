@@ -4,7 +4,7 @@
 // FB - 201012256
 #include <iostream>
 #include <iomanip>
-#include <queue>
+#include <vector>
 #include <string>
 #include <math.h>
 #include <ctime>
@@ -14,14 +14,24 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
-#include <ipa_building_navigation/node.h>
+#include <boost/shared_ptr.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
 //This class provides an AStar pathplanner, which calculates the pathlength from one cv::Point to another. It was taken from
 // http://code.activestate.com/recipes/577457-a-star-shortest-path-algorithm/ and slightly changed (to use it with openCV).
-//It needs node.h to work, which gives an implementation of nodes of the graph.
+//The search buffers (costs, parent directions, open list) are allocated once and reused by all following queries. Instead of
+//resetting them before each search, every cell carries the number of the search that touched it last (generation stamp), so
+//a query only costs the cells it actually visits. The open list is an indexed binary heap, which allows to decrease the
+//priority of a cell in place. The planner keeps no static state, so it is safe to use one instance per thread (an instance
+//itself must not be shared between threads).
+//Instead of A*, path queries can use Jump Point Search (Harabor and Grastien 2011), which finds routes of the same length on
+//the uniform cost grid but only opens the cells where the route may change its direction (jump points), so open areas and
+//corridors are crossed with very few expansions. The found routes can be shortened by line-of-sight checks to a list of
+//waypoints (any-angle post-processing in the style of Theta*).
+//Long path queries on a downsampled map can optionally be answered by a HierarchicalPathPlanner (see setHierarchicalPlanning),
+//which searches an abstract graph of the map instead of the whole grid and finds slightly longer paths.
 //
 //!!!!!!!!!Important!!!!!!!!!!!!!
 //It downsamples the map mith the given factor (0 < factor < 1) so the map gets reduced and calculationtime gets better.
@@ -30,22 +40,134 @@
 //amount of erosions to include the radius in the planning.
 //
 
+class HierarchicalPathPlanner;
+
 class AStarPlanner
 {
+public:
+	// strategy to expand the cells in path queries (planPath)
+	enum SearchStrategy
+	{
+		A_STAR_SEARCH = 0,
+		JUMP_POINT_SEARCH = 1
+	};
+
 protected:
-	int n;
-	int m;
+	// element of the open list, the cell is stored as index row*cols+col
+	struct HeapNode
+	{
+		int priority;
+		int cell;
+	};
+
+	cv::Mat map_;		// map of the current query (shallow copy), cells with value 255 are accessible
+	int rows_;
+	int cols_;
+
+	// search buffers, the entries of a cell are only valid if generation_[cell] == current_generation_
+	std::vector<unsigned int> generation_;		// number of the search that has touched the cell last
+	std::vector<int> cost_;					// cost from the start cell (10 for a straight step, 14 for a diagonal step)
+	std::vector<unsigned char> closed_;		// 1 if the cell has already been expanded
+	std::vector<unsigned char> parent_direction_;	// direction from the cell to its parent
+	std::vector<int> parent_steps_;				// number of steps from a jump point to its parent (Jump Point Search)
+	std::vector<int> heap_position_;			// position of the cell in heap_ while it is open
+	std::vector<HeapNode> heap_;				// open list as binary min heap
+	unsigned int current_generation_;
+
+	std::vector<cv::Point> route_;		// cells of the last found route, including the start and the end cell
+
+	SearchStrategy search_strategy_;
+
+	// hierarchical planning of long queries (see setHierarchicalPlanning), the abstract graph is built for the downsampled map
+	// of the last downsampleMap call at the first query that uses it
+	bool use_hierarchical_planner_;
+	double hierarchical_planner_min_distance_;		// [pixel of the original map]
+	int hierarchical_planner_cluster_size_;
+	boost::shared_ptr<HierarchicalPathPlanner> hierarchical_planner_;
+	bool hierarchical_planner_has_map_;			// true if hierarchical_planner_ holds the graph of hierarchical_planner_map_
+	cv::Mat hierarchical_planner_map_;			// downsampled map of the last downsampleMap call (shares its data with the cache)
+	unsigned long long hierarchical_planner_map_hash_;
+	double hierarchical_planner_downsampling_factor_;
+	double hierarchical_planner_robot_radius_;
+	double hierarchical_planner_map_resolution_;
+
+	// answers the query with the hierarchical planner if it is enabled, downsampled_map is the map of the last downsampleMap
+	// call and the points are at least hierarchical_planner_min_distance_ apart, returns false if the query is not answered
+	bool planHierarchicalPath(const cv::Mat& downsampled_map, const cv::Point& start_point, const cv::Point& end_point,
+			const double downsampling_factor, double& path_length);
+
+	// sets the map for the following searches, the buffers only grow if the map is larger than all maps before
+	void setMap(const cv::Mat& map);
+
+	// starts a new search by invalidating all buffer entries
+	void startSearch();
+
+	// puts the start cell into the open list of a new search
+	void startAtCell(const cv::Point& start, const int priority);
+
+	// moves to all accessible neighbors of cell and opens them or updates their costs, the priority of a neighbor is its cost
+	// plus the estimated costs to goal if use_estimate is true (A*) or only its cost (Dijkstra)
+	void expandCell(const int cell, const cv::Point& goal, const bool use_estimate);
+
+	// A* search from start to goal on map_, returns true if a route was found and stores it in route_
+	bool pathFind(const cv::Point& start, const cv::Point& goal);
 
-	std::string route_;
+	// returns true if the cell is inside map_ and accessible
+	inline bool isAccessible(const int x, const int y) const
+	{
+		return (x >= 0 && x < cols_ && y >= 0 && y < rows_ && map_.ptr<unsigned char>(y)[x] == 255);
+	}
 
-	std::string pathFind(const int& xStart, const int& yStart, const int& xFinish, const int& yFinish, const cv::Mat& map);
+	// moves from (x, y) in the given direction until a jump point is reached (the goal, a cell with a forced neighbor or for
+	// diagonal moves a cell from which a straight move reaches a jump point), returns the jump point as index row*cols+col
+	// or -1 if an obstacle is hit first, steps receives the number of steps to the jump point
+	int jump(int x, int y, const int direction, const int goal_cell, int& steps) const;
+
+	// opens the jump points that are reached from the natural and forced neighbors of cell (all neighbors for the start cell)
+	void expandJumpPoints(const int cell, const int goal_cell, const cv::Point& goal);
+
+	// Jump Point Search from start to goal on map_, returns true if a route was found and stores it in route_
+	bool pathFindJumpPoints(const cv::Point& start, const cv::Point& goal);
+
+	// stores the route from the start cell of the last Jump Point Search to the given (closed) jump point in route_
+	void reconstructJumpPointRoute(const int cell);
+
+	// Dijkstra search from start on map_ that stops as soon as all target cells (given as index row*cols+col) are closed,
+	// afterwards every closed cell holds its shortest route to start
+	void pathFindToTargets(const cv::Point& start, std::vector<int> target_cells);
+
+	// length of a route (sequence of cells) with the given length of a straight step
+	double getRouteLength(const std::vector<cv::Point>& route, const double step_length);
+
+	// stores the route from the start cell of the last search to the given (closed) cell in route_
+	void reconstructRoute(const int cell);
+
+	// open list operations
+	void pushHeap(const int cell, const int priority);
+	int popHeap();
+	void decreaseKey(const int cell, const int priority);
+	void siftUp(int position);
+	void siftDown(int position);
 
 public:
 	AStarPlanner();
 
-	void drawRoute(cv::Mat& map, const cv::Point start_point, const std::string& route, double step_length);
+	// sets the strategy for the following path queries, A_STAR_SEARCH is the default
+	void setSearchStrategy(const SearchStrategy search_strategy);
 
-	void getRoute(const cv::Point start_point, const std::string& route, double step_length, std::vector<cv::Point>& route_points);
+	// enables the hierarchical planning (HPA*, see HierarchicalPathPlanner) of the queries of planPath with a downsampled map
+	// whose start and end point are at least min_distance [pixel of the original map] apart, these queries then search the
+	// abstract graph of the downsampled map instead of the whole map, which is much faster for long queries but finds a few
+	// percent longer paths, it is only used for the downsampled map of the last downsampleMap call and if neither a route nor
+	// a drawing of the path is requested, the abstract graph is shared by all planners of the process (cluster_size is the
+	// side length of its clusters in cells of the downsampled map), disabled by default
+	void setHierarchicalPlanning(const bool use_hierarchical_planner, const double min_distance, const int cluster_size=16);
+
+	// draws the route (sequence of cells, see route_) with the given step length between two cells into map, beginning at start_point
+	void drawRoute(cv::Mat& map, const cv::Point start_point, const std::vector<cv::Point>& route, double step_length);
+
+	// converts the route (sequence of cells, see route_) into points with the given step length between two cells, beginning at start_point
+	void getRoute(const cv::Point start_point, const std::vector<cv::Point>& route, double step_length, std::vector<cv::Point>& route_points);
 
 	// computes the path length between start point and end point
 	double planPath(const cv::Mat& map, const cv::Point& start_point, const cv::Point& end_point,
@@ -53,10 +175,42 @@ public:
 			const int end_point_valid_neighborhood_radius=0, std::vector<cv::Point>* route=NULL);
 
 	// computes the path length between start point and end point, tries first with a downsampled map for fast computation and uses the original map if the first try was not successful
+	// long queries may be answered by the hierarchical planner (see setHierarchicalPlanning)
 	// if end_point_valid_neighborhood_radius [measured in cell size of downsampled_map] is set greater than 0, then it is sufficient to find a path to a cell within that neighborhood radius to end_point for a success
 	double planPath(const cv::Mat& map, const cv::Mat& downsampled_map, const cv::Point& start_point, const cv::Point& end_point, const double downsampling_factor,
 			const double robot_radius, const double map_resolution, const int end_point_valid_neighborhood_radius=0, cv::Mat* draw_path_map=NULL,
 			std::vector<cv::Point>* route=NULL);
 
+	// computes a path like planPath with a downsampled map, shortens it with smoothRoute and returns the length of the shortened
+	// path (1e100 if no path exists), waypoints receives its corners in coordinates of the original map, beginning with
+	// start_point and ending with end_point
+	double planSmoothedPath(const cv::Mat& map, const cv::Mat& downsampled_map, const cv::Point& start_point, const cv::Point& end_point,
+			const double downsampling_factor, const double map_resolution, std::vector<cv::Point>& waypoints);
+
+	// shortens a route (sequence of cells of map) by line-of-sight checks: a cell of the route is only kept as waypoint if the
+	// line from the previous waypoint to the next cell crosses an inaccessible cell (value != 255) of map
+	static void smoothRoute(const cv::Mat& map, const std::vector<cv::Point>& route, std::vector<cv::Point>& waypoints);
+
+	// computes the path lengths from start_point to all target_points with one search on downsampled_map (map downsampled with
+	// downsampling_factor, see downsampleMap), the search stops as soon as every target is reached, unreachable targets get 1e100
+	// the points and lengths are in the coordinates of the original map like for planPath with downsampled_map, if routes is
+	// provided it receives the route to each target in cells of downsampled_map
+	void planPathsToTargets(const cv::Mat& downsampled_map, const cv::Point& start_point, const std::vector<cv::Point>& target_points,
+			const double downsampling_factor, std::vector<double>& path_lengths, std::vector<std::vector<cv::Point> >* routes=NULL);
+
+	// computes the path lengths from start_point to the cells of downsampled_map with one Dijkstra search (wavefront), the
+	// points and lengths are in the coordinates of the original map like for planPathsToTargets, distance_field receives a
+	// CV_64F image of the size of downsampled_map with the length of the shortest route to each cell, unreached cells get 1e100
+	// if area (in cells of downsampled_map) is not empty, the search stops as soon as every accessible cell in it is reached
+	void computeDistanceField(const cv::Mat& downsampled_map, const cv::Point& start_point, const double downsampling_factor,
+			cv::Mat& distance_field, const cv::Rect& area=cv::Rect());
+
+	// erodes the map by the robot radius and downsamples it, the result is taken from the MapPreprocessingCache and shares its
+	// data with the cache (do not write into downsampled_map)
 	void downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution);
+
+	// same as above with the already computed hash of map (MapPreprocessingCache::computeMapHash), saves hashing the map again
+	// if it is downsampled several times
+	void downsampleMap(const unsigned long long map_hash, const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor,
+			const double robot_radius, const double map_resolution);
 };
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+
+//Token to stop one or more running TSP solvers from another thread, e.g. when the goal of an action is preempted. A cancelled
+//solver returns the best tour it has found so far.
+class TSPCancellationToken
+{
+public:
+	TSPCancellationToken();
+
+	//requests all solvers that use this token to stop
+	void cancel();
+
+	//allows the token to be used for the next computation
+	void reset();
+
+	bool isCancelled() const;
+
+protected:
+	bool cancelled_;
+	mutable boost::mutex mutex_;
+};
+typedef boost::shared_ptr<TSPCancellationToken> TSPCancellationTokenPtr;
+
+//Common interface of the TSP solvers, which allows to trade the quality of the tour for computation time:
+//		1. A solver stops when its own stopping rule is met, when the maximum computation time or the deadline is exceeded or
+//		   when its cancellation token is cancelled. In the latter three cases the best tour found so far is returned.
+//		2. Every improvement of the best tour is reported to the improvement callback (from the thread that runs the solver),
+//		   so a caller can publish intermediate results.
+//		3. abortComputation() stops the solver immediately, then an empty tour is returned.
+//The deadline and the maximum computation time may be combined, the earlier one is applied.
+class AnytimeTSPSolver
+{
+public:
+	typedef boost::chrono::steady_clock Clock;
+
+	//called with the new best tour (beginning at the start node) and its length including the way back to the start node
+	typedef boost::function<void (const std::vector<int>& tour, const double tour_length)> ImprovementCallback;
+
+	AnytimeTSPSolver();
+
+	virtual ~AnytimeTSPSolver();
+
+	//solves the TSP of the given distance matrix (see the solvers for its format), the tour begins at start_node
+	virtual std::vector<int> solveTSP(const cv::Mat& path_length_matrix, const int start_node) = 0;
+
+	//stops the computation, the solver returns an empty tour
+	void abortComputation();
+
+	//sets the maximum computation time of each solveTSP call in [s], 0 = unlimited (default)
+	void setMaximumComputationTime(const double max_computation_time);
+
+	//sets a point in time at which the computation stops, e.g. the time when the result of a request is needed
+	void setDeadline(const Clock::time_point& deadline);
+
+	//removes the deadline
+	void clearDeadline();
+
+	//sets the token to cancel the computation from another thread, an empty pointer removes the token
+	void setCancellationToken(const TSPCancellationTokenPtr& cancellation_token);
+
+	//sets the function that is called with every improvement of the best tour, an empty function removes the callback
+	void setImprovementCallback(const ImprovementCallback& improvement_callback);
+
+protected:
+
+	//has to be called by the solvers when they begin a new computation, starts the clock of the maximum computation time
+	void startComputation();
+
+	//returns true if the solver should stop and return its best tour, i.e. if the computation was aborted or cancelled or if
+	//the time is up
+	bool isStopRequested() const;
+
+	//passes a new best tour to the improvement callback
+	void reportImprovement(const std::vector<int>& tour, const double tour_length);
+
+	//length of the tour including the way from its last node back to its first node
+	static double getClosedTourLength(const cv::Mat& path_length_matrix, const std::vector<int>& tour);
+
+	bool abort_computation_;
+	double max_computation_time_;	// maximum computation time of each solveTSP call in [s], 0 = unlimited
+
+	bool use_deadline_;
+	Clock::time_point deadline_;
+
+	bool use_computation_deadline_;	// earlier one of deadline_ and the maximum computation time of the current computation
+	Clock::time_point computation_deadline_;
+
+	TSPCancellationTokenPtr cancellation_token_;
+	ImprovementCallback improvement_callback_;
+};
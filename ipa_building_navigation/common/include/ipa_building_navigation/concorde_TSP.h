@@ -17,6 +17,7 @@
 
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/anytime_tsp_solver.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -26,9 +27,11 @@
 //A short explanation on how to build the solver is given at:
 //		http://www.math.uwaterloo.ca/tsp/concorde/DOC/README.html
 //If you have build the solver navigate to the./TSP folder and type " ./concorde -h " to see how to use this solver. This class
-//uses the concorde solver by using a systemcall.
-//Make sure you have a "/common/files/TSP_order.txt" and a "/common/files/TSPlib_file.txt" file. These files are used to tell
-//concorde the current problem and save the output of it.
+//runs the concorde binary of the libconcorde_tsp_solver package as child process (without a shell). The problem is given to
+//concorde as TSPlib file and its result is read from the order file, both files are located in a temporary directory that is
+//created for each call, so several solvers may run in parallel.
+//Concorde does not report intermediate tours, so a Lin-Kernighan tour (without kicks) is computed and reported first. If
+//the computation is stopped (see AnytimeTSPSolver) concorde is killed and this tour is returned.
 //
 //It needs a symmetrical matrix of pathlenghts between the nodes and the starting-point index in this matrix.
 //If the path from one node to another doesn't exist or the path is from one node to itself, the entry in the matrix must
@@ -42,7 +45,7 @@
 //		| 1.2 9.0  88.0 0.0  0.0 |
 //		---					   ---
 
-class ConcordeTSPSolver
+class ConcordeTSPSolver : public AnytimeTSPSolver
 {
 protected:
 
@@ -59,14 +62,21 @@ protected:
 			const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
 			double robot_radius, double map_resolution, AStarPlanner& path_planner);
 
-	bool abort_computation_;
-	std::string unique_file_identifier_;
+	//Function to run a program without a shell, see concorde_TSP.cpp, time_limit = 0 means unlimited.
+	int executeProcess(const std::vector<std::string>& arguments, const std::string& working_directory, std::string& output, const double time_limit);
+
+	//Function to find the concorde binary.
+	std::string getConcordeBinary();
+
+	//Function to remove the temporary directory of one call.
+	void removeDirectory(const std::string& directory);
 
 public:
 	//Constructor
 	ConcordeTSPSolver();
 
-	void abortComputation();
+	//solves the TSP with the given distance matrix, see AnytimeTSPSolver
+	std::vector<int> solveTSP(const cv::Mat& path_length_matrix, const int start_node);
 
 	//Functions to solve the TSP. It needs a distance matrix, that shows the pathlengths between two nodes of the problem.
 	//This matrix has to be symmetrical or else the TSPlib must be changed. The int shows the index in the Matrix.
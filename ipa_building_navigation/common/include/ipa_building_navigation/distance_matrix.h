@@ -4,7 +4,13 @@
 
 #include <vector>
 #include <opencv2/opencv.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 #include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+#include <ipa_building_navigation/stop_condition.h>
 
 #include <ipa_building_navigation/timer.h>
 
@@ -14,10 +20,232 @@ protected:
 
 	bool abort_computation_;
 
+	StopCondition stop_condition_;
+	bool stopped_;		// true if the last computation has been stopped by stop_condition_
+
+	// hands out the rows of the distance matrix to the computing threads
+	struct RowQueue
+	{
+		RowQueue() : next_row(0), known_points(NULL), stopped(false) {}
+
+		int next_row;
+		boost::mutex mutex;
+		const std::vector<bool>* known_points;	// if set, the distance between two known points is not computed
+		bool stopped;							// set if a row has been approximated because of the stop condition
+	};
+
+	// computes the rows of the distance matrix that are taken from next_row until all rows are done, every row i contains the
+	// distances to the points j>i, which are copied to the column i (symmetrical matrix)
+	// If known points are given, the rows of the known points are skipped and the row of every other point i contains the
+	// distances to all known points and to the unknown points j>i, so adding one point to a known set needs one search.
+	// The stop condition is checked before each search, once it is met the remaining distances are approximated by the
+	// length of the straight line (a lower bound of the path length).
+	void computeDistanceMatrixRows(cv::Mat& distance_matrix, const cv::Mat& original_map, const cv::Mat& downsampled_map,
+			const std::vector<cv::Point>& points, const double downsampling_factor, const double map_resolution,
+			std::vector<std::vector<std::vector<cv::Point> > >* paths, RowQueue& row_queue)
+	{
+		AStarPlanner path_planner;
+		while (true)
+		{
+			int i = 0;
+			{
+				boost::mutex::scoped_lock lock(row_queue.mutex);
+				i = row_queue.next_row++;
+				if (i < (int)points.size() && points.size()>500 && i%(std::max(1,(int)points.size()/100))==0)
+					std::cout << "." << std::flush;
+			}
+			if (i >= (int)points.size() || abort_computation_==true)
+				return;
+
+			distance_matrix.at<double>(i, i) = 0;
+			const std::vector<bool>* known_points = row_queue.known_points;
+			if (known_points!=NULL && known_points->at(i)==true)
+				continue;
+
+			// try first with direct connecting line (often sufficient and a significant speedup over a search)
+			std::vector<int> planned_indices;
+			std::vector<cv::Point> planned_points;
+			for (int j = (known_points!=NULL ? 0 : i+1); j < (int)points.size(); j++)
+			{
+				if (j == i || (j < i && known_points->at(j)==false))
+					continue;
+
+				cv::LineIterator it(original_map, points[i], points[j]);
+				bool direct_connection = true;
+				for (int k=0; k<it.count && direct_connection==true; k++, ++it)
+					if (**it < 250)
+						direct_connection = false;		// if a pixel in between is not accessible, direct connection is not possible
+				if (direct_connection == true)
+				{
+					// compute distance
+					const double length = cv::norm(points[i]-points[j]);
+					distance_matrix.at<double>(i, j) = length;
+					distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+					if (paths!=NULL)
+					{
+						// store path
+						cv::LineIterator it2(original_map, points[i], points[j]);
+						std::vector<cv::Point> current_path(it2.count);
+						for (int k=0; k<it2.count; k++, ++it2)
+							current_path[k] = it2.pos();
+						paths->at(i).at(j) = current_path;
+						paths->at(j).at(i) = current_path;
+					}
+				}
+				else
+				{
+					planned_indices.push_back(j);
+					planned_points.push_back(points[j]);
+				}
+			}
+			if (planned_points.size() == 0)
+				continue;
+
+			if (isStopConditionMet(stop_condition_) == true)
+			{
+				{
+					boost::mutex::scoped_lock lock(row_queue.mutex);
+					row_queue.stopped = true;
+				}
+				for (size_t k=0; k<planned_indices.size(); ++k)
+				{
+					const int j = planned_indices[k];
+					const double length = cv::norm(points[i]-points[j]);
+					distance_matrix.at<double>(i, j) = length;
+					distance_matrix.at<double>(j, i) = length;
+				}
+				continue;
+			}
+
+			// one search on the downsampled map to all remaining points
+			std::vector<double> lengths;
+			std::vector<std::vector<cv::Point> > routes;
+			path_planner.planPathsToTargets(downsampled_map, points[i], planned_points, downsampling_factor, lengths, (paths!=NULL ? &routes : NULL));
+			for (size_t k=0; k<planned_indices.size(); ++k)
+			{
+				const int j = planned_indices[k];
+				double length = lengths[k];
+				std::vector<cv::Point> current_path;
+				if (length > 1e90 && isStopConditionMet(stop_condition_) == true)
+				{
+					// no search on the original map anymore, the straight line is taken like for the skipped rows
+					boost::mutex::scoped_lock lock(row_queue.mutex);
+					row_queue.stopped = true;
+					length = cv::norm(points[i]-points[j]);
+				}
+				else if (length > 1e90)
+				{
+					// if no path can be found try with the original map
+					length = path_planner.planPath(original_map, points[i], points[j], 1., 0., map_resolution, 0, (paths!=NULL ? &current_path : NULL));
+					if (length > 1e90)
+						std::cout << "######################### No path found on the originally sized map #######################" << std::endl;
+				}
+				else if (paths!=NULL)
+				{
+					// remap path points to original map size
+					current_path = routes[k];
+					for(std::vector<cv::Point>::iterator point=current_path.begin(); point!=current_path.end(); ++point)
+					{
+						point->x = point->x/downsampling_factor;
+						point->y = point->y/downsampling_factor;
+					}
+				}
+				distance_matrix.at<double>(i, j) = length;
+				distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+				if (paths!=NULL)
+				{
+					paths->at(i).at(j) = current_path;
+					paths->at(j).at(i) = current_path;
+				}
+			}
+		}
+	}
+
+	// computes all entries of distance_matrix (which has to have the right size already) that are not between two known points
+	// map_hash = MapPreprocessingCache::computeMapHash(original_map)
+	void computeDistanceMatrix(cv::Mat& distance_matrix, const unsigned long long map_hash, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
+			const std::vector<bool>* known_points, std::vector<std::vector<std::vector<cv::Point> > >* paths)
+	{
+		// hack: speed up trick
+		if (points.size()>500)
+			downsampling_factor *= 0.5;
+
+		// reduce image size already here to avoid resizing in the planner each time
+		cv::Mat downsampled_map;
+		path_planner.downsampleMap(map_hash, original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+
+		if (points.size()>500)
+			std::cout << "0         10        20        30        40        50        60        70        80        90        100" << std::endl;
+
+		// compute the rows in parallel, the threads take the next row to compute from row_queue
+		RowQueue row_queue;
+		row_queue.known_points = known_points;
+		const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)points.size()));
+		boost::thread_group threads;
+		for (int t=0; t<number_of_threads; ++t)
+			threads.create_thread(boost::bind(&DistanceMatrix::computeDistanceMatrixRows, this, boost::ref(distance_matrix), boost::cref(original_map),
+					boost::cref(downsampled_map), boost::cref(points), downsampling_factor, map_resolution, paths, boost::ref(row_queue)));
+		threads.join_all();
+		stopped_ = row_queue.stopped;
+	}
+
+	// returns the representative of the set of node in a union-find forest and shortens the path to it (path halving)
+	static int findSetRepresentative(std::vector<int>& parent, int node)
+	{
+		while (parent[node] != node)
+		{
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+		return node;
+	}
+
+	// removes the point with most infinite distances to the other points from entries until there are no infinite distances
+	// between the remaining points (the highest index of equal points first), the numbers of infinite distances are updated
+	// with each removal instead of being counted again
+	static void removeInfiniteDistances(const cv::Mat& distance_matrix, std::vector<int>& entries, const double max_length)
+	{
+		std::vector<int> infinite_length_entries(entries.size(), 0);
+		int number_infinite_entries = 0;
+		for (size_t a=0; a<entries.size(); ++a)
+			for (size_t b=0; b<entries.size(); ++b)
+				if (distance_matrix.at<double>(entries[a], entries[b]) > max_length)
+					infinite_length_entries[a]++;
+		for (size_t a=0; a<entries.size(); ++a)
+			number_infinite_entries += infinite_length_entries[a];
+		if (number_infinite_entries == 0)
+			return;
+
+		std::vector<bool> removed(entries.size(), false);
+		while (number_infinite_entries > 0)
+		{
+			int mark = -1;
+			for (int a=0; a<(int)entries.size(); ++a)
+				if (removed[a] == false && (mark < 0 || infinite_length_entries[a] >= infinite_length_entries[mark]))
+					mark = a;
+			removed[mark] = true;
+			number_infinite_entries -= infinite_length_entries[mark];
+			for (size_t a=0; a<entries.size(); ++a)
+			{
+				if (removed[a] == false && distance_matrix.at<double>(entries[a], entries[mark]) > max_length)
+				{
+					infinite_length_entries[a]--;
+					number_infinite_entries--;
+				}
+			}
+		}
+		std::vector<int> remaining_entries;
+		for (size_t a=0; a<entries.size(); ++a)
+			if (removed[a] == false)
+				remaining_entries.push_back(entries[a]);
+		entries.swap(remaining_entries);
+	}
+
 public:
 
 	DistanceMatrix()
-	: abort_computation_(false)
+	: abort_computation_(false), stopped_(false)
 	{
 	}
 
@@ -26,14 +254,39 @@ public:
 		abort_computation_ = true;
 	}
 
+	//sets the condition that stops the computation of a matrix early (see StopCondition), the distances that have not been
+	//computed until then are approximated by the straight line distance, an empty function removes the condition
+	void setStopCondition(const StopCondition& stop_condition)
+	{
+		stop_condition_ = stop_condition;
+	}
+
+	//returns true if the last computed matrix contains approximated distances because the stop condition was met
+	bool wasStopped() const
+	{
+		return stopped_;
+	}
+
 	//Function to construct the symmetrical distance matrix from the given points. The rows show from which node to start and
 	//the columns to which node to go. If the path between nodes doesn't exist or the node to go to is the same as the one to
 	//start from, the entry of the matrix is 0.
+	//Each row is computed with one search from its point to all later points (see AStarPlanner::planPathsToTargets), the rows
+	//are distributed over as many threads as the hardware provides. The path_planner is only used to get the downsampled map,
+	//every thread uses its own planner.
 	// REMARK:	paths is a pointer that points to a 3D vector that has dimensionality NxN in the outer vectors to store
 	//			the paths in a matrix manner
 	void constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
 			double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
 			std::vector<std::vector<std::vector<cv::Point> > >* paths=NULL)
+	{
+		constructDistanceMatrix(distance_matrix, MapPreprocessingCache::computeMapHash(original_map), original_map, points, downsampling_factor,
+				robot_radius, map_resolution, path_planner, paths);
+	}
+
+	//same as above with the already computed hash of original_map (MapPreprocessingCache::computeMapHash)
+	void constructDistanceMatrix(cv::Mat& distance_matrix, const unsigned long long map_hash, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
+			std::vector<std::vector<std::vector<cv::Point> > >* paths=NULL)
 	{
 		std::cout << "DistanceMatrix::constructDistanceMatrix: Constructing distance matrix..." << std::endl;
 		Timer tim;
@@ -41,197 +294,124 @@ public:
 		//create the distance matrix with the right size
 		distance_matrix.create((int)points.size(), (int)points.size(), CV_64F);
 
-		// hack: speed up trick
-		if (points.size()>500)
-			downsampling_factor *= 0.5;
+		computeDistanceMatrix(distance_matrix, map_hash, original_map, points, downsampling_factor, robot_radius, map_resolution, path_planner, NULL, paths);
 
-		// reduce image size already here to avoid resizing in the planner each time
-		const double one_by_downsampling_factor = 1./downsampling_factor;
-		cv::Mat downsampled_map;
-		path_planner.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+		std::cout << "\nDistance matrix created in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;// "\nDistance matrix:\n" << distance_matrix << std::endl;
+	}
 
-		if (points.size()>500)
-			std::cout << "0         10        20        30        40        50        60        70        80        90        100" << std::endl;
-//		int a=0, b=0;
-		for (int i = 0; i < points.size(); i++)
-		{
-			//std::cout << "  a=" << a << "   b=" << b << std::endl;
-			if (points.size()>500 && i%(std::max(1,(int)points.size()/100))==0)
-				std::cout << "." << std::flush;
-			//cv::Point current_center = downsampling_factor * points[i];
-			for (int j = 0; j < points.size(); j++)
-			{
-				if (j != i)
-				{
-					if (j > i) //only compute upper right triangle of matrix, rest is symmetrically added
-					{
-						if (abort_computation_==true)
-							return;
-
-						// try first with direct connecting line (often sufficient and a significant speedup over A*)
-						cv::LineIterator it(original_map, points[i], points[j]);
-						bool direct_connection = true;
-						for (int k=0; k<it.count && direct_connection==true; k++, ++it)
-							if (**it < 250)
-								direct_connection = false;		// if a pixel in between is not accessible, direct connection is not possible
-						if (direct_connection == true)
-						{
-							// compute distance
-							const double length = cv::norm(points[i]-points[j]);
-							distance_matrix.at<double>(i, j) = length;
-							distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-							if (paths!=NULL)
-							{
-								// store path
-								cv::LineIterator it2(original_map, points[i], points[j]);
-								std::vector<cv::Point> current_path(it2.count);
-								for (int k=0; k<it2.count; k++, ++it2)
-									current_path[k] = it2.pos();
-								paths->at(i).at(j) = current_path;
-								paths->at(j).at(i) = current_path;
-							}
-//							++a;
-						}
-						else
-						{
-							// A* path planner
-							if(paths!=NULL)
-							{
-								std::vector<cv::Point> current_path;
-								double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution, 0, NULL, &current_path);
-								distance_matrix.at<double>(i, j) = length;
-								distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-
-								// remap path points to original map size
-								for(std::vector<cv::Point>::iterator point=current_path.begin(); point!=current_path.end(); ++point)
-								{
-									point->x = point->x/downsampling_factor;
-									point->y = point->y/downsampling_factor;
-								}
-
-								paths->at(i).at(j) = current_path;
-								paths->at(j).at(i) = current_path;
-							}
-							else
-							{
-								double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution);
-								distance_matrix.at<double>(i, j) = length;
-								distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-
-							}
-//							++b;
-						}
-					}
-				}
-				else
-				{
-					distance_matrix.at<double>(i, j) = 0;
-				}
-			}
-		}
+	//Function to complete a distance matrix of which the distances between the known points (known_points[i]==true) have
+	//already been filled in, e.g. from an earlier computation with fewer points. Only the rows and columns of the other points
+	//are computed in the same way as in constructDistanceMatrix, with one search from each of the other points.
+	//map_hash = MapPreprocessingCache::computeMapHash(original_map)
+	void completeDistanceMatrix(cv::Mat& distance_matrix, const unsigned long long map_hash, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
+			const std::vector<bool>& known_points)
+	{
+		std::cout << "DistanceMatrix::completeDistanceMatrix: Completing distance matrix..." << std::endl;
+		Timer tim;
 
-		std::cout << "\nDistance matrix created in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;// "\nDistance matrix:\n" << distance_matrix << std::endl;
+		computeDistanceMatrix(distance_matrix, map_hash, original_map, points, downsampling_factor, robot_radius, map_resolution, path_planner, &known_points, NULL);
+
+		std::cout << "\nDistance matrix completed in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+	}
+
+	//Function to take the distance matrix of a subset of the points (e.g. the rooms of one clique) from the distance matrix of
+	//all points without any computation: sub_matrix(a,b) = distance_matrix(indices[a], indices[b])
+	static void extractDistanceMatrix(const cv::Mat& distance_matrix, const std::vector<int>& indices, cv::Mat& sub_matrix)
+	{
+		sub_matrix.create((int)indices.size(), (int)indices.size(), CV_64F);
+		for (size_t a=0; a<indices.size(); ++a)
+			for (size_t b=0; b<indices.size(); ++b)
+				sub_matrix.at<double>(a, b) = distance_matrix.at<double>(indices[a], indices[b]);
 	}
 
 	// check whether distance matrix contains infinite path lengths and if this is true, create a new distance matrix with maximum size clique of reachable points
 	// cleaned_index_to_original_index_mapping --> maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
+	//
+	// 1. The points are grouped into sets of mutually reachable points with a union-find over all pairs of finite distances.
+	// 2. Path lengths are not always transitive (e.g. because of the downsampled map), so points of one set may still have
+	//    infinite distances to each other, which are removed from each set (see removeInfiniteDistances). The largest
+	//    cleaned set is kept (of equally large sets the one whose highest point index is lowest).
+	// 3. The rows and columns of the kept points are copied into the cleaned matrix in one pass.
 	void cleanDistanceMatrix(const cv::Mat& distance_matrix, cv::Mat& distance_matrix_cleaned, std::map<int,int>& cleaned_index_to_original_index_mapping)
 	{
 		// standard: use a 1:1 mapping (input = output)
 		cleaned_index_to_original_index_mapping.clear();
 		for (int i=0; i<distance_matrix.rows; ++i)
 			cleaned_index_to_original_index_mapping[i] = i;
-		distance_matrix_cleaned = distance_matrix.clone();
 
 		if (distance_matrix.rows < 1)
+		{
+			distance_matrix_cleaned = distance_matrix.clone();
 			return;
+		}
 
+		const int n = distance_matrix.rows;
 		const double max_length = 1e90;
 
-		std::vector<bool> remove_entry(distance_matrix.rows, false);	// keeps track on which entries of distance_matrix need to be removed
-
-		// loop until all lines are marked, which need to be removed
-		cv::Mat distance_matrix_temp = distance_matrix.clone();
-		while (true)
+		// 1. sets of mutually reachable points
+		std::vector<int> parent(n);
+		for (int i=0; i<n; ++i)
+			parent[i] = i;
+		bool has_infinite_entries = false;
+		for (int i=0; i<n; ++i)
 		{
-			// count infinite entries in each row of distance matrix
-			std::vector<int> infinite_length_entries(distance_matrix_temp.rows, 0);
-			for (int i=0; i<distance_matrix_temp.rows; ++i)
-				for (int j=0; j<distance_matrix_temp.cols; ++j)
-					if (distance_matrix_temp.at<double>(i,j)>max_length)
-						infinite_length_entries[i]++;
-
-			// sort rows by their number of infinite entries
-			std::multimap<int, int> number_infinite_entries_to_row_index_mapping;	// maps number of infinite entries to the corresponding row index
-			for (size_t i=0; i<infinite_length_entries.size(); ++i)
-				number_infinite_entries_to_row_index_mapping.insert(std::pair<int,int>(infinite_length_entries[i], (int)i));
-
-			// if any row has at least one infinite entry, mark the row with most infinity entries for deletion
-			bool mark_line = false;
-			int mark_index = -1;
-			std::multimap<int, int>::reverse_iterator number_infinite_entries_to_row_index_mapping_last = number_infinite_entries_to_row_index_mapping.rbegin();
-			if (number_infinite_entries_to_row_index_mapping_last->first > 0)
-			{
-				mark_line = true;
-				mark_index = number_infinite_entries_to_row_index_mapping_last->second;
-				remove_entry[mark_index] = true;
-			}
-			if (mark_line == true)
+			const double* row = distance_matrix.ptr<double>(i);
+			for (int j=0; j<n; ++j)
 			{
-				for (int j=0; j<distance_matrix_temp.cols; ++j)			// mark row: mark_index
-					distance_matrix_temp.at<double>(mark_index, j) = -1.;
-				for (int i=0; i<distance_matrix_temp.rows; ++i)			// mark col: mark_index
-					distance_matrix_temp.at<double>(i, mark_index) = -1.;
+				if (row[j] > max_length)
+					has_infinite_entries = true;
+				else if (j > i && distance_matrix.at<double>(j, i) <= max_length)
+				{
+					const int root_i = findSetRepresentative(parent, i);
+					const int root_j = findSetRepresentative(parent, j);
+					if (root_i != root_j)
+						parent[std::max(root_i, root_j)] = std::min(root_i, root_j);
+				}
 			}
-			else
-				break;
 		}
-
-		// count entries to remove
-		int number_entries_to_be_removed = 0;
-		for (size_t i=0; i<remove_entry.size(); ++i)
-			if (remove_entry[i] == true)
-				number_entries_to_be_removed++;
-
-		// remove elements from distance matrix if necessary
-		if (number_entries_to_be_removed > 0)
+		if (has_infinite_entries == false)
 		{
-			std::cout << "  DistanceMatrix::cleanDistanceMatrix: Need to remove " << number_entries_to_be_removed << " elements out of " << distance_matrix.rows << " elements from the distance matrix." << std::endl;
-
-			// setup new distance_matrix
-			const int new_size = distance_matrix.rows - number_entries_to_be_removed;
-			if (new_size == 0)
-			{
-				std::cout << "  DistanceMatrix::cleanDistanceMatrix: Warning: Would need to remove all elements of distance_matrix. Aborting." << std::endl;
-				return;
-			}
-			distance_matrix_cleaned.create(new_size, new_size, CV_64F);
-			cleaned_index_to_original_index_mapping.clear();
+			distance_matrix_cleaned = distance_matrix.clone();
+			return;
+		}
 
-			// fill new distance_matrix
-			int new_index = 0;
-			for (size_t i=0; i<remove_entry.size(); ++i)
-			{
-				if (remove_entry[i] == false)
-				{
-					// mapping from new to old indices
-					cleaned_index_to_original_index_mapping[new_index] = (int)i;
+		// 2. remove the points with infinite distances within each set and keep the largest cleaned set
+		std::vector<std::vector<int> > sets(n);
+		for (int i=0; i<n; ++i)
+			sets[findSetRepresentative(parent, i)].push_back(i);
+		std::vector<int> remaining_entries;
+		for (int root=0; root<n; ++root)
+		{
+			if (sets[root].size() < std::max((size_t)1, remaining_entries.size()))
+				continue;
+			removeInfiniteDistances(distance_matrix, sets[root], max_length);
+			if (sets[root].empty() == false && (sets[root].size() > remaining_entries.size()
+					|| (sets[root].size() == remaining_entries.size() && sets[root].back() < remaining_entries.back())))
+				remaining_entries.swap(sets[root]);
+		}
 
-					// copy values
-					int new_j = 0;
-					for (size_t j=0; j<remove_entry.size(); ++j)
-					{
-						if (remove_entry[j] == false)
-						{
-							distance_matrix_cleaned.at<double>(new_index, new_j) = distance_matrix.at<double>(i,j);
-							new_j++;
-						}
-					}
-					new_index++;
-				}
-			}
-			if (new_index != new_size)
-				std::cout << "##################################################\nDistanceMatrix::cleanDistanceMatrix: Warning: new_index != new_size.\n##################################################" << std::endl;
+		// 3. copy the remaining rows and columns
+		const int new_size = remaining_entries.size();
+		std::cout << "  DistanceMatrix::cleanDistanceMatrix: Need to remove " << n-new_size << " elements out of " << n << " elements from the distance matrix." << std::endl;
+		if (new_size == 0)
+		{
+			std::cout << "  DistanceMatrix::cleanDistanceMatrix: Warning: Would need to remove all elements of distance_matrix. Aborting." << std::endl;
+			distance_matrix_cleaned = distance_matrix.clone();
+			return;
+		}
+		distance_matrix_cleaned.create(new_size, new_size, CV_64F);
+		cleaned_index_to_original_index_mapping.clear();
+		for (int new_index=0; new_index<new_size; ++new_index)
+		{
+			// mapping from new to old indices
+			cleaned_index_to_original_index_mapping[new_index] = remaining_entries[new_index];
+
+			// copy values
+			const double* row = distance_matrix.ptr<double>(remaining_entries[new_index]);
+			double* new_row = distance_matrix_cleaned.ptr<double>(new_index);
+			for (int new_j=0; new_j<new_size; ++new_j)
+				new_row[new_j] = row[remaining_entries[new_j]];
 		}
 	}
 
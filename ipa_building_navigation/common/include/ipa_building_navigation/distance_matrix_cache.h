@@ -0,0 +1,115 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/distance_matrix.h>
+
+//This class caches the distance matrices of point sets (e.g. room centers) on a map, so that repeated sequence planning
+//requests for the same map do not compute the same paths again. A matrix is identified by the hash of the map, the
+//downsampling factor, the robot radius, the map resolution and the ordered list of points.
+//
+//There are two tiers:
+//		1. memory: the most recently used matrices of the process
+//		2. disk (only if a cache directory is set): every computed matrix is written into one file of the directory, which
+//		   is read again if the matrix is requested after a restart of the process or after it was dropped from memory, the
+//		   least recently used files are deleted if the files of the directory exceed the byte budget of the disk tier
+//
+//If a requested point list is not cached yet, the cached matrix of the same map and parameters that contains most of the
+//requested points is reused and only the rows and columns of the new points are computed, e.g. re-planning after one
+//room has been added computes one row and one column. Point lists that are a subset of a cached list (e.g. the rooms of
+//one clique) need no computation at all.
+//
+//File format (native byte order, all blocks 8 byte aligned, so the file can be memory mapped and used in place):
+//		FileHeader                                            48 bytes
+//		points          int32 x, int32 y per point            8*N bytes
+//		distance matrix double, row major                     8*N*N bytes
+class DistanceMatrixCache
+{
+public:
+	DistanceMatrixCache(const std::string& cache_directory="", const size_t max_number_of_matrices=16,
+			const unsigned long long max_disk_bytes=1024ULL*1024ULL*1024ULL);
+
+	//sets the directory of the disk tier, an empty string disables the disk tier, the directory has to exist
+	void setCacheDirectory(const std::string& cache_directory);
+
+	//sets the byte budget of the disk tier, i.e. the maximal size of all distance matrix files in the cache directory
+	void setMaxDiskBytes(const unsigned long long max_disk_bytes);
+
+	//returns the distance matrix of points on original_map (see DistanceMatrix::constructDistanceMatrix for the parameters), the
+	//matrix is taken from the cache or computed (completely or partially) and stored in the cache
+	//If the computation is stopped by stop_condition, the missing distances are approximated (see DistanceMatrix::setStopCondition),
+	//such a matrix is not stored and false is returned.
+	bool getDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			const double downsampling_factor, const double robot_radius, const double map_resolution, AStarPlanner& path_planner,
+			const StopCondition& stop_condition=StopCondition());
+
+	//same as above with the already computed hash of original_map (MapPreprocessingCache::computeMapHash), saves hashing the map
+	//again if several matrices of the same map are requested
+	bool getDistanceMatrix(cv::Mat& distance_matrix, const unsigned long long map_hash, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			const double downsampling_factor, const double robot_radius, const double map_resolution, AStarPlanner& path_planner,
+			const StopCondition& stop_condition=StopCondition());
+
+	//removes all matrices from the memory tier, the files of the disk tier are kept
+	void clear();
+
+	//writes a distance matrix of the given points into a file of the format described above, returns false if that failed,
+	//the file is written under a temporary name of the calling process and thread first and then renamed, so concurrent
+	//writers of the same file never mix their data
+	static bool writeDistanceMatrixFile(const std::string& filename, const unsigned long long map_hash, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, const std::vector<cv::Point>& points, const cv::Mat& distance_matrix);
+
+	//reads a file written by writeDistanceMatrixFile via memory mapping, returns false if the file does not exist or does not
+	//match the given parameters
+	static bool readDistanceMatrixFile(const std::string& filename, const unsigned long long map_hash, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, std::vector<cv::Point>& points, cv::Mat& distance_matrix);
+
+protected:
+
+	//header of a cache file
+	struct FileHeader
+	{
+		char magic[8];					// "IPADMC01"
+		unsigned long long map_hash;
+		double downsampling_factor;
+		double robot_radius;
+		double map_resolution;
+		unsigned long long number_of_points;
+	};
+
+	//one cached matrix
+	struct CachedMatrix
+	{
+		std::string parameter_key;		// key of the map and parameters without the points
+		std::vector<cv::Point> points;
+		cv::Mat distance_matrix;
+	};
+
+	//hash over the ordered point list
+	static unsigned long long computePointsHash(const std::vector<cv::Point>& points);
+
+	//key of the map and the parameters
+	static std::string getParameterKey(const unsigned long long map_hash, const double downsampling_factor, const double robot_radius, const double map_resolution);
+
+	//stores a matrix in the memory tier and drops the least recently used matrices if necessary, call with locked cache_mutex_
+	void storeInMemory(const std::string& key, const CachedMatrix& cached_matrix);
+
+	//deletes the distance matrix files of cache_directory with the oldest modification time (which is renewed on every read)
+	//until all of them fit into max_disk_bytes
+	static void limitDiskTier(const std::string& cache_directory, const unsigned long long max_disk_bytes);
+
+	std::string cache_directory_;
+	size_t max_number_of_matrices_;
+	unsigned long long max_disk_bytes_;
+	std::map<std::string, CachedMatrix> matrices_;		// maps "<parameter key>_<points hash>" to the matrix
+	std::list<std::string> usage_order_;					// keys of matrices_, most recently used first
+	boost::mutex cache_mutex_;							// protects all members above
+};
@@ -11,15 +11,24 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include <boost/random/mersenne_twister.hpp>
+
 #include <ipa_building_navigation/contains.h>
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/anytime_tsp_solver.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
 //This class provides a solution for the TSP by taking the nearest-neighbor path and applying a genetic algorithm on it.
+//By default a memetic algorithm is used, i.e. every child of a generation is improved by the local search heuristics 2-opt
+//and Or-opt before the selection. The children are created in parallel, each child uses its own random number generator
+//that is seeded from the seed of the solver, the generation and the index of the child, so the result does not depend on
+//the number of threads. The evolution stops if the best tour has not improved for a number of generations or if the
+//maximum computation time is exceeded. The classic genetic algorithm (mutations only) can still be chosen for comparisons.
+//Both algorithms stop at the deadline or on cancellation (see AnytimeTSPSolver) and report each new best tour.
 //It needs a symmetrical matrix of pathlenghts between the nodes and the starting-point index in this matrix.
 //If the path from one node to another doesn't exist or the path is from one node to itself, the entry in the matrix must
 //be 0 or smaller. so the format for this matrix is:
@@ -32,7 +41,7 @@
 //		| 1.2 9.0  88.0 0.0  0.0 |
 //		---					   ---
 
-class GeneticTSPSolver
+class GeneticTSPSolver : public AnytimeTSPSolver
 {
 protected:
 
@@ -42,8 +51,10 @@ protected:
 	//function to get the length of a given path
 	double getPathLength(const cv::Mat& path_length_Matrix, std::vector<int> given_path);
 
+	typedef boost::random::mt19937 RandomNumberGenerator;
+
 	//function to mutate (randomly change) a given Parent-path
-	std::vector<int> mutatePath(const std::vector<int>& parent_path);
+	std::vector<int> mutatePath(const std::vector<int>& parent_path, RandomNumberGenerator& random_number_generator);
 
 	//function that selects the best path from the given paths
 	std::vector<int> getBestPath(const std::vector<std::vector<int> > paths, const cv::Mat& pathlength_Matrix, bool& changed);
@@ -52,13 +63,64 @@ protected:
 			const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
 			double robot_radius, double map_resolution, AStarPlanner& path_planner);
 
-	bool abort_computation_;
+	//classic genetic algorithm, see genetic_TSP.cpp
+	std::vector<int> solveClassicGeneticTSP(const cv::Mat& path_length_Matrix, const int start_Node);
+
+	//memetic algorithm, see genetic_TSP.cpp
+	std::vector<int> solveMemeticTSP(const cv::Mat& path_length_Matrix, const int start_Node);
+
+	//The following functions work on closed tours of the memetic algorithm: a tour contains every node once, starts with the
+	//start node and returns to it from its last node. distances is the row-major distance matrix with number_of_nodes columns.
+
+	//function to get the length of a closed tour
+	static double getTourLength(const std::vector<double>& distances, const int number_of_nodes, const std::vector<int>& tour);
+
+	//applies 2-opt and Or-opt moves until the tour is a local optimum, the start node stays at the beginning
+	static void improveTour(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour);
+
+	//applies all improving 2-opt moves (inversion of a part of the tour) found in one pass, returns true if the tour was changed
+	static bool applyTwoOptMoves(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour);
+
+	//applies all improving Or-opt moves (shifting a part of 1 to 3 nodes to another place) found in one pass, returns true if
+	//the tour was changed
+	static bool applyOrOptMoves(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour);
+
+	//order crossover of two tours: a random part of first_parent is kept, the other nodes are filled in the order of second_parent
+	static std::vector<int> crossoverTours(const std::vector<int>& first_parent, const std::vector<int>& second_parent, RandomNumberGenerator& random_number_generator);
+
+	//double bridge mutation: the tour is cut into four parts A B C D, that are reconnected to A C B D
+	static void mutateTour(std::vector<int>& tour, RandomNumberGenerator& random_number_generator);
+
+	//tours of one generation of the memetic algorithm
+	struct Generation
+	{
+		unsigned int index;
+		std::vector<std::vector<int> > population;		// sorted by length, the best tour first
+		std::vector<double> population_lengths;
+		std::vector<std::vector<int> > children;
+		std::vector<double> children_lengths;
+	};
+
+	//thread function that creates the children thread_index, thread_index+number_of_threads, ... of one generation
+	void createChildren(const std::vector<double>& distances, const int number_of_nodes, Generation& generation,
+			const int thread_index, const int number_of_threads);
+
+	bool use_local_search_;			// if true the memetic algorithm is used (default), else the classic genetic algorithm
+	unsigned int random_seed_;		// seed for the random number generators of both algorithms
 
 public:
 	//constructor
 	GeneticTSPSolver();
 
-	void abortComputation();
+	//chooses between the memetic algorithm (true, default) and the classic genetic algorithm without local search (false)
+	void setUseLocalSearch(const bool use_local_search);
+
+	//sets the seed of the random number generators of the memetic and the classic algorithm, solving the same problem with
+	//the same seed gives the same result
+	void setRandomSeed(const unsigned int random_seed);
+
+	//solves the TSP with the given distance matrix, see AnytimeTSPSolver
+	std::vector<int> solveTSP(const cv::Mat& path_length_matrix, const int start_node);
 
 	//Solving-algorithms for the given TSP. It returns a vector of int, which is the order from this solution. The int shows
 	//the index in the Matrix. There are two functions for different cases:
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+
+//This class provides a hierarchical pathplanner (HPA*, Botea et al. 2004) for long queries on large building maps. The
+//downsampled map (see AStarPlanner::downsampleMap) is divided into square clusters of cluster_size x cluster_size cells:
+//		1. Along the border of two neighboring clusters every maximal run of cells that is accessible on both sides is an
+//		   entrance. A short entrance gets one transition in its middle, a long one gets a transition at each of its ends.
+//		   Both cells of a transition are nodes of the abstract graph, connected by one straight step.
+//		2. Inside every cluster the pathlengths between its nodes are computed with a search that stays in the cluster.
+//		3. A query connects the start and the goal to the nodes of their clusters with one search inside each of these two
+//		   clusters and then searches the abstract graph with A*, so only the abstract graph and two clusters are searched.
+//		   If the clusters of the start and the goal are neighbors, the path is searched directly in the clusters around them.
+//The found pathlength of a long query is usually a few percent longer than the shortest path, because the paths have to
+//cross the borders of the clusters at the transitions.
+//
+//The abstract graph of a map is built once (the clusters in parallel) and stored in a process-wide cache under the hash of
+//the map and the parameters, so every planner of the process that uses the same map shares it. The graph is not changed by
+//the queries, but one planner must not be used by several threads at the same time.
+class HierarchicalPathPlanner
+{
+public:
+	HierarchicalPathPlanner();
+
+	//sets the map for the following queries, the abstract graph is taken from the cache or built (see AStarPlanner for the
+	//downsampling parameters), cluster_size is the side length of a cluster in cells of the downsampled map
+	void setMap(const cv::Mat& original_map, const double downsampling_factor, const double robot_radius, const double map_resolution,
+			const int cluster_size=16);
+
+	//same as above with the hash of the original map (MapPreprocessingCache::computeMapHash) and its already downsampled map
+	//(AStarPlanner::downsampleMap with the same parameters)
+	void setMap(const unsigned long long map_hash, const cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius,
+			const double map_resolution, const int cluster_size=16);
+
+	//computes the pathlength between start point and end point (in coordinates of the original map like
+	//AStarPlanner::planPath with a downsampled map), returns 1e100 if no path exists, if waypoints is provided it receives the
+	//start point, the traversed transitions (the cells of the route for a search in neighboring clusters) and the end point in
+	//coordinates of the original map
+	double planPath(const cv::Point& start_point, const cv::Point& end_point, std::vector<cv::Point>* waypoints=NULL);
+
+	//number of nodes and edges of the abstract graph of the current map
+	size_t getNumberOfNodes() const;
+	size_t getNumberOfEdges() const;
+
+	//removes all abstract graphs from the cache
+	static void clearCache();
+
+protected:
+
+	//edge of the abstract graph, the cost is measured in cells of the downsampled map
+	struct Edge
+	{
+		int target;
+		double cost;
+	};
+
+	//abstract graph of one map, it is not changed after it has been built
+	struct AbstractGraph
+	{
+		cv::Mat downsampled_map;
+		int cluster_size;
+		int clusters_x;
+		int clusters_y;
+		std::vector<cv::Point> nodes;						// cell of each node in the downsampled map
+		std::vector<std::vector<Edge> > edges;				// edges of each node
+		std::vector<std::vector<int> > cluster_nodes;		// nodes of each cluster, index = cluster_y*clusters_x + cluster_x
+	};
+	typedef boost::shared_ptr<const AbstractGraph> AbstractGraphPtr;
+
+	// hands out the clusters to the threads that compute the intra-cluster edges
+	struct ClusterQueue
+	{
+		ClusterQueue() : next_cluster(0) {}
+
+		int next_cluster;
+		boost::mutex mutex;
+	};
+
+	//returns the abstract graph of the downsampled map from the cache or builds it, map_hash is the hash of the original map
+	//(MapPreprocessingCache::computeMapHash)
+	static AbstractGraphPtr getAbstractGraph(const unsigned long long map_hash, const cv::Mat& downsampled_map, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, const int cluster_size);
+
+	//builds the abstract graph of a downsampled map
+	static void buildAbstractGraph(AbstractGraph& graph, const cv::Mat& downsampled_map, const int cluster_size);
+
+	//returns the node of cell and adds it to the graph if the cell has no node yet
+	static int addNode(AbstractGraph& graph, std::map<int, int>& cell_to_node, const cv::Point& cell);
+
+	//computes the edges between the nodes of the clusters taken from the queue until all clusters are done, the edges of each
+	//cluster are stored in intra_cluster_edges[cluster] as (node, edge) pairs
+	static void computeIntraClusterEdges(const AbstractGraph& graph, std::vector<std::vector<std::pair<int, Edge> > >& intra_cluster_edges,
+			ClusterQueue& cluster_queue);
+
+	//area of a cluster in the downsampled map
+	static cv::Rect getClusterArea(const AbstractGraph& graph, const int cluster);
+
+	//index of the cluster that contains cell
+	static int getCluster(const AbstractGraph& graph, const cv::Point& cell);
+
+	AStarPlanner local_planner_;		// searches inside the clusters of the start and the goal
+	AbstractGraphPtr graph_;
+	double downsampling_factor_;
+};
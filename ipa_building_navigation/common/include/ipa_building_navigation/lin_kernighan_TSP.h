@@ -0,0 +1,137 @@
+#include "ros/ros.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <ipa_building_navigation/nearest_neighbor_TSP.h>
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/anytime_tsp_solver.h>
+
+#pragma once //make sure this header gets included only one time when multiple classes need it in the same project
+			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
+
+//This class provides a solution for the TSP with a chained Lin-Kernighan heuristic (in the style of LKH and the chained
+//Lin-Kernighan of Applegate et al.):
+//		1. The nearest neighbor tour is improved by Lin-Kernighan moves (variable depth sequences of 2-opt moves) and
+//		   Or-opt moves (shifting a part of 1 to 3 nodes to another place) until it is a local optimum.
+//		2. The local optimum is perturbed by a double bridge kick on a random part of the tour and improved again, the new
+//		   tour is kept if it is shorter. This is repeated for a number of kicks or until the maximum computation time is reached.
+//Only the nearest neighbors of each node are considered as new tour neighbors (neighbor lists) and only nodes whose tour
+//neighborhood has changed are checked for improving moves again (don't-look bits), so the tour of a few hundred nodes is
+//found in milliseconds. The computation can be stopped at any time (see AnytimeTSPSolver), then the best tour is returned.
+//
+//It needs a symmetrical matrix of pathlenghts between the nodes and the starting-point index in this matrix.
+//If the path from one node to another doesn't exist or the path is from one node to itself, the entry in the matrix must
+//be 0 or smaller. so the format for this matrix is:
+// row: node to start from, column: node to go to
+//		---					   ---
+//		| 0.0 1.0  3.5  5.8  1.2 |
+//		| 1.0 0.0  2.4  3.3  9.0 |
+//		| 3.5 2.4  0.0 	7.7  88.0|
+//		| 5.8 3.3  7.7  0.0  0.0 |
+//		| 1.2 9.0  88.0 0.0  0.0 |
+//		---					   ---
+class LinKernighanTSPSolver : public AnytimeTSPSolver
+{
+protected:
+
+	typedef boost::random::mt19937 RandomNumberGenerator;
+
+	//Astar pathplanner to find the pathlengths from cv::Point to cv::Point
+	AStarPlanner pathplanner_;
+
+	void distance_matrix_thread(DistanceMatrix& distance_matrix_computation, cv::Mat& distance_matrix,
+			const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
+			double robot_radius, double map_resolution, AStarPlanner& path_planner);
+
+	//distance between two nodes
+	inline double getDistance(const int first_node, const int second_node) const
+	{
+		return distances_[first_node*number_of_nodes_ + second_node];
+	}
+
+	//successor (direction = 1) or predecessor (direction = -1) of a node in the current tour
+	inline int getTourNeighbor(const int node, const int direction) const
+	{
+		return tour_[(positions_[node] + direction + number_of_nodes_) % number_of_nodes_];
+	}
+
+	//function to get the length of the current tour
+	double getTourLength() const;
+
+	//reverses the part of the current tour that starts at first_position and contains length nodes (cyclic)
+	void reverseTourSegment(const int first_position, const int length);
+
+	//tries to find an improving Lin-Kernighan move that starts with removing the edge between t1 and its successor
+	//(direction = 1) or predecessor (direction = -1), applies it and returns true if successful, the nodes whose tour
+	//neighbors have changed are appended to changed_nodes
+	bool applyLinKernighanMove(const int t1, const int direction, std::vector<int>& changed_nodes);
+
+	//tries to find an improving Or-opt move of the part of 1 to 3 nodes that starts at first_node, applies it and returns
+	//true if successful, the nodes whose tour neighbors have changed are appended to changed_nodes
+	bool applyOrOptMove(const int first_node, std::vector<int>& changed_nodes);
+
+	//applies improving moves until none of the active nodes (nodes with cleared don't-look bit) can be improved or the
+	//computation is stopped
+	void optimizeTour(std::deque<int>& active_nodes, std::vector<bool>& is_active);
+
+	//reports the current tour, rotated to begin at start_node, as new best tour
+	void reportTour(const int start_node, const double tour_length);
+
+	//exchanges two random neighboring parts of the current tour (double bridge), the nodes whose tour neighbors have changed
+	//are appended to changed_nodes
+	void applyDoubleBridgeKick(RandomNumberGenerator& random_number_generator, std::vector<int>& changed_nodes);
+
+	//data of the currently solved problem
+	int number_of_nodes_;
+	std::vector<double> distances_;					// row-major distance matrix
+	std::vector<std::vector<int> > neighbor_lists_;	// nearest nodes of each node, sorted by distance
+	std::vector<int> tour_;							// nodes in the order of the current tour
+	std::vector<int> positions_;					// position of each node in tour_
+
+	int max_number_of_kicks_;		// number of double bridge kicks, < 0 = automatic (depends on the number of nodes)
+	unsigned int random_seed_;		// seed for the random kicks
+
+public:
+	//constructor
+	LinKernighanTSPSolver();
+
+	//sets the number of double bridge kicks after the first local optimum, 0 = return the first local optimum, < 0 = automatic (default)
+	void setMaximumNumberOfKicks(const int max_number_of_kicks);
+
+	//sets the seed of the random kicks, solving the same problem with the same seed gives the same result
+	void setRandomSeed(const unsigned int random_seed);
+
+	//solves the TSP with the given distance matrix, see AnytimeTSPSolver
+	std::vector<int> solveTSP(const cv::Mat& path_length_matrix, const int start_node);
+
+	//Solving-algorithms for the given TSP. It returns a vector of int, which is the order from this solution. The int shows
+	//the index in the Matrix. There are two functions for different cases:
+	//		1. The distance matrix already exists
+	//		2. The distance matrix has to be computed and maybe returned
+
+	//with given distance matrix
+	std::vector<int> solveLinKernighanTSP(const cv::Mat& path_length_Matrix, const int start_Node);
+
+	// compute distance matrix and maybe returning it
+	// this version does not exclude infinite paths from the TSP ordering
+	std::vector<int> solveLinKernighanTSP(const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
+			double robot_radius, double map_resolution, const int start_Node, cv::Mat* distance_matrix=0);
+
+	// compute TSP from a cleaned distance matrix (does not contain any infinity paths) that has to be computed
+	std::vector<int> solveLinKernighanTSPClean(const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			double downsampling_factor, double robot_radius, double map_resolution, const int start_node);
+
+	// compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
+	std::vector<int> solveLinKernighanTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
+			const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <map>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+
+//This class provides a process-wide cache for images that are derived from the same map again and again by the segmentation,
+//navigation and exploration algorithms, e.g. robot-inflated (eroded) maps, downsampled maps, distance transforms or Voronoi
+//graphs. An artifact gets computed lazily on the first request and is stored under the hash of the map and a key that
+//describes the artifact and its parameters. Every later request for the same artifact of the same map, from whichever
+//algorithm or thread of the process, receives the already computed image.
+//
+//!!!!!!!!!Important!!!!!!!!!!!!!
+//The returned images share their data with the cache, so never write into them. Use clone() if the image needs to be modified.
+//
+//The cache is thread-safe. Concurrent requests for the same artifact compute it only once (the other threads wait for the
+//result), requests for different artifacts are computed in parallel. The memory of the stored artifacts is bounded by a
+//byte budget, the least recently used artifacts are dropped if it is exceeded.
+//
+//Every artifact keeps a copy of the map it was computed from (shared by all artifacts of the same map), so a request whose
+//map has the same hash but differs from the stored map (hash collision) is recognized and computed without the cache.
+//Hashing a map costs one pass over its pixels, so callers that request several artifacts of the same map should compute
+//the hash once with computeMapHash and use the functions that take map_hash.
+class MapPreprocessingCache
+{
+public:
+	//function that computes an artifact from the given map
+	typedef boost::function<void (const cv::Mat& map, cv::Mat& artifact)> ArtifactFunction;
+
+	//max_bytes is the byte budget for the images of all stored artifacts and their map copies
+	MapPreprocessingCache(const size_t max_bytes=256*1024*1024);
+
+	//returns the instance that is shared by all algorithms of the process
+	static MapPreprocessingCache& getInstance();
+
+	//computes a 64 bit FNV-1a hash over the size, type and pixel data of the map
+	static unsigned long long computeMapHash(const cv::Mat& map);
+
+	//returns the artifact of map that is described by artifact_key and computes it with compute_artifact if it is not cached yet,
+	//artifact_key has to identify the artifact and all of its parameters uniquely, e.g. "eroded_map:4"
+	cv::Mat getArtifact(const cv::Mat& map, const std::string& artifact_key, const ArtifactFunction& compute_artifact);
+
+	//same as above with an already computed map hash (computeMapHash(map)), saves hashing the map again
+	cv::Mat getArtifact(const unsigned long long map_hash, const cv::Mat& map, const std::string& artifact_key, const ArtifactFunction& compute_artifact);
+
+	//map eroded number_of_erosions times with the standard 3x3 kernel, i.e. cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1,-1), number_of_erosions)
+	//returns map itself (not cached) if number_of_erosions <= 0
+	cv::Mat getErodedMap(const cv::Mat& map, const int number_of_erosions);
+	cv::Mat getErodedMap(const unsigned long long map_hash, const cv::Mat& map, const int number_of_erosions);
+
+	//map eroded by the robot radius and downsampled by downsampling_factor (see AStarPlanner::downsampleMap for the parameters)
+	//returns map itself (not cached) if there is nothing to erode and downsampling_factor == 1
+	cv::Mat getDownsampledMap(const cv::Mat& map, const double downsampling_factor, const double robot_radius, const double map_resolution);
+	cv::Mat getDownsampledMap(const unsigned long long map_hash, const cv::Mat& map, const double downsampling_factor, const double robot_radius, const double map_resolution);
+
+	//L2 distance transform (mask size 5, type CV_32FC1) of the map that has been eroded number_of_erosions times before
+	cv::Mat getDistanceTransform(const cv::Mat& map, const int number_of_erosions=0);
+	cv::Mat getDistanceTransform(const unsigned long long map_hash, const cv::Mat& map, const int number_of_erosions=0);
+
+	//removes all cached artifacts
+	void clear();
+
+	//statistics on the usage of the cache
+	size_t getNumberOfHits() const;
+	size_t getNumberOfMisses() const;
+	size_t getNumberOfBytes() const;
+
+protected:
+
+	//one cached artifact, the image is computed by the first thread that requests it while holding the artifact's own mutex
+	struct Artifact
+	{
+		Artifact() : computed(false), last_access(0), bytes(0) {}
+
+		boost::mutex mutex;
+		bool computed;
+		cv::Mat image;
+		cv::Mat source_map;		// copy of the map the artifact was computed from
+		unsigned long long last_access;
+		size_t bytes;			// memory of image and source_map, set when the artifact has been computed
+	};
+	typedef boost::shared_ptr<Artifact> ArtifactPtr;
+
+	//returns true if both maps have the same size, type and pixels
+	static bool isSameMap(const cv::Mat& map1, const cv::Mat& map2);
+
+	//drops the least recently used artifacts except keep until the byte budget is met, call with locked cache_mutex_
+	void evictArtifacts(const ArtifactPtr& keep);
+
+	std::map<std::string, ArtifactPtr> artifacts_;		// maps "<map hash>/<artifact key>" to the artifact
+	size_t max_bytes_;
+	size_t number_of_bytes_;			// sum of the bytes of all artifacts in artifacts_
+	unsigned long long access_counter_;
+	size_t number_of_hits_;
+	size_t number_of_misses_;
+	mutable boost::mutex cache_mutex_;		// protects all members above, but not the computation of an artifact
+};
@@ -13,16 +13,15 @@
 #include <fstream>
 
 #include <ipa_building_navigation/contains.h>
+#include <ipa_building_navigation/stop_condition.h>
 
-#include <boost/graph/graph_traits.hpp>
-#include <boost/graph/undirected_graph.hpp>
-#include <boost/graph/bron_kerbosch_all_cliques.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
-//This algorithm provides a class that finds all maximal cliques in a given graph. It uses the Bron-Kerbosch Implementation
-//in Boost to do this. As input a symmetrical distance-Matrix is needed that shows the pathlenghts from one node to another.
+//This algorithm provides a class that finds all maximal cliques in a given graph. It uses the Bron-Kerbosch algorithm with
+//Tomita pivoting in degeneracy ordering (Eppstein, Loeffler and Strash), working on bitsets of the vertex indices. As input a symmetrical distance-Matrix is needed that shows the pathlenghts from one node to another.
 //If the path from one node to another doesn't exist, the entry in the matrix must be 0 or smaller. so the format for this
 //Matrix is:
 // row: node to start from, column: node to go to
@@ -46,24 +45,35 @@
 //		---					   ---
 //
 //The nodes in the graph are named after their position in the distance-Matrix and the cliques are
-// std::vector<int> variables so you can easily acces the right nodes in the matrix outside this class.
+// std::vector<int> variables so you can easily acces the right nodes in the matrix outside this class. Nodes without any
+//connection are returned as cliques of one node.
+//If a stop condition is set and met, the search returns the maximal cliques found until then, so not every node may be
+//contained in a clique.
 
 class cliqueFinder
 {
 protected:
-	//function that allows to add a Vertex with a name to a boost::Graph. See boosts helper.hpp ( http://www.boost.org/doc/libs/1_47_0/libs/graph/example/helper.hpp ) for explanation
-	template<typename Graph, typename NameMap, typename VertexMap>
-	typename boost::graph_traits<Graph>::vertex_descriptor addNamedVertex(Graph& g, NameMap nm, const std::string& name, VertexMap& vm);
+	typedef boost::dynamic_bitset<> VertexSet;
 
-	//function to create a graph out of the given distanceMatrix
-	template<typename Graph>
-	void createGraph(Graph& graph, cv::Mat& distance_Matrix);
+	//function to create the adjacency sets of the graph out of the given distance matrix, edges that are longer than maxval
+	//are cut
+	void createGraph(std::vector<VertexSet>& adjacency, const cv::Mat& distance_matrix, const double maxval);
 
-	//function to set too long paths in the distance_matrix to zero
-	void cutTooLongEdges(cv::Mat& complete_distance_matrix, double maxval);
+	//function to get the vertices ordered by their degeneracy (repeatedly taking the vertex of smallest remaining degree)
+	std::vector<int> getDegeneracyOrdering(const std::vector<VertexSet>& adjacency);
+
+	//recursive Bron-Kerbosch with Tomita pivoting: reports all maximal cliques that contain the vertices of current_clique,
+	//some of the candidates and none of the excluded vertices
+	void findCliques(const std::vector<VertexSet>& adjacency, std::vector<int>& current_clique, VertexSet& candidates,
+			VertexSet& excluded, std::vector<std::vector<int> >& cliques);
+
+	StopCondition stop_condition_;
 
 public:
 	cliqueFinder();
 
+	//sets the condition that stops the search early (see StopCondition), an empty function removes it
+	void setStopCondition(const StopCondition& stop_condition);
+
 	std::vector<std::vector<int> > getCliques(const cv::Mat& distance_matrix, double maxval);
 };
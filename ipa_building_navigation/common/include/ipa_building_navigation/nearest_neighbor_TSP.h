@@ -14,6 +14,7 @@
 #include <ipa_building_navigation/contains.h>
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/anytime_tsp_solver.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -31,7 +32,7 @@
 //		| 1.2 9.0  88.0 0.0  0.0 |
 //		---					   ---
 
-class NearestNeighborTSPSolver
+class NearestNeighborTSPSolver : public AnytimeTSPSolver
 {
 protected:
 
@@ -46,6 +47,9 @@ public:
 	//constructor
 	NearestNeighborTSPSolver();
 
+	//solves the TSP with the given distance matrix, see AnytimeTSPSolver
+	std::vector<int> solveTSP(const cv::Mat& path_length_matrix, const int start_node);
+
 	//Solving-algorithms for the given TSP. It returns a vector of int, which is the order from this solution. The int shows
 	//the index in the Matrix. There are two functions for different cases:
 	//		1. The distance matrix already exists
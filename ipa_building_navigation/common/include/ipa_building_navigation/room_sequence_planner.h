@@ -0,0 +1,127 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/stop_condition.h>
+#include <ipa_building_navigation/tsp_solvers.h>
+
+#pragma once //make sure this header gets included only one time when multiple classes need it in the same project
+			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
+
+// parameters of the room sequence planning
+struct RoomSequencePlanningParameters
+{
+	int planning_method;			// 1 = drag trolley if next room is too far away, 2 = calculate roomgroups and a trolleyposition for each of it
+	int tsp_solver;					// see TSPSolvers in tsp_solver_defines.h
+	double max_clique_path_length;	// max A* path length between two rooms that are assigned to the same clique, in [m]
+	int max_clique_size;			// maximal number of rooms in one clique
+	double map_downsampling_factor;	// the map is downsampled for the path planning, range of the factor (0, 1]
+	double robot_radius;			// in [m]
+	double map_resolution;			// in [m/pixel]
+	bool use_hierarchical_planner;	// plans the long single path queries with the hierarchical planner (see AStarPlanner::setHierarchicalPlanning)
+	double hierarchical_planner_min_distance;	// in [m]
+	int search_strategy;			// search of the path queries, see AStarPlanner::SearchStrategy
+
+	RoomSequencePlanningParameters()
+	: planning_method(2), tsp_solver(TSP_CONCORDE), max_clique_path_length(12.), max_clique_size(9001), map_downsampling_factor(0.25),
+	  robot_radius(0.3), map_resolution(0.05), use_hierarchical_planner(false), hierarchical_planner_min_distance(20.),
+	  search_strategy(AStarPlanner::A_STAR_SEARCH)
+	{
+	}
+};
+
+// computation times of the steps of one planning, in [s]
+struct RoomSequencePlanningStatistics
+{
+	double time_distance_matrices;	// time spent in the distance matrix cache
+	double time_cliques;			// set cover or splitting of the room sequence
+	double time_trolley_positions;
+	double time_tsp;
+
+	RoomSequencePlanningStatistics()
+	: time_distance_matrices(0.), time_cliques(0.), time_trolley_positions(0.), time_tsp(0.)
+	{
+	}
+};
+
+//This class plans the sequence in which the rooms of a map are visited and the trolley positions (checkpoints) from which
+//they are visited, it is used by the room sequence planning action server and the evaluation. There are two methods:
+//		1. Drag the trolley: the TSP of all rooms is solved and the trolley is dragged along this sequence, it is left at the
+//		   next room if that room is too far away from the trolley (max_clique_path_length) or the current clique is full.
+//		2. Room groups: the rooms are grouped by a set cover of the cliques of rooms that are close to each other, every group
+//		   gets a trolley position (TrolleyPositionFinder), then the TSP of the trolley positions and the TSP of the rooms
+//		   of each group are solved.
+//The distance matrices are taken from the given DistanceMatrixCache. The TSPs are solved with the solver of the parameters or
+//with a function that is set with setTSPSolver, e.g. to stop the solvers at a deadline and report their progress. If a stop
+//condition is set (setStopCondition), the steps before the TSPs finish early with approximate results once it is met.
+class RoomSequencePlanner
+{
+public:
+	// solves the TSP of distance_matrix beginning at start_node and returns the sequence of the nodes, stage names the TSP
+	// ("room_sequence" for all rooms of method 1, "checkpoint_sequence" for the trolley positions and "clique_sequence" for the
+	// rooms of the clique with index clique_index of method 2, clique_index is -1 for the first two), node i of the
+	// distance matrix is the room (or trolley position for "checkpoint_sequence") with the index node_indices[i]
+	typedef boost::function<std::vector<int> (const cv::Mat& distance_matrix, const int start_node, const std::string& stage,
+			const int clique_index, const std::vector<int>& node_indices)> TSPSolverFunction;
+
+	RoomSequencePlanner(DistanceMatrixCache& distance_matrix_cache);
+
+	// sets the function that solves the TSPs, if it is empty the TSP solver of the parameters is used without time limit
+	void setTSPSolver(const TSPSolverFunction& tsp_solver_function);
+
+	// sets the condition that stops the computation of the distance matrices, the cliques and the trolley positions early
+	// (see StopCondition)
+	void setStopCondition(const StopCondition& stop_condition);
+
+	// plans the sequence of the rooms (in pixel) starting at start_position, floor_plan_hash = MapPreprocessingCache::computeMapHash(floor_plan),
+	// cliques[i] receives the indices of the rooms in the order in which they are visited from trolley_positions[i], the
+	// cliques are in their order too, with method 1 the first trolley position is start_position (its clique may be empty),
+	// returns false if the planning method is not defined, if statistics is provided it receives the computation times
+	bool planSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+			const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+			std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics* statistics=NULL);
+
+	// returns the index of the position with the shortest path from start_position, if the stop condition is met the nearest
+	// position found until then is taken
+	size_t getNearestLocation(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const cv::Point& start_position,
+			const std::vector<cv::Point>& positions, const RoomSequencePlanningParameters& parameters);
+
+	// creates the TSP solver of type tsp_solver (see TSPSolvers in tsp_solver_defines.h), returns an empty pointer for an
+	// undefined type
+	static boost::shared_ptr<AnytimeTSPSolver> createTSPSolver(const int tsp_solver);
+
+protected:
+
+	// method 1, see planSequence
+	void planDragSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+			const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+			std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics& statistics);
+
+	// method 2, see planSequence
+	void planGroupSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+			const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+			std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics& statistics);
+
+	// solves a TSP with tsp_solver_function_ or the solver of the parameters (see TSPSolverFunction) and measures its time
+	std::vector<int> solveTSP(const cv::Mat& distance_matrix, const int start_node, const std::string& stage, const int clique_index,
+			const std::vector<int>& node_indices, const RoomSequencePlanningParameters& parameters, RoomSequencePlanningStatistics& statistics);
+
+	// takes the distance matrix of the points from the cache and measures its time
+	void getDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& floor_plan, const unsigned long long floor_plan_hash,
+			const std::vector<cv::Point>& points, const RoomSequencePlanningParameters& parameters, RoomSequencePlanningStatistics& statistics);
+
+	// sets the search strategy and the hierarchical planning of the parameters for path_planner_
+	void setupPathPlanner(const RoomSequencePlanningParameters& parameters);
+
+	DistanceMatrixCache& distance_matrix_cache_;
+	TSPSolverFunction tsp_solver_function_;
+	StopCondition stop_condition_;
+	AStarPlanner path_planner_;
+};
@@ -18,6 +18,8 @@
 #include <ipa_building_navigation/maximal_clique_finder.h>
 #include <ipa_building_navigation/distance_matrix.h>
 
+#include <boost/dynamic_bitset.hpp>
+
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
@@ -25,10 +27,16 @@
 //algorithm, which takes the clique with most unvisited nodes before the other nodes and removes the nodes in it from the
 //unvisited. It repeats this step until no more node hasn't been visited. It then merges cliques together that have at least
 //one node in common.
+//The greedy search is lazy: the nodes are stored as bitsets and the cliques are kept in a priority queue with the number of
+//unvisited nodes they had when they were inserted. This number can only decrease, so only the clique at the top of the queue
+//has to be counted again, it is taken if it is still the best one, else it is inserted again with its new number. Optionally
+//each clique has a cost, then the clique with most unvisited nodes per cost is taken (weighted set cover).
 //
 //!!!!!!!!!!!!!!!!Important!!!!!!!!!!!!!!!!!
 //Make sure that the cliques cover all nodes in the graph or else this algorithm runs into an endless loop. For best results
 //take the cliques from a maximal-clique finder like the Bron-Kerbosch algorithm.
+//A stop condition (setStopCondition) stops the search for the maximal cliques, the set cover is then solved with the cliques
+//found so far and the single nodes.
 
 class SetCoverSolver
 {
@@ -42,9 +50,22 @@ protected:
 	//for further information.
 	cliqueFinder maximal_clique_finder;
 
+	StopCondition stop_condition_;
+
+	typedef boost::dynamic_bitset<> NodeSet;
+
 	//function to merge groups together, which have at least one node in common
 	std::vector<std::vector<int> > mergeGroups(const std::vector<std::vector<int> >& found_groups);
 
+	//lazy greedy search for the set cover, clique_costs may be empty (every clique costs 1), see set_cover_solver.cpp
+	std::vector<std::vector<int> > solveGreedySetCover(const std::vector<std::vector<int> >& given_cliques, const std::vector<double>& clique_costs,
+			const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix);
+
+	//function to split a clique that is too big into cliques of the allowed size by iteratively removing the node farthest
+	//away from the other nodes, the found cliques are appended to minimal_set
+	void splitClique(std::vector<int> big_clique, const int max_number_of_clique_members, const cv::Mat& distance_matrix,
+			std::vector<std::vector<int> >& minimal_set);
+
 //	//Function to construct the distance matrix, showing the pathlength from node to node
 //	void constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
 //	        double downsampling_factor, double robot_radius, double map_resolution);
@@ -53,6 +74,10 @@ public:
 	//Constructor
 	SetCoverSolver();
 
+	//sets the condition that stops the search for the maximal cliques and the computation of the distance matrix early (see
+	//StopCondition)
+	void setStopCondition(const StopCondition& stop_condition);
+
 	//algorithms to solve the set cover problem. There are three functions for different cases:
 	//		1. The cliques already have been found
 	//		2. The distance matrix already exists
@@ -62,6 +87,10 @@ public:
 	std::vector<std::vector<int> > solveSetCover(std::vector<std::vector<int> >& given_cliques, const int number_of_nodes,
 			const int max_number_of_clique_members, const cv::Mat& distance_matrix);
 
+	//cliques and their costs (> 0) are given, the clique with most uncovered nodes per cost is chosen first
+	std::vector<std::vector<int> > solveWeightedSetCover(const std::vector<std::vector<int> >& given_cliques, const std::vector<double>& clique_costs,
+			const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix);
+
 	//the distance matrix is given
 	std::vector<std::vector<int> > solveSetCover(const cv::Mat& distance_matrix, const std::vector<cv::Point>& points,
 			const int number_of_nodes, double maximal_pathlength, const int max_number_of_clique_members);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <boost/function.hpp>
+
+//Function that long computations of the sequence planning (distance matrices, set cover, trolley positions) poll between
+//their single steps, e.g. between two path searches. If it returns true, the computation finishes early with an approximate
+//result, see the classes that take it. It may be called from several threads at once. An empty function never stops.
+typedef boost::function<bool ()> StopCondition;
+
+//returns true if stop_condition is set and requests to stop
+inline bool isStopConditionMet(const StopCondition& stop_condition)
+{
+	return (stop_condition && stop_condition());
+}
@@ -15,6 +15,9 @@
 #include <ipa_building_navigation/contains.h>
 
 #include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/stop_condition.h>
+
+#include <boost/thread.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -23,6 +26,9 @@
 //the Point where the trolley of a robot should be placed during the cleaning of the group. This is done by searching in the
 //bounding box of these points for the point which minimizes the pathlength to every group member. If the goup has only two
 //members the algorithm chooses a Point on the optimal path between these two Points that is in the middlest of this path.
+//The pathlengths from each group member to all cells are computed with one Dijkstra search (wavefront) per member, the sum
+//of these distance fields gives the summed pathlength of every possible trolley position at once. The groups are processed
+//in parallel, every thread uses its own pathplanner.
 //This algorithm needs as input:
 //		1. The original occupancy gridmap to get the pathlength between two Points.
 //		2. A vector of found groups. This vector stores the group as integer that show the Position of the node in the
@@ -35,6 +41,8 @@
 //		   calculationtime. It has to be (0, 1]. If it is 1 the map will be took as it is.
 //		5. The Radius of the robot and the map resolution to make sure the A_star pathplanner stays in enough distance to the
 //		   walls and obstacles. (See A_star_pathplanner.cpp for further information)
+//If a stop condition is set (setStopCondition), it is checked before each search, once it is met the remaining groups get
+//their first member as trolley position.
 
 class TrolleyPositionFinder
 {
@@ -42,15 +50,34 @@ protected:
 
 	AStarPlanner path_planner_; //Object to plan a path from Point A to Point B in a given gridmap
 
+	StopCondition stop_condition_;
+
+	// hands out the groups to the computing threads
+	struct GroupQueue
+	{
+		GroupQueue() : next_group(0) {}
+
+		int next_group;
+		boost::mutex mutex;
+	};
+
 	//Function to find a trolley position for one group
 	cv::Point findOneTrolleyPosition(const std::vector<cv::Point> group_points, const cv::Mat& original_map,
-			const double downsampling_factor, const double robot_radius, const double map_resolution);
+			const cv::Mat& downsampled_map, const double downsampling_factor, AStarPlanner& path_planner);
+
+	//Function that finds the trolley positions of the groups that are taken from next_group until all groups are done
+	void findTrolleyPositionsOfGroups(const cv::Mat& original_map, const cv::Mat& downsampled_map, const std::vector<std::vector<int> >& found_groups,
+			const std::vector<cv::Point>& room_centers, const double downsampling_factor, std::vector<cv::Point>& trolley_positions,
+			GroupQueue& group_queue);
 
 public:
 
 	//constructor
 	TrolleyPositionFinder();
 
+	//sets the condition that stops the search for the trolley positions early (see StopCondition)
+	void setStopCondition(const StopCondition& stop_condition);
+
 	//Function to find a trolley position for each group by using the findOneTrolleyPosition function
 	std::vector<cv::Point> findTrolleyPositions(const cv::Mat& original_map, const std::vector<std::vector<int> >& found_groups,
 			const std::vector<cv::Point>& room_centers, const double downsampling_factor, const double robot_radius,
@@ -60,4 +60,4 @@
 #pragma once
 
 
-enum TSPSolvers {TSP_NEAREST_NEIGHBOR=1, TSP_GENETIC=2, TSP_CONCORDE=3};
+enum TSPSolvers {TSP_NEAREST_NEIGHBOR=1, TSP_GENETIC=2, TSP_CONCORDE=3, TSP_LIN_KERNIGHAN=4};
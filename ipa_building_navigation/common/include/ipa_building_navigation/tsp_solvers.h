@@ -65,3 +65,4 @@
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/genetic_TSP.h>
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/lin_kernighan_TSP.h>
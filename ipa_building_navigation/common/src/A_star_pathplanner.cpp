@@ -1,49 +1,102 @@
 #include <ipa_building_navigation/A_star_pathplanner.h>
 
 #include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+#include <ipa_building_navigation/hierarchical_path_planner.h>
+
+#include <algorithm>
 
 const int dir = 8; // number of possible directions to go at any position
 // if dir==4
 //static int dx[dir]={1, 0, -1, 0};
 //static int dy[dir]={0, 1, 0, -1};
 // if dir==8
-static int dx[dir] =
+static const int dx[dir] =
 { 1, 1, 0, -1, -1, -1, 0, 1 };
-static int dy[dir] =
+static const int dy[dir] =
 { 0, 1, 1, 1, 0, -1, -1, -1 };
 
-static int expanding_counter = 0;
+// give better priority to going strait instead of diagonally
+static const int straight_cost = 10;
+static const int diagonal_cost = 14;
+
+// Estimation function for the remaining distance to the goal (octile distance with the step costs from above), it never
+// overestimates the real costs, so the found routes are still the shortest ones
+static inline int estimate(const int x, const int y, const int x_goal, const int y_goal)
+{
+	const int xd = abs(x_goal - x);
+	const int yd = abs(y_goal - y);
+	return (xd > yd ? straight_cost*xd + (diagonal_cost-straight_cost)*yd : straight_cost*yd + (diagonal_cost-straight_cost)*xd);
+}
 
-// Determine priority (in the priority queue)
-bool operator<(const NodeAstar& a, const NodeAstar& b)
+// index of the direction (x_step, y_step) in dx and dy
+static inline int getDirection(const int x_step, const int y_step)
 {
-	return a.getPriority() > b.getPriority();
+	for (int i = 0; i < dir; i++)
+		if (dx[i] == x_step && dy[i] == y_step)
+			return i;
+	return 0;
 }
 
 AStarPlanner::AStarPlanner()
+: rows_(0), cols_(0), current_generation_(0), search_strategy_(A_STAR_SEARCH), use_hierarchical_planner_(false),
+  hierarchical_planner_min_distance_(0.), hierarchical_planner_cluster_size_(16), hierarchical_planner_has_map_(false),
+  hierarchical_planner_map_hash_(0), hierarchical_planner_downsampling_factor_(1.), hierarchical_planner_robot_radius_(0.),
+  hierarchical_planner_map_resolution_(1.)
+{
+}
+
+void AStarPlanner::setSearchStrategy(const SearchStrategy search_strategy)
 {
-	n = 1;
-	m = 1;
+	search_strategy_ = search_strategy;
 }
 
-void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const std::string& route, double step_length)
+void AStarPlanner::setHierarchicalPlanning(const bool use_hierarchical_planner, const double min_distance, const int cluster_size)
+{
+	use_hierarchical_planner_ = use_hierarchical_planner;
+	hierarchical_planner_min_distance_ = min_distance;
+	if (cluster_size != hierarchical_planner_cluster_size_)
+		hierarchical_planner_has_map_ = false;
+	hierarchical_planner_cluster_size_ = cluster_size;
+}
+
+bool AStarPlanner::planHierarchicalPath(const cv::Mat& downsampled_map, const cv::Point& start_point, const cv::Point& end_point,
+		const double downsampling_factor, double& path_length)
+{
+	// the cached downsampled maps are not changed, so the map of the last downsampleMap call is recognized by its data, which
+	// stays valid as long as hierarchical_planner_map_ refers to it
+	if (use_hierarchical_planner_ == false || hierarchical_planner_map_.empty() == true || downsampled_map.data != hierarchical_planner_map_.data
+			|| downsampled_map.rows != hierarchical_planner_map_.rows || downsampled_map.cols != hierarchical_planner_map_.cols
+			|| downsampling_factor != hierarchical_planner_downsampling_factor_ || cv::norm(end_point-start_point) < hierarchical_planner_min_distance_)
+		return false;
+
+	if (hierarchical_planner_has_map_ == false)
+	{
+		if (!hierarchical_planner_)
+			hierarchical_planner_.reset(new HierarchicalPathPlanner());
+		hierarchical_planner_->setMap(hierarchical_planner_map_hash_, hierarchical_planner_map_, hierarchical_planner_downsampling_factor_,
+				hierarchical_planner_robot_radius_, hierarchical_planner_map_resolution_, hierarchical_planner_cluster_size_);
+		hierarchical_planner_has_map_ = true;
+	}
+
+	// if the abstract graph has no path, the usual search decides (e.g. on the original map)
+	path_length = hierarchical_planner_->planPath(start_point, end_point);
+	return (path_length < 1e90);
+}
+
+void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const std::vector<cv::Point>& route, double step_length)
 {
 	// follow the route on the map and update the path length
-	if (route.length() > 0)
+	if (route.size() > 1)
 	{
-		int j;
-		char c;
 		int x1 = start_point.x;
 		int y1 = start_point.y;
 		int x2,y2;
-		for (int i = 0; i < route.length(); i++)
+		for (size_t i = 1; i < route.size(); i++)
 		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route.at(i);
-			j=c-'0';
-			x2 = x1 + dx[j]*step_length;
-			y2 = y1 + dy[j]*step_length;
-			const double progress = 0.2 + 0.6*(double)i/(double)route.length();
+			x2 = x1 + (route[i].x-route[i-1].x)*step_length;
+			y2 = y1 + (route[i].y-route[i-1].y)*step_length;
+			const double progress = 0.2 + 0.6*(double)(i-1)/(double)(route.size()-1);
 			cv::line(map, cv::Point(x1,y1), cv::Point(x2,y2), CV_RGB(0,progress*255,0), 1);
 			x1 = x2;
 			y1 = y2;
@@ -51,25 +104,20 @@ void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const st
 	}
 }
 
-void AStarPlanner::getRoute(const cv::Point start_point, const std::string& route,
+void AStarPlanner::getRoute(const cv::Point start_point, const std::vector<cv::Point>& route,
 		double step_length, std::vector<cv::Point>& route_points)
 {
 	// follow the route on the map and update the path length
-	if (route.length() > 0)
+	if (route.size() > 1)
 	{
-		int j;
-		char c;
 		int x1 = start_point.x;
 		int y1 = start_point.y;
 		route_points.push_back(cv::Point(x1, y1));
 		int x2,y2;
-		for (int i = 0; i < route.length(); i++)
+		for (size_t i = 1; i < route.size(); i++)
 		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route.at(i);
-			j=c-'0';
-			x2 = x1 + dx[j]*step_length;
-			y2 = y1 + dy[j]*step_length;
+			x2 = x1 + (route[i].x-route[i-1].x)*step_length;
+			y2 = y1 + (route[i].y-route[i-1].y)*step_length;
 			route_points.push_back(cv::Point(x2, y2));
 			x1 = x2;
 			y1 = y2;
@@ -79,167 +127,433 @@ void AStarPlanner::getRoute(const cv::Point start_point, const std::string& rout
 
 void AStarPlanner::downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution)
 {
-	//erode the map so the planner doesn't go near the walls
-	//	--> calculate the number of times for eroding from Robot Radius [m]
-	cv::Mat eroded_map;
-	int number_of_erosions = (robot_radius / map_resolution);
-	cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1, -1), number_of_erosions);
-	//downsampling of the map to reduce calculation time
-	if (downsampling_factor != 1.)
-		cv::resize(eroded_map, downsampled_map, cv::Size(0, 0), downsampling_factor, downsampling_factor, cv::INTER_NEAREST);//_LINEAR);
+	//erode the map so the planner doesn't go near the walls and downsample it to reduce calculation time
+	//	--> the result is shared with all other users of the same map in this process, so it is computed only once
+	if (use_hierarchical_planner_ == true)
+		downsampleMap(MapPreprocessingCache::computeMapHash(map), map, downsampled_map, downsampling_factor, robot_radius, map_resolution);	// the hash is needed for the abstract graph
 	else
-		downsampled_map = eroded_map;
+		downsampled_map = MapPreprocessingCache::getInstance().getDownsampledMap(map, downsampling_factor, robot_radius, map_resolution);
 }
 
-// A-star algorithm.
-// The route returned is a string of direction digits.
-std::string AStarPlanner::pathFind(const int & xStart, const int & yStart, const int & xFinish, const int & yFinish, const cv::Mat& map)
+void AStarPlanner::downsampleMap(const unsigned long long map_hash, const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor,
+		const double robot_radius, const double map_resolution)
 {
-	static std::priority_queue<NodeAstar> pq[2]; // list of open (not-yet-tried) nodes
-	static int pqi; // pq index
-	static NodeAstar* n0;
-	static NodeAstar* m0;
-	static int i, j, x, y, xdx, ydy;
-	static char c;
-	pqi = 0;
+	downsampled_map = MapPreprocessingCache::getInstance().getDownsampledMap(map_hash, map, downsampling_factor, robot_radius, map_resolution);
+
+	// remember the map for the hierarchical planner, its abstract graph is only built if a long query needs it
+	if (use_hierarchical_planner_ == true && (downsampled_map.data != hierarchical_planner_map_.data || map_hash != hierarchical_planner_map_hash_
+			|| downsampling_factor != hierarchical_planner_downsampling_factor_ || robot_radius != hierarchical_planner_robot_radius_
+			|| map_resolution != hierarchical_planner_map_resolution_))
+	{
+		hierarchical_planner_map_ = downsampled_map;
+		hierarchical_planner_map_hash_ = map_hash;
+		hierarchical_planner_downsampling_factor_ = downsampling_factor;
+		hierarchical_planner_robot_radius_ = robot_radius;
+		hierarchical_planner_map_resolution_ = map_resolution;
+		hierarchical_planner_has_map_ = false;
+	}
+}
 
-	cv::Mat map_to_calculate_path(cv::Size(m, n), CV_32S);
+void AStarPlanner::setMap(const cv::Mat& map)
+{
+	map_ = map;
+	rows_ = map.rows;
+	cols_ = map.cols;
 
-	// create map from the given eroded map
-	for (int y = 0; y < map.rows; y++)
+	// the buffers only need to be enlarged, entries of former searches are invalid anyway because of the generation stamps
+	const size_t number_of_cells = (size_t)rows_*(size_t)cols_;
+	if (generation_.size() < number_of_cells)
 	{
-		for (int x = 0; x < map.cols; x++)
-		{
-			if (map.at<unsigned char>(y, x) == 255)
-			{
-				map_to_calculate_path.at<int>(x, y) = 0;
-			}
-			else
-			{
-				map_to_calculate_path.at<int>(x, y) = 1;
-			}
-		}
+		generation_.resize(number_of_cells, 0);
+		cost_.resize(number_of_cells);
+		closed_.resize(number_of_cells);
+		parent_direction_.resize(number_of_cells);
+		parent_steps_.resize(number_of_cells);
+		heap_position_.resize(number_of_cells);
+		heap_.reserve(number_of_cells);
+	}
+}
+
+void AStarPlanner::startSearch()
+{
+	heap_.clear();
+	++current_generation_;
+	// after an overflow of the counter the old stamps could be mistaken for valid ones
+	if (current_generation_ == 0)
+	{
+		std::fill(generation_.begin(), generation_.end(), 0);
+		current_generation_ = 1;
 	}
+}
+
+void AStarPlanner::pushHeap(const int cell, const int priority)
+{
+	HeapNode node;
+	node.priority = priority;
+	node.cell = cell;
+	heap_.push_back(node);
+	heap_position_[cell] = heap_.size()-1;
+	siftUp(heap_.size()-1);
+}
 
-	cv::Mat closed_nodes_map(cv::Size(m, n), CV_32S); //map of already tried nodes
-	cv::Mat open_nodes_map(cv::Size(m, n), CV_32S); // map of open (not-yet-tried) nodes
-	cv::Mat dir_map(cv::Size(m, n), CV_32S); // map of directions
+int AStarPlanner::popHeap()
+{
+	const int cell = heap_[0].cell;
+	heap_[0] = heap_.back();
+	heap_position_[heap_[0].cell] = 0;
+	heap_.pop_back();
+	if (heap_.empty() == false)
+		siftDown(0);
+	return cell;
+}
+
+void AStarPlanner::decreaseKey(const int cell, const int priority)
+{
+	const int position = heap_position_[cell];
+	heap_[position].priority = priority;
+	siftUp(position);
+}
+
+void AStarPlanner::siftUp(int position)
+{
+	const HeapNode node = heap_[position];
+	while (position > 0)
+	{
+		const int parent = (position-1)/2;
+		if (heap_[parent].priority <= node.priority)
+			break;
+		heap_[position] = heap_[parent];
+		heap_position_[heap_[position].cell] = position;
+		position = parent;
+	}
+	heap_[position] = node;
+	heap_position_[node.cell] = position;
+}
 
-	// initialize the node maps
-	for (y = 0; y < closed_nodes_map.rows; y++)
+void AStarPlanner::siftDown(int position)
+{
+	const HeapNode node = heap_[position];
+	const int size = heap_.size();
+	while (true)
 	{
-		for (x = 0; x < closed_nodes_map.cols; x++)
+		int child = 2*position+1;
+		if (child >= size)
+			break;
+		if (child+1 < size && heap_[child+1].priority < heap_[child].priority)
+			++child;
+		if (node.priority <= heap_[child].priority)
+			break;
+		heap_[position] = heap_[child];
+		heap_position_[heap_[position].cell] = position;
+		position = child;
+	}
+	heap_[position] = node;
+	heap_position_[node.cell] = position;
+}
+
+void AStarPlanner::reconstructRoute(const int cell)
+{
+	// generate the path from finish to start by following the directions
+	route_.clear();
+	int x = cell % cols_;
+	int y = cell / cols_;
+	route_.push_back(cv::Point(x, y));
+	int current_cell = cell;
+	while (cost_[current_cell] > 0)
+	{
+		const int j = parent_direction_[current_cell];
+		x += dx[j];
+		y += dy[j];
+		current_cell = y*cols_ + x;
+		route_.push_back(cv::Point(x, y));
+	}
+	std::reverse(route_.begin(), route_.end());
+}
+
+void AStarPlanner::startAtCell(const cv::Point& start, const int priority)
+{
+	// create the start node and push into list of open nodes
+	const int start_cell = start.y*cols_ + start.x;
+	generation_[start_cell] = current_generation_;
+	cost_[start_cell] = 0;
+	closed_[start_cell] = 0;
+	pushHeap(start_cell, priority);
+}
+
+void AStarPlanner::expandCell(const int cell, const cv::Point& goal, const bool use_estimate)
+{
+	// generate moves (child nodes) in all possible directions
+	const int x = cell % cols_;
+	const int y = cell / cols_;
+	for (int i = 0; i < dir; i++)
+	{
+		const int xdx = x + dx[i];
+		const int ydy = y + dy[i];
+		if (xdx < 0 || xdx >= cols_ || ydy < 0 || ydy >= rows_ || map_.ptr<unsigned char>(ydy)[xdx] != 255)
+			continue;
+
+		const int child = ydy*cols_ + xdx;
+		const int child_cost = cost_[cell] + (i % 2 == 0 ? straight_cost : diagonal_cost);
+		if (generation_[child] != current_generation_)
+		{
+			// if it is not in the open list then add into that and mark its parent node direction
+			generation_[child] = current_generation_;
+			cost_[child] = child_cost;
+			closed_[child] = 0;
+			parent_direction_[child] = (i + dir / 2) % dir;
+			pushHeap(child, child_cost + (use_estimate ? estimate(xdx, ydy, goal.x, goal.y) : 0));
+		}
+		else if (closed_[child] == 0 && child_cost < cost_[child])
 		{
-			closed_nodes_map.at<int>(y, x) = 0;
-			open_nodes_map.at<int>(y, x) = 0;
+			// update the priority and the parent direction info
+			cost_[child] = child_cost;
+			parent_direction_[child] = (i + dir / 2) % dir;
+			decreaseKey(child, child_cost + (use_estimate ? estimate(xdx, ydy, goal.x, goal.y) : 0));
 		}
 	}
+}
 
-	// create the start node and push into list of open nodes
-	n0 = new NodeAstar(xStart, yStart, 0, 0);
-	n0->updatePriority(xFinish, yFinish);
-	pq[pqi].push(*n0);
-	open_nodes_map.at<int>(xStart, yStart) = n0->getPriority(); // mark it on the open nodes map
+// A-star algorithm.
+// The route is stored in route_ as sequence of cells.
+bool AStarPlanner::pathFind(const cv::Point& start, const cv::Point& goal)
+{
+	startSearch();
+	route_.clear();
 
-	//garbage collection
-	delete n0;
+	const int goal_cell = goal.y*cols_ + goal.x;
+	startAtCell(start, estimate(start.x, start.y, goal.x, goal.y));
 
 	// A* search
-	while (!pq[pqi].empty())
+	while (heap_.empty() == false)
 	{
-		// get the current node w/ the highest priority
-		// from the list of open nodes
-		n0 = new NodeAstar(pq[pqi].top().getxPos(), pq[pqi].top().getyPos(), pq[pqi].top().getLevel(), pq[pqi].top().getPriority());
+		// get the current node w/ the highest priority from the list of open nodes and mark it as closed
+		const int cell = popHeap();
+		closed_[cell] = 1;
+
+		// quit searching when the goal state is reached
+		if (cell == goal_cell)
+		{
+			reconstructRoute(cell);
+			return true;
+		}
+
+		expandCell(cell, goal, true);
+	}
+	return false; // no route found
+}
 
-		x = n0->getxPos();
-		y = n0->getyPos();
+int AStarPlanner::jump(int x, int y, const int direction, const int goal_cell, int& steps) const
+{
+	const int x_step = dx[direction];
+	const int y_step = dy[direction];
+	steps = 0;
+	while (true)
+	{
+		x += x_step;
+		y += y_step;
+		++steps;
+		if (isAccessible(x, y) == false)
+			return -1;
+		const int cell = y*cols_ + x;
+		if (cell == goal_cell)
+			return cell;
+
+		if (x_step != 0 && y_step != 0)
+		{
+			// diagonal move: forced neighbors behind the obstacles next to the cell or a jump point in one of the straight directions
+			if ((isAccessible(x-x_step, y) == false && isAccessible(x-x_step, y+y_step) == true) ||
+					(isAccessible(x, y-y_step) == false && isAccessible(x+x_step, y-y_step) == true))
+				return cell;
+			int straight_steps = 0;
+			if (jump(x, y, getDirection(x_step, 0), goal_cell, straight_steps) >= 0 || jump(x, y, getDirection(0, y_step), goal_cell, straight_steps) >= 0)
+				return cell;
+		}
+		else if (x_step != 0)
+		{
+			// horizontal move: forced neighbors behind the obstacles above or below the cell
+			if ((isAccessible(x, y+1) == false && isAccessible(x+x_step, y+1) == true) ||
+					(isAccessible(x, y-1) == false && isAccessible(x+x_step, y-1) == true))
+				return cell;
+		}
+		else
+		{
+			// vertical move: forced neighbors behind the obstacles left or right of the cell
+			if ((isAccessible(x+1, y) == false && isAccessible(x+1, y+y_step) == true) ||
+					(isAccessible(x-1, y) == false && isAccessible(x-1, y+y_step) == true))
+				return cell;
+		}
+	}
+}
 
-		pq[pqi].pop(); // remove the node from the open list
-		open_nodes_map.at<int>(x, y) = 0;
-		// mark it on the closed nodes map
-		closed_nodes_map.at<int>(x, y) = 1;
+void AStarPlanner::expandJumpPoints(const int cell, const int goal_cell, const cv::Point& goal)
+{
+	const int x = cell % cols_;
+	const int y = cell / cols_;
 
-		// quit searching when the goal state is reached
-		//if((*n0).estimate(xFinish, yFinish) == 0)
-		if (x == xFinish && y == yFinish)
+	// directions to search: all from the start cell, else the natural and the forced neighbors of the move from the parent
+	int directions[dir];
+	int number_of_directions = 0;
+	if (cost_[cell] == 0)
+	{
+		for (int i = 0; i < dir; i++)
+			directions[number_of_directions++] = i;
+	}
+	else
+	{
+		const int travel_direction = (parent_direction_[cell] + dir / 2) % dir;
+		const int x_step = dx[travel_direction];
+		const int y_step = dy[travel_direction];
+		directions[number_of_directions++] = travel_direction;
+		if (x_step != 0 && y_step != 0)
 		{
-			// generate the path from finish to start
-			// by following the directions
-			std::string path = "";
-			while (!(x == xStart && y == yStart))
-			{
-				j = dir_map.at<int>(x, y);
-				c = '0' + (j + dir / 2) % dir;
-				path = c + path;
-				x += dx[j];
-				y += dy[j];
-			}
+			directions[number_of_directions++] = getDirection(x_step, 0);
+			directions[number_of_directions++] = getDirection(0, y_step);
+			if (isAccessible(x-x_step, y) == false)
+				directions[number_of_directions++] = getDirection(-x_step, y_step);
+			if (isAccessible(x, y-y_step) == false)
+				directions[number_of_directions++] = getDirection(x_step, -y_step);
+		}
+		else if (x_step != 0)
+		{
+			if (isAccessible(x, y+1) == false)
+				directions[number_of_directions++] = getDirection(x_step, 1);
+			if (isAccessible(x, y-1) == false)
+				directions[number_of_directions++] = getDirection(x_step, -1);
+		}
+		else
+		{
+			if (isAccessible(x+1, y) == false)
+				directions[number_of_directions++] = getDirection(1, y_step);
+			if (isAccessible(x-1, y) == false)
+				directions[number_of_directions++] = getDirection(-1, y_step);
+		}
+	}
 
-			delete n0;// garbage collection
-			// empty the leftover nodes
-			while (!pq[pqi].empty())
-				pq[pqi].pop();
-			return path;
+	// open the found jump points or update their costs like expandCell does for the neighbors
+	for (int d = 0; d < number_of_directions; d++)
+	{
+		const int i = directions[d];
+		int steps = 0;
+		const int child = jump(x, y, i, goal_cell, steps);
+		if (child < 0)
+			continue;
+
+		const int child_cost = cost_[cell] + steps * (i % 2 == 0 ? straight_cost : diagonal_cost);
+		const int child_x = child % cols_;
+		const int child_y = child / cols_;
+		if (generation_[child] != current_generation_)
+		{
+			generation_[child] = current_generation_;
+			cost_[child] = child_cost;
+			closed_[child] = 0;
+			parent_direction_[child] = (i + dir / 2) % dir;
+			parent_steps_[child] = steps;
+			pushHeap(child, child_cost + estimate(child_x, child_y, goal.x, goal.y));
 		}
+		else if (closed_[child] == 0 && child_cost < cost_[child])
+		{
+			cost_[child] = child_cost;
+			parent_direction_[child] = (i + dir / 2) % dir;
+			parent_steps_[child] = steps;
+			decreaseKey(child, child_cost + estimate(child_x, child_y, goal.x, goal.y));
+		}
+	}
+}
+
+// Jump Point Search, i.e. A* that only opens jump points.
+// The route is stored in route_ as sequence of cells.
+bool AStarPlanner::pathFindJumpPoints(const cv::Point& start, const cv::Point& goal)
+{
+	startSearch();
+	route_.clear();
+
+	const int goal_cell = goal.y*cols_ + goal.x;
+	startAtCell(start, estimate(start.x, start.y, goal.x, goal.y));
+
+	while (heap_.empty() == false)
+	{
+		const int cell = popHeap();
+		closed_[cell] = 1;
 
-		// generate moves (child nodes) in all possible directions
-		for (i = 0; i < dir; i++)
+		if (cell == goal_cell)
 		{
-			xdx = x + dx[i];
-			ydy = y + dy[i];
+			reconstructJumpPointRoute(cell);
+			return true;
+		}
 
-			expanding_counter++;
+		expandJumpPoints(cell, goal_cell, goal);
+	}
+	return false; // no route found
+}
 
-			if (!(xdx < 0 || xdx > n - 1 || ydy < 0 || ydy > m - 1 || map_to_calculate_path.at<int>(xdx, ydy) == 1 || closed_nodes_map.at<int>(xdx, ydy) == 1))
-			{
-				// generate a child node
-				m0 = new NodeAstar(xdx, ydy, n0->getLevel(), n0->getPriority());
-				m0->nextLevel(i);
-				m0->updatePriority(xFinish, yFinish);
+void AStarPlanner::reconstructJumpPointRoute(const int cell)
+{
+	// follow the directions from jump point to jump point back to the start and add the cells in between
+	route_.clear();
+	int x = cell % cols_;
+	int y = cell / cols_;
+	route_.push_back(cv::Point(x, y));
+	int current_cell = cell;
+	while (cost_[current_cell] > 0)
+	{
+		const int j = parent_direction_[current_cell];
+		const int steps = parent_steps_[current_cell];
+		for (int step = 0; step < steps; ++step)
+		{
+			x += dx[j];
+			y += dy[j];
+			route_.push_back(cv::Point(x, y));
+		}
+		current_cell = y*cols_ + x;
+	}
+	std::reverse(route_.begin(), route_.end());
+}
 
-				// if it is not in the open list then add into that
-				if (open_nodes_map.at<int>(xdx, ydy) == 0)
-				{
-					open_nodes_map.at<int>(xdx, ydy) = m0->getPriority();
-					pq[pqi].push(*m0);
-					// mark its parent node direction
-					dir_map.at<int>(xdx, ydy) = (i + dir / 2) % dir;
-				}
-				else if (open_nodes_map.at<int>(xdx, ydy) > m0->getPriority())
-				{
-					// update the priority info
-					open_nodes_map.at<int>(xdx, ydy) = m0->getPriority();
-					// update the parent direction info
-					dir_map.at<int>(xdx, ydy) = (i + dir / 2) % dir;
-
-					// replace the node
-					// by emptying one pq to the other one
-					// except the node to be replaced will be ignored
-					// and the new node will be pushed in instead
-					while (!(pq[pqi].top().getxPos() == xdx && pq[pqi].top().getyPos() == ydy))
-					{
-						pq[1 - pqi].push(pq[pqi].top());
-						pq[pqi].pop();
-					}
-					pq[pqi].pop(); // remove the wanted node
+// Dijkstra algorithm, i.e. A* without estimate, that settles all target cells.
+void AStarPlanner::pathFindToTargets(const cv::Point& start, std::vector<int> target_cells)
+{
+	startSearch();
+	route_.clear();
+
+	// the search is finished when every (distinct) target cell has been closed
+	std::sort(target_cells.begin(), target_cells.end());
+	target_cells.erase(std::unique(target_cells.begin(), target_cells.end()), target_cells.end());
+	size_t remaining_targets = target_cells.size();
+	if (remaining_targets == 0)
+		return;
+
+	startAtCell(start, 0);
+	while (heap_.empty() == false)
+	{
+		const int cell = popHeap();
+		closed_[cell] = 1;
 
-					// empty the larger size pq to the smaller one
-					if (pq[pqi].size() > pq[1 - pqi].size())
-						pqi = 1 - pqi;
-					while (!pq[pqi].empty())
-					{
-						pq[1 - pqi].push(pq[pqi].top());
-						pq[pqi].pop();
-					}
-					pqi = 1 - pqi;
-					pq[pqi].push(*m0); // add the better node instead
-				}
-				delete m0; // garbage collection
-			}
+		if (std::binary_search(target_cells.begin(), target_cells.end(), cell) == true)
+		{
+			--remaining_targets;
+			if (remaining_targets == 0)
+				return;
 		}
-		delete n0; // garbage collection
+
+		expandCell(cell, start, false);
+	}
+}
+
+double AStarPlanner::getRouteLength(const std::vector<cv::Point>& route, const double step_length)
+{
+	//Update the pathlength with the directions of the path. When the path goes vertical or horizontal add length 1.
+	//When it goes diagonal add sqrt(2)
+	const double straight_step = step_length;
+	const double diagonal_step = std::sqrt(2.) * step_length;
+	double path_length = 0.;
+	for (size_t i = 1; i < route.size(); i++)
+	{
+		if (route[i].x == route[i-1].x || route[i].y == route[i-1].y)
+			path_length += straight_step;
+		else
+			path_length += diagonal_step;
 	}
-	return ""; // no route found
+	return path_length;
 }
 
 //This is the path planning algorithm for this class. It downsamples the map with the given factor (0 < factor < 1) so the
@@ -250,12 +564,14 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 		const double downsampling_factor, const double robot_radius, const double map_resolution,
 		const int end_point_valid_neighborhood_radius, std::vector<cv::Point>* route)
 {
-	expanding_counter = 0;
 	double step_length = 1./downsampling_factor;
 
 	//length of the planned path
 	double path_length = 0;
 
+	// the route of the previous query must not be taken for the route of this query by the early returns below
+	route_.clear();
+
 	if(start_point.x == end_point.x && start_point.y == end_point.y)//if the start and end-point are the same return 0
 	{
 		return path_length;
@@ -268,8 +584,9 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 		return 1e100;
 	}
 
-	cv::Mat downsampled_map;
-	downsampleMap(map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	// the map is taken from the cache directly and not recorded for the hierarchical planner, this function is also the grid
+	// search of the queries with a downsampled map (factor 1 and no erosion, which returns the map itself without hashing it)
+	const cv::Mat downsampled_map = MapPreprocessingCache::getInstance().getDownsampledMap(map, downsampling_factor, robot_radius, map_resolution);
 
 	//transform the Pixel values to the downsampled ones
 	int start_x = downsampling_factor * start_point.x;
@@ -277,73 +594,53 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 	int end_x = downsampling_factor * end_point.x;
 	int end_y = downsampling_factor * end_point.y;
 
-	//set the sizes of the map
-	m = downsampled_map.rows;// horizontal size of the map
-	n = downsampled_map.cols;// vertical size size of the map
+	// the rounding of the downsampling may move the points out of the downsampled map
+	if (start_x >= downsampled_map.cols || start_y >= downsampled_map.rows || end_x >= downsampled_map.cols || end_y >= downsampled_map.rows)
+	{
+		return 1e100;
+	}
 
 	// get the route
-//	clock_t start = clock();
-	route_ = pathFind(start_x, start_y, end_x, end_y, downsampled_map);
-	if (route_ == "")
+	setMap(downsampled_map);
+	const bool route_found = (search_strategy_ == JUMP_POINT_SEARCH ? pathFindJumpPoints(cv::Point(start_x, start_y), cv::Point(end_x, end_y))
+			: pathFind(cv::Point(start_x, start_y), cv::Point(end_x, end_y)));
+	if (route_found == false)
 	{
 		if (end_point_valid_neighborhood_radius > 0)
 		{
-			for (int r=1; r<=end_point_valid_neighborhood_radius; ++r)
+			// a failed Jump Point Search has only expanded the jump points, so the reachable cells are expanded with A* again
+			if (search_strategy_ == JUMP_POINT_SEARCH)
+				pathFind(cv::Point(start_x, start_y), cv::Point(end_x, end_y));
+
+			// the failed search has expanded every cell that is reachable from the start, all of them have their shortest
+			// route already stored, so the first reachable cell in the neighborhood can be taken without searching again
+			for (int r=1; r<=end_point_valid_neighborhood_radius && route_.empty(); ++r)
 			{
-				for (int dy=-r; dy<=r; ++dy)
+				for (int dy=-r; dy<=r && route_.empty(); ++dy)
 				{
 					for (int dx=-r; dx<=r; ++dx)
 					{
-						if ((abs(dy)!=r && abs(dx)!=r) || end_x+dx<0 || end_x+dx>=n || end_y+dy<0 || end_y+dy>=m)
+						if ((abs(dy)!=r && abs(dx)!=r) || end_x+dx<0 || end_x+dx>=cols_ || end_y+dy<0 || end_y+dy>=rows_)
 							continue;
-						route_ = pathFind(start_x, start_y, end_x+dx, end_y+dy, downsampled_map);
-						if (route_ != "")
+						const int cell = (end_y+dy)*cols_ + end_x+dx;
+						if (generation_[cell] == current_generation_ && closed_[cell] == 1)
+						{
+							reconstructRoute(cell);
 							break;
+						}
 					}
-					if (route_ != "")
-						break;
 				}
-				if (route_ != "")
-					break;
 			}
 		}
-		if (route_ == "")
+		if (route_.empty())
 		{
 //			std::cout << "No path from " << start_point << " to " << end_point << " found for map of size " << map.rows << "x" << map.cols << " and downsampling factor " << downsampling_factor << std::endl;
 			return 1e100; //return extremely large distance as path length if the rout could not be generated
 		}
 	}
-//	clock_t end = clock();
-//	double time_elapsed = double(end - start);
 
 	// follow the route on the map and update the path length
-	if (route_.length() > 0)
-	{
-		int j;
-		char c;
-		int x = start_x;
-		int y = start_y;
-		const double straight_step = (1. / downsampling_factor);
-		const double diagonal_step = (std::sqrt(2.) / downsampling_factor);
-		for (int i = 0; i < route_.length(); i++)
-		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route_.at(i);
-			j=c-'0';
-			x = x + dx[j];
-			y = y + dy[j];
-			//Update the pathlength with the directions of the path. When the path goes vertical or horizontal add length 1.
-			//When it goes diagonal add sqrt(2)
-			if (j == 0 || j == 2 || j == 4 || j == 6)
-			{
-				path_length += straight_step;
-			}
-			if (j == 1 || j == 3 || j == 5 || j == 7)
-			{
-				path_length += diagonal_step;
-			}
-		}
-	}
+	path_length = getRouteLength(route_, 1. / downsampling_factor);
 
 	if(route != NULL)
 		getRoute(start_point, route_, step_length, *route);
@@ -356,7 +653,14 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Mat& downsampled_map
 		const double robot_radius, const double map_resolution, const int end_point_valid_neighborhood_radius, cv::Mat* draw_path_map,
 		std::vector<cv::Point>* route)
 {
-	route_ = "";
+	route_.clear();
+
+	// long queries without route may be answered on the abstract graph of the downsampled map
+	double hierarchical_path_length = 1e100;
+	if (route == NULL && draw_path_map == NULL && end_point_valid_neighborhood_radius == 0
+			&& planHierarchicalPath(downsampled_map, start_point, end_point, downsampling_factor, hierarchical_path_length) == true)
+		return hierarchical_path_length;
+
 	double step_length = 1./downsampling_factor;
 //	cv::Mat debug = map.clone();
 //	cv::circle(debug, start_point, 2, cv::Scalar(127), CV_FILLED);
@@ -381,3 +685,162 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Mat& downsampled_map
 
 	return pathlength;
 }
+
+void AStarPlanner::planPathsToTargets(const cv::Mat& downsampled_map, const cv::Point& start_point, const std::vector<cv::Point>& target_points,
+		const double downsampling_factor, std::vector<double>& path_lengths, std::vector<std::vector<cv::Point> >* routes)
+{
+	path_lengths.assign(target_points.size(), 1e100);
+	if (routes != NULL)
+		routes->assign(target_points.size(), std::vector<cv::Point>());
+
+	// transform the points to the downsampled map in the same way as planPath with the downsampled map does
+	const cv::Point start = downsampling_factor*start_point;
+	if (start.x < 0 || start.x >= downsampled_map.cols || start.y < 0 || start.y >= downsampled_map.rows)
+		return;
+	setMap(downsampled_map);
+	std::vector<int> target_cells(target_points.size(), -1);
+	for (size_t k=0; k<target_points.size(); ++k)
+	{
+		const cv::Point target = downsampling_factor*target_points[k];
+		if (target.x < 0 || target.x >= cols_ || target.y < 0 || target.y >= rows_)
+			continue;
+		if (target == start)
+			path_lengths[k] = 0.;
+		else
+			target_cells[k] = target.y*cols_ + target.x;
+	}
+	std::vector<int> searched_cells;
+	for (size_t k=0; k<target_cells.size(); ++k)
+		if (target_cells[k] >= 0)
+			searched_cells.push_back(target_cells[k]);
+
+	// one search for all targets
+	pathFindToTargets(start, searched_cells);
+
+	// read out the route to each reached target
+	const double step_length = 1./downsampling_factor;
+	for (size_t k=0; k<target_cells.size(); ++k)
+	{
+		const int cell = target_cells[k];
+		if (cell < 0 || generation_[cell] != current_generation_ || closed_[cell] == 0)
+			continue;
+		reconstructRoute(cell);
+		path_lengths[k] = getRouteLength(route_, step_length);
+		if (routes != NULL)
+			getRoute(start, route_, 1., routes->at(k));
+	}
+}
+
+void AStarPlanner::computeDistanceField(const cv::Mat& downsampled_map, const cv::Point& start_point, const double downsampling_factor,
+		cv::Mat& distance_field, const cv::Rect& area)
+{
+	distance_field = cv::Mat(downsampled_map.rows, downsampled_map.cols, CV_64F, cv::Scalar(1e100));
+
+	// transform the start point to the downsampled map in the same way as planPathsToTargets does
+	const cv::Point start = downsampling_factor*start_point;
+	if (start.x < 0 || start.x >= downsampled_map.cols || start.y < 0 || start.y >= downsampled_map.rows)
+		return;
+	setMap(downsampled_map);
+
+	// count the accessible cells of the area, the search may stop when all of them are closed
+	const cv::Rect searched_area = area & cv::Rect(0, 0, cols_, rows_);
+	const bool use_area = (area.width > 0 && area.height > 0);
+	int remaining_cells = 0;
+	for (int y = searched_area.y; y < searched_area.y+searched_area.height; ++y)
+		for (int x = searched_area.x; x < searched_area.x+searched_area.width; ++x)
+			if (map_.ptr<unsigned char>(y)[x] == 255)
+				++remaining_cells;
+
+	// Dijkstra search, every closed cell gets the length of its route, which is the length of the route of its parent (closed
+	// before) plus the length of the last step
+	const double straight_step = 1./downsampling_factor;
+	const double diagonal_step = std::sqrt(2.)/downsampling_factor;
+	startSearch();
+	startAtCell(start, 0);
+	while (heap_.empty() == false)
+	{
+		const int cell = popHeap();
+		closed_[cell] = 1;
+
+		const int x = cell % cols_;
+		const int y = cell / cols_;
+		if (cost_[cell] > 0)
+		{
+			const int j = parent_direction_[cell];
+			distance_field.at<double>(y, x) = distance_field.at<double>(y+dy[j], x+dx[j]) + (j % 2 == 0 ? straight_step : diagonal_step);
+		}
+		else
+			distance_field.at<double>(y, x) = 0.;
+
+		if (use_area == true && searched_area.contains(cv::Point(x, y)) == true && map_.ptr<unsigned char>(y)[x] == 255)
+		{
+			--remaining_cells;
+			if (remaining_cells == 0)
+				return;
+		}
+
+		expandCell(cell, start, false);
+	}
+}
+
+double AStarPlanner::planSmoothedPath(const cv::Mat& map, const cv::Mat& downsampled_map, const cv::Point& start_point, const cv::Point& end_point,
+		const double downsampling_factor, const double map_resolution, std::vector<cv::Point>& waypoints)
+{
+	waypoints.clear();
+
+	// plan the route on the downsampled map first and on the original map if no route was found, like planPath does
+	double scale = downsampling_factor;
+	route_.clear();
+	double path_length = planPath(downsampled_map, downsampling_factor*start_point, downsampling_factor*end_point, 1., 0., map_resolution);
+	if (path_length > 1e90)
+	{
+		scale = 1.;
+		route_.clear();
+		path_length = planPath(map, start_point, end_point, 1., 0., map_resolution);
+	}
+	if (path_length > 1e90)
+		return 1e100;
+
+	waypoints.push_back(start_point);
+	if (route_.size() < 2)
+	{
+		// start and end point are in the same cell
+		waypoints.push_back(end_point);
+		return cv::norm(end_point - start_point);
+	}
+
+	// shorten the route on the map that has been searched (map_) and convert its corners to the original map
+	std::vector<cv::Point> corners;
+	smoothRoute(map_, route_, corners);
+	path_length = 0.;
+	for (size_t i = 1; i < corners.size(); ++i)
+	{
+		path_length += cv::norm(corners[i] - corners[i-1]) / scale;
+		if (i+1 < corners.size())
+			waypoints.push_back((1./scale) * corners[i]);
+	}
+	waypoints.push_back(end_point);
+	return path_length;
+}
+
+void AStarPlanner::smoothRoute(const cv::Mat& map, const std::vector<cv::Point>& route, std::vector<cv::Point>& waypoints)
+{
+	waypoints.clear();
+	if (route.empty() == true)
+		return;
+
+	// keep a cell as waypoint if the next cell cannot be seen from the last waypoint
+	waypoints.push_back(route[0]);
+	for (size_t i = 2; i < route.size(); ++i)
+	{
+		bool line_of_sight = true;
+		cv::LineIterator it(map, waypoints.back(), route[i]);
+		for (int k = 0; k < it.count && line_of_sight == true; k++, ++it)
+			if (**it != 255)
+				line_of_sight = false;
+		if (line_of_sight == false)
+			waypoints.push_back(route[i-1]);
+	}
+	if (route.size() > 1)
+		waypoints.push_back(route.back());
+}
@@ -0,0 +1,100 @@
+#include <ipa_building_navigation/anytime_tsp_solver.h>
+
+TSPCancellationToken::TSPCancellationToken()
+: cancelled_(false)
+{
+}
+
+void TSPCancellationToken::cancel()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	cancelled_ = true;
+}
+
+void TSPCancellationToken::reset()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	cancelled_ = false;
+}
+
+bool TSPCancellationToken::isCancelled() const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return cancelled_;
+}
+
+AnytimeTSPSolver::AnytimeTSPSolver()
+: abort_computation_(false), max_computation_time_(0.), use_deadline_(false), use_computation_deadline_(false)
+{
+}
+
+AnytimeTSPSolver::~AnytimeTSPSolver()
+{
+}
+
+void AnytimeTSPSolver::abortComputation()
+{
+	abort_computation_ = true;
+}
+
+void AnytimeTSPSolver::setMaximumComputationTime(const double max_computation_time)
+{
+	max_computation_time_ = max_computation_time;
+}
+
+void AnytimeTSPSolver::setDeadline(const Clock::time_point& deadline)
+{
+	use_deadline_ = true;
+	deadline_ = deadline;
+}
+
+void AnytimeTSPSolver::clearDeadline()
+{
+	use_deadline_ = false;
+}
+
+void AnytimeTSPSolver::setCancellationToken(const TSPCancellationTokenPtr& cancellation_token)
+{
+	cancellation_token_ = cancellation_token;
+}
+
+void AnytimeTSPSolver::setImprovementCallback(const ImprovementCallback& improvement_callback)
+{
+	improvement_callback_ = improvement_callback;
+}
+
+void AnytimeTSPSolver::startComputation()
+{
+	use_computation_deadline_ = use_deadline_;
+	computation_deadline_ = deadline_;
+	if (max_computation_time_ > 0.)
+	{
+		const Clock::time_point time_limit = Clock::now() + boost::chrono::duration_cast<Clock::duration>(boost::chrono::duration<double>(max_computation_time_));
+		if (use_computation_deadline_ == false || time_limit < computation_deadline_)
+			computation_deadline_ = time_limit;
+		use_computation_deadline_ = true;
+	}
+}
+
+bool AnytimeTSPSolver::isStopRequested() const
+{
+	if (abort_computation_ == true)
+		return true;
+	if (cancellation_token_ && cancellation_token_->isCancelled() == true)
+		return true;
+	return (use_computation_deadline_ == true && Clock::now() >= computation_deadline_);
+}
+
+void AnytimeTSPSolver::reportImprovement(const std::vector<int>& tour, const double tour_length)
+{
+	if (improvement_callback_)
+		improvement_callback_(tour, tour_length);
+}
+
+double AnytimeTSPSolver::getClosedTourLength(const cv::Mat& path_length_matrix, const std::vector<int>& tour)
+{
+	double tour_length = 0.;
+	for (size_t i=0; i<tour.size(); ++i)
+		tour_length += path_length_matrix.at<double>(tour[i], tour[(i+1)%tour.size()]);
+	return tour_length;
+}
@@ -1,12 +1,20 @@
 # include <ipa_building_navigation/concorde_TSP.h>
 
+#include <ipa_building_navigation/lin_kernighan_TSP.h>
+#include <ipa_building_navigation/timer.h>
+
 #include <boost/thread.hpp>
 #include <boost/chrono.hpp>
 #include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <dirent.h>
 
 //Default constructor
 ConcordeTSPSolver::ConcordeTSPSolver()
-: abort_computation_(false)
 {
 
 }
@@ -19,35 +27,138 @@ void ConcordeTSPSolver::distance_matrix_thread(DistanceMatrix& distance_matrix_c
 				robot_radius, map_resolution, pathplanner_);
 }
 
-void ConcordeTSPSolver::abortComputation()
+std::vector<int> ConcordeTSPSolver::solveTSP(const cv::Mat& path_length_matrix, const int start_node)
+{
+	return solveConcordeTSP(path_length_matrix, start_node);
+}
+
+//This function runs a program directly (without a shell) with the given arguments, the first argument is the program, which
+//is searched in PATH if it does not contain a slash. The output of the program (stdout and stderr) is read through a pipe.
+//The program is killed if the computation is aborted or stopped (see AnytimeTSPSolver) or the time limit (if > 0) is exceeded. Returns the exit status of the
+//program or -1 if it could not be started or was killed.
+int ConcordeTSPSolver::executeProcess(const std::vector<std::string>& arguments, const std::string& working_directory,
+		std::string& output, const double time_limit)
 {
-	abort_computation_ = true;
-
-	// kill concorde if running
-	const std::string pid_filename = "concorde_tsp_pid" + unique_file_identifier_ + ".txt";
-	std::string pid_cmd = "pidof concorde > " + pid_filename;
-	int pid_result = system(pid_cmd.c_str());
-	std::ifstream pid_reader(pid_filename.c_str());
-	int value = -1;
-	std::string line;
-	if (pid_reader.is_open())
+	output.clear();
+	if (arguments.size() == 0)
+		return -1;
+
+	// prepare everything that is needed in the child process before forking, only async-signal-safe calls are allowed after fork
+	std::vector<char*> argv(arguments.size()+1, (char*)NULL);
+	for (size_t i=0; i<arguments.size(); ++i)
+		argv[i] = const_cast<char*>(arguments[i].c_str());
+	const char* directory = (working_directory.empty() ? NULL : working_directory.c_str());
+
+	int output_pipe[2];
+	if (pipe(output_pipe) != 0)
+		return -1;
+	const pid_t pid = fork();
+	if (pid < 0)
+	{
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+		return -1;
+	}
+	if (pid == 0)
 	{
-		while (getline(pid_reader, line))
+		// child process
+		dup2(output_pipe[1], STDOUT_FILENO);
+		dup2(output_pipe[1], STDERR_FILENO);
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+		if (directory != NULL && chdir(directory) != 0)
+			_exit(127);
+		execvp(argv[0], &argv[0]);
+		_exit(127);
+	}
+	close(output_pipe[1]);
+
+	// collect the output until the process has finished, kill it on abort or time out
+	Timer tim;
+	bool pipe_open = true;
+	bool killed = false;
+	int status = 0;
+	while (true)
+	{
+		if (pipe_open == true)
 		{
-			std::istringstream iss(line);
-			while (iss >> value)
+			struct pollfd poll_descriptor;
+			poll_descriptor.fd = output_pipe[0];
+			poll_descriptor.events = POLLIN;
+			poll_descriptor.revents = 0;
+			if (poll(&poll_descriptor, 1, 10) > 0)
 			{
-				std::cout << "PID of concorde: " << value << std::endl;
-				std::stringstream ss;
-				ss << "kill " << value;
-				std::string kill_cmd = ss.str();
-				int kill_result = system(kill_cmd.c_str());
-				std::cout << "kill result: " << kill_result << std::endl;
+				char buffer[4096];
+				const ssize_t number_of_bytes = read(output_pipe[0], buffer, sizeof(buffer));
+				if (number_of_bytes > 0)
+					output.append(buffer, number_of_bytes);
+				else
+					pipe_open = false;
 			}
 		}
-		pid_reader.close();
-		remove(pid_filename.c_str());
+		else
+			usleep(10000);
+
+		const pid_t result = waitpid(pid, &status, WNOHANG);
+		if (result == pid || result < 0)
+			break;
+		if (killed == false && (isStopRequested() == true || (time_limit > 0. && tim.getElapsedTimeInSec() > time_limit)))
+		{
+			kill(pid, SIGKILL);
+			killed = true;
+		}
+	}
+	close(output_pipe[0]);
+
+	if (killed == true || WIFEXITED(status) == false)
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+//This function finds the concorde binary of the libconcorde_tsp_solver package. It is searched only once per process.
+std::string ConcordeTSPSolver::getConcordeBinary()
+{
+	static boost::mutex concorde_binary_mutex;
+	static std::string concorde_binary;
+	boost::mutex::scoped_lock lock(concorde_binary_mutex);
+	for (int trial=0; trial<3 && concorde_binary.empty()==true; ++trial)
+	{
+		std::vector<std::string> arguments;
+		arguments.push_back("rospack");
+		arguments.push_back("libs-only-L");
+		arguments.push_back("libconcorde_tsp_solver");
+		std::string output;
+		if (executeProcess(arguments, "", output, 10.) == 0)
+		{
+			std::string bin_folder;
+			std::istringstream iss(output);
+			iss >> bin_folder;
+			if (bin_folder.empty() == false)
+				concorde_binary = bin_folder + "/libconcorde_tsp_solver/concorde";
+		}
+		else
+			std::cout << "ConcordeTSPSolver::getConcordeBinary: ERROR: 'rospack libs-only-L libconcorde_tsp_solver' failed: " << output << std::endl;
 	}
+	std::cout << "concorde binary: " << concorde_binary << std::endl;
+	return concorde_binary;
+}
+
+//This function removes the temporary directory of one call together with all files concorde has created in it.
+void ConcordeTSPSolver::removeDirectory(const std::string& directory)
+{
+	DIR* dir = opendir(directory.c_str());
+	if (dir != NULL)
+	{
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL)
+		{
+			const std::string name = entry->d_name;
+			if (name != "." && name != "..")
+				remove((directory + "/" + name).c_str());
+		}
+		closedir(dir);
+	}
+	rmdir(directory.c_str());
 }
 
 //This function generates a file with the current TSP in TSPlib format. This is necessary because concorde needs this file
@@ -141,68 +252,95 @@ std::vector<int> ConcordeTSPSolver::readFromFile(const std::string& tsp_order_fi
 	return order_vector;
 }
 
-//This function solves the given TSP using the systemcall to use the concorde TSP solver. This solver is applied from:
+//This function solves the given TSP using the concorde TSP solver. This solver is applied from:
 //		http://www.math.uwaterloo.ca/tsp/concorde.html
-//First you have to build the Solver in any possible way and if you don't make a ros-package out of it you have to change
-//the paths to the right ones. If it is a ros-package the ros::package::getpath() function will find the right path.
+//The solver is built by the libconcorde_tsp_solver package, the binary is found with rospack.
 //The usage of the solver is: ./concorde [-see below-] [dat_file]
 //Navigate to the build Solver and then ./TSP and type ./concorde -h for a short explanation.
+//Every call uses its own temporary directory for the TSPlib file and the files concorde creates, so several solvers can run
+//at the same time. Concorde is started directly as child process and killed when the computation is aborted or stopped, in
+//the latter case the initial Lin-Kernighan tour is returned.
 
 //with a given distance matrix
 std::vector<int> ConcordeTSPSolver::solveConcordeTSP(const cv::Mat& path_length_matrix, const int start_Node)
 {
-	// generate a unique filename
-	timeval time;
-	gettimeofday(&time, NULL);
-	std::stringstream ss;
-	ss << "_" << time.tv_sec << "_" << time.tv_usec;
-	unique_file_identifier_ = ss.str();
-	const std::string tsp_lib_filename = "TSPlib_file" + unique_file_identifier_ + ".txt";
-	const std::string tsp_order_filename = "TSP_order" + unique_file_identifier_ + ".txt";
-
+	startComputation();
 	std::vector<int> unsorted_order, sorted_order;
+	bool concorde_succeeded = false;
 	std::cout << "finding optimal order" << std::endl;
 	std::cout << "number of nodes: " << path_length_matrix.rows << " start node: " << start_Node << std::endl;
 	if (path_length_matrix.rows > 2) //check if the TSP has at least 3 nodes
 	{
-		//create the TSPlib file
-		writeToFile(path_length_matrix, tsp_lib_filename, tsp_order_filename);
-
-		//use concorde to find optimal tour
-		std::string bin_folder;
-		while (bin_folder.length()==0)
+		// a good tour that is returned if concorde is stopped or fails, it is found in a few milliseconds
+		LinKernighanTSPSolver initial_tour_solver;
+		initial_tour_solver.setMaximumNumberOfKicks(0);
+		const std::vector<int> initial_tour = initial_tour_solver.solveLinKernighanTSP(path_length_matrix, start_Node);
+		reportImprovement(initial_tour, getClosedTourLength(path_length_matrix, initial_tour));
+
+		// create a unique temporary directory for the files of this call
+		char directory_template[] = "/tmp/concorde_tsp_XXXXXX";
+		if (mkdtemp(directory_template) == NULL)
 		{
-			const std::string temp_file = "temp_libconcorde_path" + unique_file_identifier_ + ".txt";
-			try
+			std::cout << "ConcordeTSPSolver::solveConcordeTSP: ERROR: Could not create a temporary directory." << std::endl;
+			unsorted_order = initial_tour;
+		}
+		else
+		{
+			const std::string directory = directory_template;
+			const std::string tsp_lib_filename = directory + "/TSPlib_file.txt";
+			const std::string tsp_order_filename = directory + "/TSP_order.txt";
+
+			//create the TSPlib file
+			writeToFile(path_length_matrix, tsp_lib_filename, tsp_order_filename);
+
+			//use concorde to find optimal tour
+			const std::string concorde_binary = getConcordeBinary();
+			if (abort_computation_==true)
 			{
-				std::string cmd = "rospack libs-only-L libconcorde_tsp_solver > " + temp_file;
-				int result = system(cmd.c_str());
-				std::ifstream file(temp_file.c_str(), std::ifstream::in);
-				if (file.is_open())
-				{
-					file >> bin_folder;
-					file.close();
-				}
-				std::cout << "bin_folder: " << bin_folder << std::endl;
-				remove(temp_file.c_str());
-				//bin_folder = ros::package::command("libs-only-L libconcorde_tsp_solver"); // this command crashes sometimes
-				//bin_folder.erase(std::remove(bin_folder.begin(), bin_folder.end(), '\n'));
+				removeDirectory(directory);
+				return sorted_order;
 			}
-			catch (...)
+			if (isStopRequested()==true)
 			{
-				std::cout << "ConcordeTSPSolver::solveConcordeTSP: ERROR: ['rospack libs-only-L libconcorde_tsp_solver > '" << temp_file << "] failed. Trying again." << std::endl;
+				std::cout << "ConcordeTSPSolver::solveConcordeTSP: Computation stopped before concorde was started, taking the Lin-Kernighan tour." << std::endl;
+				removeDirectory(directory);
+				return initial_tour;
 			}
-		}
-		std::string cmd = bin_folder + "/libconcorde_tsp_solver/concorde -o " + "$HOME/.ros/" + tsp_order_filename + " $HOME/.ros/" + tsp_lib_filename;
-		if (abort_computation_==true)
-			return sorted_order;
-		int result = system(cmd.c_str());
-		if (abort_computation_==true)
-			return sorted_order;
-		assert(!result);
+			std::vector<std::string> arguments;
+			arguments.push_back(concorde_binary);
+			arguments.push_back("-o");
+			arguments.push_back(tsp_order_filename);
+			arguments.push_back(tsp_lib_filename);
+			std::string output;
+			Timer tim;
+			const int result = executeProcess(arguments, directory, output, 0.);
+			if (abort_computation_==true)
+			{
+				removeDirectory(directory);
+				return sorted_order;
+			}
+			std::cout << "concorde finished with result " << result << " in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
 
-		//get order from saving file
-		unsorted_order = readFromFile(tsp_order_filename);
+			//get order from saving file
+			if (result == 0)
+			{
+				unsorted_order = readFromFile(tsp_order_filename);
+				concorde_succeeded = (unsorted_order.size() == path_length_matrix.rows);
+			}
+			else if (isStopRequested()==true)
+			{
+				std::cout << "ConcordeTSPSolver::solveConcordeTSP: Concorde was stopped, taking the Lin-Kernighan tour." << std::endl;
+				unsorted_order = initial_tour;
+			}
+			else
+			{
+				std::cout << "ConcordeTSPSolver::solveConcordeTSP: ERROR: concorde failed, taking the Lin-Kernighan tour:\n" << output << std::endl;
+				unsorted_order = initial_tour;
+			}
+
+			// cleanup files
+			removeDirectory(directory);
+		}
 	}
 	else
 	{
@@ -211,13 +349,6 @@ std::vector<int> ConcordeTSPSolver::solveConcordeTSP(const cv::Mat& path_length_
 			unsorted_order.push_back(node);
 		}
 	}
-	// cleanup files
-	remove(tsp_lib_filename.c_str());
-	remove(tsp_order_filename.c_str());
-	const std::string tsp_lib_sol_filename = "TSPlib_file" + unique_file_identifier_ + ".sol";
-	remove(tsp_lib_sol_filename.c_str());
-	const std::string tsp_lib_res_filename = "TSPlib_file" + unique_file_identifier_ + ".res";
-	remove(tsp_lib_res_filename.c_str());
 	std::cout << "finished TSP" << std::endl;
 
 	// if there is an error, just set unsorted order to 1, 2, 3, ...
@@ -231,7 +362,7 @@ std::vector<int> ConcordeTSPSolver::solveConcordeTSP(const cv::Mat& path_length_
 	}
 
 	//sort the order with the start_node at the beginning
-	unsigned int start_node_position;
+	unsigned int start_node_position = 0;
 
 	for (unsigned int i = 0; i < unsorted_order.size(); i++) //find position of the start node in the order
 	{
@@ -249,6 +380,8 @@ std::vector<int> ConcordeTSPSolver::solveConcordeTSP(const cv::Mat& path_length_
 	{
 		sorted_order.push_back(unsorted_order[i]);
 	}
+	if (concorde_succeeded == true)
+		reportImprovement(sorted_order, getClosedTourLength(path_length_matrix, sorted_order));
 
 	return sorted_order;
 }
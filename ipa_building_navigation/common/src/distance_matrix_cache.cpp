@@ -0,0 +1,350 @@
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#include <boost/thread/thread.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char distance_matrix_file_magic[8] = {'I', 'P', 'A', 'D', 'M', 'C', '0', '1'};
+
+// strict weak ordering of points for the lookup of known points
+struct PointComparator
+{
+	bool operator()(const cv::Point& a, const cv::Point& b) const
+	{
+		return (a.x < b.x || (a.x == b.x && a.y < b.y));
+	}
+};
+
+// distance matrix file of the disk tier, ordered by modification time
+struct CacheFile
+{
+	time_t modification_time;
+	unsigned long long size;
+	std::string filename;
+
+	bool operator<(const CacheFile& other) const
+	{
+		return modification_time < other.modification_time;
+	}
+};
+
+DistanceMatrixCache::DistanceMatrixCache(const std::string& cache_directory, const size_t max_number_of_matrices, const unsigned long long max_disk_bytes)
+: cache_directory_(cache_directory), max_number_of_matrices_(std::max((size_t)1, max_number_of_matrices)), max_disk_bytes_(max_disk_bytes)
+{
+}
+
+void DistanceMatrixCache::setCacheDirectory(const std::string& cache_directory)
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	cache_directory_ = cache_directory;
+}
+
+void DistanceMatrixCache::setMaxDiskBytes(const unsigned long long max_disk_bytes)
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	max_disk_bytes_ = max_disk_bytes;
+}
+
+unsigned long long DistanceMatrixCache::computePointsHash(const std::vector<cv::Point>& points)
+{
+	// 64 bit FNV-1a over the coordinates
+	const unsigned long long fnv_prime = 1099511628211ULL;
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i=0; i<points.size(); ++i)
+	{
+		const int coordinates[2] = {points[i].x, points[i].y};
+		const unsigned char* bytes = (const unsigned char*)coordinates;
+		for (size_t b=0; b<sizeof(coordinates); ++b)
+			hash = (hash ^ bytes[b]) * fnv_prime;
+	}
+	return hash;
+}
+
+std::string DistanceMatrixCache::getParameterKey(const unsigned long long map_hash, const double downsampling_factor, const double robot_radius, const double map_resolution)
+{
+	std::stringstream key;
+	key << std::hex << map_hash << std::dec << std::setprecision(10) << "_" << downsampling_factor << "_" << robot_radius << "_" << map_resolution;
+	return key.str();
+}
+
+bool DistanceMatrixCache::getDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+		const double downsampling_factor, const double robot_radius, const double map_resolution, AStarPlanner& path_planner,
+		const StopCondition& stop_condition)
+{
+	return getDistanceMatrix(distance_matrix, MapPreprocessingCache::computeMapHash(original_map), original_map, points, downsampling_factor,
+			robot_radius, map_resolution, path_planner, stop_condition);
+}
+
+bool DistanceMatrixCache::getDistanceMatrix(cv::Mat& distance_matrix, const unsigned long long map_hash, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+		const double downsampling_factor, const double robot_radius, const double map_resolution, AStarPlanner& path_planner,
+		const StopCondition& stop_condition)
+{
+	const std::string parameter_key = getParameterKey(map_hash, downsampling_factor, robot_radius, map_resolution);
+	std::stringstream key_stream;
+	key_stream << parameter_key << "_" << std::hex << computePointsHash(points);
+	const std::string key = key_stream.str();
+
+	// 1. memory tier: the same point list
+	std::string cache_directory;
+	unsigned long long max_disk_bytes = 0;
+	{
+		boost::mutex::scoped_lock lock(cache_mutex_);
+		std::map<std::string, CachedMatrix>::iterator it = matrices_.find(key);
+		if (it != matrices_.end() && it->second.points == points)
+		{
+			distance_matrix = it->second.distance_matrix.clone();
+			usage_order_.remove(key);
+			usage_order_.push_front(key);
+			std::cout << "DistanceMatrixCache::getDistanceMatrix: Distance matrix taken from memory." << std::endl;
+			return true;
+		}
+		cache_directory = cache_directory_;
+		max_disk_bytes = max_disk_bytes_;
+	}
+
+	// 2. disk tier: the same point list
+	const std::string filename = (cache_directory.empty() ? "" : cache_directory + "/distance_matrix_" + key + ".dmc");
+	CachedMatrix cached_matrix;
+	cached_matrix.parameter_key = parameter_key;
+	if (filename.empty() == false && readDistanceMatrixFile(filename, map_hash, downsampling_factor, robot_radius, map_resolution, cached_matrix.points, cached_matrix.distance_matrix) == true
+			&& cached_matrix.points == points)
+	{
+		distance_matrix = cached_matrix.distance_matrix.clone();
+		utime(filename.c_str(), NULL);		// renew the modification time, so the file counts as recently used in limitDiskTier
+		boost::mutex::scoped_lock lock(cache_mutex_);
+		storeInMemory(key, cached_matrix);
+		std::cout << "DistanceMatrixCache::getDistanceMatrix: Distance matrix read from " << filename << std::endl;
+		return true;
+	}
+
+	// 3. reuse the distances of the cached matrix of this map that contains most of the requested points
+	distance_matrix.create((int)points.size(), (int)points.size(), CV_64F);
+	std::vector<bool> known_points(points.size(), false);
+	int number_of_known_points = 0;
+	{
+		boost::mutex::scoped_lock lock(cache_mutex_);
+		std::vector<int> best_indices;
+		for (std::map<std::string, CachedMatrix>::iterator it=matrices_.begin(); it!=matrices_.end(); ++it)
+		{
+			if (it->second.parameter_key != parameter_key)
+				continue;
+
+			// index of every requested point in the cached matrix, -1 if it is not contained
+			std::map<cv::Point, int, PointComparator> cached_point_indices;
+			for (size_t i=0; i<it->second.points.size(); ++i)
+				cached_point_indices.insert(std::pair<cv::Point, int>(it->second.points[i], (int)i));
+			std::vector<int> indices(points.size(), -1);
+			int number_of_contained_points = 0;
+			for (size_t i=0; i<points.size(); ++i)
+			{
+				std::map<cv::Point, int, PointComparator>::iterator point_it = cached_point_indices.find(points[i]);
+				if (point_it != cached_point_indices.end())
+				{
+					indices[i] = point_it->second;
+					++number_of_contained_points;
+				}
+			}
+			if (number_of_contained_points > number_of_known_points)
+			{
+				number_of_known_points = number_of_contained_points;
+				best_indices = indices;
+				cached_matrix.distance_matrix = it->second.distance_matrix;
+			}
+		}
+
+		// copy the known distances
+		for (size_t i=0; i<best_indices.size(); ++i)
+		{
+			if (best_indices[i] < 0)
+				continue;
+			known_points[i] = true;
+			for (size_t j=0; j<best_indices.size(); ++j)
+				if (best_indices[j] >= 0)
+					distance_matrix.at<double>(i, j) = cached_matrix.distance_matrix.at<double>(best_indices[i], best_indices[j]);
+		}
+	}
+
+	// compute the missing rows and columns
+	DistanceMatrix distance_matrix_computation;
+	distance_matrix_computation.setStopCondition(stop_condition);
+	if (number_of_known_points == 0)
+		distance_matrix_computation.constructDistanceMatrix(distance_matrix, map_hash, original_map, points, downsampling_factor, robot_radius, map_resolution, path_planner);
+	else if (number_of_known_points < (int)points.size())
+	{
+		std::cout << "DistanceMatrixCache::getDistanceMatrix: Reusing the distances between " << number_of_known_points << " of "
+				<< points.size() << " points." << std::endl;
+		distance_matrix_computation.completeDistanceMatrix(distance_matrix, map_hash, original_map, points, downsampling_factor, robot_radius, map_resolution, path_planner, known_points);
+	}
+	else
+		std::cout << "DistanceMatrixCache::getDistanceMatrix: Distance matrix taken from a cached matrix of more points." << std::endl;
+	if (distance_matrix_computation.wasStopped() == true)
+	{
+		std::cout << "DistanceMatrixCache::getDistanceMatrix: Computation stopped, the matrix contains approximated distances and is not stored." << std::endl;
+		return false;
+	}
+
+	// store the new matrix in both tiers
+	cached_matrix.points = points;
+	cached_matrix.distance_matrix = distance_matrix.clone();
+	if (filename.empty() == false)
+	{
+		if (writeDistanceMatrixFile(filename, map_hash, downsampling_factor, robot_radius, map_resolution, points, distance_matrix) == true)
+			limitDiskTier(cache_directory, max_disk_bytes);
+		else
+			std::cout << "DistanceMatrixCache::getDistanceMatrix: Warning: Could not write " << filename << std::endl;
+	}
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	storeInMemory(key, cached_matrix);
+	return true;
+}
+
+void DistanceMatrixCache::clear()
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	matrices_.clear();
+	usage_order_.clear();
+}
+
+void DistanceMatrixCache::limitDiskTier(const std::string& cache_directory, const unsigned long long max_disk_bytes)
+{
+	DIR* directory = opendir(cache_directory.c_str());
+	if (directory == NULL)
+		return;
+
+	// modification time, size and name of every distance matrix file
+	std::vector<CacheFile> files;
+	unsigned long long total_size = 0;
+	const std::string prefix = "distance_matrix_", suffix = ".dmc";
+	for (struct dirent* entry=readdir(directory); entry!=NULL; entry=readdir(directory))
+	{
+		const std::string name = entry->d_name;
+		if (name.size() <= prefix.size()+suffix.size() || name.compare(0, prefix.size(), prefix) != 0
+				|| name.compare(name.size()-suffix.size(), suffix.size(), suffix) != 0)
+			continue;
+		CacheFile file;
+		file.filename = cache_directory + "/" + name;
+		struct stat file_status;
+		if (stat(file.filename.c_str(), &file_status) != 0)
+			continue;
+		file.modification_time = file_status.st_mtime;
+		file.size = file_status.st_size;
+		total_size += file.size;
+		files.push_back(file);
+	}
+	closedir(directory);
+
+	// delete the least recently used files first, other processes that still read a deleted file keep their memory mapping
+	std::sort(files.begin(), files.end());
+	for (size_t i=0; i<files.size() && total_size>max_disk_bytes; ++i)
+	{
+		if (std::remove(files[i].filename.c_str()) == 0)
+			total_size -= files[i].size;
+	}
+}
+
+void DistanceMatrixCache::storeInMemory(const std::string& key, const CachedMatrix& cached_matrix)
+{
+	usage_order_.remove(key);
+	usage_order_.push_front(key);
+	matrices_[key] = cached_matrix;
+	while (matrices_.size() > max_number_of_matrices_)
+	{
+		matrices_.erase(usage_order_.back());
+		usage_order_.pop_back();
+	}
+}
+
+bool DistanceMatrixCache::writeDistanceMatrixFile(const std::string& filename, const unsigned long long map_hash, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, const std::vector<cv::Point>& points, const cv::Mat& distance_matrix)
+{
+	if (distance_matrix.rows != (int)points.size() || distance_matrix.cols != (int)points.size() || distance_matrix.type() != CV_64F)
+		return false;
+
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, distance_matrix_file_magic, sizeof(header.magic));
+	header.map_hash = map_hash;
+	header.downsampling_factor = downsampling_factor;
+	header.robot_radius = robot_radius;
+	header.map_resolution = map_resolution;
+	header.number_of_points = points.size();
+
+	// write into a temporary file of this process and thread first, so other processes never read a partially written file
+	// and concurrent writers of the same matrix do not write into the same temporary file
+	std::stringstream temporary_filename_stream;
+	temporary_filename_stream << filename << "." << getpid() << "_" << boost::this_thread::get_id() << ".tmp";
+	const std::string temporary_filename = temporary_filename_stream.str();
+	std::ofstream file(temporary_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (file.is_open() == false)
+		return false;
+	file.write((const char*)&header, sizeof(header));
+	for (size_t i=0; i<points.size(); ++i)
+	{
+		const int coordinates[2] = {points[i].x, points[i].y};
+		file.write((const char*)coordinates, sizeof(coordinates));
+	}
+	for (int i=0; i<distance_matrix.rows; ++i)
+		file.write((const char*)distance_matrix.ptr<double>(i), distance_matrix.cols*sizeof(double));
+	file.close();
+	if (file.fail() == true)
+	{
+		std::remove(temporary_filename.c_str());
+		return false;
+	}
+	if (std::rename(temporary_filename.c_str(), filename.c_str()) != 0)
+	{
+		std::remove(temporary_filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool DistanceMatrixCache::readDistanceMatrixFile(const std::string& filename, const unsigned long long map_hash, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, std::vector<cv::Point>& points, cv::Mat& distance_matrix)
+{
+	const int file_descriptor = open(filename.c_str(), O_RDONLY);
+	if (file_descriptor < 0)
+		return false;
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || (size_t)file_status.st_size < sizeof(FileHeader))
+	{
+		close(file_descriptor);
+		return false;
+	}
+	const size_t file_size = file_status.st_size;
+	void* data = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (data == MAP_FAILED)
+		return false;
+
+	// check the header and the size of the file
+	const FileHeader* header = (const FileHeader*)data;
+	const unsigned long long n = header->number_of_points;
+	bool valid = (std::memcmp(header->magic, distance_matrix_file_magic, sizeof(header->magic)) == 0 && header->map_hash == map_hash
+			&& header->downsampling_factor == downsampling_factor && header->robot_radius == robot_radius && header->map_resolution == map_resolution
+			&& n < (1ULL<<24) && file_size == sizeof(FileHeader) + 2*sizeof(int)*n + sizeof(double)*n*n);
+	if (valid == true)
+	{
+		const int* coordinates = (const int*)((const char*)data + sizeof(FileHeader));
+		points.resize(n);
+		for (size_t i=0; i<n; ++i)
+			points[i] = cv::Point(coordinates[2*i], coordinates[2*i+1]);
+		double* matrix_data = (double*)((const char*)data + sizeof(FileHeader) + 2*sizeof(int)*n);
+		distance_matrix = cv::Mat((int)n, (int)n, CV_64F, matrix_data).clone();
+	}
+	munmap(data, file_size);
+	return valid;
+}
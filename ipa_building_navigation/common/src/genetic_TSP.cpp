@@ -1,13 +1,32 @@
 #include <ipa_building_navigation/genetic_TSP.h>
 
+#include <algorithm>
+
 #include <boost/thread.hpp>
 #include <boost/chrono.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+// parameters of the memetic algorithm
+static const int memetic_population_size = 8;			// number of tours that survive a generation
+static const int memetic_number_of_children = 8;		// number of children created in each generation
+static const int memetic_stagnation_limit = 30;			// the evolution stops if the best tour has not improved for this number of generations
+static const double memetic_improvement_epsilon = 1e-7;	// minimal change of the length that counts as improvement
 
 //Default constructor
 GeneticTSPSolver::GeneticTSPSolver()
-: abort_computation_(false)
+: use_local_search_(true), random_seed_(5489u)
+{
+
+}
+
+void GeneticTSPSolver::setUseLocalSearch(const bool use_local_search)
 {
+	use_local_search_ = use_local_search;
+}
 
+void GeneticTSPSolver::setRandomSeed(const unsigned int random_seed)
+{
+	random_seed_ = random_seed;
 }
 
 void GeneticTSPSolver::distance_matrix_thread(DistanceMatrix& distance_matrix_computation, cv::Mat& distance_matrix,
@@ -18,11 +37,6 @@ void GeneticTSPSolver::distance_matrix_thread(DistanceMatrix& distance_matrix_co
 				robot_radius, map_resolution, pathplanner_);
 }
 
-void GeneticTSPSolver::abortComputation()
-{
-	abort_computation_ = true;
-}
-
 ////Function to construct the distance matrix from the given points. See the definition at solveGeneticTSP for the style of this matrix.
 //void GeneticTSPSolver::constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const int number_of_nodes,
 //        const std::vector<cv::Point>& points, double downsampling_factor, double robot_radius, double map_resolution)
@@ -75,8 +89,8 @@ double GeneticTSPSolver::getPathLength(const cv::Mat& path_length_Matrix, std::v
 
 // This Function takes the given path and mutates it. A mutation is a random change of the path-order. For example random
 // nodes can be switched, or a random intervall of nodes can be inverted. Only the first and last Node can't be changed, because
-// they are given from the Main-function.
-std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_path)
+// they are given from the Main-function. The random numbers are drawn from random_number_generator.
+std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_path, RandomNumberGenerator& random_number_generator)
 {
 	std::vector<int> mutated_path;
 
@@ -86,11 +100,11 @@ std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_pat
 	//this variable sets which aspect should be changed:
 	//		0: random nodes should be switched
 	//		1: random intervall should be inverted:
-	int what_to_change = (rand() % 2);
+	int what_to_change = boost::random::uniform_int_distribution<int>(0, 1)(random_number_generator);
 
 	if (what_to_change == 0) //random node-switching
 	{
-		int number_of_switches = (rand() % (parent_path.size() - 3)) + 1; // Set the number of switches that should be done.
+		int number_of_switches = boost::random::uniform_int_distribution<int>(1, (int)parent_path.size() - 3)(random_number_generator); // Set the number of switches that should be done.
 		                                                                  // Because the first needs to be unchanged the number is limited.
 		                                                                  // Also at least one change should be done.
 		for (int change = 0; change < number_of_switches; change++)
@@ -99,8 +113,8 @@ std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_pat
 			bool switched = false; //this variable makes sure that the switch has been done
 			do
 			{
-				int node_one = (rand() % (saving_variable_path.size() - 2)) + 1; //this variables random choose which nodes should be changed
-				int node_two = (rand() % (saving_variable_path.size() - 2)) + 1; //The first and last one should be untouched
+				int node_one = boost::random::uniform_int_distribution<int>(1, (int)saving_variable_path.size() - 2)(random_number_generator); //this variables random choose which nodes should be changed
+				int node_two = boost::random::uniform_int_distribution<int>(1, (int)saving_variable_path.size() - 2)(random_number_generator); //The first and last one should be untouched
 				if (node_one != node_two) //node can't be switched with himself
 				{
 					for (int node = 0; node < saving_variable_path.size(); node++) //fill the mutated path with the information
@@ -130,8 +144,8 @@ std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_pat
 		bool inverted = false;
 		do
 		{
-			int node_one = (rand() % (saving_variable_path.size() - 2)) + 1; //this variables random choose which intervall
-			int node_two = (rand() % (saving_variable_path.size() - 2)) + 1; //The first and last one should be untouched
+			int node_one = boost::random::uniform_int_distribution<int>(1, (int)saving_variable_path.size() - 2)(random_number_generator); //this variables random choose which intervall
+			int node_two = boost::random::uniform_int_distribution<int>(1, (int)saving_variable_path.size() - 2)(random_number_generator); //The first and last one should be untouched
 			int inverting_counter = 0; //variable to choose the node based on distance to the node_two
 			if (node_one > node_two) //switch variables, if the node_one is bigger than the node_two (easier to work with here)
 			{
@@ -186,7 +200,7 @@ std::vector<int> GeneticTSPSolver::getBestPath(const std::vector<std::vector<int
 	return best_path;
 }
 
-//This is a solver for the TSP using a genetic algorithm. It calculates a initial path by using the nearest-neighbor
+//This is the classic solver for the TSP using a genetic algorithm. It calculates a initial path by using the nearest-neighbor
 //search. It then applies an evolutional algorithm:
 //
 //	I. Take the parent of the current generation and calculate 8 mutated children of it. A mutation can be a change
@@ -201,11 +215,11 @@ std::vector<int> GeneticTSPSolver::getBestPath(const std::vector<std::vector<int
 //		2. For the columns in a row the Matrix shows the distance to the Node in the column.
 //		3. From the node to itself the distance is 0.
 
-//don't compute distance matrix
-std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Matrix, const int start_Node)
+std::vector<int> GeneticTSPSolver::solveClassicGeneticTSP(const cv::Mat& path_length_Matrix, const int start_Node)
 {
 	std::vector<int> return_vector;
 	NearestNeighborTSPSolver nearest_neighbor_solver;
+	RandomNumberGenerator random_number_generator(random_seed_);
 
 	std::vector<int> calculated_path = nearest_neighbor_solver.solveNearestTSP(path_length_Matrix, start_Node);
 	calculated_path.push_back(start_Node); //push the start node at the end, so the reaching of the start at the end is included in the planning
@@ -221,6 +235,11 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Ma
 		{
 			if (abort_computation_==true)
 				return return_vector;
+			if (isStopRequested()==true)
+			{
+				std::cout << "GeneticTSPSolver::solveClassicGeneticTSP: Computation stopped after " << number_of_generations << " generations." << std::endl;
+				break;
+			}
 
 			number_of_generations++;
 			changed_path = false;
@@ -228,9 +247,11 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Ma
 			current_generation_paths.push_back(calculated_path); //first path is always the parent --> important for checking if the path has changed in getBestPath!!
 			for (int child = 0; child < 8; child++) //get 8 children and add them to the vector
 			{
-				current_generation_paths.push_back(mutatePath(calculated_path));
+				current_generation_paths.push_back(mutatePath(calculated_path, random_number_generator));
 			}
 			calculated_path = getBestPath(current_generation_paths, path_length_Matrix, changed_path); //get the best path of this generation
+			if (changed_path == true && improvement_callback_)
+				reportImprovement(std::vector<int>(calculated_path.begin(), calculated_path.end()-1), getPathLength(path_length_Matrix, calculated_path));
 			if (number_of_generations >= 2300) //when a specified amount of steps have been done the algorithm checks if the last paths didn't change
 			{
 				if (changed_path)
@@ -254,6 +275,312 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Ma
 	return return_vector;
 }
 
+double GeneticTSPSolver::getTourLength(const std::vector<double>& distances, const int number_of_nodes, const std::vector<int>& tour)
+{
+	double length = distances[tour.back()*number_of_nodes + tour[0]];
+	for (size_t i=1; i<tour.size(); ++i)
+		length += distances[tour[i-1]*number_of_nodes + tour[i]];
+	return length;
+}
+
+// 2-opt: the edges (a,b) and (c,e) of the tour a b ... c e are replaced by (a,c) and (b,e), i.e. the part b ... c gets inverted.
+// The first node of the tour is never moved.
+bool GeneticTSPSolver::applyTwoOptMoves(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour)
+{
+	const int n = number_of_nodes;
+	bool changed = false;
+	for (int i=0; i<n-2; ++i)
+	{
+		const int a = tour[i];
+		for (int j=i+2; j<n; ++j)
+		{
+			if (i==0 && j==n-1)	// the edges (tour[0],tour[1]) and (tour[n-1],tour[0]) are adjacent
+				continue;
+			const int b = tour[i+1];
+			const int c = tour[j];
+			const int e = tour[(j+1)%n];
+			const double delta = distances[a*n+c] + distances[b*n+e] - distances[a*n+b] - distances[c*n+e];
+			if (delta < -memetic_improvement_epsilon)
+			{
+				std::reverse(tour.begin()+i+1, tour.begin()+j+1);
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
+
+// Or-opt: the part s0 ... sL between p and q is removed (p gets connected to q) and inserted between two neighboring nodes x
+// and y of the remaining tour, either as x s0 ... sL y or inverted as x sL ... s0 y. The first node of the tour is never moved.
+bool GeneticTSPSolver::applyOrOptMoves(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour)
+{
+	const int n = number_of_nodes;
+	bool changed = false;
+	for (int segment_length=1; segment_length<=3 && segment_length<n-2; ++segment_length)
+	{
+		for (int i=1; i+segment_length<=n; ++i)
+		{
+			const int last = i+segment_length-1;
+			const int p = tour[i-1];
+			const int s0 = tour[i];
+			const int sL = tour[last];
+			const int q = tour[(last+1)%n];
+			const double removal_gain = distances[p*n+s0] + distances[sL*n+q] - distances[p*n+q];
+			if (removal_gain <= memetic_improvement_epsilon)
+				continue;
+
+			for (int j=0; j<n; ++j)
+			{
+				if (j>=i-1 && j<=last)	// edges that touch the part
+					continue;
+				const int x = tour[j];
+				const int y = tour[(j+1)%n];
+				const double forward_cost = distances[x*n+s0] + distances[sL*n+y] - distances[x*n+y];
+				const double inverted_cost = distances[x*n+sL] + distances[s0*n+y] - distances[x*n+y];
+				const bool invert = (inverted_cost < forward_cost);
+				if (std::min(forward_cost, inverted_cost) < removal_gain - memetic_improvement_epsilon)
+				{
+					std::vector<int> segment(tour.begin()+i, tour.begin()+last+1);
+					if (invert == true)
+						std::reverse(segment.begin(), segment.end());
+					tour.erase(tour.begin()+i, tour.begin()+last+1);
+					const int insert_position = (j < i ? j+1 : j+1-segment_length);
+					tour.insert(tour.begin()+insert_position, segment.begin(), segment.end());
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+	return changed;
+}
+
+void GeneticTSPSolver::improveTour(const std::vector<double>& distances, const int number_of_nodes, std::vector<int>& tour)
+{
+	if (number_of_nodes < 4)
+		return;
+
+	// the number of moves is limited, so rounding errors with very large (infinite) distances can't lead to an endless loop
+	const int max_number_of_moves = 100*number_of_nodes;
+	int number_of_moves = 0;
+	bool changed = true;
+	while (changed == true && number_of_moves < max_number_of_moves)
+	{
+		changed = false;
+		while (applyTwoOptMoves(distances, number_of_nodes, tour) == true && ++number_of_moves < max_number_of_moves);
+		if (applyOrOptMoves(distances, number_of_nodes, tour) == true)
+		{
+			changed = true;
+			++number_of_moves;
+		}
+	}
+}
+
+std::vector<int> GeneticTSPSolver::crossoverTours(const std::vector<int>& first_parent, const std::vector<int>& second_parent, RandomNumberGenerator& random_number_generator)
+{
+	// keep the part [begin, end] of the first parent at its place
+	const int n = first_parent.size();
+	boost::random::uniform_int_distribution<int> position_distribution(1, n-1);
+	int begin = position_distribution(random_number_generator);
+	int end = position_distribution(random_number_generator);
+	if (begin > end)
+		std::swap(begin, end);
+	std::vector<bool> kept(n, false);
+	for (int i=begin; i<=end; ++i)
+		kept[first_parent[i]] = true;
+
+	// fill the other places with the remaining nodes in the order of the second parent
+	std::vector<int> child(first_parent);
+	int position = 1;
+	for (int i=1; i<n; ++i)
+	{
+		if (kept[second_parent[i]] == true)
+			continue;
+		if (position == begin)
+			position = end+1;
+		child[position] = second_parent[i];
+		++position;
+	}
+	return child;
+}
+
+void GeneticTSPSolver::mutateTour(std::vector<int>& tour, RandomNumberGenerator& random_number_generator)
+{
+	// cut positions 1 <= first < second < third <= n, the part A contains the start node, the part D may be empty
+	const int n = tour.size();
+	if (n < 4)
+		return;
+	const int first = boost::random::uniform_int_distribution<int>(1, n-2)(random_number_generator);
+	const int second = boost::random::uniform_int_distribution<int>(first+1, n-1)(random_number_generator);
+	const int third = boost::random::uniform_int_distribution<int>(second+1, n)(random_number_generator);
+	std::vector<int> mutated_tour(tour.begin(), tour.begin()+first);
+	mutated_tour.insert(mutated_tour.end(), tour.begin()+second, tour.begin()+third);
+	mutated_tour.insert(mutated_tour.end(), tour.begin()+first, tour.begin()+second);
+	mutated_tour.insert(mutated_tour.end(), tour.begin()+third, tour.end());
+	tour.swap(mutated_tour);
+}
+
+void GeneticTSPSolver::createChildren(const std::vector<double>& distances, const int number_of_nodes, Generation& generation,
+		const int thread_index, const int number_of_threads)
+{
+	const std::vector<std::vector<int> >& population = generation.population;
+	const std::vector<double>& population_lengths = generation.population_lengths;
+	for (size_t child=thread_index; child<generation.children.size(); child+=number_of_threads)
+	{
+		if (isStopRequested() == true)
+			return;
+
+		// random number generator of this child
+		RandomNumberGenerator random_number_generator(random_seed_ + 7919u*generation.index + 104729u*(unsigned int)child);
+		boost::random::uniform_int_distribution<int> parent_distribution(0, population.size()-1);
+
+		// binary tournament selection of the parents
+		int parents[2];
+		for (int p=0; p<2; ++p)
+		{
+			const int first_candidate = parent_distribution(random_number_generator);
+			const int second_candidate = parent_distribution(random_number_generator);
+			parents[p] = (population_lengths[first_candidate] <= population_lengths[second_candidate] ? first_candidate : second_candidate);
+		}
+
+		// recombine the parents in half of the cases, mutate and improve the child
+		std::vector<int> tour;
+		if (parents[0] != parents[1] && boost::random::uniform_int_distribution<int>(0, 1)(random_number_generator) == 0)
+			tour = crossoverTours(population[parents[0]], population[parents[1]], random_number_generator);
+		else
+			tour = population[parents[0]];
+		mutateTour(tour, random_number_generator);
+		improveTour(distances, number_of_nodes, tour);
+
+		generation.children_lengths[child] = getTourLength(distances, number_of_nodes, tour);
+		generation.children[child].swap(tour);
+	}
+}
+
+//This is a memetic solver for the TSP, i.e. a genetic algorithm that improves each child by local search:
+//
+//	I. The initial population consists of the nearest-neighbor tour and mutations of it, all improved by 2-opt and Or-opt.
+//	II. In each generation the children are created in parallel. Each child is either a copy or an order crossover of two
+//		parents that are selected by binary tournaments. It is mutated by a double bridge move (which can't be undone by 2-opt)
+//		and improved by 2-opt and Or-opt until it is a local optimum.
+//	III. The best distinct tours of the parents and children form the next population.
+//	IV. The steps II. and III. are repeated until the best tour hasn't improved for a specified number of generations or
+//		the computation is stopped (maximum computation time, deadline or cancellation).
+std::vector<int> GeneticTSPSolver::solveMemeticTSP(const cv::Mat& path_length_Matrix, const int start_Node)
+{
+	NearestNeighborTSPSolver nearest_neighbor_solver;
+	std::vector<int> nearest_neighbor_tour = nearest_neighbor_solver.solveNearestTSP(path_length_Matrix, start_Node);
+	const int number_of_nodes = path_length_Matrix.rows;
+	if (number_of_nodes < 4 || (int)nearest_neighbor_tour.size() != number_of_nodes) //with less than four nodes all tours have the same length
+		return nearest_neighbor_tour;
+
+	// copy the distance matrix into a continuous array for fast access
+	std::vector<double> distances(number_of_nodes*number_of_nodes);
+	for (int row=0; row<number_of_nodes; ++row)
+		for (int column=0; column<number_of_nodes; ++column)
+			distances[row*number_of_nodes+column] = path_length_Matrix.at<double>(row, column);
+
+	// small problems are solved faster in one thread than the threads are started
+	const int number_of_threads = (number_of_nodes < 30 ? 1 : std::max(1, std::min((int)boost::thread::hardware_concurrency(), memetic_number_of_children)));
+
+	// initial population: the improved nearest neighbor tour and improved double bridge mutations of it, of equally long
+	// tours only the first one is kept
+	std::vector<std::vector<int> > initial_tours(memetic_population_size, nearest_neighbor_tour);
+	std::vector<std::pair<double, int> > initial_candidates;	// (length, index)
+	RandomNumberGenerator random_number_generator(random_seed_ ^ 0x9e3779b9u);	// differs from the generators of the children
+	for (size_t i=0; i<initial_tours.size(); ++i)
+	{
+		if (i > 0)
+			mutateTour(initial_tours[i], random_number_generator);
+		improveTour(distances, number_of_nodes, initial_tours[i]);
+		initial_candidates.push_back(std::pair<double, int>(getTourLength(distances, number_of_nodes, initial_tours[i]), (int)i));
+	}
+	std::stable_sort(initial_candidates.begin(), initial_candidates.end());
+	Generation generation;
+	for (size_t i=0; i<initial_candidates.size(); ++i)
+	{
+		if (generation.population.empty() == false && initial_candidates[i].first - generation.population_lengths.back() <= memetic_improvement_epsilon)
+			continue;
+		generation.population.push_back(initial_tours[initial_candidates[i].second]);
+		generation.population_lengths.push_back(initial_candidates[i].first);
+	}
+	reportImprovement(generation.population[0], generation.population_lengths[0]);
+	generation.children.resize(memetic_number_of_children);
+	generation.children_lengths.resize(memetic_number_of_children);
+
+	int stagnant_generations = 0;
+	for (generation.index=0; stagnant_generations<memetic_stagnation_limit; ++generation.index)
+	{
+		if (isStopRequested() == true)
+			break;
+
+		// create the children in parallel
+		if (number_of_threads == 1)
+			createChildren(distances, number_of_nodes, generation, 0, 1);
+		else
+		{
+			boost::thread_group threads;
+			for (int thread_index=0; thread_index<number_of_threads; ++thread_index)
+				threads.create_thread(boost::bind(&GeneticTSPSolver::createChildren, this, boost::cref(distances), number_of_nodes,
+						boost::ref(generation), thread_index, number_of_threads));
+			threads.join_all();
+		}
+		if (abort_computation_ == true)
+			return std::vector<int>();
+		if (isStopRequested() == true)	// the children of this generation are incomplete
+			break;
+
+		// select the best distinct tours of parents and children, tours of equal length are considered as equal
+		std::vector<std::pair<double, int> > candidates;	// (length, index), index < 0 for children
+		for (size_t i=0; i<generation.population.size(); ++i)
+			candidates.push_back(std::pair<double, int>(generation.population_lengths[i], (int)i));
+		for (size_t i=0; i<generation.children.size(); ++i)
+			candidates.push_back(std::pair<double, int>(generation.children_lengths[i], -1-(int)i));
+		std::stable_sort(candidates.begin(), candidates.end());
+		const double previous_best_length = generation.population_lengths[0];
+		std::vector<std::vector<int> > next_population;
+		std::vector<double> next_population_lengths;
+		for (size_t i=0; i<candidates.size() && (int)next_population.size()<memetic_population_size; ++i)
+		{
+			if (next_population.empty() == false && candidates[i].first - next_population_lengths.back() <= memetic_improvement_epsilon)
+				continue;
+			const int index = candidates[i].second;
+			next_population.push_back(index >= 0 ? generation.population[index] : generation.children[-1-index]);
+			next_population_lengths.push_back(candidates[i].first);
+		}
+		generation.population.swap(next_population);
+		generation.population_lengths.swap(next_population_lengths);
+
+		if (generation.population_lengths[0] < previous_best_length - memetic_improvement_epsilon)
+		{
+			stagnant_generations = 0;
+			reportImprovement(generation.population[0], generation.population_lengths[0]);
+		}
+		else
+			++stagnant_generations;
+	}
+	if (abort_computation_ == true)
+		return std::vector<int>();
+	if (stagnant_generations < memetic_stagnation_limit)
+		std::cout << "GeneticTSPSolver::solveMemeticTSP: Computation stopped after " << generation.index << " generations." << std::endl;
+
+	return generation.population[0];
+}
+
+std::vector<int> GeneticTSPSolver::solveTSP(const cv::Mat& path_length_matrix, const int start_node)
+{
+	return solveGeneticTSP(path_length_matrix, start_node);
+}
+
+//don't compute distance matrix
+std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Matrix, const int start_Node)
+{
+	startComputation();
+	if (use_local_search_ == true)
+		return solveMemeticTSP(path_length_Matrix, start_Node);
+	return solveClassicGeneticTSP(path_length_Matrix, start_Node);
+}
+
 // compute distance matrix and maybe returning it
 // this version does not exclude infinite paths from the TSP ordering
 std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
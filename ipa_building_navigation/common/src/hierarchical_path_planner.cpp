@@ -0,0 +1,408 @@
+#include <ipa_building_navigation/hierarchical_path_planner.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
+#include <sstream>
+#include <iomanip>
+#include <queue>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+// entrances that are longer than this get a transition at each of their ends, shorter ones one in their middle
+static const int max_single_transition_entrance_length = 6;
+
+// maximum number of abstract graphs in the cache
+static const size_t max_number_of_cached_graphs = 8;
+
+// octile distance between two cells, it never overestimates the length of a path on the 8-connected grid
+static inline double estimate(const cv::Point& a, const cv::Point& b)
+{
+	const double xd = std::abs(a.x - b.x);
+	const double yd = std::abs(a.y - b.y);
+	return std::max(xd, yd) + (std::sqrt(2.)-1.)*std::min(xd, yd);
+}
+
+// process-wide cache of the abstract graphs, a graph is built by the first thread that requests it while holding the
+// mutex of its entry, other threads requesting the same graph wait for it
+struct CachedAbstractGraph
+{
+	CachedAbstractGraph() : last_access(0) {}
+
+	boost::mutex mutex;
+	boost::shared_ptr<void> graph;		// the AbstractGraph, empty until it has been built
+	unsigned long long last_access;
+};
+typedef boost::shared_ptr<CachedAbstractGraph> CachedAbstractGraphPtr;
+
+static boost::mutex abstract_graph_cache_mutex;
+static std::map<std::string, CachedAbstractGraphPtr> abstract_graph_cache;
+static unsigned long long abstract_graph_cache_access_counter = 0;
+
+HierarchicalPathPlanner::HierarchicalPathPlanner()
+: downsampling_factor_(1.)
+{
+}
+
+void HierarchicalPathPlanner::setMap(const cv::Mat& original_map, const double downsampling_factor, const double robot_radius,
+		const double map_resolution, const int cluster_size)
+{
+	// the map is hashed only once for the downsampled map and the graph cache
+	const unsigned long long map_hash = MapPreprocessingCache::computeMapHash(original_map);
+	cv::Mat downsampled_map;
+	local_planner_.downsampleMap(map_hash, original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	setMap(map_hash, downsampled_map, downsampling_factor, robot_radius, map_resolution, cluster_size);
+}
+
+void HierarchicalPathPlanner::setMap(const unsigned long long map_hash, const cv::Mat& downsampled_map, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, const int cluster_size)
+{
+	downsampling_factor_ = downsampling_factor;
+	graph_ = getAbstractGraph(map_hash, downsampled_map, downsampling_factor, robot_radius, map_resolution, std::max(2, cluster_size));
+}
+
+size_t HierarchicalPathPlanner::getNumberOfNodes() const
+{
+	return (graph_ ? graph_->nodes.size() : 0);
+}
+
+size_t HierarchicalPathPlanner::getNumberOfEdges() const
+{
+	size_t number_of_edges = 0;
+	if (graph_)
+		for (size_t node=0; node<graph_->edges.size(); ++node)
+			number_of_edges += graph_->edges[node].size();
+	return number_of_edges;
+}
+
+void HierarchicalPathPlanner::clearCache()
+{
+	boost::mutex::scoped_lock lock(abstract_graph_cache_mutex);
+	abstract_graph_cache.clear();
+}
+
+HierarchicalPathPlanner::AbstractGraphPtr HierarchicalPathPlanner::getAbstractGraph(const unsigned long long map_hash, const cv::Mat& downsampled_map,
+		const double downsampling_factor, const double robot_radius, const double map_resolution, const int cluster_size)
+{
+	// maps with the same number of erosions have the same downsampled map (see MapPreprocessingCache::getDownsampledMap)
+	std::stringstream key;
+	key << std::hex << map_hash << std::dec << std::setprecision(10) << "_" << downsampling_factor
+			<< "_" << (int)(robot_radius / map_resolution) << "_" << cluster_size;
+
+	// find or create the entry of the graph, drop the least recently used graph if the cache is full
+	CachedAbstractGraphPtr entry;
+	{
+		boost::mutex::scoped_lock lock(abstract_graph_cache_mutex);
+		std::map<std::string, CachedAbstractGraphPtr>::iterator it = abstract_graph_cache.find(key.str());
+		if (it != abstract_graph_cache.end())
+			entry = it->second;
+		else
+		{
+			while (abstract_graph_cache.size() >= max_number_of_cached_graphs)
+			{
+				std::map<std::string, CachedAbstractGraphPtr>::iterator oldest = abstract_graph_cache.begin();
+				for (it = abstract_graph_cache.begin(); it != abstract_graph_cache.end(); ++it)
+					if (it->second->last_access < oldest->second->last_access)
+						oldest = it;
+				abstract_graph_cache.erase(oldest);
+			}
+			entry.reset(new CachedAbstractGraph());
+			abstract_graph_cache[key.str()] = entry;
+		}
+		entry->last_access = ++abstract_graph_cache_access_counter;
+	}
+
+	// build the graph if this is the first request
+	boost::mutex::scoped_lock entry_lock(entry->mutex);
+	if (!entry->graph)
+	{
+		boost::shared_ptr<AbstractGraph> graph(new AbstractGraph());
+		buildAbstractGraph(*graph, downsampled_map, cluster_size);
+		entry->graph = graph;
+	}
+	return boost::static_pointer_cast<const AbstractGraph>(entry->graph);
+}
+
+cv::Rect HierarchicalPathPlanner::getClusterArea(const AbstractGraph& graph, const int cluster)
+{
+	const int x = (cluster % graph.clusters_x) * graph.cluster_size;
+	const int y = (cluster / graph.clusters_x) * graph.cluster_size;
+	return cv::Rect(x, y, std::min(graph.cluster_size, graph.downsampled_map.cols-x), std::min(graph.cluster_size, graph.downsampled_map.rows-y));
+}
+
+int HierarchicalPathPlanner::getCluster(const AbstractGraph& graph, const cv::Point& cell)
+{
+	return (cell.y / graph.cluster_size) * graph.clusters_x + cell.x / graph.cluster_size;
+}
+
+int HierarchicalPathPlanner::addNode(AbstractGraph& graph, std::map<int, int>& cell_to_node, const cv::Point& cell)
+{
+	const int cell_index = cell.y*graph.downsampled_map.cols + cell.x;
+	std::map<int, int>::iterator it = cell_to_node.find(cell_index);
+	if (it != cell_to_node.end())
+		return it->second;
+	const int node = graph.nodes.size();
+	graph.nodes.push_back(cell);
+	graph.edges.push_back(std::vector<Edge>());
+	graph.cluster_nodes[getCluster(graph, cell)].push_back(node);
+	cell_to_node[cell_index] = node;
+	return node;
+}
+
+//This function builds the abstract graph. The transitions are found on the vertical and the horizontal borders of the
+//clusters, then the intra-cluster edges are computed in parallel, every thread uses its own planner.
+void HierarchicalPathPlanner::buildAbstractGraph(AbstractGraph& graph, const cv::Mat& downsampled_map, const int cluster_size)
+{
+	graph.downsampled_map = downsampled_map;
+	graph.cluster_size = cluster_size;
+	graph.clusters_x = (downsampled_map.cols + cluster_size - 1) / cluster_size;
+	graph.clusters_y = (downsampled_map.rows + cluster_size - 1) / cluster_size;
+	graph.cluster_nodes.resize(graph.clusters_x * graph.clusters_y);
+
+	// node of each cell that is part of a transition
+	std::map<int, int> cell_to_node;
+
+	// 1. find the entrances along the borders, direction 0 = vertical borders (between left and right cluster), 1 = horizontal
+	//    borders, every border is scanned separately for each pair of neighboring clusters
+	for (int direction = 0; direction < 2; ++direction)
+	{
+		const cv::Point along = (direction == 0 ? cv::Point(0, 1) : cv::Point(1, 0));		// step along the border
+		const cv::Point across = (direction == 0 ? cv::Point(1, 0) : cv::Point(0, 1));		// step over the border
+		const int number_of_borders = (direction == 0 ? graph.clusters_x : graph.clusters_y) - 1;
+		const int border_length = (direction == 0 ? downsampled_map.rows : downsampled_map.cols);
+		for (int border = 0; border < number_of_borders; ++border)
+		{
+			const int border_position = (border+1)*cluster_size - 1;	// coordinate of the last cell before the border
+			for (int segment_begin = 0; segment_begin < border_length; segment_begin += cluster_size)
+			{
+				const int segment_end = std::min(segment_begin + cluster_size, border_length);
+				int entrance_begin = -1;
+				for (int i = segment_begin; i <= segment_end; ++i)
+				{
+					bool accessible = false;
+					if (i < segment_end)
+					{
+						const cv::Point cell = border_position*across + i*along;
+						accessible = (downsampled_map.at<unsigned char>(cell) == 255 && downsampled_map.at<unsigned char>(cell + across) == 255);
+					}
+					if (accessible == true && entrance_begin < 0)
+						entrance_begin = i;
+					if (accessible == true || entrance_begin < 0)
+						continue;
+
+					// the entrance [entrance_begin, i-1] is complete
+					const int entrance_length = i - entrance_begin;
+					std::vector<int> transitions;
+					if (entrance_length < max_single_transition_entrance_length)
+						transitions.push_back(entrance_begin + entrance_length/2);
+					else
+					{
+						transitions.push_back(entrance_begin);
+						transitions.push_back(i-1);
+					}
+					for (size_t t = 0; t < transitions.size(); ++t)
+					{
+						const cv::Point cell = border_position*across + transitions[t]*along;
+						const int first_node = addNode(graph, cell_to_node, cell);
+						const int second_node = addNode(graph, cell_to_node, cell + across);
+						Edge edge;
+						edge.cost = 1.;
+						edge.target = second_node;
+						graph.edges[first_node].push_back(edge);
+						edge.target = first_node;
+						graph.edges[second_node].push_back(edge);
+					}
+					entrance_begin = -1;
+				}
+			}
+		}
+	}
+
+	// 2. compute the edges inside the clusters in parallel
+	std::vector<std::vector<std::pair<int, Edge> > > intra_cluster_edges(graph.cluster_nodes.size());
+	ClusterQueue cluster_queue;
+	const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)graph.cluster_nodes.size()));
+	boost::thread_group threads;
+	for (int t=0; t<number_of_threads; ++t)
+		threads.create_thread(boost::bind(&HierarchicalPathPlanner::computeIntraClusterEdges, boost::cref(graph),
+				boost::ref(intra_cluster_edges), boost::ref(cluster_queue)));
+	threads.join_all();
+	for (size_t cluster = 0; cluster < intra_cluster_edges.size(); ++cluster)
+		for (size_t e = 0; e < intra_cluster_edges[cluster].size(); ++e)
+			graph.edges[intra_cluster_edges[cluster][e].first].push_back(intra_cluster_edges[cluster][e].second);
+
+	std::cout << "HierarchicalPathPlanner::buildAbstractGraph: " << graph.clusters_x << "x" << graph.clusters_y << " clusters, "
+			<< graph.nodes.size() << " nodes." << std::endl;
+}
+
+void HierarchicalPathPlanner::computeIntraClusterEdges(const AbstractGraph& graph, std::vector<std::vector<std::pair<int, Edge> > >& intra_cluster_edges,
+		ClusterQueue& cluster_queue)
+{
+	AStarPlanner path_planner;
+	while (true)
+	{
+		int cluster = 0;
+		{
+			boost::mutex::scoped_lock lock(cluster_queue.mutex);
+			cluster = cluster_queue.next_cluster++;
+		}
+		if (cluster >= (int)graph.cluster_nodes.size())
+			return;
+
+		// one search inside the cluster from each of its nodes, the edges are stored in both directions
+		const std::vector<int>& nodes = graph.cluster_nodes[cluster];
+		const cv::Rect area = getClusterArea(graph, cluster);
+		const cv::Mat cluster_map = graph.downsampled_map(area);
+		for (size_t i = 0; i+1 < nodes.size(); ++i)
+		{
+			cv::Mat distance_field;
+			path_planner.computeDistanceField(cluster_map, graph.nodes[nodes[i]] - area.tl(), 1., distance_field);
+			for (size_t j = i+1; j < nodes.size(); ++j)
+			{
+				Edge edge;
+				edge.cost = distance_field.at<double>(graph.nodes[nodes[j]] - area.tl());
+				if (edge.cost > 1e90)
+					continue;
+				edge.target = nodes[j];
+				intra_cluster_edges[cluster].push_back(std::pair<int, Edge>(nodes[i], edge));
+				edge.target = nodes[i];
+				intra_cluster_edges[cluster].push_back(std::pair<int, Edge>(nodes[j], edge));
+			}
+		}
+	}
+}
+
+//This function plans a path on the abstract graph. The start and the goal are connected to the nodes of their clusters by
+//one search inside each of the two clusters, they are added to the graph only for this query (as the nodes with the indices
+//number_of_nodes and number_of_nodes+1), so the graph can be shared.
+double HierarchicalPathPlanner::planPath(const cv::Point& start_point, const cv::Point& end_point, std::vector<cv::Point>* waypoints)
+{
+	if (waypoints != NULL)
+		waypoints->clear();
+	if (!graph_)
+	{
+		std::cout << "HierarchicalPathPlanner::planPath: Error: No map has been set." << std::endl;
+		return 1e100;
+	}
+	const AbstractGraph& graph = *graph_;
+
+	// transform the points to the downsampled map in the same way as AStarPlanner::planPathsToTargets does
+	const cv::Point start = downsampling_factor_*start_point;
+	const cv::Point goal = downsampling_factor_*end_point;
+	if (start.x < 0 || start.x >= graph.downsampled_map.cols || start.y < 0 || start.y >= graph.downsampled_map.rows ||
+			goal.x < 0 || goal.x >= graph.downsampled_map.cols || goal.y < 0 || goal.y >= graph.downsampled_map.rows)
+		return 1e100;
+	if (start == goal)
+	{
+		if (waypoints != NULL)
+		{
+			waypoints->push_back(start_point);
+			waypoints->push_back(end_point);
+		}
+		return 0.;
+	}
+
+	// the abstract path is much longer than the shortest one if the start and the goal are close to each other, so if their
+	// clusters are neighbors the path is searched directly in the area of their clusters and the clusters around them
+	const int start_cluster = getCluster(graph, start);
+	const int goal_cluster = getCluster(graph, goal);
+	if (std::abs(start_cluster % graph.clusters_x - goal_cluster % graph.clusters_x) <= 1 && std::abs(start_cluster / graph.clusters_x - goal_cluster / graph.clusters_x) <= 1)
+	{
+		const int min_x = std::max(0, (std::min(start.x, goal.x) / graph.cluster_size - 1) * graph.cluster_size);
+		const int min_y = std::max(0, (std::min(start.y, goal.y) / graph.cluster_size - 1) * graph.cluster_size);
+		const int max_x = std::min(graph.downsampled_map.cols, (std::max(start.x, goal.x) / graph.cluster_size + 2) * graph.cluster_size);
+		const int max_y = std::min(graph.downsampled_map.rows, (std::max(start.y, goal.y) / graph.cluster_size + 2) * graph.cluster_size);
+		const cv::Rect area(min_x, min_y, max_x-min_x, max_y-min_y);
+		std::vector<cv::Point> route;
+		const double path_length = local_planner_.planPath(graph.downsampled_map(area), start - area.tl(), goal - area.tl(), 1., 0., 1., 0, &route);
+		if (path_length < 1e90)
+		{
+			if (waypoints != NULL)
+			{
+				waypoints->push_back(start_point);
+				for (size_t i = 1; i+1 < route.size(); ++i)
+					waypoints->push_back((1./downsampling_factor_) * (route[i] + area.tl()));
+				waypoints->push_back(end_point);
+			}
+			return path_length / downsampling_factor_;
+		}
+	}
+
+	// connect the start and the goal to the nodes of their clusters
+	const int start_node = graph.nodes.size();
+	const int goal_node = start_node + 1;
+	const cv::Rect start_area = getClusterArea(graph, start_cluster);
+	const cv::Rect goal_area = getClusterArea(graph, goal_cluster);
+	cv::Mat start_field, goal_field;
+	local_planner_.computeDistanceField(graph.downsampled_map(start_area), start - start_area.tl(), 1., start_field);
+	local_planner_.computeDistanceField(graph.downsampled_map(goal_area), goal - goal_area.tl(), 1., goal_field);
+	std::vector<Edge> start_edges;
+	for (size_t i = 0; i < graph.cluster_nodes[start_cluster].size(); ++i)
+	{
+		Edge edge;
+		edge.target = graph.cluster_nodes[start_cluster][i];
+		edge.cost = start_field.at<double>(graph.nodes[edge.target] - start_area.tl());
+		if (edge.cost < 1e90)
+			start_edges.push_back(edge);
+	}
+	std::vector<double> goal_costs(graph.nodes.size()+2, -1.);		// cost of the edge from a node to the goal, < 0 = no edge
+	for (size_t i = 0; i < graph.cluster_nodes[goal_cluster].size(); ++i)
+	{
+		const int node = graph.cluster_nodes[goal_cluster][i];
+		const double cost = goal_field.at<double>(graph.nodes[node] - goal_area.tl());
+		if (cost < 1e90)
+			goal_costs[node] = cost;
+	}
+	if (start_cluster == goal_cluster && start_field.at<double>(goal - start_area.tl()) < 1e90)
+		goal_costs[start_node] = start_field.at<double>(goal - start_area.tl());
+
+	// A* search on the abstract graph
+	std::vector<double> costs(graph.nodes.size()+2, 1e100);
+	std::vector<int> parents(graph.nodes.size()+2, -1);
+	std::vector<bool> closed(graph.nodes.size()+2, false);
+	std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int> >, std::greater<std::pair<double, int> > > open_list;
+	costs[start_node] = 0.;
+	open_list.push(std::pair<double, int>(estimate(start, goal), start_node));
+	while (open_list.empty() == false)
+	{
+		const int node = open_list.top().second;
+		open_list.pop();
+		if (closed[node] == true)
+			continue;
+		closed[node] = true;
+		if (node == goal_node)
+			break;
+
+		// the edges of the node, the goal edge included
+		const std::vector<Edge>& node_edges = (node == start_node ? start_edges : graph.edges[node]);
+		for (size_t e = 0; e <= node_edges.size(); ++e)
+		{
+			int neighbor = goal_node;
+			double cost = goal_costs[node];
+			if (e < node_edges.size())
+			{
+				neighbor = node_edges[e].target;
+				cost = node_edges[e].cost;
+			}
+			if (cost < 0. || closed[neighbor] == true || costs[node] + cost >= costs[neighbor])
+				continue;
+			costs[neighbor] = costs[node] + cost;
+			parents[neighbor] = node;
+			open_list.push(std::pair<double, int>(costs[neighbor] + (neighbor == goal_node ? 0. : estimate(graph.nodes[neighbor], goal)), neighbor));
+		}
+	}
+	if (closed[goal_node] == false)
+		return 1e100;
+
+	if (waypoints != NULL)
+	{
+		const double one_by_downsampling_factor = 1./downsampling_factor_;
+		for (int node = parents[goal_node]; node != start_node; node = parents[node])
+			waypoints->push_back(one_by_downsampling_factor * graph.nodes[node]);
+		waypoints->push_back(start_point);
+		std::reverse(waypoints->begin(), waypoints->end());
+		waypoints->push_back(end_point);
+	}
+
+	return costs[goal_node] / downsampling_factor_;
+}
@@ -0,0 +1,450 @@
+#include <ipa_building_navigation/lin_kernighan_TSP.h>
+
+#include <algorithm>
+
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+// parameters of the heuristic
+static const int lin_kernighan_neighbor_list_size = 10;		// number of nearest nodes that are considered as new tour neighbors of a node
+static const int lin_kernighan_max_depth = 50;				// maximum number of 2-opt moves of one Lin-Kernighan move
+static const int lin_kernighan_max_kick_segment_length = 50;	// maximum length of the parts that are exchanged by a kick
+static const double lin_kernighan_improvement_epsilon = 1e-7;	// minimal gain of a move that counts as improvement
+
+//Default constructor
+LinKernighanTSPSolver::LinKernighanTSPSolver()
+: number_of_nodes_(0), max_number_of_kicks_(-1), random_seed_(5489u)
+{
+
+}
+
+void LinKernighanTSPSolver::distance_matrix_thread(DistanceMatrix& distance_matrix_computation, cv::Mat& distance_matrix,
+		const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
+		double robot_radius, double map_resolution, AStarPlanner& path_planner)
+{
+	distance_matrix_computation.constructDistanceMatrix(distance_matrix, original_map, points, downsampling_factor,
+				robot_radius, map_resolution, pathplanner_);
+}
+
+void LinKernighanTSPSolver::setMaximumNumberOfKicks(const int max_number_of_kicks)
+{
+	max_number_of_kicks_ = max_number_of_kicks;
+}
+
+void LinKernighanTSPSolver::setRandomSeed(const unsigned int random_seed)
+{
+	random_seed_ = random_seed;
+}
+
+double LinKernighanTSPSolver::getTourLength() const
+{
+	double length = getDistance(tour_.back(), tour_[0]);
+	for (size_t i=1; i<tour_.size(); ++i)
+		length += getDistance(tour_[i-1], tour_[i]);
+	return length;
+}
+
+void LinKernighanTSPSolver::reverseTourSegment(const int first_position, const int length)
+{
+	for (int i=0; i<length/2; ++i)
+	{
+		const int first = (first_position + i) % number_of_nodes_;
+		const int second = (first_position + length - 1 - i) % number_of_nodes_;
+		std::swap(tour_[first], tour_[second]);
+		positions_[tour_[first]] = first;
+		positions_[tour_[second]] = second;
+	}
+}
+
+// A Lin-Kernighan move is a sequence of 2-opt moves, the following is written for direction = 1 (successors):
+//	The edge (t1,t2) with t2 = successor(t1) gets removed, leaving the path t2 ... t1. In each step a new edge (t2,t3) is added
+//	to a near node t3 of t2 and the edge (t4,t3) with t4 = predecessor(t3) is removed. Reversing the path t2 ... t4 gives the
+//	path t4 ... t2 t3 ... t1, so t4 is the new t2 and the tour could be closed with the edge (t4,t1). The sum of the lengths of
+//	the removed edges minus the sum of the added edges (gain) has to stay positive. t3 is chosen such that the gain after the
+//	step is maximal, removed edges are never added again and added edges are never removed again. At the end, the tour is
+//	closed after the step with the maximal gain of the closed tour, the later steps are undone.
+bool LinKernighanTSPSolver::applyLinKernighanMove(const int t1, const int direction, std::vector<int>& changed_nodes)
+{
+	const int n = number_of_nodes_;
+	int t2 = getTourNeighbor(t1, direction);
+	double gain = getDistance(t1, t2);
+
+	std::vector<std::pair<int, int> > reversals;		// (first position, length) of the applied reversals
+	std::vector<std::pair<int, int> > removed_edges(1, std::pair<int, int>(std::min(t1, t2), std::max(t1, t2)));
+	std::vector<std::pair<int, int> > added_edges;
+	std::vector<int> touched_nodes;
+	double best_closed_gain = lin_kernighan_improvement_epsilon;
+	size_t best_number_of_reversals = 0;
+
+	for (int depth=0; depth<lin_kernighan_max_depth; ++depth)
+	{
+		// choose the next node t3 among the nearest nodes of t2
+		int best_t3 = -1, best_t4 = -1;
+		double best_gain = 0.;
+		const std::vector<int>& neighbors = neighbor_lists_[t2];
+		for (size_t k=0; k<neighbors.size(); ++k)
+		{
+			const int t3 = neighbors[k];
+			const double partial_gain = gain - getDistance(t2, t3);
+			if (partial_gain <= lin_kernighan_improvement_epsilon)
+				break;	// the neighbors are sorted by distance, so all further neighbors give smaller gains
+			const int t4 = getTourNeighbor(t3, -direction);
+			if (t3 == t1 || t4 == t2)	// (t2,t3) is the removed closing edge or already an edge of the tour
+				continue;
+			const std::pair<int, int> added_edge(std::min(t2, t3), std::max(t2, t3));
+			const std::pair<int, int> removed_edge(std::min(t3, t4), std::max(t3, t4));
+			if (std::find(removed_edges.begin(), removed_edges.end(), added_edge) != removed_edges.end() ||
+					std::find(added_edges.begin(), added_edges.end(), removed_edge) != added_edges.end())
+				continue;
+			const double step_gain = partial_gain + getDistance(t3, t4);
+			if (best_t3 < 0 || step_gain > best_gain)
+			{
+				best_t3 = t3;
+				best_t4 = t4;
+				best_gain = step_gain;
+			}
+		}
+		if (best_t3 < 0)
+			break;
+
+		// reverse the path t2 ... t4
+		const int t3 = best_t3;
+		const int t4 = best_t4;
+		const int first_position = (direction > 0 ? positions_[t2] : positions_[t4]);
+		const int length = (direction > 0 ? positions_[t4] - positions_[t2] : positions_[t2] - positions_[t4]) + 1 + n;
+		reversals.push_back(std::pair<int, int>(first_position, (length - 1) % n + 1));
+		reverseTourSegment(reversals.back().first, reversals.back().second);
+		added_edges.push_back(std::pair<int, int>(std::min(t2, t3), std::max(t2, t3)));
+		removed_edges.push_back(std::pair<int, int>(std::min(t3, t4), std::max(t3, t4)));
+		touched_nodes.push_back(t2);
+		touched_nodes.push_back(t3);
+		touched_nodes.push_back(t4);
+
+		// check the gain of the closed tour
+		gain = best_gain;
+		const double closed_gain = gain - getDistance(t4, t1);
+		if (closed_gain > best_closed_gain)
+		{
+			best_closed_gain = closed_gain;
+			best_number_of_reversals = reversals.size();
+		}
+		t2 = t4;
+	}
+
+	// undo the steps after the best closed tour
+	while (reversals.size() > best_number_of_reversals)
+	{
+		reverseTourSegment(reversals.back().first, reversals.back().second);
+		reversals.pop_back();
+	}
+	if (best_number_of_reversals == 0)
+		return false;
+
+	changed_nodes.push_back(t1);
+	changed_nodes.insert(changed_nodes.end(), touched_nodes.begin(), touched_nodes.begin()+3*best_number_of_reversals);
+	return true;
+}
+
+// Or-opt: the part s0 ... sL between p and q is removed (p gets connected to q) and inserted between two neighboring nodes x
+// and y of the remaining tour, either as x s0 ... sL y or inverted as x sL ... s0 y. Only places next to the nearest nodes
+// of s0 and sL are considered.
+bool LinKernighanTSPSolver::applyOrOptMove(const int first_node, std::vector<int>& changed_nodes)
+{
+	const int n = number_of_nodes_;
+	for (int segment_length=1; segment_length<=3 && segment_length<n-2; ++segment_length)
+	{
+		const int s0 = first_node;
+		const int sL = tour_[(positions_[s0] + segment_length - 1) % n];
+		const int p = getTourNeighbor(s0, -1);
+		const int q = getTourNeighbor(sL, 1);
+		const double removal_gain = getDistance(p, s0) + getDistance(sL, q) - getDistance(p, q);
+		if (removal_gain <= lin_kernighan_improvement_epsilon)
+			continue;
+
+		// mark the nodes of the part
+		std::vector<int> segment(segment_length);
+		for (int i=0; i<segment_length; ++i)
+			segment[i] = tour_[(positions_[s0] + i) % n];
+
+		for (int end=0; end<2; ++end)
+		{
+			const std::vector<int>& neighbors = neighbor_lists_[end==0 ? s0 : sL];
+			for (size_t k=0; k<neighbors.size(); ++k)
+			{
+				const int c = neighbors[k];
+				if (getDistance(c, end==0 ? s0 : sL) >= removal_gain)
+					break;	// the neighbors are sorted by distance, further neighbors are not promising (gain criterion)
+				if (std::find(segment.begin(), segment.end(), c) != segment.end())
+					continue;
+				// try the places before and after c
+				for (int side=0; side<2; ++side)
+				{
+					const int x = (side==0 ? getTourNeighbor(c, -1) : c);
+					const int y = (side==0 ? c : getTourNeighbor(c, 1));
+					if (std::find(segment.begin(), segment.end(), x) != segment.end() || std::find(segment.begin(), segment.end(), y) != segment.end())
+						continue;
+					const double forward_cost = getDistance(x, s0) + getDistance(sL, y) - getDistance(x, y);
+					const double inverted_cost = getDistance(x, sL) + getDistance(s0, y) - getDistance(x, y);
+					if (std::min(forward_cost, inverted_cost) >= removal_gain - lin_kernighan_improvement_epsilon)
+						continue;
+
+					// rebuild the tour: q ... x (inserted part) y ... p
+					if (inverted_cost < forward_cost)
+						std::reverse(segment.begin(), segment.end());
+					std::vector<int> new_tour;
+					new_tour.reserve(n);
+					for (int node=q, i=0; i<n-segment_length; node=getTourNeighbor(node, 1), ++i)
+					{
+						new_tour.push_back(node);
+						if (node == x)
+							new_tour.insert(new_tour.end(), segment.begin(), segment.end());
+					}
+					tour_.swap(new_tour);
+					for (int i=0; i<n; ++i)
+						positions_[tour_[i]] = i;
+
+					changed_nodes.push_back(p);
+					changed_nodes.push_back(q);
+					changed_nodes.push_back(x);
+					changed_nodes.push_back(y);
+					changed_nodes.insert(changed_nodes.end(), segment.begin(), segment.end());
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void LinKernighanTSPSolver::optimizeTour(std::deque<int>& active_nodes, std::vector<bool>& is_active)
+{
+	// the number of moves is limited, so rounding errors with very large (infinite) distances can't lead to an endless loop
+	const int max_number_of_moves = 100*number_of_nodes_;
+	int number_of_moves = 0;
+	std::vector<int> changed_nodes;
+	while (active_nodes.empty() == false && isStopRequested() == false && number_of_moves < max_number_of_moves)
+	{
+		const int t1 = active_nodes.front();
+		active_nodes.pop_front();
+		is_active[t1] = false;
+
+		changed_nodes.clear();
+		if (applyLinKernighanMove(t1, 1, changed_nodes) == true || applyLinKernighanMove(t1, -1, changed_nodes) == true
+				|| applyOrOptMove(t1, changed_nodes) == true)
+		{
+			++number_of_moves;
+			// clear the don't-look bits of the nodes with new tour neighbors
+			for (size_t i=0; i<changed_nodes.size(); ++i)
+			{
+				if (is_active[changed_nodes[i]] == false)
+				{
+					is_active[changed_nodes[i]] = true;
+					active_nodes.push_back(changed_nodes[i]);
+				}
+			}
+		}
+	}
+}
+
+void LinKernighanTSPSolver::reportTour(const int start_node, const double tour_length)
+{
+	if (!improvement_callback_)
+		return;
+	std::vector<int> tour(number_of_nodes_);
+	for (int i=0; i<number_of_nodes_; ++i)
+		tour[i] = tour_[(positions_[start_node] + i) % number_of_nodes_];
+	reportImprovement(tour, tour_length);
+}
+
+void LinKernighanTSPSolver::applyDoubleBridgeKick(RandomNumberGenerator& random_number_generator, std::vector<int>& changed_nodes)
+{
+	// exchange the neighboring parts B and C of the tour ... a B C d ... (all positions cyclic)
+	const int n = number_of_nodes_;
+	const int max_segment_length = std::max(1, std::min(lin_kernighan_max_kick_segment_length, (n-2)/2));
+	const int first_position = boost::random::uniform_int_distribution<int>(0, n-1)(random_number_generator);
+	const int first_length = boost::random::uniform_int_distribution<int>(1, max_segment_length)(random_number_generator);
+	const int second_length = boost::random::uniform_int_distribution<int>(1, max_segment_length)(random_number_generator);
+
+	std::vector<int> segments(first_length+second_length);
+	for (int i=0; i<first_length+second_length; ++i)
+		segments[i] = tour_[(first_position + i) % n];
+	changed_nodes.push_back(getTourNeighbor(segments[0], -1));
+	changed_nodes.push_back(segments[0]);
+	changed_nodes.push_back(segments[first_length-1]);
+	changed_nodes.push_back(segments[first_length]);
+	changed_nodes.push_back(segments.back());
+	changed_nodes.push_back(getTourNeighbor(segments.back(), 1));
+
+	std::rotate(segments.begin(), segments.begin()+first_length, segments.end());
+	for (int i=0; i<first_length+second_length; ++i)
+	{
+		const int position = (first_position + i) % n;
+		tour_[position] = segments[i];
+		positions_[segments[i]] = position;
+	}
+}
+
+//This is a solver for the TSP using the chained Lin-Kernighan heuristic (see lin_kernighan_TSP.h):
+//	I. Compute the nearest neighbor tour and the neighbor lists of all nodes.
+//	II. Improve the tour with Lin-Kernighan and Or-opt moves until no node can be improved anymore.
+//	III. Repeat: perturb the best tour with a double bridge kick, improve it starting from the nodes next to the kick and
+//		 keep it if it is shorter than the best tour.
+std::vector<int> LinKernighanTSPSolver::solveTSP(const cv::Mat& path_length_matrix, const int start_node)
+{
+	return solveLinKernighanTSP(path_length_matrix, start_node);
+}
+
+std::vector<int> LinKernighanTSPSolver::solveLinKernighanTSP(const cv::Mat& path_length_Matrix, const int start_Node)
+{
+	startComputation();
+	NearestNeighborTSPSolver nearest_neighbor_solver;
+	std::vector<int> nearest_neighbor_tour = nearest_neighbor_solver.solveNearestTSP(path_length_Matrix, start_Node);
+	number_of_nodes_ = path_length_Matrix.rows;
+	if (number_of_nodes_ < 4 || (int)nearest_neighbor_tour.size() != number_of_nodes_) //with less than four nodes all tours have the same length
+	{
+		if (number_of_nodes_ >= 4)
+			std::cout << "LinKernighanTSPSolver::solveLinKernighanTSP: Warning: Nearest neighbor tour is incomplete." << std::endl;
+		return nearest_neighbor_tour;
+	}
+	const int n = number_of_nodes_;
+
+	// copy the distance matrix into a continuous array for fast access and compute the neighbor lists
+	distances_.resize(n*n);
+	for (int row=0; row<n; ++row)
+		for (int column=0; column<n; ++column)
+			distances_[row*n+column] = path_length_Matrix.at<double>(row, column);
+	neighbor_lists_.assign(n, std::vector<int>());
+	const int neighbor_list_size = std::min(lin_kernighan_neighbor_list_size, n-1);
+	std::vector<std::pair<double, int> > candidates(n-1);
+	for (int node=0; node<n; ++node)
+	{
+		for (int other=0, i=0; other<n; ++other)
+			if (other != node)
+				candidates[i++] = std::pair<double, int>(getDistance(node, other), other);
+		std::partial_sort(candidates.begin(), candidates.begin()+neighbor_list_size, candidates.end());
+		for (int i=0; i<neighbor_list_size; ++i)
+			neighbor_lists_[node].push_back(candidates[i].second);
+	}
+
+	// improve the nearest neighbor tour with all nodes active
+	tour_ = nearest_neighbor_tour;
+	positions_.resize(n);
+	for (int i=0; i<n; ++i)
+		positions_[tour_[i]] = i;
+	std::deque<int> active_nodes(tour_.begin(), tour_.end());
+	std::vector<bool> is_active(n, true);
+	optimizeTour(active_nodes, is_active);
+	std::vector<int> best_tour = tour_;
+	double best_length = getTourLength();
+	reportTour(start_Node, best_length);
+
+	// kick the best tour and improve it again
+	const int number_of_kicks = (max_number_of_kicks_ >= 0 ? max_number_of_kicks_ : std::max(100, 2*n));
+	RandomNumberGenerator random_number_generator(random_seed_);
+	std::vector<int> changed_nodes;
+	for (int kick=0; kick<number_of_kicks; ++kick)
+	{
+		if (isStopRequested() == true)
+		{
+			std::cout << "LinKernighanTSPSolver::solveLinKernighanTSP: Computation stopped after " << kick << " kicks." << std::endl;
+			break;
+		}
+
+		changed_nodes.clear();
+		applyDoubleBridgeKick(random_number_generator, changed_nodes);
+		for (size_t i=0; i<changed_nodes.size(); ++i)
+		{
+			if (is_active[changed_nodes[i]] == false)
+			{
+				is_active[changed_nodes[i]] = true;
+				active_nodes.push_back(changed_nodes[i]);
+			}
+		}
+		optimizeTour(active_nodes, is_active);
+
+		const double length = getTourLength();
+		if (length < best_length - lin_kernighan_improvement_epsilon)
+		{
+			best_length = length;
+			best_tour = tour_;
+			reportTour(start_Node, best_length);
+		}
+		else
+		{
+			tour_ = best_tour;
+			for (int i=0; i<n; ++i)
+				positions_[tour_[i]] = i;
+		}
+	}
+	if (abort_computation_ == true)
+		return std::vector<int>();
+
+	// return the tour beginning at the start node
+	std::vector<int> optimal_order(n);
+	const int start_position = std::find(best_tour.begin(), best_tour.end(), start_Node) - best_tour.begin();
+	for (int i=0; i<n; ++i)
+		optimal_order[i] = best_tour[(start_position + i) % n];
+	return optimal_order;
+}
+
+// compute distance matrix and maybe returning it
+// this version does not exclude infinite paths from the TSP ordering
+std::vector<int> LinKernighanTSPSolver::solveLinKernighanTSP(const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
+		double robot_radius, double map_resolution, const int start_Node, cv::Mat* distance_matrix)
+{
+	//calculate the distance matrix
+	std::cout << "LinKernighanTSPSolver::solveLinKernighanTSP: Constructing distance matrix..." << std::endl;
+	cv::Mat distance_matrix_ref;
+	if (distance_matrix != 0)
+		distance_matrix_ref = *distance_matrix;
+	DistanceMatrix distance_matrix_computation;
+	boost::thread t(boost::bind(&LinKernighanTSPSolver::distance_matrix_thread, this, boost::ref(distance_matrix_computation),
+			boost::ref(distance_matrix_ref), boost::cref(original_map), boost::cref(points), downsampling_factor,
+			robot_radius, map_resolution, boost::ref(pathplanner_)));
+	bool finished = false;
+	while (finished==false)
+	{
+		if (abort_computation_==true)
+			distance_matrix_computation.abortComputation();
+		finished = t.try_join_for(boost::chrono::milliseconds(10));
+	}
+
+	if (abort_computation_==true)
+	{
+		std::vector<int> return_vector;
+		return return_vector;
+	}
+
+	return (solveLinKernighanTSP(distance_matrix_ref, start_Node));
+}
+
+
+// compute TSP from a cleaned distance matrix (does not contain any infinity paths) that has to be computed
+std::vector<int> LinKernighanTSPSolver::solveLinKernighanTSPClean(const cv::Mat& original_map, const std::vector<cv::Point>& points,
+		double downsampling_factor, double robot_radius, double map_resolution, const int start_node)
+{
+	// compute a cleaned distance matrix
+	cv::Mat distance_matrix_cleaned;
+	std::map<int,int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
+	int new_start_node = start_node;
+	DistanceMatrix distance_matrix_computation;
+	distance_matrix_computation.computeCleanedDistanceMatrix(original_map, points, downsampling_factor, robot_radius, map_resolution, pathplanner_,
+			distance_matrix_cleaned, cleaned_index_to_original_index_mapping, new_start_node);
+
+	// solve TSP and re-index points to original indices
+	return solveLinKernighanTSPWithCleanedDistanceMatrix(distance_matrix_cleaned, cleaned_index_to_original_index_mapping, new_start_node);
+}
+
+
+// compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
+std::vector<int> LinKernighanTSPSolver::solveLinKernighanTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
+		const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node)
+{
+	// solve TSP and re-index points to original indices
+	std::vector<int> optimal_order = solveLinKernighanTSP(distance_matrix, start_node);
+	for (size_t i=0; i<optimal_order.size(); ++i)
+		optimal_order[i] = cleaned_index_to_original_index_mapping.at(optimal_order[i]);
+
+	return optimal_order;
+}
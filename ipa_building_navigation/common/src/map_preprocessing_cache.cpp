@@ -0,0 +1,247 @@
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
+#include <sstream>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+// functions that compute the standard artifacts
+static void computeErodedMap(const cv::Mat& map, cv::Mat& eroded_map, const int number_of_erosions)
+{
+	cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1, -1), number_of_erosions);
+}
+
+static void computeDownsampledMap(const cv::Mat& map, cv::Mat& downsampled_map, const unsigned long long map_hash, const double downsampling_factor, const int number_of_erosions)
+{
+	// erode the map so the planner doesn't go near the walls, then downsample it to reduce calculation time
+	cv::Mat eroded_map = MapPreprocessingCache::getInstance().getErodedMap(map_hash, map, number_of_erosions);
+	if (downsampling_factor != 1.)
+		cv::resize(eroded_map, downsampled_map, cv::Size(0, 0), downsampling_factor, downsampling_factor, cv::INTER_NEAREST);
+	else
+		downsampled_map = eroded_map;
+}
+
+static void computeDistanceTransform(const cv::Mat& map, cv::Mat& distance_map, const unsigned long long map_hash, const int number_of_erosions)
+{
+	if (number_of_erosions > 0)
+		cv::distanceTransform(MapPreprocessingCache::getInstance().getErodedMap(map_hash, map, number_of_erosions), distance_map, CV_DIST_L2, 5);
+	else
+		cv::distanceTransform(map, distance_map, CV_DIST_L2, 5);
+}
+
+// memory of the pixels of an image
+static size_t getImageBytes(const cv::Mat& image)
+{
+	return (size_t)image.rows * (size_t)image.cols * image.elemSize();
+}
+
+
+MapPreprocessingCache::MapPreprocessingCache(const size_t max_bytes)
+: max_bytes_(max_bytes), number_of_bytes_(0), access_counter_(0), number_of_hits_(0), number_of_misses_(0)
+{
+}
+
+MapPreprocessingCache& MapPreprocessingCache::getInstance()
+{
+	static MapPreprocessingCache instance;
+	return instance;
+}
+
+unsigned long long MapPreprocessingCache::computeMapHash(const cv::Mat& map)
+{
+	const unsigned long long fnv_prime = 1099511628211ULL;
+	unsigned long long hash = 14695981039346656037ULL;
+
+	// include the geometry of the map, so maps with the same data but different size get different hashes
+	const int header[3] = {map.rows, map.cols, map.type()};
+	const unsigned char* header_bytes = (const unsigned char*)header;
+	for (size_t i=0; i<sizeof(header); ++i)
+		hash = (hash ^ header_bytes[i]) * fnv_prime;
+
+	// hash the data row by row, the map does not need to be continuous
+	const size_t row_length = map.cols * map.elemSize();
+	for (int v=0; v<map.rows; ++v)
+	{
+		const unsigned char* row = map.ptr<unsigned char>(v);
+		for (size_t u=0; u<row_length; ++u)
+			hash = (hash ^ row[u]) * fnv_prime;
+	}
+
+	return hash;
+}
+
+cv::Mat MapPreprocessingCache::getArtifact(const cv::Mat& map, const std::string& artifact_key, const ArtifactFunction& compute_artifact)
+{
+	return getArtifact(computeMapHash(map), map, artifact_key, compute_artifact);
+}
+
+cv::Mat MapPreprocessingCache::getArtifact(const unsigned long long map_hash, const cv::Mat& map, const std::string& artifact_key, const ArtifactFunction& compute_artifact)
+{
+	std::stringstream map_prefix;
+	map_prefix << std::hex << map_hash << "/";
+	const std::string key = map_prefix.str() + artifact_key;
+
+	// find or create the entry of the artifact
+	ArtifactPtr artifact;
+	cv::Mat stored_map;		// copy of the map that is already stored with another artifact of the same hash
+	{
+		boost::mutex::scoped_lock lock(cache_mutex_);
+		std::map<std::string, ArtifactPtr>::iterator it = artifacts_.find(key);
+		if (it != artifacts_.end())
+		{
+			artifact = it->second;
+			++number_of_hits_;
+		}
+		else
+		{
+			std::map<std::string, ArtifactPtr>::iterator sibling = artifacts_.lower_bound(map_prefix.str());
+			if (sibling != artifacts_.end() && sibling->first.compare(0, map_prefix.str().size(), map_prefix.str()) == 0)
+				stored_map = sibling->second->source_map;
+			artifact.reset(new Artifact());
+			artifacts_[key] = artifact;
+			++number_of_misses_;
+		}
+		artifact->last_access = ++access_counter_;
+	}
+
+	// compute the artifact if this is the first request, other threads requesting the same artifact wait here
+	cv::Mat image, source_map;
+	bool computed_here = false;
+	{
+		boost::mutex::scoped_lock artifact_lock(artifact->mutex);
+		if (artifact->computed == false)
+		{
+			// keep a copy of the map (shared with the other artifacts of the map if possible), so a later write into map
+			// by the caller does not change the cache and hash collisions can be detected
+			artifact->source_map = (stored_map.empty() == false && isSameMap(map, stored_map) == true ? stored_map : map.clone());
+			compute_artifact(map, artifact->image);
+			// the image must not share its data with the caller's map
+			if (artifact->image.data >= map.datastart && artifact->image.data < map.dataend)
+				artifact->image = artifact->image.clone();
+			artifact->computed = true;
+			computed_here = true;
+
+			// account the memory of the artifact if it is still stored and drop old artifacts if the budget is exceeded
+			boost::mutex::scoped_lock lock(cache_mutex_);
+			std::map<std::string, ArtifactPtr>::iterator it = artifacts_.find(key);
+			if (it != artifacts_.end() && it->second == artifact)
+			{
+				artifact->bytes = getImageBytes(artifact->image) + getImageBytes(artifact->source_map);
+				number_of_bytes_ += artifact->bytes;
+				evictArtifacts(artifact);
+			}
+		}
+		image = artifact->image;
+		source_map = artifact->source_map;
+	}
+
+	// hash collision: the artifact belongs to another map with the same hash, so compute it without the cache
+	if (computed_here == false && isSameMap(map, source_map) == false)
+	{
+		std::cout << "MapPreprocessingCache::getArtifact: Warning: hash collision for " << artifact_key << ", computing it without the cache." << std::endl;
+		cv::Mat uncached_image;
+		compute_artifact(map, uncached_image);
+		return uncached_image;
+	}
+	return image;
+}
+
+cv::Mat MapPreprocessingCache::getErodedMap(const cv::Mat& map, const int number_of_erosions)
+{
+	if (number_of_erosions <= 0)
+		return map;
+	return getErodedMap(computeMapHash(map), map, number_of_erosions);
+}
+
+cv::Mat MapPreprocessingCache::getErodedMap(const unsigned long long map_hash, const cv::Mat& map, const int number_of_erosions)
+{
+	if (number_of_erosions <= 0)
+		return map;
+
+	std::stringstream key;
+	key << "eroded_map:" << number_of_erosions;
+	return getArtifact(map_hash, map, key.str(), boost::bind(&computeErodedMap, _1, _2, number_of_erosions));
+}
+
+cv::Mat MapPreprocessingCache::getDownsampledMap(const cv::Mat& map, const double downsampling_factor, const double robot_radius, const double map_resolution)
+{
+	const int number_of_erosions = (robot_radius / map_resolution);
+	if (number_of_erosions <= 0 && downsampling_factor == 1.)
+		return map;
+	return getDownsampledMap(computeMapHash(map), map, downsampling_factor, robot_radius, map_resolution);
+}
+
+cv::Mat MapPreprocessingCache::getDownsampledMap(const unsigned long long map_hash, const cv::Mat& map, const double downsampling_factor, const double robot_radius, const double map_resolution)
+{
+	// calculate the number of times for eroding from the robot radius [m], maps with the same number of erosions are identical
+	const int number_of_erosions = (robot_radius / map_resolution);
+	if (number_of_erosions <= 0 && downsampling_factor == 1.)
+		return map;
+
+	std::stringstream key;
+	key << "downsampled_map:" << downsampling_factor << ":" << number_of_erosions;
+	return getArtifact(map_hash, map, key.str(), boost::bind(&computeDownsampledMap, _1, _2, map_hash, downsampling_factor, number_of_erosions));
+}
+
+cv::Mat MapPreprocessingCache::getDistanceTransform(const cv::Mat& map, const int number_of_erosions)
+{
+	return getDistanceTransform(computeMapHash(map), map, number_of_erosions);
+}
+
+cv::Mat MapPreprocessingCache::getDistanceTransform(const unsigned long long map_hash, const cv::Mat& map, const int number_of_erosions)
+{
+	std::stringstream key;
+	key << "distance_transform:" << std::max(0, number_of_erosions);
+	return getArtifact(map_hash, map, key.str(), boost::bind(&computeDistanceTransform, _1, _2, map_hash, number_of_erosions));
+}
+
+void MapPreprocessingCache::clear()
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	artifacts_.clear();
+	number_of_bytes_ = 0;
+}
+
+size_t MapPreprocessingCache::getNumberOfHits() const
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	return number_of_hits_;
+}
+
+size_t MapPreprocessingCache::getNumberOfMisses() const
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	return number_of_misses_;
+}
+
+size_t MapPreprocessingCache::getNumberOfBytes() const
+{
+	boost::mutex::scoped_lock lock(cache_mutex_);
+	return number_of_bytes_;
+}
+
+bool MapPreprocessingCache::isSameMap(const cv::Mat& map1, const cv::Mat& map2)
+{
+	if (map1.rows != map2.rows || map1.cols != map2.cols || map1.type() != map2.type())
+		return false;
+	const size_t row_length = map1.cols * map1.elemSize();
+	for (int v=0; v<map1.rows; ++v)
+		if (std::memcmp(map1.ptr<unsigned char>(v), map2.ptr<unsigned char>(v), row_length) != 0)
+			return false;
+	return true;
+}
+
+void MapPreprocessingCache::evictArtifacts(const ArtifactPtr& keep)
+{
+	// artifacts that are still in use by other threads stay valid, because they are held by shared pointers, each artifact
+	// is charged with its copy of the map although the copy is shared, so the budget is an upper bound of the used memory
+	while (number_of_bytes_ > max_bytes_ && artifacts_.size() > 1)
+	{
+		std::map<std::string, ArtifactPtr>::iterator oldest = artifacts_.end();
+		for (std::map<std::string, ArtifactPtr>::iterator it=artifacts_.begin(); it!=artifacts_.end(); ++it)
+			if (it->second != keep && (oldest == artifacts_.end() || it->second->last_access < oldest->second->last_access))
+				oldest = it;
+		number_of_bytes_ -= oldest->second->bytes;
+		artifacts_.erase(oldest);
+	}
+}
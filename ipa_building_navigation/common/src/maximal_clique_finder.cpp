@@ -1,186 +1,162 @@
 #include <ipa_building_navigation/maximal_clique_finder.h>
 
-using namespace std;
-using namespace boost;
+#include <algorithm>
 
 //
 //***********************Maximal Clique Finder*****************************
 //
 //This class provides a maximal clique-finder for a given Graph that finds all maximal cliques in this. A maximal clique
 //is a subgraph in the given Graph, in which all Nodes are connected to each other and cannot be enlarged by adding other
-//Nodes ( https://en.wikipedia.org/wiki/Maximum_clique ). It uses the c++ Boost library by using the implementen Bron-Kerbosch
-//function and defining the Graph as a boost::undirected_Graph. Due of a missing documentation for this function see
+//Nodes ( https://en.wikipedia.org/wiki/Maximum_clique ). It uses the Bron-Kerbosch algorithm with the pivoting of Tomita
+//et al. and the outer loop in degeneracy ordering as described in
 //
-//		http://www.boost.org/doc/libs/1_56_0/libs/graph/example/bron_kerbosch_print_cliques.cpp
-//		http://www.boost.org/doc/libs/1_58_0/libs/graph/example/bron_kerbosch_clique_number.cpp
-//		http://www.boost.org/doc/libs/1_47_0/libs/graph/example/helper.hpp
-//		http://stackoverflow.com/questions/23299406/maximum-weighted-clique-in-a-large-graph-with-high-density
+//		D. Eppstein, M. Loeffler, D. Strash: Listing All Maximal Cliques in Sparse Graphs in Near-optimal Time. ISAAC 2010.
 //
-//for further information.
+//The sets of vertices are bitsets over the indices of the nodes, so intersections of candidate sets with neighborhoods
+//take only a few word operations even for hundreds of rooms.
 //As input this function takes a symmetrical Matrix that stores the pathlengths from one node of the graph to another.
 //If one Node has no connection to another the element in the matrix is zero, it also is at the main-diagonal.
 //!!!!!!!!!!!!!See maximal_clique_finder.h for further information on formatting.!!!!!!!!!!!!!
 
-static std::vector<std::vector<int> > names_; //vector to save the cliques achieved by Boost
-
-// The Actor type stores the name of each vertex in the graph.
-struct Actor
+cliqueFinder::cliqueFinder()
 {
-	string name;
-};
 
-//define some types that are used for the boost function
-typedef undirected_graph<Actor> Graph;
-typedef graph_traits<Graph>::vertex_descriptor Vertex;
-typedef graph_traits<Graph>::edge_descriptor Edge;
-typedef property_map<Graph, string Actor::*>::type NameMap;
+}
 
-template<typename Graph, typename NameMap, typename VertexMap>
-typename graph_traits<Graph>::vertex_descriptor cliqueFinder::addNamedVertex(Graph& g, NameMap nm, const string& name, VertexMap& vm)
+void cliqueFinder::setStopCondition(const StopCondition& stop_condition)
 {
-	typedef typename graph_traits<Graph>::vertex_descriptor Vertex;
-	typedef typename VertexMap::iterator Iterator;
-
-	Vertex v;
-	Iterator iter;
-	bool inserted;
-	boost::tie(iter, inserted) = vm.insert(make_pair(name, Vertex()));
-	if (inserted)
-	{
-		// The name was unique so we need to add a vertex to the graph
-		v = add_vertex(g);
-		iter->second = v;
-		put(nm, v, name); // store the name in the name map
-	}
-	else
-	{
-		// We had already inserted this name so we can return the
-		// associated vertex.
-		v = iter->second;
-	}
-	return v;
+	stop_condition_ = stop_condition;
 }
 
-//This class is the Visitor for all nodes in the graph, which is used by boost::bron_kerbosch. the function clique() gets
-//called everytime a maximal clique was found. This comes from the boost implementation.
-template<typename OutputStream>
-struct visitor
+//This function creates the adjacency sets of the graph out of the distance-Matrix. Two nodes are connected if the path
+//between them exists and is not longer than maxval. Cutting the too long edges is neccessary to find possible areas in the
+//graph for cliques. If the complete graph is connected only one clique will be found, containing all Nodes in the graph,
+//which isn't very useful for planning.
+void cliqueFinder::createGraph(std::vector<VertexSet>& adjacency, const cv::Mat& distance_matrix, const double maxval)
 {
-	vector<int> current_names;
-	visitor()
-	{
-
-	}
-
-	template<typename Clique, typename Graph>
-	void clique(const Clique& c, const Graph& g)
+	const int number_of_nodes = distance_matrix.rows;
+	adjacency.assign(number_of_nodes, VertexSet(number_of_nodes));
+	for (int current_vertex = 0; current_vertex < number_of_nodes; current_vertex++)
 	{
-		// Iterate over the clique and print each vertex within it.
-		typename Clique::const_iterator i, end = c.end();
-		for (i = c.begin(); i != end; ++i)
+		for (int neighbor_node = current_vertex+1; neighbor_node < number_of_nodes; neighbor_node++)
 		{
-			current_names.push_back(atoi(g[*i].name.c_str()));
+			const double distance = distance_matrix.at<double>(current_vertex, neighbor_node);
+			if (distance > 0 && distance <= maxval)
+			{
+				adjacency[current_vertex].set(neighbor_node);
+				adjacency[neighbor_node].set(current_vertex);
+			}
 		}
-		names_.push_back(current_names); //save the clique to return all later
-		current_names.clear(); //clear the current clique
 	}
-};
-
-cliqueFinder::cliqueFinder()
-{
-
 }
 
-//This function creates a boost::undirected_graph out of the cutted distance-Matrix. The Graph is used for the
-//boost::bron-kerbosch algorihtm.
-template<typename Graph>
-void cliqueFinder::createGraph(Graph& graph, cv::Mat& distance_Matrix)
+//This function orders the vertices by repeatedly taking the vertex with the smallest number of neighbors that have not been
+//taken yet. Starting the search from each vertex in this order with only the later vertices as candidates keeps the
+//candidate sets of the outer loop as small as the degeneracy of the graph.
+std::vector<int> cliqueFinder::getDegeneracyOrdering(const std::vector<VertexSet>& adjacency)
 {
-	vector<Vertex> vertexes;
-	NameMap nmap(get(&Actor::name, graph));
-	std::map<std::string, Vertex> vert_map;
-	//add all Nodes to the graph
-	for (int counter = 0; counter < distance_Matrix.cols; counter++)
+	const int number_of_nodes = adjacency.size();
+	std::vector<int> degrees(number_of_nodes);
+	for (int node = 0; node < number_of_nodes; ++node)
+		degrees[node] = adjacency[node].count();
+
+	std::vector<int> ordering;
+	std::vector<bool> taken(number_of_nodes, false);
+	for (int step = 0; step < number_of_nodes; ++step)
 	{
-		stringstream current_name;
-		current_name << counter; //<< counter;
-		Vertex current_vertex = addNamedVertex(graph, nmap, current_name.str(), vert_map);
-		vertexes.push_back(current_vertex);
+		int next_node = -1;
+		for (int node = 0; node < number_of_nodes; ++node)
+			if (taken[node] == false && (next_node < 0 || degrees[node] < degrees[next_node]))
+				next_node = node;
+		taken[next_node] = true;
+		ordering.push_back(next_node);
+		for (VertexSet::size_type neighbor = adjacency[next_node].find_first(); neighbor != VertexSet::npos; neighbor = adjacency[next_node].find_next(neighbor))
+			--degrees[neighbor];
 	}
-	//add each Edge if there is a connection between the Nodes
-	for (int current_vertex = 0; current_vertex < vertexes.size(); current_vertex++)
+	return ordering;
+}
+
+//This function is the recursive part of the Bron-Kerbosch algorithm. The pivot is the vertex of candidates or excluded with
+//the most neighbors among the candidates, only candidates that are not neighbors of the pivot have to be tried, because
+//every maximal clique contains the pivot or one of its non-neighbors.
+void cliqueFinder::findCliques(const std::vector<VertexSet>& adjacency, std::vector<int>& current_clique, VertexSet& candidates,
+		VertexSet& excluded, std::vector<std::vector<int> >& cliques)
+{
+	if (candidates.none() == true)
 	{
-		for (int neighbor_node = current_vertex; neighbor_node < vertexes.size(); neighbor_node++)
+		if (excluded.none() == true)
 		{
-			if (distance_Matrix.at<double>(current_vertex, neighbor_node) > 0)
-			{
-				add_edge(vertexes[current_vertex], vertexes[neighbor_node], graph);
-			}
+			//the clique can't be enlarged anymore, save it with ascending node indices
+			std::vector<int> clique(current_clique);
+			std::sort(clique.begin(), clique.end());
+			cliques.push_back(clique);
 		}
+		return;
 	}
-}
 
-//This function cuts an edge if the distance between the two Nodes is too large. This is neccessary to find possible
-//areas in the graph for cliques. If the complete graph is connected only one clique will be found, containing all
-//Nodes in the graph, which isn't very useful for planning.
-void cliqueFinder::cutTooLongEdges(cv::Mat& complete_distance_matrix, double maxval)
-{
-	for (int row = 0; row < complete_distance_matrix.rows; row++)
+	//choose the pivot
+	VertexSet::size_type pivot = VertexSet::npos;
+	size_t max_number_of_neighbors = 0;
+	const VertexSet candidates_or_excluded = candidates | excluded;
+	for (VertexSet::size_type node = candidates_or_excluded.find_first(); node != VertexSet::npos; node = candidates_or_excluded.find_next(node))
 	{
-		for (int col = 0; col < complete_distance_matrix.cols; col++)
+		const size_t number_of_neighbors = (candidates & adjacency[node]).count();
+		if (pivot == VertexSet::npos || number_of_neighbors > max_number_of_neighbors)
 		{
-			if (complete_distance_matrix.at<double>(row, col) > maxval)
-			{
-				complete_distance_matrix.at<double>(row, col) = 0;
-			}
+			pivot = node;
+			max_number_of_neighbors = number_of_neighbors;
 		}
 	}
+
+	//extend the current clique by every candidate that is not a neighbor of the pivot
+	const VertexSet branch_vertices = candidates - adjacency[pivot];
+	for (VertexSet::size_type node = branch_vertices.find_first(); node != VertexSet::npos; node = branch_vertices.find_next(node))
+	{
+		if (isStopConditionMet(stop_condition_) == true)
+			return;
+
+		VertexSet new_candidates = candidates & adjacency[node];
+		VertexSet new_excluded = excluded & adjacency[node];
+		current_clique.push_back(node);
+		findCliques(adjacency, current_clique, new_candidates, new_excluded, cliques);
+		current_clique.pop_back();
+		candidates.reset(node);
+		excluded.set(node);
+	}
 }
 
 //This function uses the previously described functions and finds all maximal cliques in a given graph. The maxval parameter
 //is used to cut edges that are too long. See maximal_clique_finder.h for further information on formatting.
 std::vector<std::vector<int> > cliqueFinder::getCliques(const cv::Mat& distance_matrix, double maxval)
 {
-	// Create a graph object
-	Graph g;
-
-	//cut the edges if they are too long
-	cv::Mat cutted_distance_matrix = distance_matrix.clone();
-	cutTooLongEdges(cutted_distance_matrix, maxval);
-
-	//Create a graph out of the cutted distance matrix
-	createGraph(g, cutted_distance_matrix);
-
-	//Object needed from boost to return the results
-	visitor<ostream> vis;
-
-	// Use the Bron-Kerbosch algorithm to find all cliques
-	bron_kerbosch_all_cliques(g, vis);
-
-	//Make sure that nodes, which are too far away from other nodes are in the clique-vector
-	//(a clique has at least two nodes, but in this case it is neccessary to have all nodes in the cliques and
-	//nodes that are too far away from others count also as a possible group)
-	for (int node = 0; node < distance_matrix.rows; node++)
+	std::vector<std::vector<int> > cliques;
+	const int number_of_nodes = distance_matrix.rows;
+
+	//Create a graph out of the distance matrix without the too long edges
+	std::vector<VertexSet> adjacency;
+	createGraph(adjacency, distance_matrix, maxval);
+
+	//start the search at each vertex in degeneracy order, the vertices before it in this order are excluded, so every
+	//maximal clique is found once (nodes without neighbors give cliques of one node)
+	const std::vector<int> ordering = getDegeneracyOrdering(adjacency);
+	VertexSet later_vertices(number_of_nodes);
+	later_vertices.set();
+	std::vector<int> current_clique;
+	for (size_t i = 0; i < ordering.size(); ++i)
 	{
-		bool add = true;
-		for (int group = 0; group < names_.size(); group++)
+		if (isStopConditionMet(stop_condition_) == true)
 		{
-			if (contains(names_[group], node))
-			{
-				add = false;
-			}
-		}
-		if(add)
-		{
-			std::vector<int> adding_vector;
-			adding_vector.push_back(node);
-			names_.push_back(adding_vector);
+			std::cout << "cliqueFinder::getCliques: Search stopped, returning the " << cliques.size() << " maximal cliques found so far." << std::endl;
+			break;
 		}
+		const int node = ordering[i];
+		later_vertices.reset(node);
+		VertexSet candidates = adjacency[node] & later_vertices;
+		VertexSet excluded = adjacency[node] - later_vertices;
+		current_clique.push_back(node);
+		findCliques(adjacency, current_clique, candidates, excluded, cliques);
+		current_clique.pop_back();
 	}
 
-	//save the names_ vector and clear it for next usage
-	std::vector<std::vector<int> > returning_vector(names_);
-	names_.clear();
-
-	return returning_vector;
+	return cliques;
 }
@@ -6,6 +6,11 @@ NearestNeighborTSPSolver::NearestNeighborTSPSolver()
 
 }
 
+std::vector<int> NearestNeighborTSPSolver::solveTSP(const cv::Mat& path_length_matrix, const int start_node)
+{
+	return solveNearestTSP(path_length_matrix, start_node);
+}
+
 //This function calculates the order of the TSP, using the nearest neighbor method. It uses a pathlength Matrix, which
 //should be calculated once. This Matrix should save the pathlengths with this logic:
 //		1. The rows show from which Node the length is calculated.
@@ -27,7 +32,7 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& path_l
 		//check every Point for the next nearest neighbor and add it to the order
 		do
 		{
-			int next_node; //saver for next node
+			int next_node = -1; //saver for next node
 			double min_distance = 1e100; //saver for distance to current next node
 			for (int current_neighbor = 0; current_neighbor < path_length_matrix.cols; current_neighbor++)
 			{
@@ -39,6 +44,8 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& path_l
 						next_node = current_neighbor;
 						min_distance = length;
 					}
+					else if (next_node < 0) //take any unvisited node if none of them is reachable
+						next_node = current_neighbor;
 				}
 			}
 			calculated_order.push_back(next_node); //add the found nearest neighbor to the order-vector
@@ -52,6 +59,9 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& path_l
 		calculated_order.push_back(start_node);
 	}
 
+	// the tour is found at once, so it is reported as the only improvement
+	reportImprovement(calculated_order, (path_length_matrix.rows > 1 ? getClosedTourLength(path_length_matrix, calculated_order) : 0.));
+
 	return calculated_order;
 }
 
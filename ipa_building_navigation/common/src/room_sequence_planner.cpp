@@ -0,0 +1,237 @@
+#include <ipa_building_navigation/room_sequence_planner.h>
+
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/set_cover_solver.h>
+#include <ipa_building_navigation/trolley_position_finder.h>
+
+RoomSequencePlanner::RoomSequencePlanner(DistanceMatrixCache& distance_matrix_cache)
+: distance_matrix_cache_(distance_matrix_cache)
+{
+}
+
+void RoomSequencePlanner::setTSPSolver(const TSPSolverFunction& tsp_solver_function)
+{
+	tsp_solver_function_ = tsp_solver_function;
+}
+
+void RoomSequencePlanner::setStopCondition(const StopCondition& stop_condition)
+{
+	stop_condition_ = stop_condition;
+}
+
+boost::shared_ptr<AnytimeTSPSolver> RoomSequencePlanner::createTSPSolver(const int tsp_solver)
+{
+	boost::shared_ptr<AnytimeTSPSolver> solver;
+	if (tsp_solver == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
+		solver.reset(new NearestNeighborTSPSolver());
+	else if (tsp_solver == TSP_GENETIC) //genetic TSP solver
+		solver.reset(new GeneticTSPSolver());
+	else if (tsp_solver == TSP_CONCORDE) //concorde TSP solver
+		solver.reset(new ConcordeTSPSolver());
+	else if (tsp_solver == TSP_LIN_KERNIGHAN) //Lin-Kernighan TSP solver
+		solver.reset(new LinKernighanTSPSolver());
+	return solver;
+}
+
+bool RoomSequencePlanner::planSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+		const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+		std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics* statistics)
+{
+	cliques.clear();
+	trolley_positions.clear();
+	RoomSequencePlanningStatistics planning_statistics;
+	if (parameters.planning_method == 1)
+		planDragSequence(floor_plan, floor_plan_hash, rooms, start_position, parameters, cliques, trolley_positions, planning_statistics);
+	else if (parameters.planning_method == 2)
+		planGroupSequence(floor_plan, floor_plan_hash, rooms, start_position, parameters, cliques, trolley_positions, planning_statistics);
+	else
+	{
+		std::cout << "RoomSequencePlanner::planSequence: Error: undefined planning method " << parameters.planning_method << std::endl;
+		return false;
+	}
+	if (statistics != NULL)
+		*statistics = planning_statistics;
+	return true;
+}
+
+//This function drags the trolley along the sequence of all rooms. The rooms that are close enough to the current trolley
+//position are put into its clique, the first room that is not starts a new clique and becomes its trolley position.
+void RoomSequencePlanner::planDragSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+		const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+		std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics& statistics)
+{
+	std::cout << "Maximal cliquedistance [m]: "<< parameters.max_clique_path_length << " Maximal cliquedistance [Pixel]: "<< parameters.max_clique_path_length/parameters.map_resolution << std::endl;
+
+	//calculate the index of the best starting position
+	const size_t optimal_start_position = getNearestLocation(floor_plan, floor_plan_hash, start_position, rooms, parameters);
+
+	//plan the optimal path trough all given rooms
+	cv::Mat room_distance_matrix;
+	getDistanceMatrix(room_distance_matrix, floor_plan, floor_plan_hash, rooms, parameters, statistics);
+	std::vector<int> room_indices(rooms.size());
+	for (size_t i=0; i<rooms.size(); ++i)
+		room_indices[i] = i;
+	const std::vector<int> optimal_room_sequence = solveTSP(room_distance_matrix, (int)optimal_start_position, "room_sequence", -1, room_indices, parameters, statistics);
+
+	//put the rooms that are close enough together into the same clique, if a new clique is needed put the first roomcenter as a trolleyposition
+	Timer timer;
+	std::vector<int> current_clique;
+	trolley_positions.push_back(start_position); //trolley stands close to robot on startup
+	//sample down map one time to reduce calculation time
+	setupPathPlanner(parameters);
+	cv::Mat downsampled_map;
+	path_planner_.downsampleMap(floor_plan_hash, floor_plan, downsampled_map, parameters.map_downsampling_factor, parameters.robot_radius, parameters.map_resolution);
+	for (size_t i=0; i<optimal_room_sequence.size(); ++i)
+	{
+		// without time left the straight line distance is taken
+		const cv::Point& room = rooms[optimal_room_sequence[i]];
+		const double distance_to_trolley = (isStopConditionMet(stop_condition_) == true ? cv::norm(trolley_positions.back()-room)
+				: path_planner_.planPath(floor_plan, downsampled_map, trolley_positions.back(), room, parameters.map_downsampling_factor, 0., parameters.map_resolution));
+		if (distance_to_trolley <= parameters.max_clique_path_length/parameters.map_resolution && (int)current_clique.size() < parameters.max_clique_size) //expand current clique by next roomcenter
+		{
+			current_clique.push_back(optimal_room_sequence[i]);
+		}
+		else //start new clique and put the old clique into the cliques vector
+		{
+			cliques.push_back(current_clique);
+			current_clique.clear();
+			current_clique.push_back(optimal_room_sequence[i]);
+			trolley_positions.push_back(room);
+		}
+	}
+	//add last clique
+	cliques.push_back(current_clique);
+	statistics.time_cliques += timer.getElapsedTimeInSec();
+}
+
+//This function groups the rooms and plans the sequences in four steps:
+//		1. determine cliques of rooms with a set cover
+//		2. determine a trolley position within each clique
+//		3. determine the optimal sequence of the trolley positions, beginning at the one that is nearest to the start position
+//		4. determine the optimal sequence of the rooms of each clique, beginning at the room that is nearest to its trolley position
+//At last the cliques and trolley positions are put into the order of the trolley sequence.
+void RoomSequencePlanner::planGroupSequence(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const std::vector<cv::Point>& rooms,
+		const cv::Point& start_position, const RoomSequencePlanningParameters& parameters, std::vector<std::vector<int> >& cliques,
+		std::vector<cv::Point>& trolley_positions, RoomSequencePlanningStatistics& statistics)
+{
+	std::cout << "Maximal cliquedistance [m]: "<< parameters.max_clique_path_length << " Maximal cliquedistance [Pixel]: "<< parameters.max_clique_path_length/parameters.map_resolution << std::endl;
+
+	// 1. determine cliques of rooms
+	std::cout << "finding trolley positions" << std::endl;
+	cv::Mat room_distance_matrix;
+	getDistanceMatrix(room_distance_matrix, floor_plan, floor_plan_hash, rooms, parameters, statistics);
+	Timer timer;
+	SetCoverSolver set_cover_solver;
+	set_cover_solver.setStopCondition(stop_condition_);
+	std::vector<std::vector<int> > unordered_cliques = set_cover_solver.solveSetCover(room_distance_matrix, rooms, (int)rooms.size(),
+			parameters.max_clique_path_length/parameters.map_resolution, parameters.max_clique_size);
+	statistics.time_cliques += timer.getElapsedTimeInSec();
+
+	// 2. determine trolley position within each clique (same indexing as in unordered_cliques)
+	timer.start();
+	TrolleyPositionFinder trolley_position_finder;
+	trolley_position_finder.setStopCondition(stop_condition_);
+	std::vector<cv::Point> unordered_trolley_positions = trolley_position_finder.findTrolleyPositions(floor_plan, unordered_cliques, rooms,
+			parameters.map_downsampling_factor, parameters.robot_radius, parameters.map_resolution);
+	statistics.time_trolley_positions += timer.getElapsedTimeInSec();
+	std::cout << "Trolley positions within each clique computed" << std::endl;
+
+	// 3. determine optimal sequence of trolley positions (solve TSP problem)
+	//		a) find nearest trolley location to current robot location
+	//		b) solve the TSP for the trolley positions
+	const size_t optimal_trolley_start_position = getNearestLocation(floor_plan, floor_plan_hash, start_position, unordered_trolley_positions, parameters);
+	std::cout << "finding optimal trolley sequence. Start: " << optimal_trolley_start_position << std::endl;
+	cv::Mat trolley_distance_matrix;
+	getDistanceMatrix(trolley_distance_matrix, floor_plan, floor_plan_hash, unordered_trolley_positions, parameters, statistics);
+	std::vector<int> trolley_indices(unordered_trolley_positions.size());
+	for (size_t i=0; i<unordered_trolley_positions.size(); ++i)
+		trolley_indices[i] = i;
+	const std::vector<int> optimal_trolley_sequence = solveTSP(trolley_distance_matrix, (int)optimal_trolley_start_position, "checkpoint_sequence", -1,
+			trolley_indices, parameters, statistics);
+
+	// 4. determine optimal sequence of rooms with each clique (solve TSP problem)
+	//		a) find start point for each clique closest to the trolley position
+	//		b) solve the TSP for each clique, the distances between the rooms of a clique are taken from the distance matrix of
+	//		   all rooms, so only the matrices of the whole map are kept in the cache
+	std::vector<std::vector<int> > optimal_room_sequences(unordered_cliques.size());
+	for (size_t i=0; i<unordered_cliques.size(); ++i)
+	{
+		std::vector<cv::Point> clique_points(unordered_cliques[i].size());
+		for (size_t j=0; j<unordered_cliques[i].size(); ++j)
+			clique_points[j] = rooms[unordered_cliques[i][j]];
+		const size_t clique_start_position = getNearestLocation(floor_plan, floor_plan_hash, unordered_trolley_positions[i], clique_points, parameters);
+		cv::Mat clique_distance_matrix;
+		DistanceMatrix::extractDistanceMatrix(room_distance_matrix, unordered_cliques[i], clique_distance_matrix);
+		optimal_room_sequences[i] = solveTSP(clique_distance_matrix, (int)clique_start_position, "clique_sequence", (int)i, unordered_cliques[i],
+				parameters, statistics);
+	}
+
+	// reorder cliques, trolley positions and rooms into optimal order
+	cliques.resize(optimal_trolley_sequence.size());
+	trolley_positions.resize(optimal_trolley_sequence.size());
+	for (size_t i=0; i<optimal_trolley_sequence.size(); ++i)
+	{
+		const int oi = optimal_trolley_sequence[i];
+		trolley_positions[i] = unordered_trolley_positions[oi];
+		cliques[i].resize(optimal_room_sequences[oi].size());
+		for (size_t j=0; j<optimal_room_sequences[oi].size(); ++j)
+			cliques[i][j] = unordered_cliques[oi][optimal_room_sequences[oi][j]];
+	}
+}
+
+std::vector<int> RoomSequencePlanner::solveTSP(const cv::Mat& distance_matrix, const int start_node, const std::string& stage, const int clique_index,
+		const std::vector<int>& node_indices, const RoomSequencePlanningParameters& parameters, RoomSequencePlanningStatistics& statistics)
+{
+	Timer timer;
+	std::vector<int> sequence;
+	if (tsp_solver_function_)
+		sequence = tsp_solver_function_(distance_matrix, start_node, stage, clique_index, node_indices);
+	else
+	{
+		boost::shared_ptr<AnytimeTSPSolver> tsp_solver = createTSPSolver(parameters.tsp_solver);
+		if (tsp_solver)
+			sequence = tsp_solver->solveTSP(distance_matrix, start_node);
+		else
+			std::cout << "RoomSequencePlanner::solveTSP: Error: undefined TSP solver " << parameters.tsp_solver << std::endl;
+	}
+	statistics.time_tsp += timer.getElapsedTimeInSec();
+	return sequence;
+}
+
+void RoomSequencePlanner::getDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& floor_plan, const unsigned long long floor_plan_hash,
+		const std::vector<cv::Point>& points, const RoomSequencePlanningParameters& parameters, RoomSequencePlanningStatistics& statistics)
+{
+	Timer timer;
+	distance_matrix_cache_.getDistanceMatrix(distance_matrix, floor_plan_hash, floor_plan, points, parameters.map_downsampling_factor,
+			parameters.robot_radius, parameters.map_resolution, path_planner_, stop_condition_);
+	statistics.time_distance_matrices += timer.getElapsedTimeInSec();
+}
+
+size_t RoomSequencePlanner::getNearestLocation(const cv::Mat& floor_plan, const unsigned long long floor_plan_hash, const cv::Point& start_position,
+		const std::vector<cv::Point>& positions, const RoomSequencePlanningParameters& parameters)
+{
+	setupPathPlanner(parameters);
+	cv::Mat downsampled_map;
+	path_planner_.downsampleMap(floor_plan_hash, floor_plan, downsampled_map, parameters.map_downsampling_factor, parameters.robot_radius, parameters.map_resolution);
+	double min_dist = 1e10;
+	size_t nearest_position = 0;
+	for (size_t i=0; i<positions.size(); ++i)
+	{
+		// without time left the nearest position found so far is taken
+		if (i > 0 && isStopConditionMet(stop_condition_) == true)
+			break;
+		const double dist = path_planner_.planPath(floor_plan, downsampled_map, start_position, positions[i], parameters.map_downsampling_factor, 0., parameters.map_resolution);
+		if (dist < min_dist)
+		{
+			min_dist = dist;
+			nearest_position = i;
+		}
+	}
+	return nearest_position;
+}
+
+void RoomSequencePlanner::setupPathPlanner(const RoomSequencePlanningParameters& parameters)
+{
+	path_planner_.setSearchStrategy(parameters.search_strategy == AStarPlanner::JUMP_POINT_SEARCH ? AStarPlanner::JUMP_POINT_SEARCH : AStarPlanner::A_STAR_SEARCH);
+	path_planner_.setHierarchicalPlanning(parameters.use_hierarchical_planner, parameters.hierarchical_planner_min_distance/parameters.map_resolution);
+}
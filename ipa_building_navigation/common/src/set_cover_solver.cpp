@@ -6,6 +6,12 @@ SetCoverSolver::SetCoverSolver()
 
 }
 
+void SetCoverSolver::setStopCondition(const StopCondition& stop_condition)
+{
+	stop_condition_ = stop_condition;
+	maximal_clique_finder.setStopCondition(stop_condition);
+}
+
 ////Function to construct the symmetrical distance matrix from the given points. The rows show from which node to start and
 ////the columns to which node to go. If the path between nodes doesn't exist or the node to go to is the same as the one to
 ////start from, the entry of the matrix is 0.
@@ -104,165 +110,162 @@ std::vector<std::vector<int> > SetCoverSolver::mergeGroups(const std::vector<std
 	return merged_groups;
 }
 
-//This functions solves the set-cover Problem ( https://en.wikipedia.org/wiki/Set_cover_problem#Greedy_algorithm ) using
-//the greedy-search algorithm. It chooses the clique that has the most uncovered nodes in it first. Then it uses the merge-function
-//above to merge groups that have at least one node in common together. The vector stores the indexes of the nodes, which
-//are the same as the ones from the clique-solver and also the distance-matrix. The variable max_number_of_clique_members
-//implies how many members a clique is allowed to have.
-
-//the cliques are given
-std::vector<std::vector<int> > SetCoverSolver::solveSetCover(std::vector<std::vector<int> >& given_cliques,
-		const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix)
+//This function splits a clique that is bigger than allowed. The node with the largest sum of distances to the other nodes
+//is removed until the clique has the allowed size, the result is saved and the same is repeated with the removed nodes.
+void SetCoverSolver::splitClique(std::vector<int> big_clique, const int max_number_of_clique_members, const cv::Mat& distance_matrix,
+		std::vector<std::vector<int> >& minimal_set)
 {
-	std::vector < std::vector<int> > minimal_set;
-
-	std::vector<std::vector<int> > cliques_for_covering;
-
-	for(size_t clique = 0; clique < given_cliques.size(); clique++)
-	{
-		std::vector<int> temporary_clique;
-		for(size_t node = 0; node < given_cliques[clique].size(); node++)
-		{
-			temporary_clique.push_back(given_cliques[clique][node]);
-		}
-		cliques_for_covering.push_back(temporary_clique);
-	}
-
-	//Put the nodes in a open-nodes vector. The nodes are named after their position in the room-centers-vector and so every
-	//node from 0 to number_of_nodes-1 is in the Graph.
-	std::vector<int> open_nodes;
-	for (int new_node = 0; new_node < number_of_nodes; new_node++)
-	{
-		open_nodes.push_back(new_node);
-	}
-
-	std::cout << "Starting greedy search for set-cover-problem." << std::endl;
-
-	//Search for the clique with the most unvisited nodes and choose this one before the others. Then remove the nodes of
-	//this clique from the unvisited-vector. This is done until no more nodes can be visited.
-
+	// iteratively remove nodes far away from the remaining nodes to create small cliques
+	bool removed_node = false;
 	do
 	{
-		int covered_open_nodes;
-		int best_covered_counter = 0;
-		int best_clique = -1;
-		for (int clique = 0; clique < cliques_for_covering.size(); clique++)
+		removed_node = false; // reset checking boolean
+		std::vector<int> current_subgraph = big_clique;
+		while(current_subgraph.size() > max_number_of_clique_members)
 		{
-			// skip too big cliques
-			if(cliques_for_covering[clique].size() > max_number_of_clique_members)
-				continue;
+			removed_node = true;
 
-			covered_open_nodes = 0;
-			for (int node = 0; node < cliques_for_covering[clique].size(); node++)
+			// find the node farthest away from the other nodes
+			double max_distance = 0.0;
+			int worst_node = -1;
+			for(size_t node = 0; node < current_subgraph.size(); ++node)
 			{
-				if (contains(open_nodes, cliques_for_covering[clique][node]))
+				// compute sum of distances from current node to neighboring nodes
+				double current_distance = 0;
+				for(size_t neighbor = 0; neighbor < current_subgraph.size(); ++neighbor)
 				{
-					covered_open_nodes++;
-				}
-			}
-			if (covered_open_nodes > best_covered_counter)
-			{
-				best_covered_counter = covered_open_nodes;
-				best_clique = clique;
-			}
-		}
+					// don't look at node itself
+					if(node == neighbor)
+						continue;
 
-		// check if a allowed clique could be found, if not split the biggest clique until it consists of cliques that are of the
-		// allowed size
-		if(best_clique == -1)
-		{
-			for (int clique = 0; clique < cliques_for_covering.size(); clique++)
-			{
-				covered_open_nodes = 0;
-				for (int node = 0; node < cliques_for_covering[clique].size(); node++)
-				{
-					if (contains(open_nodes, cliques_for_covering[clique][node]))
-					{
-						covered_open_nodes++;
-					}
+					current_distance += distance_matrix.at<double>(current_subgraph[node], current_subgraph[neighbor]);
 				}
-				if (covered_open_nodes > best_covered_counter)
+
+				// check if sum of distances is worse than the previously found ones
+				if(current_distance > max_distance)
 				{
-					best_covered_counter = covered_open_nodes;
-					best_clique = clique;
+					worst_node = node;
+					max_distance = current_distance;
 				}
 			}
 
-			// save big clique
-			std::vector<int> big_clique = cliques_for_covering[best_clique];
-
-			// iteratively remove nodes far away from the remaining nodes to create small cliques
-			bool removed_node = false;
-			std::vector<std::vector<int> > found_subgraphs;
-			do
-			{
-				removed_node = false; // reset checking boolean
-				std::vector<int> current_subgraph = big_clique;
-				while(current_subgraph.size() > max_number_of_clique_members)
-				{
-					removed_node = true;
-
-					// find the node farthest away from the other nodes
-					double max_distance = 0.0;
-					int worst_node = -1;
-					for(size_t node = 0; node < current_subgraph.size(); ++node)
-					{
-						// compute sum of distances from current node to neighboring nodes
-						double current_distance = 0;
-						for(size_t neighbor = 0; neighbor < current_subgraph.size(); ++neighbor)
-						{
-							// don't look at node itself
-							if(node == neighbor)
-								continue;
+			// remove the node farthest away from all other nodes out of the subgraph
+			current_subgraph.erase(current_subgraph.begin() + worst_node);
+		}
 
-							current_distance += distance_matrix.at<double>(current_subgraph[node], current_subgraph[neighbor]);
-						}
+		// save the found subgraph
+		minimal_set.push_back(current_subgraph);
 
-						// check if sum of distances is worse than the previously found ones
-						if(current_distance > max_distance)
-						{
-							worst_node = node;
-							max_distance = current_distance;
-						}
-					}
+		// erase the covered nodes from the big clique
+		for(size_t node = 0; node < current_subgraph.size(); ++node)
+			big_clique.erase(std::remove(big_clique.begin(), big_clique.end(), current_subgraph[node]), big_clique.end());
 
-					// remove the node farthest away from all other nodes out of the subgraph
-					current_subgraph.erase(current_subgraph.begin() + worst_node);
-				}
+	}while(removed_node == true && big_clique.size() > 0);
+}
 
-				// save the found subgraph
-				found_subgraphs.push_back(current_subgraph);
+//This functions solves the set-cover Problem ( https://en.wikipedia.org/wiki/Set_cover_problem#Greedy_algorithm ) using
+//the greedy-search algorithm. It chooses the clique that has the most uncovered nodes in it first (per cost for the weighted
+//problem, of equally good cliques the first one). Then it uses the merge-function above to merge groups that have at least
+//one node in common together. The vector stores the indexes of the nodes, which are the same as the ones from the
+//clique-solver and also the distance-matrix. The variable max_number_of_clique_members implies how many members a clique is
+//allowed to have. The covered nodes are removed from all cliques (this is okay because if you remove a node from a clique it
+//stays a clique, it only isn't a maximal clique anymore), so a clique that is too big may become small enough later. If no
+//clique of the allowed size covers any uncovered node, the best clique is split into cliques of the allowed size.
+std::vector<std::vector<int> > SetCoverSolver::solveGreedySetCover(const std::vector<std::vector<int> >& given_cliques,
+		const std::vector<double>& clique_costs, const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix)
+{
+	std::vector < std::vector<int> > minimal_set;
 
-				// erase the covered nodes from the big clique
-				for(size_t node = 0; node < current_subgraph.size(); ++node)
-					big_clique.erase(std::remove(big_clique.begin(), big_clique.end(), current_subgraph[node]), big_clique.end());
+	//The nodes are named after their position in the room-centers-vector and so every node from 0 to number_of_nodes-1 is in
+	//the Graph. Each clique and the open (uncovered) nodes are stored as bitsets over these nodes.
+	std::vector<NodeSet> clique_nodes(given_cliques.size(), NodeSet(number_of_nodes));
+	for (size_t clique = 0; clique < given_cliques.size(); ++clique)
+		for (size_t node = 0; node < given_cliques[clique].size(); ++node)
+			clique_nodes[clique].set(given_cliques[clique][node]);
+	NodeSet open_nodes(number_of_nodes);
+	open_nodes.set();
+
+	//queue of the cliques of the allowed size with their (possibly outdated) priority, the negative index of the clique is the
+	//second element, so the first of equally good cliques is on top, the cliques that are too big wait in an extra list
+	std::priority_queue<std::pair<double, int> > clique_queue;
+	std::vector<int> too_big_cliques;
+	for (int clique = (int)given_cliques.size()-1; clique >= 0; --clique)
+		too_big_cliques.push_back(clique);
 
-			}while(removed_node == true && big_clique.size() > 0);
+	std::cout << "Starting greedy search for set-cover-problem." << std::endl;
 
-			// add found subgraphs to the minimal set
-			for(size_t subgraph = 0; subgraph < found_subgraphs.size(); ++subgraph)
-				minimal_set.push_back(found_subgraphs[subgraph]);
-		}
-		else
+	//Search for the clique with the most unvisited nodes and choose this one before the others. Then remove the nodes of
+	//this clique from the unvisited nodes. This is done until no more nodes can be visited.
+	while (open_nodes.any() == true)
+	{
+		// move the cliques that have become small enough into the queue
+		for (size_t i = 0; i < too_big_cliques.size();)
 		{
-			minimal_set.push_back(cliques_for_covering[best_clique]);
+			const int clique = too_big_cliques[i];
+			const size_t covered_open_nodes = (clique_nodes[clique] & open_nodes).count();
+			if (covered_open_nodes <= (size_t)std::max(0, max_number_of_clique_members))
+			{
+				if (covered_open_nodes > 0)
+					clique_queue.push(std::pair<double, int>(covered_open_nodes / (clique_costs.empty() ? 1. : clique_costs[clique]), -clique));
+				too_big_cliques[i] = too_big_cliques.back();
+				too_big_cliques.pop_back();
+			}
+			else
+				++i;
 		}
-		//remove nodes of best clique from all cliques (this is okay because if you remove a node from a clique it stays a clique, it only isn't a maximal clique anymore)
-		for(size_t clique = 0; clique < cliques_for_covering.size(); clique++)
+
+		// take the best clique of the allowed size, the priority of the top clique is updated until it stays on top
+		int best_clique = -1;
+		while (clique_queue.empty() == false)
 		{
-			for(int node = 0; node < cliques_for_covering[best_clique].size(); node++)
+			const int clique = -clique_queue.top().second;
+			clique_queue.pop();
+			const size_t covered_open_nodes = (clique_nodes[clique] & open_nodes).count();
+			if (covered_open_nodes == 0)
+				continue;
+			const std::pair<double, int> current_priority(covered_open_nodes / (clique_costs.empty() ? 1. : clique_costs[clique]), -clique);
+			if (clique_queue.empty() == true || current_priority >= clique_queue.top())
 			{
-				if(clique != best_clique)
-					cliques_for_covering[clique].erase(std::remove(cliques_for_covering[clique].begin(), cliques_for_covering[clique].end(), cliques_for_covering[best_clique][node]), cliques_for_covering[clique].end());
+				best_clique = clique;
+				break;
 			}
+			clique_queue.push(current_priority);
 		}
-		for (int node = 0; node < cliques_for_covering[best_clique].size(); node++)
+
+		// check if a allowed clique could be found, if not split the best clique until it consists of cliques that are of the
+		// allowed size
+		bool split_clique = false;
+		if (best_clique == -1)
 		{
-			open_nodes.erase(std::remove(open_nodes.begin(), open_nodes.end(), cliques_for_covering[best_clique][node]), open_nodes.end());
+			double best_priority = 0.;
+			for (size_t clique = 0; clique < given_cliques.size(); ++clique)
+			{
+				const double priority = (clique_nodes[clique] & open_nodes).count() / (clique_costs.empty() ? 1. : clique_costs[clique]);
+				if (priority > best_priority)
+				{
+					best_priority = priority;
+					best_clique = clique;
+				}
+			}
+			if (best_clique == -1)
+			{
+				std::cout << "SetCoverSolver::solveGreedySetCover: Warning: " << open_nodes.count() << " nodes are not contained in any clique." << std::endl;
+				break;
+			}
+			split_clique = true;
 		}
-//		cliques_for_covering = new_set;
-//		std::cout << open_nodes.size() << std::endl;
-	} while (open_nodes.size() > 0);
+
+		// the uncovered nodes of the best clique in the order of the given clique
+		std::vector<int> covered_nodes;
+		for (size_t node = 0; node < given_cliques[best_clique].size(); ++node)
+			if (open_nodes.test(given_cliques[best_clique][node]) == true && contains(covered_nodes, given_cliques[best_clique][node]) == false)
+				covered_nodes.push_back(given_cliques[best_clique][node]);
+		if (split_clique == true)
+			splitClique(covered_nodes, max_number_of_clique_members, distance_matrix, minimal_set);
+		else
+			minimal_set.push_back(covered_nodes);
+		open_nodes -= clique_nodes[best_clique];
+	}
 
 	std::cout << "Finished greedy search." << std::endl;
 
@@ -272,6 +275,25 @@ std::vector<std::vector<int> > SetCoverSolver::solveSetCover(std::vector<std::ve
 	return minimal_set;
 }
 
+//the cliques are given
+std::vector<std::vector<int> > SetCoverSolver::solveSetCover(std::vector<std::vector<int> >& given_cliques,
+		const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix)
+{
+	return solveGreedySetCover(given_cliques, std::vector<double>(), number_of_nodes, max_number_of_clique_members, distance_matrix);
+}
+
+//the cliques and their costs are given
+std::vector<std::vector<int> > SetCoverSolver::solveWeightedSetCover(const std::vector<std::vector<int> >& given_cliques,
+		const std::vector<double>& clique_costs, const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix)
+{
+	if (clique_costs.size() != given_cliques.size())
+	{
+		std::cout << "SetCoverSolver::solveWeightedSetCover: Error: The number of costs does not match the number of cliques." << std::endl;
+		return std::vector<std::vector<int> >();
+	}
+	return solveGreedySetCover(given_cliques, clique_costs, number_of_nodes, max_number_of_clique_members, distance_matrix);
+}
+
 //the distance matrix is given, but not the cliques
 std::vector<std::vector<int> > SetCoverSolver::solveSetCover(const cv::Mat& distance_matrix, const std::vector<cv::Point>& points,
 		const int number_of_nodes, double maximal_pathlength, const int max_number_of_clique_members)
@@ -299,6 +321,7 @@ std::vector<std::vector<int> > SetCoverSolver::solveSetCover(const cv::Mat& orig
 	if (distance_matrix != 0)
 		distance_matrix_ref = *distance_matrix;
 	DistanceMatrix distance_matrix_computation;
+	distance_matrix_computation.setStopCondition(stop_condition_);
 	distance_matrix_computation.constructDistanceMatrix(distance_matrix_ref, original_map, points, downsampling_factor, robot_radius, map_resolution, pathplanner_);
 
 	//get all maximal cliques for this graph and solve the set cover problem
@@ -1,21 +1,29 @@
 #include <ipa_building_navigation/trolley_position_finder.h>
 
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
 //Defaul Constructor
 TrolleyPositionFinder::TrolleyPositionFinder()
 {
 
 }
 
+void TrolleyPositionFinder::setStopCondition(const StopCondition& stop_condition)
+{
+	stop_condition_ = stop_condition;
+}
+
 //This function takes one group and calculates the trolley position for it. It does following steps:
 //		I.   Get the bounding box for all Points in the group. Then expand it by a little factor to make sure the best
 //			 position is found, even when it is slightly outside the bounding Box.
-//		II.  Put a grid over the bounding box to get cells in which the trolley-position possibly is.
-//		     Find the Point in these cells that have the largest distance to the closest zero Pixel as possible candidates
-//			 for trolley positions.
-//		III. From these candidates the one is chosen, which gets the smallest pathlength to all group Points. If the group
-//			 has only two members the algorithm chooses the candidate as trolley position that is the middlest between these.
+//		II.  Compute the distance field of each group Point on the downsampled map, i.e. the pathlength from the Point to
+//			 every cell, and sum them up. The search of each field stops when all cells of the bounding box are reached.
+//		III. From the Points in the bounding box that are far enough away from the boundaries the one is chosen, which gets
+//			 the smallest summed pathlength to all group Points. If the group has only two members the algorithm chooses the
+//			 Point as trolley position that is the middlest between these. Of equally good Points the one that is farthest
+//			 away from the closest zero Pixel is taken.
 cv::Point TrolleyPositionFinder::findOneTrolleyPosition(const std::vector<cv::Point> group_points, const cv::Mat& original_map,
-		const double downsampling_factor, const double robot_radius, const double map_resolution)
+		const cv::Mat& downsampled_map, const double downsampling_factor, AStarPlanner& path_planner)
 {
 	double largening_of_bounding_box = 5; //Variable to expand the bounding box of the roomcenters a little bit. This is done to make sure the best trolley position is found if it is a little bit outside this bounding box.
 	double max_x_value = group_points[0].x; //max/min values of the Points that get the bounding box. Initialized with the coordinates of the first Point of the group.
@@ -24,15 +32,13 @@ cv::Point TrolleyPositionFinder::findOneTrolleyPosition(const std::vector<cv::Po
 	double min_y_value = group_points[0].y;
 
 	//create eroded map, which is used to check if the trolley-position candidates are too close to the boundaries
-	cv::Mat eroded_map;
-	cv::erode(original_map, eroded_map, cv::Mat(), cv::Point(-1, -1), 4);
+	//(the map is the same for all groups, so take it from the cache)
+	MapPreprocessingCache& map_preprocessing_cache = MapPreprocessingCache::getInstance();
+	const cv::Mat eroded_map = map_preprocessing_cache.getErodedMap(original_map, 4);
 
 	//create the distance-map to find the candidates for trolley-Positions
-	cv::Mat temporary_map = original_map.clone();
-	cv::erode(temporary_map, temporary_map, cv::Mat());
-	cv::Mat distance_map; //variable for the distance-transformed map, type: CV_32FC1
-	cv::distanceTransform(temporary_map, distance_map, CV_DIST_L2, 5);
-	cv::convertScaleAbs(distance_map, distance_map); // conversion to 8 bit image
+	cv::Mat distance_map; //variable for the distance-transformed map, converted to 8 bit
+	cv::convertScaleAbs(map_preprocessing_cache.getDistanceTransform(original_map, 1), distance_map); // conversion to 8 bit image
 
 	//
 	//******************************** I. Get bounding box of the group ********************************
@@ -77,132 +83,106 @@ cv::Point TrolleyPositionFinder::findOneTrolleyPosition(const std::vector<cv::Po
 	}
 
 	//
-	//******************************** II. Get the candidates for trolley positions ********************************
+	//******************************** II. Sum up the distance fields of the group points ********************************
 	//
-	double cell_side_length = 10;
-	double max_x_cell = min_x_value + cell_side_length;
-	double min_x_cell = min_x_value;
-	double max_y_cell = min_y_value + cell_side_length;
-	double min_y_cell = min_y_value;
-
-	bool out_of_y = false;
-	bool out_of_x = false;
-
-	std::vector < cv::Point > trolley_position_candidates;
-
-	//go trough each cell and find the candidate for each of it
-	do //go from y_min to y_max
+	// area of the bounding box in the downsampled map
+	const cv::Point min_cell = downsampling_factor * cv::Point(min_x_value, min_y_value);
+	const cv::Point max_cell = downsampling_factor * cv::Point(max_x_value, max_y_value);
+	const cv::Rect bounding_box_area(min_cell.x, min_cell.y, max_cell.x-min_cell.x+1, max_cell.y-min_cell.y+1);
+
+	cv::Mat summed_pathlengths = cv::Mat::zeros(downsampled_map.rows, downsampled_map.cols, CV_64F);
+	std::vector<cv::Mat> distance_fields(group_points.size());
+	for (size_t room_center = 0; room_center < group_points.size(); room_center++)
 	{
-		max_x_cell = min_x_value + cell_side_length; //reset the x-values for the cell to start from beginning when a new y coordinate is reached
-		min_x_cell = min_x_value;
-		do //go from x_min to x_max
-		{
-			out_of_x = false;
-			double best_x = min_x_cell;
-			double best_y = min_y_cell;
-			//go trough each Pixel of the cell and take the one that is most far away of the zero Pixels.
-			for (int y = min_y_cell; y < max_y_cell; y++)
-			{
-				for (int x = min_x_cell; x < max_x_cell; x++)
-				{
-					if (distance_map.at<unsigned char>(best_y, best_x) < distance_map.at<unsigned char>(y, x) && eroded_map.at<unsigned char>(y, x) != 0)
-					{
-						best_x = x;
-						best_y = y;
-					}
-				}
-			}
-			//check if candidate is far enough away from boundary
-			if (eroded_map.at<unsigned char>(best_y, best_x) != 0)
-			{
-				trolley_position_candidates.push_back(cv::Point(best_x, best_y));
-			}
-			min_x_cell = max_x_cell; //set new x values for next step
-			max_x_cell += cell_side_length;
-
-			//check if x is out of box --> if so the next y values should be checked
-			if (min_x_cell > max_x_value)
-			{
-				out_of_x = true;
-			}
-		} while (!out_of_x);
-
-		min_y_cell = max_y_cell; //set new y values for next step
-		max_y_cell += cell_side_length;
-
-		//check if y is out of bounding box --> if true step is done
-		if (min_y_cell > max_y_value)
-		{
-			out_of_y = true;
-		}
-	} while (!out_of_y);
+		if (isStopConditionMet(stop_condition_) == true)
+			return group_points[0];
+		path_planner.computeDistanceField(downsampled_map, group_points[room_center], downsampling_factor, distance_fields[room_center], bounding_box_area);
+		summed_pathlengths += distance_fields[room_center];
+	}
 
 	//
-	//***************** III. Find the candidate that minimizes the pathlengths to all group points *****************
+	//***************** III. Find the Point that minimizes the pathlengths to all group points *****************
 	//
-	//variables to save the best candidate
-	double best_pathlength = 1e10;
-	double best_pathlength_point_distance = 1e10;
-	int best_trolley_candidate = 0;
+	//collect the Points of the bounding box that are far enough away from the boundaries and find the shortest summed pathlength
+	std::vector<cv::Point> trolley_position_candidates;
+	double min_pathlength = 1e200;
+	for (int y = min_y_value; y <= max_y_value && y < original_map.rows; y++)
+	{
+		for (int x = min_x_value; x <= max_x_value && x < original_map.cols; x++)
+		{
+			const cv::Point cell = downsampling_factor * cv::Point(x, y);
+			if (eroded_map.at<unsigned char>(y, x) == 0 || cell.x < 0 || cell.x >= downsampled_map.cols || cell.y < 0 || cell.y >= downsampled_map.rows)
+				continue;
+			trolley_position_candidates.push_back(cv::Point(x, y));
+			min_pathlength = std::min(min_pathlength, summed_pathlengths.at<double>(cell));
+		}
+	}
 
-	// reduce image size already here to avoid resizing in the planner each time
-	const double one_by_downsampling_factor = 1./downsampling_factor;
-	cv::Mat downsampled_map;
-	path_planner_.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	//if no Point of the bounding box is accessible take the first group point
+	if (trolley_position_candidates.size() == 0)
+	{
+		std::cout << "TrolleyPositionFinder::findOneTrolleyPosition: Warning: No accessible trolley position found, taking the first group point." << std::endl;
+		return group_points[0];
+	}
 
-	//go trough each candidate and calculate the sum of pathlengths
+	//check for the best position that has the shortest pathlength to all centers. Adding the length of one cell to the shortest
+	//pathlength because the downsampling generates an error and with this better positions can be found.
+	const double max_pathlength = min_pathlength + 1./downsampling_factor;
+	double best_pathlength = 1e200;
+	double best_pathlength_point_distance = 1e200;
+	int best_boundary_distance = -1;
+	cv::Point best_trolley_position = trolley_position_candidates[0];
 	for (size_t candidate = 0; candidate < trolley_position_candidates.size(); candidate++)
 	{
-		cv::Point start_point = downsampling_factor * trolley_position_candidates[candidate];
-		double current_pathlength = 0;
-		std::vector<double> pathlengths;
-		for (int room_center = 0; room_center < group_points.size(); room_center++)
-		{
-			cv::Point end_point = downsampling_factor * group_points[room_center];
-			//get the pathlength to the current center and save it
-			double center_pathlength = one_by_downsampling_factor * path_planner_.planPath(downsampled_map, start_point, end_point, 1., 0., map_resolution);
-			pathlengths.push_back(center_pathlength);
-			//add the pathlenght to the total pathlength
-			current_pathlength += center_pathlength;
-		}
-		//check for the best position that has the shortest pathlength to all centers. Adding a little bit to the best_distances
-		//because the downsampling generates an error and with this better positions can be found.
+		const cv::Point cell = downsampling_factor * trolley_position_candidates[candidate];
+		const double current_pathlength = summed_pathlengths.at<double>(cell);
+		if (current_pathlength > max_pathlength)
+			continue;
+		const int current_boundary_distance = distance_map.at<unsigned char>(trolley_position_candidates[candidate]);
+		bool better_position = false;
 		if (group_points.size() == 2)
 		{
 			//If the group only has two members check for the position that is in the middlest of the connectionpath between
 			//these points or else a random point will be chosen.
-			double current_point_distance = std::abs(pathlengths[1] - pathlengths[0]);
-			if (current_pathlength <= (best_pathlength + 0.05) && current_point_distance <= (best_pathlength_point_distance + 0.05)
-					&& downsampled_map.at<unsigned char>(downsampling_factor * trolley_position_candidates[best_trolley_candidate]) != 0)
-			{
+			const double current_point_distance = std::abs(distance_fields[1].at<double>(cell) - distance_fields[0].at<double>(cell));
+			better_position = (current_point_distance < best_pathlength_point_distance - 0.05
+					|| (current_point_distance <= best_pathlength_point_distance + 0.05 && current_boundary_distance > best_boundary_distance));
+			if (better_position == true)
 				best_pathlength_point_distance = current_point_distance;
-				best_pathlength = current_pathlength;
-				best_trolley_candidate = candidate;
-			}
 		}
 		else
 		{
-			if (current_pathlength <= (best_pathlength + 0.05))
-			{
-				best_pathlength = current_pathlength;
-				best_trolley_candidate = candidate;
-			}
+			//take the Point that is farthest away from the boundaries
+			better_position = (current_boundary_distance > best_boundary_distance
+					|| (current_boundary_distance == best_boundary_distance && current_pathlength < best_pathlength));
+		}
+		if (better_position == true)
+		{
+			best_pathlength = current_pathlength;
+			best_boundary_distance = current_boundary_distance;
+			best_trolley_position = trolley_position_candidates[candidate];
 		}
 	}
 
-	return trolley_position_candidates[best_trolley_candidate];
+	return best_trolley_position;
 }
 
-//This function takes all found groups and calculates for each of it the best trolley-position using the previously
-//described functions.
-std::vector<cv::Point> TrolleyPositionFinder::findTrolleyPositions(const cv::Mat& original_map, const std::vector<std::vector<int> >& found_groups,
-		const std::vector<cv::Point>& room_centers, const double downsampling_factor, const double robot_radius, const double map_resolution)
+//This function takes the next group from group_queue and calculates its trolley position until all groups are done.
+void TrolleyPositionFinder::findTrolleyPositionsOfGroups(const cv::Mat& original_map, const cv::Mat& downsampled_map,
+		const std::vector<std::vector<int> >& found_groups, const std::vector<cv::Point>& room_centers, const double downsampling_factor,
+		std::vector<cv::Point>& trolley_positions, GroupQueue& group_queue)
 {
-	std::vector < cv::Point > trolley_positions;
-
-	//go trough each group and find the best trolley position.
-	for (int current_group = 0; current_group < found_groups.size(); current_group++)
+	AStarPlanner path_planner;
+	while (true)
 	{
+		int current_group = 0;
+		{
+			boost::mutex::scoped_lock lock(group_queue.mutex);
+			current_group = group_queue.next_group++;
+		}
+		if (current_group >= (int)found_groups.size())
+			return;
+
 		std::vector < cv::Point > group_points_vector; //vector to save the Points for each group
 
 		//add the Points from the given groups vector
@@ -211,17 +191,37 @@ std::vector<cv::Point> TrolleyPositionFinder::findTrolleyPositions(const cv::Mat
 			group_points_vector.push_back(room_centers[found_groups[current_group][index]]);
 		}
 		//calculate the trolley-position for each group that has at least 2 members
-		if (found_groups[current_group].size() > 1)
+		if (found_groups[current_group].size() > 1 && isStopConditionMet(stop_condition_) == false)
 		{
-			trolley_positions.push_back(
-						findOneTrolleyPosition(group_points_vector, original_map, downsampling_factor, robot_radius, map_resolution));
+			trolley_positions[current_group] = findOneTrolleyPosition(group_points_vector, original_map, downsampled_map, downsampling_factor, path_planner);
 		}
-		else //if the group has only one member this one is the trolley-position
+		else //if the group has only one member (or the search has been stopped) the first member is the trolley-position
 		{
-			cv::Point trolley_position_for_one_sized_groups = room_centers[found_groups[current_group][0]];
-			trolley_positions.push_back(trolley_position_for_one_sized_groups);
+			trolley_positions[current_group] = room_centers[found_groups[current_group][0]];
 		}
 	}
+}
+
+//This function takes all found groups and calculates for each of it the best trolley-position using the previously
+//described functions.
+std::vector<cv::Point> TrolleyPositionFinder::findTrolleyPositions(const cv::Mat& original_map, const std::vector<std::vector<int> >& found_groups,
+		const std::vector<cv::Point>& room_centers, const double downsampling_factor, const double robot_radius, const double map_resolution)
+{
+	std::vector < cv::Point > trolley_positions(found_groups.size());
+
+	// reduce image size already here to avoid resizing in the planner each time
+	cv::Mat downsampled_map;
+	path_planner_.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+
+	//go trough each group and find the best trolley position, the groups are computed in parallel
+	GroupQueue group_queue;
+	const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)found_groups.size()));
+	boost::thread_group threads;
+	for (int t=0; t<number_of_threads; ++t)
+		threads.create_thread(boost::bind(&TrolleyPositionFinder::findTrolleyPositionsOfGroups, this, boost::cref(original_map),
+				boost::cref(downsampled_map), boost::cref(found_groups), boost::cref(room_centers), downsampling_factor,
+				boost::ref(trolley_positions), boost::ref(group_queue)));
+	threads.join_all();
 
 	return trolley_positions;
 }
@@ -84,18 +84,21 @@
 
 //TSP solver
 #include <ipa_building_navigation/tsp_solver_defines.h>
+#include <ipa_building_navigation/anytime_tsp_solver.h>
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/genetic_TSP.h>
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/lin_kernighan_TSP.h>
 
-//Set Cover solver to find room groups
-#include <ipa_building_navigation/set_cover_solver.h>
-
-//finder of trolley positions for each room group
-#include <ipa_building_navigation/trolley_position_finder.h>
+//planning of the room sequence and the trolley positions, shared with the evaluation
+#include <ipa_building_navigation/room_sequence_planner.h>
 
 // A* planner
 #include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
+// cache for the distance matrices of the rooms
+#include <ipa_building_navigation/distance_matrix_cache.h>
 
 // action
 #include <actionlib/server/simple_action_server.h>
@@ -138,8 +141,24 @@ protected:
 	// this is the execution function used by action server
 	void findRoomSequenceWithCheckpointsServer(const ipa_building_msgs::FindRoomSequenceWithCheckpointsGoalConstPtr &goal);
 
-	size_t getNearestLocation(const cv::Mat& floor_plan, const cv::Point start_coordinate, const std::vector<cv::Point>& positions,
-			const double map_downsampling_factor, const double robot_radius, const double map_resolution);
+	// solves a TSP of the RoomSequencePlanner (see RoomSequencePlanner::TSPSolverFunction) with the chosen TSP solver, the solver
+	// stops at the planning deadline or when the goal is preempted, each improvement of the sequence is published as feedback
+	// of the given stage with the rooms converted to their index in the goal (original_room_indices_), the returned sequence
+	// is always published at last
+	std::vector<int> solveTSP(const cv::Mat& distance_matrix, const int start_node, const std::string& stage, const int clique_index,
+			const std::vector<int>& node_indices);
+
+	// publishes a new best sequence of the TSP that is currently solved as action feedback, the feedback of one TSP is rate
+	// limited unless it is the final sequence (which is only skipped if it has just been published)
+	void publishSequenceFeedback(const std::string& stage, const int clique_index, const std::vector<int>& feedback_indices,
+			const std::vector<int>& sequence, const double sequence_length, const bool final_sequence);
+
+	// returns true if the planning of the current goal should finish early, i.e. if the goal is preempted or its planning time
+	// limit is exceeded, the distance matrices, the set cover and the trolley positions are then approximated (see StopCondition)
+	bool isPlanningStopRequested() const;
+
+	// cancels running TSP solvers when the goal is preempted
+	void preemptCallback();
 
 	void publishSequenceVisualization(const std::vector<ipa_building_msgs::RoomSequence>& room_sequences, const std::vector<cv::Point>& room_centers,
 			std::vector< std::vector<int> >& cliques, const double map_resolution, const cv::Point2d& map_origin);
@@ -162,4 +181,19 @@ protected:
 	bool return_sequence_map_;	// boolean to tell the server if the map with the sequence drawn in should be returned
 	int max_clique_size_; // maximal number of nodes belonging to one clique, when planning trolley positions
 	bool display_map_;		// displays the map with paths upon service call (only if return_sequence_map=true)
+	bool use_hierarchical_planner_;	// plans the long single path queries (accessibility of rooms, nearest trolley position, trolley dragging) with the hierarchical planner (HPA*)
+	double hierarchical_planner_min_distance_;	// minimal straight line distance between start and end of a query that is planned hierarchically, in [m]
+	int search_strategy_;		// search of the path queries on the grid, 0 = A*, 1 = Jump Point Search
+
+	DistanceMatrixCache distance_matrix_cache_;	// keeps the distance matrices of former requests, so they are not computed again for the same map
+
+	// anytime TSP solving of the current goal
+	TSPCancellationTokenPtr tsp_cancellation_token_;	// cancelled when the goal is preempted
+	bool use_planning_deadline_;						// true if the goal has a planning time limit
+	AnytimeTSPSolver::Clock::time_point planning_deadline_;
+	AnytimeTSPSolver::Clock::time_point last_feedback_time_;	// feedback of the same TSP is published at most every 0.1 s
+	std::string last_feedback_stage_;
+	int last_feedback_clique_index_;
+	std::vector<int> last_feedback_sequence_;		// best_sequence of the last published feedback
+	std::vector<int> original_room_indices_;		// index in the goal of each room that is planned
 };
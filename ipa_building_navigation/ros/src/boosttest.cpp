@@ -24,8 +24,44 @@
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/genetic_TSP.h>
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/lin_kernighan_TSP.h>
 
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/timer.h>
+
+// This program compares the TSP solvers on random points of an empty map, for each problem size it saves the orders of the
+// solvers as images and the pathlengths and computation times of the solvers as text files:
+//		1. nearest neighbor
+//		2. classic genetic algorithm (mutations only)
+//		3. memetic algorithm (genetic algorithm with 2-opt and Or-opt local search)
+//		4. memetic algorithm with the computation time of the classic genetic algorithm as time budget
+//		5. chained Lin-Kernighan
+//		6. concorde (optimal)
+
+// returns the length of the closed tour
+double getTourLength(const cv::Mat& distance_matrix, const std::vector<int>& order)
+{
+	double pathlength = distance_matrix.at<double>(order.back(), order[0]);
+	for (size_t i = 1; i < order.size(); ++i)
+		pathlength += distance_matrix.at<double>(order[i-1], order[i]);
+	return pathlength;
+}
+
+// draws the closed tour into a copy of the map and saves it
+void saveTourImage(const cv::Mat& map, const std::vector<cv::Point>& nodes, const std::vector<int>& order, const std::string& filename)
+{
+	cv::Mat tour_map = map.clone();
+	cv::cvtColor(tour_map, tour_map, CV_GRAY2BGR);
+	for (size_t i = 1; i < order.size(); ++i)
+	{
+		cv::line(tour_map, nodes[order[i-1]], nodes[order[i]], CV_RGB(128,128,255), 1);
+		cv::circle(tour_map, nodes[order[i]], 2, CV_RGB(0,0,0), CV_FILLED);
+	}
+	//draw line back to start and the start node as red
+	cv::line(tour_map, nodes[order[0]], nodes[order.back()], CV_RGB(128,128,255), 1);
+	cv::circle(tour_map, nodes[order[0]], 2, CV_RGB(255,0,0), CV_FILLED);
+	cv::imwrite(filename.c_str(), tour_map);
+}
 
 int main(int argc, char **argv)
 {
@@ -42,10 +78,9 @@ int main(int argc, char **argv)
 	double map_resolution = 0.05;
 	int start_node = 0;
 
-	//saving variables for pathlengths
-	std::vector<double> nearest_pathlengths;
-	std::vector<double> genetic_pathlengths;
-	std::vector<double> concorde_pathlengths;
+	//names of the solvers
+	const int number_of_solvers = 6;
+	const std::string solver_names[number_of_solvers] = {"nearest", "classic_genetic", "memetic", "memetic_time_limited", "lin_kernighan", "concorde"};
 
 	//create empty map to random generate Points in it
 	cv::Mat map(dimension, dimension, CV_8UC1, cv::Scalar(255));
@@ -58,8 +93,13 @@ int main(int argc, char **argv)
 	//stingstreams to save the parameters
 	std::stringstream pathlength_output;
 	std::stringstream times_output;
+	std::stringstream summary_output;
+	summary_output << "nodes";
+	for (int solver = 0; solver < number_of_solvers; ++solver)
+		summary_output << "\t" << solver_names[solver] << " length\t[s]\tgap [%]";
+	summary_output << std::endl;
 
-	for(int number_of_nodes = 10; number_of_nodes <= 210; number_of_nodes += 20)
+	for(int number_of_nodes = 50; number_of_nodes <= 300; number_of_nodes += 50)
 	{
 		std::stringstream folder_name;
 		folder_name << number_of_nodes << "nodes";
@@ -83,103 +123,70 @@ int main(int argc, char **argv)
 		}while(point_counter < number_of_nodes);
 
 		NearestNeighborTSPSolver nearest_solver;
-		GeneticTSPSolver genetic_solver;
+		GeneticTSPSolver classic_genetic_solver;
+		classic_genetic_solver.setUseLocalSearch(false);
+		GeneticTSPSolver memetic_solver;
+		GeneticTSPSolver time_limited_memetic_solver;
+		LinKernighanTSPSolver lin_kernighan_solver;
 		ConcordeTSPSolver concorde_solver;
 
-		//solve the TSPs and save the calculation time and orders
-		cv::Mat distance_matrix;
-		struct timespec t0, t1, t2, t3;
-
 		//construct distance matrix once
 		std::cout << "constructing distance matrix" << std::endl;
+		cv::Mat distance_matrix;
 		AStarPlanner planner;
 		DistanceMatrix distance_matrix_computation;
 		distance_matrix_computation.constructDistanceMatrix(distance_matrix, map, nodes, downsampling, robot_radius, map_resolution, planner);
 
+		//solve the TSPs and save the calculation time and orders
 		std::cout << "solving TSPs" << std::endl;
-		clock_gettime(CLOCK_MONOTONIC,  &t0);
-		std::vector<int> nearest_order = nearest_solver.solveNearestTSP(distance_matrix, start_node);
-		std::cout << "solved nearest TSP" << std::endl;
-		clock_gettime(CLOCK_MONOTONIC,  &t1);
-		std::vector<int> genetic_order = genetic_solver.solveGeneticTSP(distance_matrix, start_node);
-		std::cout << "solved genetic TSP" << std::endl;
-		clock_gettime(CLOCK_MONOTONIC,  &t2);
-		std::vector<int> concorde_order = concorde_solver.solveConcordeTSP(distance_matrix, start_node);
-		std::cout << "solved concorde TSP" << std::endl;
-		clock_gettime(CLOCK_MONOTONIC,  &t3);
-
-		std::cout << "number of nodes in the paths: " << nearest_order.size() << " " << genetic_order.size() << " " << concorde_order.size() << std::endl;
-
-		//create maps to draw the paths in
-		cv::Mat nearest_map = map.clone();
-		cv::cvtColor(nearest_map, nearest_map, CV_GRAY2BGR);
-		cv::Mat genetic_map = nearest_map.clone();
-		cv::Mat concorde_map = nearest_map.clone();
-
-		//draw the order into the maps
-		//	draw the start node as red
-		std::cout << "starting to draw the maps" << std::endl;
-		cv::circle(nearest_map, nodes[nearest_order[0]], 2, CV_RGB(255,0,0), CV_FILLED);
-		cv::circle(genetic_map, nodes[genetic_order[0]], 2, CV_RGB(255,0,0), CV_FILLED);
-		cv::circle(concorde_map, nodes[concorde_order[0]], 2, CV_RGB(255,0,0), CV_FILLED);
-		for(size_t i = 1; i < nearest_order.size(); ++i)
+		std::vector<int> orders[number_of_solvers];
+		double times[number_of_solvers];
+		for (int solver = 0; solver < number_of_solvers; ++solver)
+		{
+			Timer tim;
+			if (solver == 0)
+				orders[solver] = nearest_solver.solveNearestTSP(distance_matrix, start_node);
+			else if (solver == 1)
+				orders[solver] = classic_genetic_solver.solveGeneticTSP(distance_matrix, start_node);
+			else if (solver == 2)
+				orders[solver] = memetic_solver.solveGeneticTSP(distance_matrix, start_node);
+			else if (solver == 3)
+			{
+				time_limited_memetic_solver.setMaximumComputationTime(times[1]);
+				orders[solver] = time_limited_memetic_solver.solveGeneticTSP(distance_matrix, start_node);
+			}
+			else if (solver == 4)
+				orders[solver] = lin_kernighan_solver.solveLinKernighanTSP(distance_matrix, start_node);
+			else
+				orders[solver] = concorde_solver.solveConcordeTSP(distance_matrix, start_node);
+			times[solver] = tim.getElapsedTimeInSec();
+			std::cout << "solved " << solver_names[solver] << " TSP" << std::endl;
+		}
+
+		//save the orders as images and get the pathlengths for each solver
+		double pathlengths[number_of_solvers];
+		for (int solver = 0; solver < number_of_solvers; ++solver)
 		{
-			cv::line(nearest_map,  nodes[nearest_order[i-1]],  nodes[nearest_order[i]], CV_RGB(128,128,255), 1);
-			cv::circle(nearest_map, nodes[nearest_order[i]], 2, CV_RGB(0,0,0), CV_FILLED);
-			cv::line(genetic_map,  nodes[genetic_order[i-1]],  nodes[genetic_order[i]], CV_RGB(128,128,255), 1);
-			cv::circle(genetic_map, nodes[genetic_order[i]], 2, CV_RGB(0,0,0), CV_FILLED);
-			cv::line(concorde_map,  nodes[concorde_order[i-1]],  nodes[concorde_order[i]], CV_RGB(128,128,255), 1);
-			cv::circle(concorde_map, nodes[concorde_order[i]], 2, CV_RGB(0,0,0), CV_FILLED);
+			saveTourImage(map, nodes, orders[solver], evaluation_path + solver_names[solver] + "_order.png");
+			pathlengths[solver] = getTourLength(distance_matrix, orders[solver]);
 		}
-		//draw line back to start
-		cv::line(nearest_map,  nodes[nearest_order[0]],  nodes[nearest_order.back()], CV_RGB(128,128,255), 1);
-		cv::line(genetic_map,  nodes[genetic_order[0]],  nodes[genetic_order.back()], CV_RGB(128,128,255), 1);
-		cv::line(concorde_map,  nodes[concorde_order[0]],  nodes[concorde_order.back()], CV_RGB(128,128,255), 1);
-
-		//save the maps
-		std::string nearest_path = evaluation_path + "nearest_order.png";
-		std::string genetic_path = evaluation_path + "genetic_order.png";
-		std::string concorde_path = evaluation_path + "concorde_order.png";
-		cv::imwrite(nearest_path.c_str(), nearest_map);
-		cv::imwrite(genetic_path.c_str(), genetic_map);
-		cv::imwrite(concorde_path.c_str(), concorde_map);
 		std::cout << "saved the maps" << std::endl;
 
-		//get the pathlengths for each solver
-		double nearest_pathlength= 0;
-		double genetic_pathlength = 0;
-		double concorde_pathlength = 0;
-		//add each pathlength
-		std::cout << "starting to calculate the pathlengths " << distance_matrix.cols << std::endl;
-		for(size_t i = 1; i < nearest_order.size(); ++i)
+		//save the pathlengths and computation times, the gap is the relative difference to the optimal (concorde) pathlength
+		pathlength_output << "number of nodes: " << number_of_nodes << std::endl;
+		times_output << "number of nodes: " << number_of_nodes << std::endl;
+		summary_output << number_of_nodes;
+		for (int solver = 0; solver < number_of_solvers; ++solver)
 		{
-			nearest_pathlength += distance_matrix.at<double>(nearest_order[i-1], nearest_order[i]);
-			genetic_pathlength += distance_matrix.at<double>(genetic_order[i-1], genetic_order[i]);
-			concorde_pathlength += distance_matrix.at<double>(concorde_order[i-1], concorde_order[i]);
-			std::cout << "done node: " << (int) i << std::endl;
+			pathlength_output << pathlengths[solver] << std::endl;
+			times_output << times[solver] << std::endl;
+			summary_output << "\t" << pathlengths[solver] << "\t" << times[solver] << "\t"
+					<< 100. * (pathlengths[solver] - pathlengths[number_of_solvers-1]) / pathlengths[number_of_solvers-1];
 		}
-		//add path from end to start
-		std::cout << "doing last paths. Indexes: " << nearest_order.back() << " " << genetic_order.back() << " " << concorde_order.back() << std::endl;
-		int last_index = nearest_order.back();
-		nearest_pathlength += distance_matrix.at<double>(nearest_order[0], last_index);
-		std::cout << "finished nearest path" << std::endl;
-		last_index = genetic_order.back();
-		genetic_pathlength += distance_matrix.at<double>(genetic_order[0], last_index);
-		std::cout << "finished genetic path." << std::endl;
-		last_index = concorde_order.back();
-		concorde_pathlength += distance_matrix.at<double>(concorde_order[0], last_index);
-		std::cout << "finished concorde path" << std::endl;
-
-		//calculate computation times
-		double nearest_time = (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) * 1e-9;
-		double genetic_time = (t2.tv_sec - t1.tv_sec) + (double) (t2.tv_nsec - t1.tv_nsec) * 1e-9;
-		double concorde_time = (t3.tv_sec - t2.tv_sec) + (double) (t3.tv_nsec - t2.tv_nsec) * 1e-9;
-
-		//save the pathlengths and computation times
-		pathlength_output << "number of nodes: " << number_of_nodes << std::endl
-				<< nearest_pathlength << std::endl << genetic_pathlength << std::endl << concorde_pathlength << std::endl << std::endl;
-		times_output << "number of nodes: " << number_of_nodes << std::endl
-				<< nearest_time << std::endl << genetic_time << std::endl << concorde_time << std::endl << std::endl;
+		pathlength_output << std::endl;
+		times_output << std::endl;
+		summary_output << std::endl;
+		std::cout << summary_output.str();
 	}
 	std::string pathlength_log_filename = data_storage_path + "pathlengths.txt";
 	std::ofstream pathlength_file(pathlength_log_filename.c_str(), std::ios::out);
@@ -195,6 +202,12 @@ int main(int argc, char **argv)
 	genetic_file.close();
 	std::cout << "finished to save the times" << std::endl;
 
+	std::string summary_log_filename = data_storage_path + "summary.txt";
+	std::ofstream summary_file(summary_log_filename.c_str(), std::ios::out);
+	if (summary_file.is_open()==true)
+		summary_file << summary_output.str();
+	summary_file.close();
+	std::cout << "finished to save the summary" << std::endl;
 
 	return 0;
 }
@@ -0,0 +1,120 @@
+#include "ros/ros.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <opencv2/opencv.hpp>
+
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/trolley_position_finder.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
+// This program measures the savings of the MapPreprocessingCache on a typical segment-then-plan-then-explore pipeline on one map:
+//		1. segmentation: distance transform of the slightly eroded map (as in the distance segmentation)
+//		2. sequence planning: distance matrix between the room centers and trolley positions for groups of rooms
+//		3. exploration: robot-inflated map (as in the room exploration server)
+// The pipeline is run once with a cache that is cleared before each stage (every stage computes its own artifacts like before)
+// and once with a cache that is shared by the stages (every artifact is computed once per pipeline). In both modes the cache
+// is cleared before each repetition, so the shared mode only measures the sharing between the stages of one pipeline and not
+// the reuse of the artifacts of former repetitions.
+
+// creates a building-like map with a corridor and rooms on both sides, the room centers are returned
+void createTestMap(cv::Mat& map, std::vector<cv::Point>& room_centers, const int number_of_rooms)
+{
+	const int room_size = 80;
+	const int corridor_width = 40;
+	const int rooms_per_side = (number_of_rooms+1)/2;
+	map = cv::Mat(2*room_size+corridor_width+2, rooms_per_side*room_size+2, CV_8UC1, cv::Scalar(0));
+	cv::rectangle(map, cv::Point(1, room_size+1), cv::Point(map.cols-2, room_size+corridor_width), cv::Scalar(255), CV_FILLED);
+	for (int r=0; r<number_of_rooms; ++r)
+	{
+		const int x = 1 + (r/2)*room_size;
+		const int y = (r%2==0 ? 1 : room_size+corridor_width+1);
+		cv::rectangle(map, cv::Point(x+2, y), cv::Point(x+room_size-3, y+room_size-1), cv::Scalar(255), CV_FILLED);
+		// door to the corridor
+		const int door_y = (r%2==0 ? y+room_size-4 : y-4);
+		cv::rectangle(map, cv::Point(x+room_size/2-6, door_y), cv::Point(x+room_size/2+6, door_y+8), cv::Scalar(255), CV_FILLED);
+		room_centers.push_back(cv::Point(x+room_size/2, y+room_size/2));
+	}
+}
+
+// returns the time for all repetitions, number_of_hits and number_of_misses receive the cache statistics of this run
+double runPipeline(const cv::Mat& map, const std::vector<cv::Point>& room_centers, const bool share_cache, const int repetitions,
+		size_t& number_of_hits, size_t& number_of_misses)
+{
+	const double downsampling_factor = 0.25;
+	const double robot_radius = 0.3;
+	const double map_resolution = 0.05;
+	MapPreprocessingCache& cache = MapPreprocessingCache::getInstance();
+
+	// groups of four neighboring rooms for the trolley position finder
+	std::vector<std::vector<int> > groups;
+	for (size_t r=0; r<room_centers.size(); r+=4)
+	{
+		std::vector<int> group;
+		for (size_t g=r; g<std::min(r+4, room_centers.size()); ++g)
+			group.push_back((int)g);
+		groups.push_back(group);
+	}
+
+	// the statistics of the cache are not reset by clear(), so they are taken relative to the start of the run
+	const size_t hits_before = cache.getNumberOfHits();
+	const size_t misses_before = cache.getNumberOfMisses();
+
+	Timer tim;
+	for (int repetition=0; repetition<repetitions; ++repetition)
+	{
+		// 1. segmentation, every pipeline starts with an empty cache
+		cache.clear();
+		cv::Mat distance_map;
+		cv::convertScaleAbs(cache.getDistanceTransform(map, 1), distance_map);
+
+		// 2. sequence planning
+		if (share_cache == false)
+			cache.clear();
+		AStarPlanner path_planner;
+		DistanceMatrix distance_matrix_computation;
+		cv::Mat distance_matrix;
+		distance_matrix_computation.constructDistanceMatrix(distance_matrix, map, room_centers, downsampling_factor, robot_radius, map_resolution, path_planner);
+		TrolleyPositionFinder trolley_position_finder;
+		std::vector<cv::Point> trolley_positions = trolley_position_finder.findTrolleyPositions(map, groups, room_centers, downsampling_factor, robot_radius, map_resolution);
+
+		// 3. exploration
+		if (share_cache == false)
+			cache.clear();
+		cv::Mat inflated_map = cache.getErodedMap(map, (int)std::floor(robot_radius/map_resolution));
+	}
+	const double time = tim.getElapsedTimeInMilliSec();
+
+	number_of_hits = cache.getNumberOfHits() - hits_before;
+	number_of_misses = cache.getNumberOfMisses() - misses_before;
+	return time;
+}
+
+int main(int argc, char **argv)
+{
+	ros::init(argc, argv, "map_preprocessing_cache_evaluation");
+	ros::NodeHandle nh;
+
+	const int repetitions = 5;
+	std::cout << "rooms\tseparate [ms]\thits\tmisses\tshared [ms]\thits\tmisses" << std::endl;
+	for (int number_of_rooms = 8; number_of_rooms <= 64; number_of_rooms *= 2)
+	{
+		cv::Mat map;
+		std::vector<cv::Point> room_centers;
+		createTestMap(map, room_centers, number_of_rooms);
+
+		size_t separate_hits = 0, separate_misses = 0, shared_hits = 0, shared_misses = 0;
+		const double separate_time = runPipeline(map, room_centers, false, repetitions, separate_hits, separate_misses);
+		const double shared_time = runPipeline(map, room_centers, true, repetitions, shared_hits, shared_misses);
+		std::cout << number_of_rooms << "\t" << separate_time/repetitions << "\t" << separate_hits << "\t" << separate_misses << "\t"
+				<< shared_time/repetitions << "\t" << shared_hits << "\t" << shared_misses << std::endl;
+	}
+
+	return 0;
+}
@@ -62,12 +62,14 @@
 RoomSequencePlanningServer::RoomSequencePlanningServer(ros::NodeHandle nh, std::string name_of_the_action) :
 	node_handle_(nh),
 	room_sequence_with_checkpoints_server_(node_handle_, name_of_the_action, boost::bind(&RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer, this, _1), false),
-	action_name_(name_of_the_action)
+	action_name_(name_of_the_action), tsp_cancellation_token_(new TSPCancellationToken()), use_planning_deadline_(false),
+	last_feedback_clique_index_(-1)
 {
 	// setup publishers
 	room_sequence_visualization_pub_ = nh.advertise<visualization_msgs::MarkerArray>("room_sequence_marker", 1);
 
 	// start action server
+	room_sequence_with_checkpoints_server_.registerPreemptCallback(boost::bind(&RoomSequencePlanningServer::preemptCallback, this));
 	room_sequence_with_checkpoints_server_.start();
 
 	// dynamic reconfigure
@@ -84,6 +86,8 @@ RoomSequencePlanningServer::RoomSequencePlanningServer(ros::NodeHandle nh, std::
 		ROS_INFO("You have chosen the Genetic TSP method.");
 	else if (tsp_solver_ == TSP_CONCORDE)
 		ROS_INFO("You have chosen the Concorde TSP solver.");
+	else if (tsp_solver_ == TSP_LIN_KERNIGHAN)
+		ROS_INFO("You have chosen the Lin-Kernighan TSP solver.");
 	else
 		ROS_ERROR("Undefined TSP Solver.");
 
@@ -131,6 +135,20 @@ RoomSequencePlanningServer::RoomSequencePlanningServer(ros::NodeHandle nh, std::
 	std::cout << "room_sequence_planning/return_sequence_map = " << return_sequence_map_ << std::endl;
 	node_handle_.param("display_map", display_map_, false);
 	std::cout << "room_sequence_planning/display_map = " << display_map_ << std::endl;
+	std::string distance_matrix_cache_directory;
+	node_handle_.param<std::string>("distance_matrix_cache_directory", distance_matrix_cache_directory, "");
+	std::cout << "room_sequence_planning/distance_matrix_cache_directory = " << distance_matrix_cache_directory << std::endl;
+	distance_matrix_cache_.setCacheDirectory(distance_matrix_cache_directory);
+	double distance_matrix_cache_max_disk_size = 1024.;
+	node_handle_.param("distance_matrix_cache_max_disk_size", distance_matrix_cache_max_disk_size, 1024.);
+	std::cout << "room_sequence_planning/distance_matrix_cache_max_disk_size = " << distance_matrix_cache_max_disk_size << std::endl;
+	distance_matrix_cache_.setMaxDiskBytes((unsigned long long)(std::max(0., distance_matrix_cache_max_disk_size)*1024.*1024.));
+	node_handle_.param("use_hierarchical_planner", use_hierarchical_planner_, false);
+	std::cout << "room_sequence_planning/use_hierarchical_planner = " << use_hierarchical_planner_ << std::endl;
+	node_handle_.param("hierarchical_planner_min_distance", hierarchical_planner_min_distance_, 20.0);
+	std::cout << "room_sequence_planning/hierarchical_planner_min_distance = " << hierarchical_planner_min_distance_ << std::endl;
+	node_handle_.param("search_strategy", search_strategy_, 0);
+	std::cout << "room_sequence_planning/search_strategy = " << search_strategy_ << std::endl;
 }
 
 // callback function for dynamic reconfigure
@@ -148,6 +166,8 @@ void RoomSequencePlanningServer::dynamic_reconfigure_callback(ipa_building_navig
 		ROS_INFO("You have chosen the Genetic TSP method.");
 	else if (tsp_solver_ == TSP_CONCORDE)
 		ROS_INFO("You have chosen the Concorde TSP solver.");
+	else if (tsp_solver_ == TSP_LIN_KERNIGHAN)
+		ROS_INFO("You have chosen the Lin-Kernighan TSP solver.");
 	else
 		ROS_ERROR("Undefined TSP Solver.");
 
@@ -201,10 +221,23 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 {
 	ROS_INFO("********Sequence planning started************");
 
+	// the TSP solvers return their best sequence when the planning time is up or the goal is preempted
+	tsp_cancellation_token_->reset();
+	if (room_sequence_with_checkpoints_server_.isPreemptRequested() == true)
+		tsp_cancellation_token_->cancel();
+	use_planning_deadline_ = (goal->planning_time_limit > 0.);
+	if (use_planning_deadline_ == true)
+		planning_deadline_ = AnytimeTSPSolver::Clock::now() + boost::chrono::duration_cast<AnytimeTSPSolver::Clock::duration>(boost::chrono::duration<double>(goal->planning_time_limit));
+	last_feedback_stage_.clear();
+	// the steps before the TSPs finish early with approximated results in the same cases
+	const StopCondition stop_condition = boost::bind(&RoomSequencePlanningServer::isPlanningStopRequested, this);
+
 	// converting the map msg in cv format
 	cv_bridge::CvImagePtr cv_ptr_obj;
 	cv_ptr_obj = cv_bridge::toCvCopy(goal->input_map, sensor_msgs::image_encodings::MONO8);
 	cv::Mat floor_plan = cv_ptr_obj->image;
+	// the map is hashed once for all lookups in the preprocessing and distance matrix caches
+	const unsigned long long floor_plan_hash = MapPreprocessingCache::computeMapHash(floor_plan);
 
 	//get map origin and convert robot start coordinate to [pixel]
 	const cv::Point2d map_origin(goal->map_origin.position.x, goal->map_origin.position.y);
@@ -213,19 +246,21 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 
 	//create a star pathplanner to plan a path from Point A to Point B in a given gridmap
 	AStarPlanner a_star_path_planner;
+	a_star_path_planner.setSearchStrategy(search_strategy_ == AStarPlanner::JUMP_POINT_SEARCH ? AStarPlanner::JUMP_POINT_SEARCH : AStarPlanner::A_STAR_SEARCH);
+	a_star_path_planner.setHierarchicalPlanning(use_hierarchical_planner_, hierarchical_planner_min_distance_/goal->map_resolution);
 
 	//get room centers and check how many of them are reachable
 	cv::Mat downsampled_map_for_accessibility_checking;
 	if(check_accessibility_of_rooms_ == true)
 	{
-		a_star_path_planner.downsampleMap(floor_plan, downsampled_map_for_accessibility_checking, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
+		a_star_path_planner.downsampleMap(floor_plan_hash, floor_plan, downsampled_map_for_accessibility_checking, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
 	}
 	std::vector<cv::Point> room_centers;	// collect the valid, accessible room_centers
 	std::map<size_t, size_t> mapping_room_centers_index_to_original_room_index;		// maps the index of each entry in room_centers to the original index in goal->room_information_in_pixel
 	for (size_t i=0; i<goal->room_information_in_pixel.size(); ++i)
 	{
 		cv::Point current_center(goal->room_information_in_pixel[i].room_center.x, goal->room_information_in_pixel[i].room_center.y);
-		if(check_accessibility_of_rooms_ == true)
+		if(check_accessibility_of_rooms_ == true && isPlanningStopRequested() == false)	// without time left the rooms are assumed to be accessible
 		{
 			std::cout << "checking for accessibility of rooms" << std::endl;
 			double length = a_star_path_planner.planPath(floor_plan, downsampled_map_for_accessibility_checking, robot_start_coordinate, current_center, map_downsampling_factor_, 0., goal->map_resolution);
@@ -241,6 +276,7 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		else
 		{
 			room_centers.push_back(current_center);
+			mapping_room_centers_index_to_original_room_index[room_centers.size()-1] = i;
 		}
 	}
 	downsampled_map_for_accessibility_checking.release(); //release not anymore needed space
@@ -263,7 +299,7 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 			ROS_INFO("You have chosen the grouping planning method.");
 	}
 
-	if(tsp_solver_ > 0 && tsp_solver_ < 4)
+	if(tsp_solver_ > 0 && tsp_solver_ < 5)
 	{
 		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR)
 			ROS_INFO("You have chosen the nearest neighbor solver.");
@@ -271,289 +307,77 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 			ROS_INFO("You have chosen the genetic TSP solver.");
 		if(tsp_solver_ == TSP_CONCORDE)
 			ROS_INFO("You have chosen the concorde TSP solver.");
+		if(tsp_solver_ == TSP_LIN_KERNIGHAN)
+			ROS_INFO("You have chosen the Lin-Kernighan TSP solver.");
 	}
-	//saving vectors needed from both planning methods
+
+	// plan the sequence, the feedback of the TSPs refers to the original room indices
+	RoomSequencePlanningParameters parameters;
+	parameters.planning_method = planning_method_;
+	parameters.tsp_solver = tsp_solver_;
+	parameters.max_clique_path_length = max_clique_path_length_;
+	parameters.max_clique_size = max_clique_size_;
+	parameters.map_downsampling_factor = map_downsampling_factor_;
+	parameters.robot_radius = goal->robot_radius;
+	parameters.map_resolution = goal->map_resolution;
+	parameters.use_hierarchical_planner = use_hierarchical_planner_;
+	parameters.hierarchical_planner_min_distance = hierarchical_planner_min_distance_;
+	parameters.search_strategy = search_strategy_;
+	original_room_indices_.resize(room_centers.size());
+	for (size_t i=0; i<room_centers.size(); ++i)
+		original_room_indices_[i] = mapping_room_centers_index_to_original_room_index[i];
+	RoomSequencePlanner room_sequence_planner(distance_matrix_cache_);
+	room_sequence_planner.setStopCondition(stop_condition);
+	room_sequence_planner.setTSPSolver(boost::bind(&RoomSequencePlanningServer::solveTSP, this, _1, _2, _3, _4, _5));
 	std::vector<std::vector<int> > cliques;
 	std::vector<cv::Point> trolley_positions;
-	std::vector< std::vector<cv::Point> > room_cliques_as_points;
+	if (room_sequence_planner.planSequence(floor_plan, floor_plan_hash, room_centers, robot_start_coordinate, parameters, cliques, trolley_positions) == false)
+	{
+		ROS_ERROR("Undefined planning method.");
+		ipa_building_msgs::FindRoomSequenceWithCheckpointsResult action_result;
+		room_sequence_with_checkpoints_server_.setAborted(action_result);
+		return;
+	}
 
 	//image container to draw the sequence in if needed
 	cv::Mat display;
-
-	if(planning_method_ == 1) //Drag Trolley if the next room is too far away
-	{
-		std::cout << "Maximal cliquedistance [m]: "<< max_clique_path_length_  << " Maximal cliquedistance [Pixel]: "<< max_clique_path_length_/goal->map_resolution << std::endl;
-
-		//calculate the index of the best starting position
-		size_t optimal_start_position = getNearestLocation(floor_plan, robot_start_coordinate, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-
-		//plan the optimal path trough all given rooms
-		std::vector<int> optimal_room_sequence;
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
-		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			optimal_room_sequence = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
-		{
-			GeneticTSPSolver genetic_tsp_solver;
-			optimal_room_sequence = genetic_tsp_solver.solveGeneticTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
-		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			optimal_room_sequence = concorde_tsp_solver.solveConcordeTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-
-		//put the rooms that are close enough together into the same clique, if a new clique is needed put the first roomcenter as a trolleyposition
-		std::vector<int> current_clique;
-		trolley_positions.push_back(robot_start_coordinate); //trolley stands close to robot on startup
-		//sample down map one time to reduce calculation time
-		cv::Mat downsampled_map;
-		a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-		const double one_by_downsampling_factor = 1 / map_downsampling_factor_;
-		for(size_t i=0; i<optimal_room_sequence.size(); ++i)
-		{
-			double distance_to_trolley = a_star_path_planner.planPath(floor_plan, downsampled_map, trolley_positions.back(), room_centers[optimal_room_sequence[i]], map_downsampling_factor_, 0, goal->map_resolution);
-			if (distance_to_trolley <= max_clique_path_length_/goal->map_resolution && current_clique.size() < max_clique_size_) //expand current clique by next roomcenter
-			{
-				current_clique.push_back(optimal_room_sequence[i]);
-			}
-			else //start new clique and put the old clique into the cliques vector
-			{
-				cliques.push_back(current_clique);
-				current_clique.clear();
-				current_clique.push_back(optimal_room_sequence[i]);
-				trolley_positions.push_back(room_centers[optimal_room_sequence[i]]);
-			}
-		}
-		//add last clique
-		cliques.push_back(current_clique);
-
-		//fill vector of cv::Point for display purpose
-		for(size_t i=0; i<cliques.size(); ++i)
-		{
-			std::vector<cv::Point> current_clique;
-			for(size_t j=0; j<cliques[i].size(); ++j)
-			{
-				current_clique.push_back(room_centers[cliques[i][j]]);
-			}
-			room_cliques_as_points.push_back(current_clique);
-		}
-
-		if(return_sequence_map_ == true)
-		{
-			cv::cvtColor(floor_plan, display, CV_GRAY2BGR);
-
-			for (size_t t=0; t<trolley_positions.size(); ++t)
-			{
-				// trolley positions + connections
-				if (t>0)
-				{
-					cv::circle(display, trolley_positions[t], 5, CV_RGB(0,0,255), CV_FILLED);
-					cv::line(display, trolley_positions[t], trolley_positions[t-1], CV_RGB(128,128,255), 1);
-				}
-				else
-				{
-					cv::circle(display, trolley_positions[t], 5, CV_RGB(255,0,0), CV_FILLED);
-				}
-
-				// room positions and connections
-				for (size_t r=0; r<cliques[t].size(); ++r)
-				{
-					cv::circle(display, room_cliques_as_points[t][r], 3, CV_RGB(0,255,0), CV_FILLED);
-					if (r==0)
-						cv::line(display, trolley_positions[t], room_cliques_as_points[t][r], CV_RGB(255,0,0), 1);
-					else
-					{
-						if(r==cliques[t].size()-1)
-							cv::line(display, room_cliques_as_points[t][r], trolley_positions[t], CV_RGB(255,0,255), 1);
-						cv::line(display, room_cliques_as_points[t][r-1], room_cliques_as_points[t][r], CV_RGB(128,255,128), 1);
-					}
-				}
-			}
-		}
-		// display
-		if (display_map_ == true && return_sequence_map_ == true)
-		{
-			cv::imshow("sequence planning", display);
-			cv::waitKey();
-		}
-	}
-	else if(planning_method_ == 2) //calculate roomgroups and corresponding trolley positions
+	if(return_sequence_map_ == true)
 	{
-		std::cout << "Maximal cliquedistance [m]: "<< max_clique_path_length_  << " Maximal cliquedistance [Pixel]: "<< max_clique_path_length_/goal->map_resolution << std::endl;
-
-		std::cout << "finding trolley positions" << std::endl;
-		// 1. determine cliques of rooms
-		SetCoverSolver set_cover_solver;
-		cliques = set_cover_solver.solveSetCover(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, max_clique_path_length_/goal->map_resolution, max_clique_size_);
-
-		// 2. determine trolley position within each clique (same indexing as in cliques)
-		TrolleyPositionFinder trolley_position_finder;
-		trolley_positions = trolley_position_finder.findTrolleyPositions(floor_plan, cliques, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-		std::cout << "Trolley positions within each clique computed" << std::endl;
-
-		// 3. determine optimal sequence of trolley positions (solve TSP problem)
-		//		a) find nearest trolley location to current robot location
-		//		b) solve the TSP for the trolley positions
-		// reduce image size already here to avoid resizing in the planner each time
-		size_t optimal_trolley_start_position = getNearestLocation(floor_plan, robot_start_coordinate, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-
-		//solve the TSP
-		std::vector<int> optimal_trolley_sequence;
-		std::cout << "finding optimal trolley sequence. Start: " << optimal_trolley_start_position << std::endl;
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
-		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			optimal_trolley_sequence = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
-		{
-			GeneticTSPSolver genetic_tsp_solver;
-			optimal_trolley_sequence = genetic_tsp_solver.solveGeneticTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
-		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			optimal_trolley_sequence = concorde_tsp_solver.solveConcordeTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
+		cv::cvtColor(floor_plan, display, CV_GRAY2BGR);
 
-		// 4. determine optimal sequence of rooms with each clique (solve TSP problem)
-		//		a) find start point for each clique closest to the trolley position
-		//		b) create a vector< vector <Point> > to fill the groups into the TSP solver
-		//		c) solve the TSP for each clique
-
-
-		//fill vector of cv::Point for TSP solver
-		for(size_t i=0; i<cliques.size(); ++i)
-		{
-			std::vector<cv::Point> current_clique;
-			for(size_t j=0; j<cliques[i].size(); ++j)
-			{
-				current_clique.push_back(room_centers[cliques[i][j]]);
-			}
-			room_cliques_as_points.push_back(current_clique);
-		}
-
-		std::cout << "cliques: " << std::endl;
-		for(size_t i = 0; i < cliques.size(); ++i)
-		{
-			for(size_t j = 0; j < cliques[i].size(); ++j)
-			{
-				std::cout << room_cliques_as_points[i][j] << std::endl;
-			}
-			std::cout << std::endl;
-		}
-		std::cout << std::endl;
-
-		std::cout << "trolley indexes: " << std::endl;
-		for(size_t i = 0; i < optimal_trolley_sequence.size(); ++i)
-		{
-			std::cout << optimal_trolley_sequence[i] << std::endl;
-		}
-		std::cout << std::endl;
-
-		std::cout << "number of trolley positions: " << trolley_positions.size() << " " << optimal_trolley_sequence.size() << std::endl;
-		//find starting points
-		//find starting points
-		std::vector<size_t> clique_starting_points(cliques.size());
-		for(size_t i=0; i<cliques.size(); ++i)
-			clique_starting_points[i] = getNearestLocation(floor_plan, trolley_positions[i], room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-		//solve TSPs
-		std::vector< std::vector <int> > optimal_room_sequences(cliques.size());
-		// Create the TSP solver objects two times and not one time for the whole function because by this way only two objects has to be
-		// created and else three
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
+		for (size_t t=0; t<trolley_positions.size(); ++t)
 		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
+			// trolley positions + connections
+			if (t>0)
 			{
-				optimal_room_sequences[i] = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
+				cv::circle(display, trolley_positions[t], 5, CV_RGB(0,0,255), CV_FILLED);
+				cv::line(display, trolley_positions[t], trolley_positions[t-1], CV_RGB(128,128,255), 1);
 			}
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
-		{
-			GeneticTSPSolver genetic_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
-			{
-				optimal_room_sequences[i] = genetic_tsp_solver.solveGeneticTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
-			}
-		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
-		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
+			else
 			{
-				optimal_room_sequences[i] = concorde_tsp_solver.solveConcordeTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
+				cv::circle(display, trolley_positions[t], 5, CV_RGB(255,0,0), CV_FILLED);
 			}
-		}
-
-		if(return_sequence_map_ == true)
-		{
-			cv::cvtColor(floor_plan, display, CV_GRAY2BGR);
 
-			for (size_t t=0; t<trolley_positions.size(); ++t)
+			// room positions and connections
+			for (size_t r=0; r<cliques[t].size(); ++r)
 			{
-				// trolley positions + connections
-				const int ot = optimal_trolley_sequence[t];
-				//std::cout << "starting to draw one clique. Position: " << trolley_positions[ot] << std::endl;
-				if (t>0)
-				{
-					cv::circle(display, trolley_positions[ot], 5, CV_RGB(0,0,255), CV_FILLED);
-					cv::line(display, trolley_positions[ot], trolley_positions[optimal_trolley_sequence[t-1]], CV_RGB(128,128,255), 1);
-				}
+				cv::circle(display, room_centers[cliques[t][r]], 3, CV_RGB(0,255,0), CV_FILLED);
+				if (r==0)
+					cv::line(display, trolley_positions[t], room_centers[cliques[t][r]], CV_RGB(255,0,0), 1);
 				else
 				{
-					cv::circle(display, trolley_positions[ot], 5, CV_RGB(255,0,0), CV_FILLED);
-				}
-
-				// room positions and connections
-				for (size_t r=0; r<optimal_room_sequences[ot].size(); ++r)
-				{
-					cv::circle(display, room_cliques_as_points[ot][optimal_room_sequences[ot][r]], 3, CV_RGB(0,255,0), CV_FILLED);
-					if (r==0)
-						cv::line(display, trolley_positions[ot], room_cliques_as_points[ot][optimal_room_sequences[ot][r]], CV_RGB(255,0,0), 1);
-					else
-					{
-						if(r==optimal_room_sequences[ot].size()-1)
-							cv::line(display, room_cliques_as_points[ot][optimal_room_sequences[ot][r]], trolley_positions[ot], CV_RGB(255,0,255), 1);
-						cv::line(display, room_cliques_as_points[ot][optimal_room_sequences[ot][r-1]], room_cliques_as_points[ot][optimal_room_sequences[ot][r]], CV_RGB(128,255,128), 1);
-					}
+					if(r==cliques[t].size()-1)
+						cv::line(display, room_centers[cliques[t][r]], trolley_positions[t], CV_RGB(255,0,255), 1);
+					cv::line(display, room_centers[cliques[t][r-1]], room_centers[cliques[t][r]], CV_RGB(128,255,128), 1);
 				}
-				//std::cout << "finished to draw one clique" << std::endl;
 			}
 		}
-		// display
-		if (display_map_ == true && return_sequence_map_ == true)
-		{
-			cv::imshow("sequence planning", display);
-			cv::waitKey();
-		}
-
-		// reorder cliques, trolley positions and rooms into optimal order
-		std::vector<std::vector<int> > new_cliques_order(cliques.size());
-		std::vector<cv::Point> new_trolley_positions(trolley_positions.size());
-		for (size_t i=0; i<optimal_trolley_sequence.size(); ++i)
-		{
-			const int oi = optimal_trolley_sequence[i];
-			new_trolley_positions[i] = trolley_positions[oi];
-			new_cliques_order[i].resize(optimal_room_sequences[oi].size());
-			for (size_t j=0; j<optimal_room_sequences[oi].size(); ++j)
-				new_cliques_order[i][j] = cliques[oi][optimal_room_sequences[oi][j]];
-		}
-		cliques = new_cliques_order;
-		trolley_positions = new_trolley_positions;
 	}
-	else
+	// display
+	if (display_map_ == true && return_sequence_map_ == true)
 	{
-		ROS_ERROR("Undefined planning method.");
-		ipa_building_msgs::FindRoomSequenceWithCheckpointsResult action_result;
-		room_sequence_with_checkpoints_server_.setAborted(action_result);
-		return;
+		cv::imshow("sequence planning", display);
+		cv::waitKey();
 	}
 	std::cout << "done sequence planning" << std::endl << std::endl;
 
@@ -587,7 +411,14 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 	// publish visualization msg for RViz
 	publishSequenceVisualization(room_sequences, room_centers, cliques, goal->map_resolution, cv::Point2d(goal->map_origin.position.x, goal->map_origin.position.y));
 
-	room_sequence_with_checkpoints_server_.setSucceeded(action_result);
+	// a preempted goal gets the best sequence that was found until the preemption
+	if (room_sequence_with_checkpoints_server_.isPreemptRequested() == true)
+	{
+		ROS_INFO("Sequence planning was preempted, returning the best sequence found so far.");
+		room_sequence_with_checkpoints_server_.setPreempted(action_result);
+	}
+	else
+		room_sequence_with_checkpoints_server_.setSucceeded(action_result);
 
 	//garbage collection
 	action_result.checkpoints.clear();
@@ -595,29 +426,73 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 	ROS_INFO("********Sequence planning finished************");
 }
 
-size_t RoomSequencePlanningServer::getNearestLocation(const cv::Mat& floor_plan, const cv::Point start_coordinate, const std::vector<cv::Point>& positions,
-		const double map_downsampling_factor, const double robot_radius, const double map_resolution)
+std::vector<int> RoomSequencePlanningServer::solveTSP(const cv::Mat& distance_matrix, const int start_node, const std::string& stage,
+		const int clique_index, const std::vector<int>& node_indices)
 {
-//	const double one_by_downsampling_factor = 1./map_downsampling_factor;
-	cv::Mat downsampled_map;
-	AStarPlanner a_star_path_planner;
-	a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor, robot_radius, map_resolution);
-	//find nearest trolley position as start point for TSP
-	double min_dist = 1e10;
-	size_t nearest_position = 0;
-//	const cv::Point start_point = map_downsampling_factor * start_coordinate;
-	for (size_t i=0; i<positions.size(); ++i)
+	boost::shared_ptr<AnytimeTSPSolver> tsp_solver = RoomSequencePlanner::createTSPSolver(tsp_solver_);
+	if (!tsp_solver)
+		return std::vector<int>();
+
+	// the rooms are reported with their index in the goal, the trolley positions with their index in the sequence planning
+	std::vector<int> feedback_indices(node_indices);
+	if (stage != "checkpoint_sequence")
+		for (size_t i=0; i<node_indices.size(); ++i)
+			feedback_indices[i] = original_room_indices_[node_indices[i]];
+
+	tsp_solver->setCancellationToken(tsp_cancellation_token_);
+	if (use_planning_deadline_ == true)
+		tsp_solver->setDeadline(planning_deadline_);
+	tsp_solver->setImprovementCallback(boost::bind(&RoomSequencePlanningServer::publishSequenceFeedback, this, boost::cref(stage),
+			clique_index, boost::cref(feedback_indices), _1, _2, false));
+	const std::vector<int> sequence = tsp_solver->solveTSP(distance_matrix, start_node);
+
+	// the rate limit may have dropped the last improvements, so the returned sequence is published in any case
+	if (sequence.empty() == false)
 	{
-//		const cv::Point end_point = map_downsampling_factor * positions[i];
-		double dist = a_star_path_planner.planPath(floor_plan, downsampled_map, start_coordinate, positions[i], map_downsampling_factor, 0., map_resolution);
-		if (dist < min_dist)
-		{
-			min_dist = dist;
-			nearest_position = i;
-		}
+		double sequence_length = 0.;
+		for (size_t i=0; i<sequence.size(); ++i)
+			sequence_length += distance_matrix.at<double>(sequence[i], sequence[(i+1)%sequence.size()]);
+		publishSequenceFeedback(stage, clique_index, feedback_indices, sequence, sequence_length, true);
 	}
+	return sequence;
+}
 
-	return nearest_position;
+void RoomSequencePlanningServer::publishSequenceFeedback(const std::string& stage, const int clique_index, const std::vector<int>& feedback_indices,
+		const std::vector<int>& sequence, const double sequence_length, const bool final_sequence)
+{
+	std::vector<int> best_sequence(sequence.size());
+	for (size_t i=0; i<sequence.size(); ++i)
+		best_sequence[i] = feedback_indices[sequence[i]];
+
+	// limit the rate of the feedback of one TSP, the first sequence of each TSP is always published, the final sequence too
+	// unless it has been the last published one
+	const bool same_tsp = (stage == last_feedback_stage_ && clique_index == last_feedback_clique_index_);
+	const AnytimeTSPSolver::Clock::time_point now = AnytimeTSPSolver::Clock::now();
+	if (same_tsp == true && ((final_sequence == false && now - last_feedback_time_ < boost::chrono::milliseconds(100))
+			|| (final_sequence == true && best_sequence == last_feedback_sequence_)))
+		return;
+	last_feedback_stage_ = stage;
+	last_feedback_clique_index_ = clique_index;
+	last_feedback_time_ = now;
+	last_feedback_sequence_ = best_sequence;
+
+	ipa_building_msgs::FindRoomSequenceWithCheckpointsFeedback feedback;
+	feedback.stage = stage;
+	feedback.clique_index = clique_index;
+	feedback.best_sequence.assign(best_sequence.begin(), best_sequence.end());
+	feedback.best_sequence_length = sequence_length;
+	room_sequence_with_checkpoints_server_.publishFeedback(feedback);
+}
+
+bool RoomSequencePlanningServer::isPlanningStopRequested() const
+{
+	return (tsp_cancellation_token_->isCancelled() == true || (use_planning_deadline_ == true && AnytimeTSPSolver::Clock::now() >= planning_deadline_));
+}
+
+void RoomSequencePlanningServer::preemptCallback()
+{
+	ROS_INFO("Sequence planning preempt requested, stopping the TSP solvers.");
+	tsp_cancellation_token_->cancel();
 }
 
 void RoomSequencePlanningServer::publishSequenceVisualization(const std::vector<ipa_building_msgs::RoomSequence>& room_sequences, const std::vector<cv::Point>& room_centers,
@@ -0,0 +1,400 @@
+#include <ros/ros.h>
+#include <ros/package.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <boost/thread.hpp>
+#include <boost/filesystem.hpp>
+
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/room_sequence_planner.h>
+
+// This program evaluates the room sequence planning over all maps x planning methods x TSP solvers x maximal clique lengths
+// like room_sequence_planning_evaluation (variation 2: the trash bins are the points of the sequence), but it calls the
+// planning library (RoomSequencePlanner, the same planning as in the action server) directly instead of the action server:
+//		1. The maps are distributed over worker processes (map i is evaluated by worker i % number_of_workers), every worker
+//		   evaluates all configurations of its maps one after another.
+//		2. Each worker keeps a DistanceMatrixCache, so the distance matrix of the trash bins of a map is computed once for all
+//		   configurations and the matrices of the trolley positions are reused by the TSP solvers of the same clique length,
+//		   the matrices of the cliques are taken from the matrix of all trash bins. The disk tier of the cache is shared by all workers and kept between runs.
+//		3. Every worker writes one line per configuration to its own results file as soon as the configuration is done, at the
+//		   end the files are merged into results.csv (one line per configuration, columns see writeResultsHeader).
+//
+// usage: room_sequence_planning_evaluation_runner [number_of_workers] [test_map_path] [data_storage_path]
+// The defaults are the number of cores, the test maps of ipa_room_segmentation and room_sequence_planning/. The parameters of
+// the path planning (map_downsampling_factor, use_hierarchical_planner, hierarchical_planner_min_distance, search_strategy) are read from the
+// private namespace of the node like in the action server, room_sequence_planning_evaluation_runner.launch loads them from the
+// parameter file of the action server.
+
+struct RunnerMapData
+{
+	std::string map_name_;		// without file type
+	cv::Mat floor_plan_;
+	unsigned long long map_hash_;	// MapPreprocessingCache::computeMapHash(floor_plan_)
+	std::vector<cv::Point> trash_bin_locations_;
+	cv::Point robot_start_position_;	// in pixel
+};
+
+struct RunnerConfig
+{
+	int sequence_planning_method_;		// 1 = drag trolley if next room is too far away, 2 = calculate roomgroups and a trolleyposition for each of it
+	int tsp_solver_;					// see TSPSolvers in tsp_solver_defines.h
+	double max_clique_path_length_;		// max A* path length between two rooms that are assigned to the same clique, in [m]
+	int max_clique_size_;				// maximal number of trash bins that can be emptied into one trolley
+
+	RunnerConfig(const int sequence_planning_method, const int tsp_solver, const double max_clique_path_length, const int max_clique_size)
+	: sequence_planning_method_(sequence_planning_method), tsp_solver_(tsp_solver), max_clique_path_length_(max_clique_path_length),
+	  max_clique_size_(max_clique_size)
+	{
+	}
+};
+
+struct RunnerResult
+{
+	bool success;
+	int number_of_cliques;
+	double time_distance_matrices;	// in [s], time spent in the distance matrix cache
+	double time_cliques;			// in [s], set cover or splitting of the room sequence
+	double time_trolley_positions;	// in [s]
+	double time_tsp;				// in [s]
+	double time_total;				// in [s], complete sequence planning
+	double trolley_path_length;		// in [m], from the robot start position along the trolley positions in their order
+	double room_path_length;		// in [m], sum of the round trips from each trolley position through the rooms of its clique
+
+	RunnerResult()
+	{
+		success = false;
+		number_of_cliques = 0;
+		time_distance_matrices = 0.;
+		time_cliques = 0.;
+		time_trolley_positions = 0.;
+		time_tsp = 0.;
+		time_total = 0.;
+		trolley_path_length = 0.;
+		room_path_length = 0.;
+	}
+};
+
+class SequencePlanningRunner
+{
+public:
+
+	// parameters holds the map resolution, the robot radius and the parameters of the path planning
+	SequencePlanningRunner(const RoomSequencePlanningParameters& parameters, const std::string& cache_directory)
+	: parameters_(parameters), distance_matrix_cache_(cache_directory, 64), route_length_cache_("", 256),
+	  room_sequence_planner_(distance_matrix_cache_)
+	{
+	}
+
+	// plans the sequence of the trash bins of the map with the given configuration and evaluates the result
+	void runConfiguration(const RunnerMapData& map_data, const RunnerConfig& config, RunnerResult& result)
+	{
+		result = RunnerResult();
+		if (map_data.trash_bin_locations_.size() == 0)
+			return;
+
+		// the same planning as in the action server
+		RoomSequencePlanningParameters parameters = parameters_;
+		parameters.planning_method = config.sequence_planning_method_;
+		parameters.tsp_solver = config.tsp_solver_;
+		parameters.max_clique_path_length = config.max_clique_path_length_;
+		parameters.max_clique_size = config.max_clique_size_;
+		std::vector<std::vector<int> > cliques;
+		std::vector<cv::Point> trolley_positions;
+		RoomSequencePlanningStatistics statistics;
+		Timer total_timer;
+		if (room_sequence_planner_.planSequence(map_data.floor_plan_, map_data.map_hash_, map_data.trash_bin_locations_, map_data.robot_start_position_,
+				parameters, cliques, trolley_positions, &statistics) == false)
+			return;
+		result.time_total = total_timer.getElapsedTimeInSec();
+		result.time_distance_matrices = statistics.time_distance_matrices;
+		result.time_cliques = statistics.time_cliques;
+		result.time_trolley_positions = statistics.time_trolley_positions;
+		result.time_tsp = statistics.time_tsp;
+		result.number_of_cliques = cliques.size();
+
+		// evaluate the planned sequence, the drag method starts with the trolley at the robot position
+		size_t number_of_visited_rooms = 0;
+		for (size_t i=0; i<cliques.size(); ++i)
+			number_of_visited_rooms += cliques[i].size();
+		if (number_of_visited_rooms != map_data.trash_bin_locations_.size())
+		{
+			std::cout << "SequencePlanningRunner::runConfiguration: Error: the sequence does not contain all rooms." << std::endl;
+			return;
+		}
+		std::vector<cv::Point> trolley_route;
+		if (config.sequence_planning_method_ == 2)
+			trolley_route.push_back(map_data.robot_start_position_);
+		trolley_route.insert(trolley_route.end(), trolley_positions.begin(), trolley_positions.end());
+		result.trolley_path_length = parameters_.map_resolution * computeRouteLength(map_data, trolley_route, false);
+		for (size_t i=0; i<cliques.size(); ++i)
+		{
+			if (cliques[i].size() == 0)
+				continue;
+			std::vector<cv::Point> room_route(1, trolley_positions[i]);
+			for (size_t j=0; j<cliques[i].size(); ++j)
+				room_route.push_back(map_data.trash_bin_locations_[cliques[i][j]]);
+			result.room_path_length += parameters_.map_resolution * computeRouteLength(map_data, room_route, true);
+		}
+		result.success = (result.trolley_path_length < 1e9 && result.room_path_length < 1e9);
+	}
+
+protected:
+
+	// pathlength in [pixel] along the points in their order, back to the first point if closed is set
+	double computeRouteLength(const RunnerMapData& map_data, const std::vector<cv::Point>& route, const bool closed)
+	{
+		if (route.size() < 2)
+			return 0.;
+		cv::Mat distance_matrix;
+		route_length_cache_.getDistanceMatrix(distance_matrix, map_data.map_hash_, map_data.floor_plan_, route, parameters_.map_downsampling_factor,
+				parameters_.robot_radius, parameters_.map_resolution, path_planner_);
+		double length = 0.;
+		for (size_t i=1; i<route.size(); ++i)
+			length += distance_matrix.at<double>(i-1, i);
+		if (closed == true)
+			length += distance_matrix.at<double>(route.size()-1, 0);
+		return length;
+	}
+
+	const RoomSequencePlanningParameters parameters_;
+
+	AStarPlanner path_planner_;
+	DistanceMatrixCache distance_matrix_cache_;	// matrices used by the planning, with the disk tier shared by the workers
+	DistanceMatrixCache route_length_cache_;		// matrices only used to evaluate the results, kept in memory
+	RoomSequencePlanner room_sequence_planner_;
+};
+
+// loads the map and its trash bins (blue) like room_sequence_planning_evaluation, returns false if the map cannot be read
+bool loadMap(const std::string& test_map_path, const std::string& map_name, const double map_resolution, const double robot_radius, RunnerMapData& map_data)
+{
+	map_data.map_name_ = map_name;
+	std::string image_filename = test_map_path + map_name + ".png";
+	cv::Mat map = cv::imread(image_filename.c_str(), 0);
+	if (map.empty() == true)
+	{
+		std::cout << "loadMap: Error: could not read " << image_filename << std::endl;
+		return false;
+	}
+	//make non-white pixels black
+	for (int y = 0; y < map.rows; y++)
+		for (int x = 0; x < map.cols; x++)
+			map.at<unsigned char>(y, x) = (map.at<unsigned char>(y, x) > 250 ? 255 : 0);
+	map_data.floor_plan_ = map;
+	map_data.map_hash_ = MapPreprocessingCache::computeMapHash(map);
+
+	// read in trash bin locations, the maps with furniture use the trash bins of the basic map
+	std::string map_name_basic = map_name;
+	std::size_t pos = map_name.find("_furnitures");
+	if (pos != std::string::npos)
+		map_name_basic = map_name.substr(0, pos);
+	image_filename = test_map_path + map_name_basic + "_trashbins.png";
+	cv::Mat trash_bin_image = cv::imread(image_filename.c_str());
+	if (trash_bin_image.empty() == true)
+	{
+		std::cout << "loadMap: Error: could not read " << image_filename << std::endl;
+		return false;
+	}
+	const cv::Vec3b blue(255, 0, 0);
+	cv::Mat eroded_map;
+	cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1,-1), (int)(robot_radius/map_resolution));
+	map_data.trash_bin_locations_.clear();
+	for (int y = 0; y < trash_bin_image.rows; y++)
+		for (int x = 0; x < trash_bin_image.cols; x++)
+			if (trash_bin_image.at<cv::Vec3b>(y, x) == blue && eroded_map.at<unsigned char>(y, x) != 0)
+				map_data.trash_bin_locations_.push_back(cv::Point(x,y));
+
+	// robot start position: first free cell that is far enough away from the walls (as in room_sequence_planning_evaluation)
+	cv::Mat map_eroded;
+	cv::erode(map, map_eroded, cv::Mat(), cv::Point(-1,-1), robot_radius/map_resolution+2);
+	cv::Mat distance_map;
+	cv::distanceTransform(map_eroded, distance_map, CV_DIST_L2, 5);
+	cv::convertScaleAbs(distance_map, distance_map);
+	map_data.robot_start_position_ = cv::Point(0, 0);
+	bool robot_start_coordinate_set = false;
+	for (int v=0; v<map_eroded.rows && robot_start_coordinate_set==false; ++v)
+		for (int u=0; u<map_eroded.cols && robot_start_coordinate_set==false; ++u)
+			if (map_eroded.at<uchar>(v,u) != 0 && distance_map.at<uchar>(v,u) > 20)
+			{
+				map_data.robot_start_position_ = cv::Point(u, v);
+				robot_start_coordinate_set = true;
+			}
+	return true;
+}
+
+void setConfigurations(std::vector<RunnerConfig>& configurations)
+{
+	configurations.clear();
+	const double max_clique_lengths[] = {6., 8., 10., 12., 14., 16., 18., 20., 25., 30., 50.};
+	const int number_of_clique_lengths = sizeof(max_clique_lengths)/sizeof(max_clique_lengths[0]);
+	for (int sequence_planning_method = 1; sequence_planning_method <= 2; ++sequence_planning_method)
+		for (int tsp_solver = TSP_NEAREST_NEIGHBOR; tsp_solver <= TSP_LIN_KERNIGHAN; ++tsp_solver)
+			for (int i=0; i<number_of_clique_lengths; ++i)
+				configurations.push_back(RunnerConfig(sequence_planning_method, tsp_solver, max_clique_lengths[i], 10));
+}
+
+void writeResultsHeader(std::ostream& output)
+{
+	output << "map,planning_method,tsp_solver,max_clique_path_length,max_clique_size,number_of_trash_bins,number_of_cliques,"
+			<< "time_distance_matrices,time_cliques,time_trolley_positions,time_tsp,time_total,"
+			<< "trolley_path_length,room_path_length,path_length,success" << std::endl;
+}
+
+void writeResult(std::ostream& output, const RunnerMapData& map_data, const RunnerConfig& config, const RunnerResult& result)
+{
+	output << map_data.map_name_ << "," << config.sequence_planning_method_ << "," << config.tsp_solver_ << ","
+			<< config.max_clique_path_length_ << "," << config.max_clique_size_ << "," << map_data.trash_bin_locations_.size() << ","
+			<< result.number_of_cliques << "," << result.time_distance_matrices << "," << result.time_cliques << ","
+			<< result.time_trolley_positions << "," << result.time_tsp << "," << result.time_total << ","
+			<< result.trolley_path_length << "," << result.room_path_length << "," << result.trolley_path_length+result.room_path_length << ","
+			<< (result.success==true ? 1 : 0) << std::endl;
+}
+
+std::string getWorkerResultsFilename(const std::string& data_storage_path, const int worker)
+{
+	std::stringstream ss;
+	ss << data_storage_path << "results_worker_" << worker << ".csv";
+	return ss.str();
+}
+
+// evaluates all configurations of the maps of one worker, returns the exit code of the worker process
+int runWorker(const int worker, const int number_of_workers, const std::vector<std::string>& map_names, const std::vector<RunnerConfig>& configurations,
+		const std::string& test_map_path, const std::string& data_storage_path, const RoomSequencePlanningParameters& parameters)
+{
+	std::ofstream output(getWorkerResultsFilename(data_storage_path, worker).c_str(), std::ios::out | std::ios::trunc);
+	if (output.is_open() == false)
+	{
+		std::cout << "worker " << worker << ": Error: could not open its results file." << std::endl;
+		return 1;
+	}
+	output << std::setprecision(10);
+
+	SequencePlanningRunner runner(parameters, data_storage_path + "distance_matrices");
+	for (size_t map_index = worker; map_index < map_names.size(); map_index += number_of_workers)
+	{
+		RunnerMapData map_data;
+		if (loadMap(test_map_path, map_names[map_index], parameters.map_resolution, parameters.robot_radius, map_data) == false)
+			continue;
+		std::cout << "worker " << worker << ": map " << map_data.map_name_ << " with " << map_data.trash_bin_locations_.size() << " trash bins" << std::endl;
+		for (size_t config = 0; config < configurations.size(); ++config)
+		{
+			RunnerResult result;
+			runner.runConfiguration(map_data, configurations[config], result);
+			writeResult(output, map_data, configurations[config], result);
+			std::cout << "worker " << worker << ": map " << map_data.map_name_ << "\tplanning method: " << configurations[config].sequence_planning_method_
+					<< "\tTSP solver: " << configurations[config].tsp_solver_ << "\tmaximal clique length: " << configurations[config].max_clique_path_length_
+					<< "\tcomputation time: " << result.time_total << " s\tpath length: " << result.trolley_path_length+result.room_path_length << " m" << std::endl;
+		}
+	}
+	output.close();
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	ros::init(argc, argv, "room_sequence_planning_evaluation_runner", ros::init_options::NoRosout);
+	int number_of_workers = std::max(1, (int)boost::thread::hardware_concurrency());
+	if (argc > 1)
+		number_of_workers = std::max(1, atoi(argv[1]));
+	const std::string test_map_path = (argc > 2 ? std::string(argv[2]) : ros::package::getPath("ipa_room_segmentation") + "/common/files/test_maps/");
+	const std::string data_storage_path = (argc > 3 ? std::string(argv[3]) : std::string("room_sequence_planning/"));
+	RoomSequencePlanningParameters parameters;
+	parameters.map_resolution = 0.05;
+	parameters.robot_radius = 0.3;
+
+	// the parameters of the path planning are the ones of the action server, they are read before the workers are started
+	{
+		ros::NodeHandle nh("~");
+		nh.param("map_downsampling_factor", parameters.map_downsampling_factor, 0.25);
+		std::cout << "room_sequence_planning/map_downsampling_factor = " << parameters.map_downsampling_factor << std::endl;
+		nh.param("use_hierarchical_planner", parameters.use_hierarchical_planner, false);
+		std::cout << "room_sequence_planning/use_hierarchical_planner = " << parameters.use_hierarchical_planner << std::endl;
+		nh.param("hierarchical_planner_min_distance", parameters.hierarchical_planner_min_distance, 20.0);
+		std::cout << "room_sequence_planning/hierarchical_planner_min_distance = " << parameters.hierarchical_planner_min_distance << std::endl;
+		nh.param("search_strategy", parameters.search_strategy, 0);
+		std::cout << "room_sequence_planning/search_strategy = " << parameters.search_strategy << std::endl;
+	}
+	ros::shutdown();
+
+	boost::system::error_code error;
+	boost::filesystem::create_directories(data_storage_path + "distance_matrices", error);
+	if (error)
+	{
+		std::cout << "Error: could not create " << data_storage_path << ": " << error.message() << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> map_names;
+	const char* basic_map_names[] = {"lab_ipa", "lab_c_scan", "Freiburg52_scan", "Freiburg79_scan", "lab_b_scan", "lab_intel", "Freiburg101_scan",
+			"lab_d_scan", "lab_f_scan", "lab_a_scan", "NLB", "office_a", "office_b", "office_c", "office_d", "office_e", "office_f", "office_g",
+			"office_h", "office_i"};
+	const int number_of_basic_maps = sizeof(basic_map_names)/sizeof(basic_map_names[0]);
+	for (int i=0; i<number_of_basic_maps; ++i)
+		map_names.push_back(basic_map_names[i]);
+	for (int i=0; i<number_of_basic_maps; ++i)
+		map_names.push_back(std::string(basic_map_names[i]) + "_furnitures");
+
+	std::vector<RunnerConfig> configurations;
+	setConfigurations(configurations);
+	number_of_workers = std::min(number_of_workers, (int)map_names.size());
+	std::cout << "evaluating " << map_names.size() << " maps x " << configurations.size() << " configurations with " << number_of_workers << " workers" << std::endl;
+
+	// start the workers, each one evaluates its maps in its own process
+	Timer timer;
+	std::vector<pid_t> workers;
+	for (int worker=0; worker<number_of_workers; ++worker)
+	{
+		const pid_t pid = fork();
+		if (pid == 0)
+			_exit(runWorker(worker, number_of_workers, map_names, configurations, test_map_path, data_storage_path, parameters));
+		if (pid < 0)
+		{
+			std::cout << "Error: could not start worker " << worker << ", evaluating its maps in this process." << std::endl;
+			runWorker(worker, number_of_workers, map_names, configurations, test_map_path, data_storage_path, parameters);
+		}
+		else
+			workers.push_back(pid);
+	}
+	for (size_t i=0; i<workers.size(); ++i)
+	{
+		int status = 0;
+		while (waitpid(workers[i], &status, 0) < 0 && errno == EINTR);
+		if (WIFEXITED(status) == false || WEXITSTATUS(status) != 0)
+			std::cout << "Warning: worker process " << workers[i] << " did not finish, its results are incomplete." << std::endl;
+	}
+
+	// merge the results of the workers
+	const std::string results_filename = data_storage_path + "results.csv";
+	std::ofstream results(results_filename.c_str(), std::ios::out | std::ios::trunc);
+	writeResultsHeader(results);
+	for (int worker=0; worker<number_of_workers; ++worker)
+	{
+		const std::string worker_results_filename = getWorkerResultsFilename(data_storage_path, worker);
+		std::ifstream worker_results(worker_results_filename.c_str());
+		std::string line;
+		while (std::getline(worker_results, line))
+			results << line << std::endl;
+		worker_results.close();
+		remove(worker_results_filename.c_str());
+	}
+	results.close();
+	std::cout << "evaluation finished after " << timer.getElapsedTimeInSec() << " s, results written to " << results_filename << std::endl;
+
+	return 0;
+}
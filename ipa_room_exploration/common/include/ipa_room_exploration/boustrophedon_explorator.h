@@ -205,13 +205,10 @@ struct BoustrophedonHorizontalLine
 // Structure for saving several properties of cells
 struct BoustrophedonCell
 {
-	typedef std::set<boost::shared_ptr<BoustrophedonCell> > BoustrophedonCellSet;
-	typedef std::set<boost::shared_ptr<BoustrophedonCell> >::iterator BoustrophedonCellSetIterator;
-
 	int label_;				// label id of the cell
 	double area_;			// area of the cell, in [pixel^2]
 	cv::Rect bounding_box_;		// bounding box of the cell
-	BoustrophedonCellSet neighbors_;		// pointer to neighboring cells
+	std::map<int, int> neighbors_;		// labels of the neighboring cells --> number of border pixels between both cells
 
 	BoustrophedonCell(const int label, const double area, const cv::Rect& bounding_box)
 	{
@@ -222,6 +219,83 @@ struct BoustrophedonCell
 
 };
 
+// Adjacency graph of the cells for merging: the cells form the sets of a union-find structure. Each cell that has not been
+// merged into another cell (a root) holds the area and the bounding box of its whole set, and its neighbors are always roots,
+// so a merger only touches the neighbors of the merged cell instead of the label image.
+struct BoustrophedonCellGraph
+{
+	std::vector<BoustrophedonCell> cells_;		// index = label, label 0 (obstacles) is unused
+	std::vector<int> parent_;					// union-find parent of each label
+
+	BoustrophedonCellGraph()
+	{
+		cells_.push_back(BoustrophedonCell(0, 0., cv::Rect()));
+		parent_.push_back(0);
+	}
+
+	// adds a new cell and returns its label
+	int addCell(const double area, const cv::Rect& bounding_box)
+	{
+		const int label = cells_.size();
+		cells_.push_back(BoustrophedonCell(label, area, bounding_box));
+		parent_.push_back(label);
+		return label;
+	}
+
+	// counts a border pixel between the cells label_1 and label_2 (if add_border_pixel is true) and makes them neighbors
+	void addBorderPixel(const int label_1, const int label_2, const bool add_border_pixel)
+	{
+		cells_[label_1].neighbors_[label_2] += (add_border_pixel==true ? 1 : 0);
+		cells_[label_2].neighbors_[label_1] += (add_border_pixel==true ? 1 : 0);
+	}
+
+	// returns the label of the cell that label has been merged into
+	int findRoot(const int label)
+	{
+		int root = label;
+		while (parent_[root] != root)
+			root = parent_[root];
+		for (int l=label; parent_[l]!=root; )
+		{
+			const int next = parent_[l];
+			parent_[l] = root;
+			l = next;
+		}
+		return root;
+	}
+
+	bool isRoot(const int label) const
+	{
+		return parent_[label] == label;
+	}
+
+	// merges the root cell minor_label into the root cell major_label, the border pixels between both become part of the major cell
+	void mergeCells(const int minor_label, const int major_label)
+	{
+		BoustrophedonCell& minor_cell = cells_[minor_label];
+		BoustrophedonCell& major_cell = cells_[major_label];
+		std::map<int, int>::iterator border = major_cell.neighbors_.find(minor_label);
+		if (border != major_cell.neighbors_.end())
+		{
+			major_cell.area_ += border->second;
+			major_cell.neighbors_.erase(border);
+		}
+		major_cell.area_ += minor_cell.area_;
+		major_cell.bounding_box_ |= minor_cell.bounding_box_;
+		for (std::map<int, int>::iterator itn=minor_cell.neighbors_.begin(); itn!=minor_cell.neighbors_.end(); ++itn)
+		{
+			if (itn->first == major_label)
+				continue;
+			major_cell.neighbors_[itn->first] += itn->second;
+			std::map<int, int>& neighbors_of_neighbor = cells_[itn->first].neighbors_;
+			neighbors_of_neighbor.erase(minor_label);
+			neighbors_of_neighbor[major_label] += itn->second;
+		}
+		minor_cell.neighbors_.clear();
+		parent_[minor_label] = major_label;
+	}
+};
+
 
 // Class that generates a room exploration path by using the morse cellular decomposition method, proposed by
 //
@@ -240,13 +314,35 @@ protected:
 	// pathplanner to check for the next nearest locations
 	AStarPlanner path_planner_;
 
+	// if true, the transitions between the tracks of a cell are shortened to straight lines between the corners of the planned
+	// path (see AStarPlanner::planSmoothedPath) instead of following the grid cells of the path
+	bool smooth_transition_paths_;
+
 	static const uchar BORDER_PIXEL_VALUE = 25;
 
+	// result of the cell decomposition with one rotation of the map
+	struct CellDecomposition
+	{
+		cv::Mat R;
+		cv::Rect bbox;
+		cv::Mat rotated_room_map;
+		std::vector<GeneralizedPolygon> cell_polygons;
+		std::vector<cv::Point> polygon_centers;
+		double score;		// see DecompositionScore, lower is better
+	};
+
 	// rotates the original map for a good axis alignment and divides it into Morse cells
-	// the functions tries two axis alignments with 90deg rotation difference and chooses the one with the lower number of cells
+	// the function computes the cell decompositions with each of the given rotation offsets (in [rad], added to the rotation of
+	// the room's main direction) in parallel and chooses the one with the best decomposition_score (see DecompositionScore)
 	void findBestCellDecomposition(const cv::Mat& room_map, const float map_resolution, const double min_cell_area,
-			const int min_cell_width, cv::Mat& R, cv::Rect& bbox, cv::Mat& rotated_room_map,
-			std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers);
+			const int min_cell_width, const std::vector<double>& rotation_offsets, const int decomposition_score, const int grid_spacing_as_int,
+			cv::Mat& R, cv::Rect& bbox, cv::Mat& rotated_room_map, std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers);
+
+	// estimates the length of the coverage path through the cells: every cell is covered by tracks along its longer side, so its
+	// path is about area/grid_spacing long plus one turn of grid_spacing per track (i.e. the shorter side of the cell), and the
+	// cells are connected by a nearest neighbor tour through the cell centers
+	double estimatePathLength(const std::vector<GeneralizedPolygon>& cell_polygons, const std::vector<cv::Point>& polygon_centers,
+			const int grid_spacing_as_int);
 
 	// rotates the original map for a good axis alignment and divides it into Morse cells
 	// @param rotation_offset can be used to put an offset to the computed rotation for good axis alignment, in [rad]
@@ -259,17 +355,13 @@ protected:
 			const int min_cell_width, std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers);
 
 	// merges cells after a cell decomposition according to various criteria specified in function @mergeCellsSelection
+	// the mergers are done on the cell adjacency graph and the label image is relabeled once at the end
 	// returns the number of cells after merging
 	int mergeCells(cv::Mat& cell_map, cv::Mat& cell_map_labels, const double min_cell_area, const int min_cell_width);
 
 	// implements the selection criterion for cell merging, in this case: too small (area) or too thin (width or height) cells
 	// are merged with their largest neighboring cell.
-	void mergeCellsSelection(cv::Mat& cell_map, cv::Mat& cell_map_labels, std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping,
-			const double min_cell_area, const int min_cell_width);
-
-	// executes the merger of minor cell into major cell
-	void mergeTwoCells(cv::Mat& cell_map, cv::Mat& cell_map_labels, const BoustrophedonCell& minor_cell, BoustrophedonCell& major_cell,
-			std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping);
+	void mergeCellsSelection(BoustrophedonCellGraph& cell_graph, const double min_cell_area, const int min_cell_width);
 
 	// this function corrects obstacles that are one pixel width at 45deg angle, i.e. a 2x2 pixel neighborhood with [0, 255, 255, 0] or [255, 0, 0, 255]
 	void correctThinWalls(cv::Mat& room_map);
@@ -279,6 +371,11 @@ protected:
 			std::vector<cv::Point2f>& fov_middlepoint_path, cv::Point& robot_pos,
 			const int grid_spacing_as_int, const int half_grid_spacing_as_int, const double path_eps, const int max_deviation_from_track, const int grid_obstacle_offset=0);
 
+	// plans the transition from start to goal inside a cell on cell_map and stores the cells of the path in path (empty if start
+	// and goal are the same or no path exists), the path is smoothed if smooth_transition_paths_ is set
+	void planTransitionPath(const cv::Mat& cell_map, const cv::Point& start, const cv::Point& goal, const float map_resolution,
+			std::vector<cv::Point>& path);
+
 	// downsamples a given path original_path to waypoint distances of path_eps and appends the resulting path to downsampled_path
 	void downsamplePath(const std::vector<cv::Point>& original_path, std::vector<cv::Point>& downsampled_path,
 			cv::Point& cell_robot_pos, const double path_eps);
@@ -288,21 +385,31 @@ protected:
 	void downsamplePathReverse(const std::vector<cv::Point>& original_path, std::vector<cv::Point>& downsampled_path,
 			cv::Point& robot_pos, const double path_eps);
 
-	void printCells(std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping);
+	void printCells(BoustrophedonCellGraph& cell_graph);
 
 public:
 	// constructor
 	BoustrophedonExplorer();
 
+	// function to set the parameters of the path planning between the tracks, search_strategy is an AStarPlanner::SearchStrategy
+	void setPathPlanningParameters(const int search_strategy, const bool smooth_transition_paths)
+	{
+		path_planner_.setSearchStrategy(search_strategy == AStarPlanner::JUMP_POINT_SEARCH ? AStarPlanner::JUMP_POINT_SEARCH : AStarPlanner::A_STAR_SEARCH);
+		smooth_transition_paths_ = smooth_transition_paths;
+	}
+
 	// Function that creates an exploration path for a given room. The room has to be drawn in a cv::Mat (filled with Bit-uchar),
 	// with free space drawn white (255) and obstacles as black (0). It returns a series of 2D poses that show to which positions
 	// the robot should drive at.
 	void getExplorationPath(const cv::Mat& room_map, std::vector<geometry_msgs::Pose2D>& path, const float map_resolution,
 				const cv::Point starting_position, const cv::Point2d map_origin, const double grid_spacing_in_pixel,
 				const double grid_obstacle_offset, const double path_eps, const int cell_visiting_order, const bool plan_for_footprint,
-				const Eigen::Matrix<float, 2, 1> robot_to_fov_vector, const double min_cell_area, const int max_deviation_from_track);
+				const Eigen::Matrix<float, 2, 1> robot_to_fov_vector, const double min_cell_area, const int max_deviation_from_track,
+				const std::vector<double>& rotation_offsets=std::vector<double>(1, 0.), const int decomposition_score=CELL_COUNT);
 
 	enum CellVisitingOrder {OPTIMAL_TSP=1, LEFT_TO_RIGHT=2};
+	// criterion for choosing the cell decomposition among several rotations of the map
+	enum DecompositionScore {CELL_COUNT=1, PATH_LENGTH=2};
 };
 
 
@@ -311,8 +418,7 @@ class BoustrophedonVariantExplorer : public BoustrophedonExplorer
 protected:
 
 	// implements the selection criterion for cell merging, in this case: only large cells with different major axis are not merged.
-	void mergeCellsSelection(cv::Mat& cell_map, cv::Mat& cell_map_labels, std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping,
-			const double min_cell_area, const int min_cell_width);
+	void mergeCellsSelection(BoustrophedonCellGraph& cell_graph, const double min_cell_area, const int min_cell_width);
 
 public:
 	BoustrophedonVariantExplorer() {};
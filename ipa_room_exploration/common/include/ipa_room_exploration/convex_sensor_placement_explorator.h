@@ -64,6 +64,7 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <fstream>
@@ -73,7 +74,7 @@
 #include <Eigen/Dense>
 // Coin-Or Cbc linear programming solver
 #include <coin/OsiClpSolverInterface.hpp>
-#include <coin/CoinModel.hpp>
+#include <coin/CoinPackedMatrix.hpp>
 #include <coin/CbcModel.hpp>
 #include <coin/CbcHeuristicLocal.hpp>
 // if available, use Gurobi
@@ -88,6 +89,7 @@
 #include <ipa_room_exploration/room_rotator.h>
 #include <ipa_room_exploration/fov_to_robot_mapper.h>
 #include <ipa_room_exploration/grid.h>
+#include <ipa_room_exploration/coverage_matrix.h>
 #include <ipa_room_exploration/timer.h>
 
 #include <geometry_msgs/Pose2D.h>
@@ -124,11 +126,22 @@ protected:
 	// function that is used to create and solve a Gurobi optimization problem out of the given matrices and vectors, if
 	// Gurobi was found on the computer
 	template<typename T>
-	void solveGurobiOptimizationProblem(std::vector<T>& C, const cv::Mat& V, const std::vector<double>* W);
+	void solveGurobiOptimizationProblem(std::vector<T>& C, const CoverageMatrix& V, const std::vector<double>* W);
 
 	// function that is used to create and solve a Qsopt optimization problem out of the given matrices and vectors
 	template<typename T>
-	void solveOptimizationProblem(std::vector<T>& C, const cv::Mat& V, const std::vector<double>* W);
+	void solveOptimizationProblem(std::vector<T>& C, const CoverageMatrix& V, const std::vector<double>* W);
+
+	// rounds the solution of the LP relaxation of the final set cover problem (min sum C s.t. VC >= 1) to a feasible cover,
+	// which is used as start solution for the MIP and as solution if the MIP finds no cover within the time limit, returns
+	// false if a cell cannot be covered by any candidate
+	bool roundRelaxedSolution(const CoverageMatrix& V, const double* relaxed_solution, std::vector<double>& cover);
+
+	// parameters of the Cbc MIP solver
+	bool use_lp_rounding_start_;	// if true, the LP relaxation of the final problem is solved and rounded first, the rounded cover is the MIP start
+	double mip_time_limit_;			// maximal time for the branch and bound of the final problem in [s], the best solution found so far (or the rounded LP relaxation if there is none) is taken when it is reached, 0 = no limit
+									// the LP relaxations before the branch and bound are not limited
+	double mip_relative_gap_;		// the branch and bound stops when the relative gap between the best solution and the lower bound is below this value, 0 = solve to optimality
 
 	// object to find a path trough the chosen sensing poses by doing a repetitive nearest neighbor algorithm
 	NearestNeighborTSPSolver tsp_solver_;
@@ -140,6 +153,14 @@ public:
 	// constructor
 	convexSPPExplorator();
 
+	// function to set the parameters of the Cbc MIP solver, see the member variables (not used when Gurobi is available)
+	void setSolverParameters(const bool use_lp_rounding_start, const double mip_time_limit, const double mip_relative_gap)
+	{
+		use_lp_rounding_start_ = use_lp_rounding_start;
+		mip_time_limit_ = mip_time_limit;
+		mip_relative_gap_ = mip_relative_gap;
+	}
+
 	// Function that creates an exploration path for a given room. The room has to be drawn in a cv::Mat (filled with Bit-uchar),
 	// with free space drawn white (255) and obstacles as black (0). It returns a series of 2D poses that show to which positions
 	// the robot should drive at. The footprint stores a polygon that is used to determine the visibility at a specific
@@ -0,0 +1,179 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2016 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_room_exploration
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 03.2017
+ *
+ * \brief
+ * Sparse binary coverage matrix of the linear programs of the coverage planners.
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+// Binary coverage matrix V of the linear programs, with one row for each cell and one column for each candidate (sensing
+// pose or arc), V(i,j) = 1 if cell i is covered by candidate j. Only the entries equal to 1 are stored, in compressed
+// sparse row (CSR) form: the columns of row i are column_indices_[row_starts_[i]] ... column_indices_[row_starts_[i+1]-1]
+// in ascending order. So the memory and the assembly of the constraints grow with the number of covered cells per candidate
+// and not with the number of cells times the number of candidates.
+class CoverageMatrix
+{
+protected:
+	int rows_;
+	int cols_;
+	std::vector<int> row_starts_;		// size rows_+1
+	std::vector<int> column_indices_;	// size nonZeros()
+
+public:
+	CoverageMatrix()
+	: rows_(0), cols_(0), row_starts_(1, 0)
+	{
+	}
+
+	// builds the matrix from the cells that are covered by each candidate, covered_rows[j] contains the rows i with V(i,j) = 1,
+	// every row may occur at most once in each column
+	void setFromColumns(const int rows, const std::vector<std::vector<int> >& covered_rows)
+	{
+		rows_ = rows;
+		cols_ = covered_rows.size();
+
+		// count the entries of each row and sort the columns into the rows, the columns of a row stay in ascending order
+		row_starts_.assign(rows_+1, 0);
+		for (size_t col=0; col<covered_rows.size(); ++col)
+			for (std::vector<int>::const_iterator row=covered_rows[col].begin(); row!=covered_rows[col].end(); ++row)
+				++row_starts_[*row+1];
+		for (int row=0; row<rows_; ++row)
+			row_starts_[row+1] += row_starts_[row];
+		column_indices_.resize(row_starts_[rows_]);
+		std::vector<int> next_entry(row_starts_.begin(), row_starts_.end()-1);
+		for (size_t col=0; col<covered_rows.size(); ++col)
+			for (std::vector<int>::const_iterator row=covered_rows[col].begin(); row!=covered_rows[col].end(); ++row)
+				column_indices_[next_entry[*row]++] = col;
+	}
+
+	// inverse of setFromColumns, covered_rows[j] receives the rows i with V(i,j) = 1 in ascending order
+	void getColumns(std::vector<std::vector<int> >& covered_rows) const
+	{
+		covered_rows.assign(cols_, std::vector<int>());
+		for (int row=0; row<rows_; ++row)
+			for (int entry=row_starts_[row]; entry<row_starts_[row+1]; ++entry)
+				covered_rows[column_indices_[entry]].push_back(row);
+	}
+
+	// stores the matrix of the given columns of this matrix in selected, column k of selected is column columns[k] of this matrix
+	void selectColumns(const std::vector<int>& columns, CoverageMatrix& selected) const
+	{
+		std::vector<int> new_column(cols_, -1);
+		for (size_t k=0; k<columns.size(); ++k)
+			new_column[columns[k]] = k;
+
+		selected.rows_ = rows_;
+		selected.cols_ = columns.size();
+		selected.row_starts_.assign(1, 0);
+		selected.column_indices_.clear();
+		for (int row=0; row<rows_; ++row)
+		{
+			for (int entry=row_starts_[row]; entry<row_starts_[row+1]; ++entry)
+				if (new_column[column_indices_[entry]] >= 0)
+					selected.column_indices_.push_back(new_column[column_indices_[entry]]);
+			std::sort(selected.column_indices_.begin()+selected.row_starts_.back(), selected.column_indices_.end());
+			selected.row_starts_.push_back(selected.column_indices_.size());
+		}
+	}
+
+	int rows() const
+	{
+		return rows_;
+	}
+
+	int cols() const
+	{
+		return cols_;
+	}
+
+	// number of entries equal to 1
+	int nonZeros() const
+	{
+		return column_indices_.size();
+	}
+
+	// number of candidates that cover the cell row
+	int rowSize(const int row) const
+	{
+		return row_starts_[row+1] - row_starts_[row];
+	}
+
+	// candidates that cover the cell row, in ascending order, the array has rowSize(row) entries
+	const int* rowBegin(const int row) const
+	{
+		return column_indices_.data() + row_starts_[row];
+	}
+
+	// returns V(row, col)
+	bool at(const int row, const int col) const
+	{
+		return std::binary_search(rowBegin(row), rowBegin(row)+rowSize(row), col);
+	}
+
+	// CSR arrays, e.g. for loading the matrix into a solver
+	const std::vector<int>& getRowStarts() const
+	{
+		return row_starts_;
+	}
+
+	const std::vector<int>& getColumnIndices() const
+	{
+		return column_indices_;
+	}
+};
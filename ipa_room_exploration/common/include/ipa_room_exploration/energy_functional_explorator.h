@@ -64,6 +64,7 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <string>
 
 #include <Eigen/Dense>
@@ -86,6 +87,7 @@ const double PI_2_INV = 1./(0.5*PI);
 struct EnergyExploratorNode
 {
 	cv::Point center_;
+	int row_, column_;	// position of the node in the grid
 	bool obstacle_;
 	bool visited_;
 	std::vector<EnergyExploratorNode*> neighbors_;
@@ -109,6 +111,58 @@ struct cv_Point_cmp
   }
 };
 
+// Bucket grid that counts the free nodes that have not been visited yet in blocks of block_size_ x block_size_ nodes. It is
+// used to search the next node in the whole grid only in the blocks around the current location that still contain unvisited
+// nodes. The cell of a node has the size grid_spacing_ and its nominal center is grid_origin_ + (column, row)*grid_spacing_,
+// the center of the node itself may be moved inside the cell.
+struct EnergyExploratorNodeBlocks
+{
+	int block_size_;
+	int blocks_x_, blocks_y_;
+	cv::Point grid_origin_;
+	int grid_spacing_;
+	std::vector<int> unvisited_nodes_;	// number of unvisited free nodes of each block, index = block_y*blocks_x_ + block_x
+
+	EnergyExploratorNodeBlocks(const std::vector<std::vector<EnergyExploratorNode> >& nodes, const cv::Point& grid_origin,
+			const int grid_spacing, const int block_size=8)
+	{
+		block_size_ = block_size;
+		blocks_y_ = ((int)nodes.size()+block_size-1)/block_size;
+		blocks_x_ = (nodes.size()>0 ? ((int)nodes[0].size()+block_size-1)/block_size : 0);
+		grid_origin_ = grid_origin;
+		grid_spacing_ = grid_spacing;
+		unvisited_nodes_.resize(blocks_x_*blocks_y_, 0);
+		for(size_t row=0; row<nodes.size(); ++row)
+			for(size_t column=0; column<nodes[row].size(); ++column)
+				if(nodes[row][column].obstacle_==false && nodes[row][column].visited_==false)
+					++unvisited_nodes_[getBlock(nodes[row][column])];
+	}
+
+	int getBlock(const EnergyExploratorNode& node) const
+	{
+		return (node.row_/block_size_)*blocks_x_ + node.column_/block_size_;
+	}
+
+	// has to be called when a free node gets visited
+	void removeNode(const EnergyExploratorNode& node)
+	{
+		--unvisited_nodes_[getBlock(node)];
+	}
+
+	// lower bound of the distance from point to the centers of the nodes in the given block
+	double getMinDistance(const cv::Point& point, const int block_x, const int block_y) const
+	{
+		const int half_grid_spacing = grid_spacing_/2;
+		const int min_x = grid_origin_.x + block_x*block_size_*grid_spacing_ - half_grid_spacing;
+		const int max_x = grid_origin_.x + ((block_x+1)*block_size_-1)*grid_spacing_ + half_grid_spacing;
+		const int min_y = grid_origin_.y + block_y*block_size_*grid_spacing_ - half_grid_spacing;
+		const int max_y = grid_origin_.y + ((block_y+1)*block_size_-1)*grid_spacing_ + half_grid_spacing;
+		const double dx = std::max(0, std::max(min_x-point.x, point.x-max_x));
+		const double dy = std::max(0, std::max(min_y-point.y, point.y-max_y));
+		return std::sqrt(dx*dx + dy*dy);
+	}
+};
+
 // This class provides the functionality of coverage path planning, based on the work in
 //
 //	Bormann Richard, Joshua Hampp, and Martin Hägele. "New brooms sweep clean-an autonomous robotic cleaning assistant for
@@ -137,6 +191,13 @@ protected:
 	// function to compute the energy function for each pair of nodes
 	double E(const EnergyExploratorNode& location, const EnergyExploratorNode& neighbor, const double cell_size_in_pixel, const double previous_travel_angle);
 
+	// function that finds the unvisited free node of the whole grid that minimizes the energy functional, on a tie the first node
+	// in row-major order is taken, returns 0 if all nodes have been visited
+	// Only the blocks of node_blocks are checked, that contain unvisited nodes and that are close enough to the location, because the
+	// energy functional of a node is at least its translational distance.
+	EnergyExploratorNode* findBestNode(std::vector<std::vector<EnergyExploratorNode> >& nodes, const EnergyExploratorNodeBlocks& node_blocks,
+			const EnergyExploratorNode& location, const double cell_size_in_pixel, const double previous_travel_angle);
+
 public:
 	// constructor
 	EnergyFunctionalExplorator();
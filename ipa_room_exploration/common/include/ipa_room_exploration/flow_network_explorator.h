@@ -23,12 +23,14 @@
 #include <boost/config.hpp>
 #include <boost/graph/strong_components.hpp>
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/thread.hpp>
 // package specific includes
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
 #include <ipa_building_navigation/contains.h>
 #include <ipa_room_exploration/fov_to_robot_mapper.h>
 #include <ipa_room_exploration/room_rotator.h>
+#include <ipa_room_exploration/coverage_matrix.h>
 // msgs
 #include <geometry_msgs/Pose2D.h>
 #include <geometry_msgs/Polygon.h>
@@ -469,24 +471,26 @@ class FlowNetworkExplorator
 protected:
 	// function that is used to create and solve a Cbc optimization problem out of the given matrices and vectors, using
 	// the three-stage ansatz and single-flow cycle prevention constraints
-	void solveThreeStageOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+	void solveThreeStageOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 			const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 			const std::vector<uint>& start_arcs);
 
 	// function that is used to create and solve a Gurobi optimization problem out of the given matrices and vectors, using
 	// the three-stage ansatz and lazy generalized cutset inequalities (GCI)
-	void solveGurobiOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+	void solveGurobiOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 			const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 			const std::vector<uint>& start_arcs);
 
 	// function that is used to create and solve a Cbc optimization problem out of the given matrices and vectors, using
 	// the three-stage ansatz and lazy generalized cutset inequalities (GCI)
-	void solveLazyConstraintOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+	void solveLazyConstraintOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 			const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 			const std::vector<uint>& start_arcs);
 
-	// function that checks if the given point is more close enough to any point in the given vector
-	bool pointClose(const std::vector<cv::Point>& points, const cv::Point& point, const double min_distance);
+	// function that finds the cells whose centers are within min_distance to any point in the given vector, the cell centers lie on
+	// a grid with the given origin and cell size and cell_labels stores the index of the cell at each grid position (-1 for no cell)
+	void getCoveredCells(const std::vector<cv::Point>& points, const cv::Mat& cell_labels, const cv::Point& grid_origin,
+			const int cell_size, const double min_distance, std::vector<int>& covered_cells);
 
 	// object that plans a path from A to B using the Astar method
 	AStarPlanner path_planner_;
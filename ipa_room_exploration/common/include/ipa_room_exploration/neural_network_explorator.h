@@ -12,7 +12,10 @@
 #include <geometry_msgs/Polygon.h>
 #include <Eigen/Dense>
 
-#include <ipa_room_exploration/neuron_class.h>
+#include <boost/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include <ipa_room_exploration/fov_to_robot_mapper.h>
 #include <ipa_room_exploration/room_rotator.h>
 #include <ipa_room_exploration/grid.h>
@@ -107,8 +110,46 @@ class NeuralNetworkExplorator
 {
 protected:
 
-	// vector that stores the neurons of the given map
-	std::vector<std::vector<Neuron> > neurons_;
+	// The neurons of the given map are stored as flat arrays (structure of arrays) on the sampling grid, surrounded by a border
+	// of one neuron with constant zero activity, so every neuron can be updated with the same 8-neighborhood stencil.
+	// Neuron (row, column) is stored at index (row+1)*network_stride_ + column+1. The activities are double buffered because all
+	// neurons are updated synchronously from the previous activities, each neuron follows the shunting equation of the paper.
+	int network_rows_, network_columns_, network_stride_;
+	std::vector<double> states_[2];			// activity of each neuron, the current activities are stored in states_[current_states_]
+	int current_states_;
+	std::vector<double> external_input_;	// external input of each neuron: E for unvisited free neurons, 0 for visited ones and -E for obstacles
+	std::vector<double> neighbor_weights_[8];	// weight of each neuron to its neighbor in the direction (dy,dx) = (-1,-1), (-1,0), (-1,1),
+												// (0,-1), (0,1), (1,-1), (1,0), (1,1), it depends on the distance of the cell centers
+	int neighbor_offsets_[8];				// index offsets to the neighbors in the same order
+
+	// checks if the given index belongs to a neuron of the network and not to its border
+	bool isInNetwork(const int index) const
+	{
+		const int row = index/network_stride_, column = index%network_stride_;
+		return index >= 0 && row >= 1 && row <= network_rows_ && column >= 1 && column <= network_columns_;
+	}
+
+	// updates the activities of all neurons number_of_updates times, the rows of the network are split among the calling thread
+	// and the worker threads of startUpdateThreads
+	void updateStates(const int number_of_updates);
+
+	// updates the activities of the rows [first_row, last_row) number_of_updates times, if the rows are split among several
+	// threads, barrier synchronizes the threads after each update
+	void updateStatesOfRows(const int first_row, const int last_row, const int number_of_updates, boost::barrier* barrier);
+
+	// starts the worker threads of updateStates for the current network, they are kept for all updates of a path and have
+	// to be stopped with stopUpdateThreads before the network changes, small networks are updated without worker threads
+	void startUpdateThreads();
+	void stopUpdateThreads();
+
+	// worker thread of updateStates: waits for the updates posted by updateStates and applies them to the rows
+	// [first_row, last_row) until stopUpdateThreads is called
+	void runUpdateThread(const int first_row, const int last_row);
+
+	int number_of_update_threads_;		// number of threads that update the network, including the calling thread
+	boost::thread_group update_threads_;
+	boost::shared_ptr<boost::barrier> update_barrier_;	// synchronizes the worker threads with the calling thread
+	int posted_updates_;				// number of updates posted to the worker threads, -1 stops them
 
 	// step size used for integrating the states of the neurons
 	double step_size_;
@@ -1,9 +1,14 @@
 #include <ipa_room_exploration/boustrophedon_explorator.h>
 
+#include <queue>
+
+#include <boost/thread.hpp>
+
 //#define DEBUG_VISUALIZATION
 
 // Constructor
 BoustrophedonExplorer::BoustrophedonExplorer()
+: smooth_transition_paths_(false)
 {
 
 }
@@ -20,7 +25,8 @@ BoustrophedonExplorer::BoustrophedonExplorer()
 // I.	Using the Sobel operator the direction of the gradient at each pixel is computed. Using this information, the direction is
 //		found that suits best for calculating the cells, i.e. such that longer cells occur, and the map is rotated in this manner.
 //		This allows to use the algorithm as it was and in the last step, the found path points simply will be transformed back to the
-//		original orientation.
+//		original orientation. If several rotation offsets are given, the cell decomposition is computed for each of these
+//		additional rotations in parallel and the one with the fewest cells or the shortest estimated path is taken.
 // II.	Sweep a slice (a morse function) trough the given map and check for connectivity of this line,
 //		i.e. how many connected segments there are. If the connectivity increases, i.e. more segments appear,
 //		an IN event occurs that opens new separate cells, if it decreases, i.e. segments merge, an OUT event occurs that
@@ -47,7 +53,8 @@ BoustrophedonExplorer::BoustrophedonExplorer()
 void BoustrophedonExplorer::getExplorationPath(const cv::Mat& room_map, std::vector<geometry_msgs::Pose2D>& path,
 		const float map_resolution, const cv::Point starting_position, const cv::Point2d map_origin,
 		const double grid_spacing_in_pixel, const double grid_obstacle_offset, const double path_eps, const int cell_visiting_order,
-		const bool plan_for_footprint, const Eigen::Matrix<float, 2, 1> robot_to_fov_vector, const double min_cell_area, const int max_deviation_from_track)
+		const bool plan_for_footprint, const Eigen::Matrix<float, 2, 1> robot_to_fov_vector, const double min_cell_area, const int max_deviation_from_track,
+		const std::vector<double>& rotation_offsets, const int decomposition_score)
 {
 	ROS_INFO("Planning the boustrophedon path trough the room.");
 	const int grid_spacing_as_int = (int)std::floor(grid_spacing_in_pixel); // convert fov-radius to int
@@ -62,8 +69,12 @@ void BoustrophedonExplorer::getExplorationPath(const cv::Mat& room_map, std::vec
 	cv::Mat rotated_room_map;
 	std::vector<GeneralizedPolygon> cell_polygons;
 	std::vector<cv::Point> polygon_centers;
-	computeCellDecompositionWithRotation(room_map, map_resolution, min_cell_area, min_cell_width, 0., R, bbox, rotated_room_map, cell_polygons, polygon_centers);
-	// does not work so well: findBestCellDecomposition(room_map, map_resolution, min_cell_area, R, bbox, rotated_room_map, cell_polygons, polygon_centers);
+	if (rotation_offsets.size() > 1)
+		findBestCellDecomposition(room_map, map_resolution, min_cell_area, min_cell_width, rotation_offsets, decomposition_score, grid_spacing_as_int,
+				R, bbox, rotated_room_map, cell_polygons, polygon_centers);
+	else
+		computeCellDecompositionWithRotation(room_map, map_resolution, min_cell_area, min_cell_width, (rotation_offsets.size()==1 ? rotation_offsets[0] : 0.),
+				R, bbox, rotated_room_map, cell_polygons, polygon_centers);
 
 	ROS_INFO("Found the cells in the given map.");
 
@@ -197,37 +208,97 @@ void BoustrophedonExplorer::getExplorationPath(const cv::Mat& room_map, std::vec
 
 
 void BoustrophedonExplorer::findBestCellDecomposition(const cv::Mat& room_map, const float map_resolution, const double min_cell_area,
-		const int min_cell_width, cv::Mat& R, cv::Rect& bbox, cv::Mat& rotated_room_map,
-		std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers)
+		const int min_cell_width, const std::vector<double>& rotation_offsets, const int decomposition_score, const int grid_spacing_as_int,
+		cv::Mat& R, cv::Rect& bbox, cv::Mat& rotated_room_map, std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers)
 {
 	// *********************** I. Find the main directions of the map and rotate it in this manner. ***********************
 	// *********************** II. Sweep a slice trough the map and mark the found cell boundaries. ***********************
 	// *********************** III. Find the separated cells. ***********************
-	cv::Mat R_1, R_2;
-	cv::Rect bbox_1, bbox_2;
-	cv::Mat rotated_room_map_1, rotated_room_map_2;
-	std::vector<GeneralizedPolygon> cell_polygons_1, cell_polygons_2;
-	std::vector<cv::Point> polygon_centers_1, polygon_centers_2;
-	computeCellDecompositionWithRotation(room_map, map_resolution, min_cell_area, min_cell_width, 0., R_1, bbox_1, rotated_room_map_1, cell_polygons_1, polygon_centers_1);
-	computeCellDecompositionWithRotation(room_map, map_resolution, min_cell_area, min_cell_width, 90./180.*CV_PI, R_2, bbox_2, rotated_room_map_2, cell_polygons_2, polygon_centers_2);
-
-	// select the cell decomposition with good axis alignment which produces less cells
-	if (cell_polygons_1.size() <= cell_polygons_2.size())
+	// each rotation is decomposed and scored independently, the threads take the next rotation until all are done
+	std::vector<CellDecomposition> decompositions(rotation_offsets.size());
+	size_t next_rotation = 0;
+	boost::mutex next_rotation_mutex;
+	const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)rotation_offsets.size()));
+	boost::thread_group threads;
+	for (int t=0; t<number_of_threads; ++t)
 	{
-		R = R_1;
-		bbox = bbox_1;
-		rotated_room_map = rotated_room_map_1;
-		cell_polygons = cell_polygons_1;
-		polygon_centers = polygon_centers_1;
+		threads.create_thread([&]()
+		{
+			while (true)
+			{
+				size_t i = 0;
+				{
+					boost::mutex::scoped_lock lock(next_rotation_mutex);
+					i = next_rotation++;
+				}
+				if (i >= rotation_offsets.size())
+					return;
+				CellDecomposition& decomposition = decompositions[i];
+				computeCellDecompositionWithRotation(room_map, map_resolution, min_cell_area, min_cell_width, rotation_offsets[i], decomposition.R,
+						decomposition.bbox, decomposition.rotated_room_map, decomposition.cell_polygons, decomposition.polygon_centers);
+				if (decomposition_score == PATH_LENGTH)
+					decomposition.score = estimatePathLength(decomposition.cell_polygons, decomposition.polygon_centers, grid_spacing_as_int);
+				else
+					decomposition.score = decomposition.cell_polygons.size();
+			}
+		});
 	}
-	else
+	threads.join_all();
+
+	// select the cell decomposition with the best score, the first rotation wins ties
+	size_t best = 0;
+	for (size_t i=1; i<decompositions.size(); ++i)
+		if (decompositions[i].score < decompositions[best].score)
+			best = i;
+	std::cout << "BoustrophedonExplorer::findBestCellDecomposition: chose rotation offset " << rotation_offsets[best]*180./CV_PI << "deg with "
+			<< decompositions[best].cell_polygons.size() << " cells and score " << decompositions[best].score << std::endl;
+	R = decompositions[best].R;
+	bbox = decompositions[best].bbox;
+	rotated_room_map = decompositions[best].rotated_room_map;
+	cell_polygons.swap(decompositions[best].cell_polygons);
+	polygon_centers.swap(decompositions[best].polygon_centers);
+}
+
+double BoustrophedonExplorer::estimatePathLength(const std::vector<GeneralizedPolygon>& cell_polygons, const std::vector<cv::Point>& polygon_centers,
+		const int grid_spacing_as_int)
+{
+	const double grid_spacing = std::max(1, grid_spacing_as_int);
+
+	// coverage paths inside the cells
+	double path_length = 0.;
+	for (size_t i=0; i<cell_polygons.size(); ++i)
 	{
-		R = R_2;
-		bbox = bbox_2;
-		rotated_room_map = rotated_room_map_2;
-		cell_polygons = cell_polygons_2;
-		polygon_centers = polygon_centers_2;
+		const std::vector<cv::Point> vertices = cell_polygons[i].getVertices();
+		if (vertices.size() == 0)
+			continue;
+		const cv::RotatedRect cell_rect = cv::minAreaRect(vertices);
+		path_length += cell_polygons[i].getArea()/grid_spacing + std::min(cell_rect.size.width, cell_rect.size.height);
 	}
+
+	// nearest neighbor tour through the cell centers
+	std::vector<bool> visited(polygon_centers.size(), false);
+	size_t current = 0;
+	for (size_t step=1; step<polygon_centers.size(); ++step)
+	{
+		visited[current] = true;
+		size_t nearest = current;
+		double nearest_distance = 1e100;
+		for (size_t j=0; j<polygon_centers.size(); ++j)
+		{
+			if (visited[j] == true)
+				continue;
+			const double distance = cv::norm(polygon_centers[j]-polygon_centers[current]);
+			if (distance < nearest_distance)
+			{
+				nearest_distance = distance;
+				nearest = j;
+			}
+		}
+		path_length += nearest_distance;
+		current = nearest;
+	}
+
+	return path_length;
 }
 
 void BoustrophedonExplorer::computeCellDecompositionWithRotation(const cv::Mat& room_map, const float map_resolution, const double min_cell_area,
@@ -494,8 +565,7 @@ int BoustrophedonExplorer::mergeCells(cv::Mat& cell_map, cv::Mat& cell_map_label
 			if (cell_map_labels.at<int>(v,u) == BORDER_PIXEL_VALUE*256)
 				cell_map_labels.at<int>(v,u) = -1;
 	//   --> flood fill cell regions with unique id labels
-	std::map<int, boost::shared_ptr<BoustrophedonCell> > cell_index_mapping;		// maps each cell label --> to the cell object
-	int label_index = 1;
+	BoustrophedonCellGraph cell_graph;		// cell i is stored at cell_graph.cells_[i]
 	for (int v=0; v<cell_map_labels.rows; ++v)
 	{
 		for (int u=0; u<cell_map_labels.cols; ++u)
@@ -506,106 +576,95 @@ int BoustrophedonExplorer::mergeCells(cv::Mat& cell_map, cv::Mat& cell_map_label
 
 			// fill each cell with a unique id
 			cv::Rect bounding_box;
+			const int label_index = cell_graph.cells_.size();
 			const double area = cv::floodFill(cell_map_labels, cv::Point(u,v), label_index, &bounding_box, 0, 0, 4);
-			cell_index_mapping[label_index] = boost::shared_ptr<BoustrophedonCell>(new BoustrophedonCell(label_index, area, bounding_box));
-			label_index++;
-			if (label_index == INT_MAX)
+			cell_graph.addCell(area, bounding_box);
+			if (label_index == INT_MAX-1)
 				std::cout << "WARN: BoustrophedonExplorer::mergeCells: label_index exceeds range of int." << std::endl;
 		}
 	}
-	std::cout << "INFO: BoustrophedonExplorer::mergeCells: found " << label_index-1 << " cells before merging." << std::endl;
+	std::cout << "INFO: BoustrophedonExplorer::mergeCells: found " << cell_graph.cells_.size()-1 << " cells before merging." << std::endl;
 
-	// determine the neighborhood relationships between all cells
+	// determine the neighborhood relationships between all cells and the border pixels between them
+	std::vector<cv::Vec4i> border_pixel_neighbors;		// labels left, right, up and down of each border pixel that separates two cells
+	std::vector<cv::Point> border_pixels;
 	for (int v=1; v<cell_map_labels.rows-1; ++v)
 	{
 		for (int u=1; u<cell_map_labels.cols-1; ++u)
 		{
 			if (cell_map_labels.at<int>(v,u)==-1)	// only check the border points for neighborhood relationships
 			{
-				const int label_left = cell_map_labels.at<int>(v,u-1);
-				const int label_right = cell_map_labels.at<int>(v,u+1);
-				if (label_left>0 && label_right>0)
+				int label_left = cell_map_labels.at<int>(v,u-1);
+				int label_right = cell_map_labels.at<int>(v,u+1);
+				int label_up = cell_map_labels.at<int>(v-1,u);
+				int label_down = cell_map_labels.at<int>(v+1,u);
+				bool separates_cells = false;
+				if (label_left>0 && label_right>0 && label_left!=label_right)
 				{
-					cell_index_mapping[label_left]->neighbors_.insert(cell_index_mapping[label_right]);
-					cell_index_mapping[label_right]->neighbors_.insert(cell_index_mapping[label_left]);
+					cell_graph.addBorderPixel(label_left, label_right, true);
+					separates_cells = true;
 				}
-				const int label_up = cell_map_labels.at<int>(v-1,u);
-				const int label_down = cell_map_labels.at<int>(v+1,u);
-				if (label_up>0 && label_down>0)
+				else
+					label_left = label_right = 0;
+				if (label_up>0 && label_down>0 && label_up!=label_down)
+				{
+					cell_graph.addBorderPixel(label_up, label_down, !separates_cells);	// the pixel is only counted once for the area
+					separates_cells = true;
+				}
+				else
+					label_up = label_down = 0;
+				if (separates_cells == true)
 				{
-					cell_index_mapping[label_up]->neighbors_.insert(cell_index_mapping[label_down]);
-					cell_index_mapping[label_down]->neighbors_.insert(cell_index_mapping[label_up]);
+					border_pixels.push_back(cv::Point(u,v));
+					border_pixel_neighbors.push_back(cv::Vec4i(label_left, label_right, label_up, label_down));
 				}
 			}
 		}
 	}
 #ifdef DEBUG_VISUALIZATION
-//	printCells(cell_index_mapping);
+//	printCells(cell_graph);
 //	cv::imshow("cell_map",cell_map);
 //	cv::waitKey();
 #endif
 
 	// iteratively merge cells
-	mergeCellsSelection(cell_map, cell_map_labels, cell_index_mapping, min_cell_area, min_cell_width);
-
-	// re-assign area labels to 1,2,3,4,...
-	int new_cell_label = 1;
-	for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc, ++new_cell_label)
-		for (int v=0; v<cell_map_labels.rows; ++v)
-			for (int u=0; u<cell_map_labels.cols; ++u)
-				if (cell_map_labels.at<int>(v,u)==itc->second->label_)
-					cell_map_labels.at<int>(v,u) = new_cell_label;
-
-	std::cout << "INFO: BoustrophedonExplorer::mergeCells: " << cell_index_mapping.size() << " cells remaining after merging." << std::endl;
-	return cell_index_mapping.size();
-}
+	mergeCellsSelection(cell_graph, min_cell_area, min_cell_width);
 
-void BoustrophedonExplorer::mergeCellsSelection(cv::Mat& cell_map, cv::Mat& cell_map_labels, std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping,
-		const double min_cell_area, const int min_cell_width)
-{
-	// iteratively merge cells
-	// merge small cells below min_cell_area with their largest neighboring cell
-	std::multimap<double, boost::shared_ptr<BoustrophedonCell> > area_to_region_id_mapping;		// maps the area of each cell --> to the respective cell
-	for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
-		area_to_region_id_mapping.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >(itc->second->area_, itc->second));
-	for (std::multimap<double, boost::shared_ptr<BoustrophedonCell> >::iterator it=area_to_region_id_mapping.begin(); it!=area_to_region_id_mapping.end();)
+	// remove the borders between merged cells from the maps
+	for (size_t i=0; i<border_pixels.size(); ++i)
 	{
-		// skip if segment is large enough (area and side length criteria)
-		if (it->first >= min_cell_area && it->second->bounding_box_.width >= min_cell_width && it->second->bounding_box_.height >= min_cell_width)
+		const cv::Vec4i& neighbors = border_pixel_neighbors[i];
+		int root = -1;
+		if (neighbors[0]>0 && cell_graph.findRoot(neighbors[0])==cell_graph.findRoot(neighbors[1]))
+			root = cell_graph.findRoot(neighbors[0]);
+		else if (neighbors[2]>0 && cell_graph.findRoot(neighbors[2])==cell_graph.findRoot(neighbors[3]))
+			root = cell_graph.findRoot(neighbors[2]);
+		if (root > 0)
 		{
-			++it;
-			continue;
+			cell_map.at<uchar>(border_pixels[i]) = 255;
+			cell_map_labels.at<int>(border_pixels[i]) = root;
 		}
+	}
 
-		// skip segments which have no neighbors
-		if (it->second->neighbors_.size() == 0)
+	// re-assign area labels to 1,2,3,4,... with a lookup table from the original labels to the labels of the merged cells
+	std::vector<int> new_labels(cell_graph.cells_.size(), 0);
+	std::vector<double> new_label_areas(1, 0.);
+	for (size_t label=1; label<cell_graph.cells_.size(); ++label)
+	{
+		if (cell_graph.isRoot(label) == true)
 		{
-			std::cout << "WARN: BoustrophedonExplorer::mergeCells: skipping small cell without neighbors." << std::endl;
-			++it;
-			continue;
+			new_labels[label] = new_label_areas.size();
+			new_label_areas.push_back(cell_graph.cells_[label].area_);
 		}
-
-		// determine the largest neighboring cell
-		const BoustrophedonCell& small_cell = *(it->second);
-		std::multimap<double, boost::shared_ptr<BoustrophedonCell>, std::greater<double> > area_sorted_neighbors;
-		for (BoustrophedonCell::BoustrophedonCellSetIterator itn = small_cell.neighbors_.begin(); itn != small_cell.neighbors_.end(); ++itn)
-			area_sorted_neighbors.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >((*itn)->area_, *itn));
-		BoustrophedonCell& large_cell = *(area_sorted_neighbors.begin()->second);
-
-		// merge the cells
-		mergeTwoCells(cell_map, cell_map_labels, small_cell, large_cell, cell_index_mapping);
-
-		// update area_to_region_id_mapping
-		area_to_region_id_mapping.clear();
-		for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
-			area_to_region_id_mapping.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >(itc->second->area_, itc->second));
-		it = area_to_region_id_mapping.begin();
-
-#ifdef DEBUG_VISUALIZATION
-//		printCells(cell_index_mapping);
-//		cv::imshow("cell_map",cell_map);
-//		cv::waitKey();
-#endif
+	}
+	for (size_t label=1; label<cell_graph.cells_.size(); ++label)
+		new_labels[label] = new_labels[cell_graph.findRoot(label)];
+	for (int v=0; v<cell_map_labels.rows; ++v)
+	{
+		int* labels = cell_map_labels.ptr<int>(v);
+		for (int u=0; u<cell_map_labels.cols; ++u)
+			if (labels[u] > 0)
+				labels[u] = new_labels[labels[u]];
 	}
 
 	// label remaining border pixels with label of largest neighboring region label
@@ -615,78 +674,73 @@ void BoustrophedonExplorer::mergeCellsSelection(cv::Mat& cell_map, cv::Mat& cell
 		{
 			if (cell_map.at<uchar>(v,u) == BORDER_PIXEL_VALUE)
 			{
-				std::set<int> neighbor_labels;
+				int new_label = -1;
 				for (int dv=-1; dv<=1; ++dv)
 				{
 					for (int du=-1; du<=1; ++du)
 					{
 						const int& val = cell_map_labels.at<int>(v+dv,u+du);
-						if (val>0)
-							neighbor_labels.insert(val);
-					}
-				}
-				if (neighbor_labels.size() > 0)
-				{
-					int new_label = -1;
-					for (std::multimap<double, boost::shared_ptr<BoustrophedonCell> >::reverse_iterator it=area_to_region_id_mapping.rbegin(); it!=area_to_region_id_mapping.rend(); ++it)
-					{
-						if (neighbor_labels.find(it->second->label_) != neighbor_labels.end())
-						{
-							cell_map_labels.at<int>(v,u) = it->second->label_;
-							break;
-						}
+						if (val>0 && (new_label==-1 || new_label_areas[val]>new_label_areas[new_label] || (new_label_areas[val]==new_label_areas[new_label] && val>new_label)))
+							new_label = val;
 					}
 				}
+				if (new_label > 0)
+					cell_map_labels.at<int>(v,u) = new_label;
 				else
 					std::cout << "WARN: BoustrophedonExplorer::mergeCells: border pixel has no labeled neighbors." << std::endl;
 			}
 		}
 	}
+
+	const int number_of_cells = new_label_areas.size()-1;
+	std::cout << "INFO: BoustrophedonExplorer::mergeCells: " << number_of_cells << " cells remaining after merging." << std::endl;
+	return number_of_cells;
 }
 
-void BoustrophedonExplorer::mergeTwoCells(cv::Mat& cell_map, cv::Mat& cell_map_labels, const BoustrophedonCell& minor_cell, BoustrophedonCell& major_cell,
-		std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping)
+void BoustrophedonExplorer::mergeCellsSelection(BoustrophedonCellGraph& cell_graph, const double min_cell_area, const int min_cell_width)
 {
-	// execute merging the minor cell into the major cell
-	//   --> remove border from maps
-	for (int v=0; v<cell_map.rows; ++v)
-		for (int u=0; u<cell_map.cols; ++u)
-			if (cell_map.at<uchar>(v,u) == BORDER_PIXEL_VALUE &&
-					((cell_map_labels.at<int>(v,u-1)==minor_cell.label_ && cell_map_labels.at<int>(v,u+1)==major_cell.label_) ||
-					(cell_map_labels.at<int>(v,u-1)==major_cell.label_ && cell_map_labels.at<int>(v,u+1)==minor_cell.label_) ||
-					(cell_map_labels.at<int>(v-1,u)==minor_cell.label_ && cell_map_labels.at<int>(v+1,u)==major_cell.label_) ||
-					(cell_map_labels.at<int>(v-1,u)==major_cell.label_ && cell_map_labels.at<int>(v+1,u)==minor_cell.label_)))
-			{
-				cell_map.at<uchar>(v,u) = 255;
-				cell_map_labels.at<int>(v,u) = major_cell.label_;
-				major_cell.area_ += 1;
-			}
-	//   --> update old label in cell_map_labels
-	for (int v=0; v<cell_map_labels.rows; ++v)
-		for (int u=0; u<cell_map_labels.cols; ++u)
-			if (cell_map_labels.at<int>(v,u) == minor_cell.label_)
-				cell_map_labels.at<int>(v,u) = major_cell.label_;
-	//   --> update major_cell
-	major_cell.area_ += minor_cell.area_;
-	for (BoustrophedonCell::BoustrophedonCellSetIterator itn = major_cell.neighbors_.begin(); itn != major_cell.neighbors_.end(); ++itn)
-		if ((*itn)->label_ == minor_cell.label_)
+	// iteratively merge cells
+	// merge small cells below min_cell_area with their largest neighboring cell, the cells are visited in the order of increasing area
+	// and a cell that has grown by a merger is queued again with its new area
+	typedef std::pair<double, int> AreaLabel;
+	std::priority_queue<AreaLabel, std::vector<AreaLabel>, std::greater<AreaLabel> > area_to_region_id_mapping;		// the area of each cell --> the respective cell
+	for (size_t label=1; label<cell_graph.cells_.size(); ++label)
+		area_to_region_id_mapping.push(AreaLabel(cell_graph.cells_[label].area_, label));
+	while (area_to_region_id_mapping.empty() == false)
+	{
+		const AreaLabel area_label = area_to_region_id_mapping.top();
+		area_to_region_id_mapping.pop();
+		const BoustrophedonCell& small_cell = cell_graph.cells_[area_label.second];
+
+		// skip outdated entries of cells that have been merged or have grown
+		if (cell_graph.isRoot(small_cell.label_) == false || small_cell.area_ != area_label.first)
+			continue;
+
+		// skip if segment is large enough (area and side length criteria)
+		if (small_cell.area_ >= min_cell_area && small_cell.bounding_box_.width >= min_cell_width && small_cell.bounding_box_.height >= min_cell_width)
+			continue;
+
+		// skip segments which have no neighbors
+		if (small_cell.neighbors_.size() == 0)
 		{
-			major_cell.neighbors_.erase(itn);
-			break;
+			std::cout << "WARN: BoustrophedonExplorer::mergeCells: skipping small cell without neighbors." << std::endl;
+			continue;
 		}
-	for (BoustrophedonCell::BoustrophedonCellSetIterator itn = minor_cell.neighbors_.begin(); itn != minor_cell.neighbors_.end(); ++itn)
-		if ((*itn)->label_ != major_cell.label_)
-			major_cell.neighbors_.insert(*itn);
-
-	// clean all references to minor_cell
-	cell_index_mapping.erase(minor_cell.label_);
-	for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
-		for (BoustrophedonCell::BoustrophedonCellSetIterator itn = itc->second->neighbors_.begin(); itn != itc->second->neighbors_.end(); ++itn)
-			if ((*itn)->label_ == minor_cell.label_)
-			{
-				(*itn)->label_ = major_cell.label_;
-				break;
-			}
+
+		// determine the largest neighboring cell
+		int large_cell_label = -1;
+		for (std::map<int, int>::const_iterator itn=small_cell.neighbors_.begin(); itn!=small_cell.neighbors_.end(); ++itn)
+			if (large_cell_label==-1 || cell_graph.cells_[itn->first].area_ > cell_graph.cells_[large_cell_label].area_)
+				large_cell_label = itn->first;
+
+		// merge the cells
+		cell_graph.mergeCells(small_cell.label_, large_cell_label);
+		area_to_region_id_mapping.push(AreaLabel(cell_graph.cells_[large_cell_label].area_, large_cell_label));
+
+#ifdef DEBUG_VISUALIZATION
+//		printCells(cell_graph);
+#endif
+	}
 }
 
 void BoustrophedonExplorer::correctThinWalls(cv::Mat& room_map)
@@ -848,7 +902,7 @@ void BoustrophedonExplorer::computeBoustrophedonPath(const cv::Mat& room_map, co
 			{
 				// get points on transition between horizontal lines by using the Astar-path
 				std::vector<cv::Point> astar_path;
-				path_planner_.planPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line[0], 1.0, 0.0, map_resolution, 0, &astar_path);
+				planTransitionPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line[0], map_resolution, astar_path);
 				downsamplePath(astar_path, current_fov_path, cell_robot_pos, path_eps);
 
 				// get points between left and right corner
@@ -864,7 +918,7 @@ void BoustrophedonExplorer::computeBoustrophedonPath(const cv::Mat& room_map, co
 			{
 				// get points on transition between horizontal lines by using the Astar-path
 				std::vector<cv::Point> astar_path;
-				path_planner_.planPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line.back(), 1.0, 0.0, map_resolution, 0, &astar_path);
+				planTransitionPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line.back(), map_resolution, astar_path);
 				downsamplePath(astar_path, current_fov_path, cell_robot_pos, path_eps);
 
 				// get points between right and left corner
@@ -895,7 +949,7 @@ void BoustrophedonExplorer::computeBoustrophedonPath(const cv::Mat& room_map, co
 			{
 				// get points on transition between horizontal lines by using the Astar-path
 				std::vector<cv::Point> astar_path;
-				path_planner_.planPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line[0], 1.0, 0.0, map_resolution, 0, &astar_path);
+				planTransitionPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line[0], map_resolution, astar_path);
 				downsamplePath(astar_path, current_fov_path, cell_robot_pos, path_eps);
 
 				// get points between left and right corner
@@ -911,7 +965,7 @@ void BoustrophedonExplorer::computeBoustrophedonPath(const cv::Mat& room_map, co
 			{
 				// get points on transition between horizontal lines by using the Astar-path
 				std::vector<cv::Point> astar_path;
-				path_planner_.planPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line.back(), 1.0, 0.0, map_resolution, 0, &astar_path);
+				planTransitionPath(rotated_inflated_cell_map, cell_robot_pos, line->upper_line.back(), map_resolution, astar_path);
 				downsamplePath(astar_path, current_fov_path, cell_robot_pos, path_eps);
 
 				// get points between right and left corner
@@ -959,6 +1013,29 @@ void BoustrophedonExplorer::computeBoustrophedonPath(const cv::Mat& room_map, co
 	robot_pos = current_pos_vector[0];
 }
 
+void BoustrophedonExplorer::planTransitionPath(const cv::Mat& cell_map, const cv::Point& start, const cv::Point& goal, const float map_resolution,
+		std::vector<cv::Point>& path)
+{
+	if (smooth_transition_paths_ == false)
+	{
+		path_planner_.planPath(cell_map, start, goal, 1.0, 0.0, map_resolution, 0, &path);
+		return;
+	}
+
+	// plan the smoothed path and follow its straight segments cell by cell, so downsamplePath samples it like a grid path
+	std::vector<cv::Point> waypoints;
+	if (start == goal || path_planner_.planSmoothedPath(cell_map, cell_map, start, goal, 1.0, map_resolution, waypoints) > 1e90)
+		return;
+	path.push_back(start);
+	for (size_t i = 1; i < waypoints.size(); ++i)
+	{
+		cv::LineIterator it(cell_map, waypoints[i-1], waypoints[i]);
+		++it;
+		for (int k = 1; k < it.count; k++, ++it)
+			path.push_back(it.pos());
+	}
+}
+
 void BoustrophedonExplorer::downsamplePath(const std::vector<cv::Point>& original_path, std::vector<cv::Point>& downsampled_path,
 		cv::Point& robot_pos, const double path_eps)
 {
@@ -1001,14 +1078,17 @@ void BoustrophedonExplorer::downsamplePathReverse(const std::vector<cv::Point>&
 	}
 }
 
-void BoustrophedonExplorer::printCells(std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping)
+void BoustrophedonExplorer::printCells(BoustrophedonCellGraph& cell_graph)
 {
 	std::cout << "---\n";
-	for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
+	for (size_t label=1; label<cell_graph.cells_.size(); ++label)
 	{
-		std::cout << itc->first << ": l=" << itc->second->label_ << "   a=" << itc->second->area_ << "   n=";
-		for (BoustrophedonCell::BoustrophedonCellSetIterator its=itc->second->neighbors_.begin(); its!=itc->second->neighbors_.end(); ++its)
-			std::cout << (*its)->label_ << ", ";
+		if (cell_graph.isRoot(label) == false)
+			continue;
+		const BoustrophedonCell& cell = cell_graph.cells_[label];
+		std::cout << label << ": l=" << cell.label_ << "   a=" << cell.area_ << "   n=";
+		for (std::map<int, int>::const_iterator itn=cell.neighbors_.begin(); itn!=cell.neighbors_.end(); ++itn)
+			std::cout << itn->first << ", ";
 		std::cout << std::endl;
 	}
 }
@@ -1019,8 +1099,7 @@ void BoustrophedonExplorer::printCells(std::map<int, boost::shared_ptr<Boustroph
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-void BoustrophedonVariantExplorer::mergeCellsSelection(cv::Mat& cell_map, cv::Mat& cell_map_labels, std::map<int, boost::shared_ptr<BoustrophedonCell> >& cell_index_mapping,
-		const double min_cell_area, const int min_cell_width)
+void BoustrophedonVariantExplorer::mergeCellsSelection(BoustrophedonCellGraph& cell_graph, const double min_cell_area, const int min_cell_width)
 {
 	// iteratively merge cells
 	//todo:
@@ -1035,83 +1114,45 @@ void BoustrophedonVariantExplorer::mergeCellsSelection(cv::Mat& cell_map, cv::Ma
 	//double rotation_angle = room_rotator.computeRoomMainDirection(cell_map, map_resolution);
 
 	// merge small cells below min_cell_area with their largest neighboring cell
-	std::multimap<double, boost::shared_ptr<BoustrophedonCell> > area_to_region_id_mapping;		// maps the area of each cell --> to the respective cell
-	for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
-		area_to_region_id_mapping.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >(itc->second->area_, itc->second));
-	for (std::multimap<double, boost::shared_ptr<BoustrophedonCell> >::iterator it=area_to_region_id_mapping.begin(); it!=area_to_region_id_mapping.end();)
+	typedef std::pair<double, int> AreaLabel;
+	std::priority_queue<AreaLabel, std::vector<AreaLabel>, std::greater<AreaLabel> > area_to_region_id_mapping;		// the area of each cell --> the respective cell
+	for (size_t label=1; label<cell_graph.cells_.size(); ++label)
+		area_to_region_id_mapping.push(AreaLabel(cell_graph.cells_[label].area_, label));
+	while (area_to_region_id_mapping.empty() == false)
 	{
+		const AreaLabel area_label = area_to_region_id_mapping.top();
+		area_to_region_id_mapping.pop();
+		const BoustrophedonCell& small_cell = cell_graph.cells_[area_label.second];
+
+		// skip outdated entries of cells that have been merged or have grown
+		if (cell_graph.isRoot(small_cell.label_) == false || small_cell.area_ != area_label.first)
+			continue;
+
 		// abort if no cells below min_cell_area remain unmerged into bigger cells
-		if (it->first >= min_cell_area && it->second->bounding_box_.width >= min_cell_width && it->second->bounding_box_.height >= min_cell_width)
-		{
-			++it;
+		if (small_cell.area_ >= min_cell_area && small_cell.bounding_box_.width >= min_cell_width && small_cell.bounding_box_.height >= min_cell_width)
 			continue;
-		}
 
 		// skip segments which have no neighbors
-		if (it->second->neighbors_.size() == 0)
+		if (small_cell.neighbors_.size() == 0)
 		{
 			std::cout << "WARN: BoustrophedonExplorer::mergeCells: skipping small cell without neighbors." << std::endl;
-			++it;
 			continue;
 		}
 
 		// determine the largest neighboring cell
-		const BoustrophedonCell& small_cell = *(it->second);
-		std::multimap<double, boost::shared_ptr<BoustrophedonCell>, std::greater<double> > area_sorted_neighbors;
-		for (BoustrophedonCell::BoustrophedonCellSetIterator itn = small_cell.neighbors_.begin(); itn != small_cell.neighbors_.end(); ++itn)
-			area_sorted_neighbors.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >((*itn)->area_, *itn));
-		BoustrophedonCell& large_cell = *(area_sorted_neighbors.begin()->second);
+		int large_cell_label = -1;
+		for (std::map<int, int>::const_iterator itn=small_cell.neighbors_.begin(); itn!=small_cell.neighbors_.end(); ++itn)
+			if (large_cell_label==-1 || cell_graph.cells_[itn->first].area_ > cell_graph.cells_[large_cell_label].area_)
+				large_cell_label = itn->first;
 
 		// merge the cells
-		mergeTwoCells(cell_map, cell_map_labels, small_cell, large_cell, cell_index_mapping);
-
-		// update area_to_region_id_mapping
-		area_to_region_id_mapping.clear();
-		for (std::map<int, boost::shared_ptr<BoustrophedonCell> >::iterator itc=cell_index_mapping.begin(); itc!=cell_index_mapping.end(); ++itc)
-			area_to_region_id_mapping.insert(std::pair<double, boost::shared_ptr<BoustrophedonCell> >(itc->second->area_, itc->second));
-		it = area_to_region_id_mapping.begin();
+		cell_graph.mergeCells(small_cell.label_, large_cell_label);
+		area_to_region_id_mapping.push(AreaLabel(cell_graph.cells_[large_cell_label].area_, large_cell_label));
 
 #ifdef DEBUG_VISUALIZATION
-//		printCells(cell_index_mapping);
-//		cv::imshow("cell_map",cell_map);
-//		cv::waitKey();
+//		printCells(cell_graph);
 #endif
 	}
-
-	// label remaining border pixels with label of largest neighboring region label
-	for (int v=1; v<cell_map.rows-1; ++v)
-	{
-		for (int u=1; u<cell_map.cols-1; ++u)
-		{
-			if (cell_map.at<uchar>(v,u) == BORDER_PIXEL_VALUE)
-			{
-				std::set<int> neighbor_labels;
-				for (int dv=-1; dv<=1; ++dv)
-				{
-					for (int du=-1; du<=1; ++du)
-					{
-						const int& val = cell_map_labels.at<int>(v+dv,u+du);
-						if (val>0)
-							neighbor_labels.insert(val);
-					}
-				}
-				if (neighbor_labels.size() > 0)
-				{
-					int new_label = -1;
-					for (std::multimap<double, boost::shared_ptr<BoustrophedonCell> >::reverse_iterator it=area_to_region_id_mapping.rbegin(); it!=area_to_region_id_mapping.rend(); ++it)
-					{
-						if (neighbor_labels.find(it->second->label_) != neighbor_labels.end())
-						{
-							cell_map_labels.at<int>(v,u) = it->second->label_;
-							break;
-						}
-					}
-				}
-				else
-					std::cout << "WARN: BoustrophedonExplorer::mergeCells: border pixel has no labeled neighbors." << std::endl;
-			}
-		}
-	}
 }
 
 //void BoustrophedonVariantExplorer::computeCellDecomposition(const cv::Mat& room_map, const float map_resolution, const double min_cell_area,
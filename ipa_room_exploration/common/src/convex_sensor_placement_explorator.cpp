@@ -2,6 +2,7 @@
 
 // Constructor
 convexSPPExplorator::convexSPPExplorator()
+: use_lp_rounding_start_(false), mip_time_limit_(0.), mip_relative_gap_(0.)
 {
 
 }
@@ -9,7 +10,7 @@ convexSPPExplorator::convexSPPExplorator()
 // function that is used to create and solve a Gurobi optimization problem out of the given matrices and vectors, if
 // Gurobi was found on the computer
 template<typename T>
-void convexSPPExplorator::solveGurobiOptimizationProblem(std::vector<T>& C, const cv::Mat& V, const std::vector<double>* W)
+void convexSPPExplorator::solveGurobiOptimizationProblem(std::vector<T>& C, const CoverageMatrix& V, const std::vector<double>* W)
 {
 #ifdef GUROBI_FOUND
 	std::cout << "Creating and solving linear program with Gurobi." << std::endl;
@@ -40,19 +41,16 @@ void convexSPPExplorator::solveGurobiOptimizationProblem(std::vector<T>& C, cons
 	std::cout << "number of variables in the problem: " << number_of_variables << std::endl;
 
 	// inequality constraints to ensure that every position has been seen at least once
-	for(size_t row=0; row<V.rows; ++row)
+	for(int row=0; row<V.rows(); ++row)
 	{
-		// gather the indices of the variables that are used in this constraint (row), i.e. where V[row][column] == 1
-		std::vector<int> variable_indices;
-		for(size_t col=0; col<V.cols; ++col)
-			if(V.at<uchar>(row, col) == 1)
-				variable_indices.push_back((int) col);
+		// the indices of the variables that are used in this constraint (row) are the entries of V in this row
+		const int* variable_indices = V.rowBegin(row);
 
 		// add the constraint, if the current cell can be covered by the given arcs, indices=1 in this constraint
-		if(variable_indices.size()>0)
+		if(V.rowSize(row)>0)
 		{
 			GRBLinExpr current_coverage_constraint;
-			for(size_t var=0; var<variable_indices.size(); ++var)
+			for(int var=0; var<V.rowSize(row); ++var)
 				current_coverage_constraint += optimization_variables[variable_indices[var]];
 			model.addConstr(current_coverage_constraint>=1);
 		}
@@ -75,71 +73,172 @@ void convexSPPExplorator::solveGurobiOptimizationProblem(std::vector<T>& C, cons
 
 // Function that creates a Qsopt optimization problem and solves it, using the given matrices and vectors.
 template<typename T>
-void convexSPPExplorator::solveOptimizationProblem(std::vector<T>& C, const cv::Mat& V, const std::vector<double>* W)
+void convexSPPExplorator::solveOptimizationProblem(std::vector<T>& C, const CoverageMatrix& V, const std::vector<double>* W)
 {
-	// initialize the problem
-	CoinModel problem_builder;
-
 	ROS_INFO("Creating and solving linear program.");
 
-	// add the optimization variables to the problem
-	int rval;
-	for(size_t variable=0; variable<C.size(); ++variable)
-	{
-		if(W != NULL) // if a weight-vector is provided, use it to set the weights for the variables
-		{
-			problem_builder.setColBounds(variable, 0.0, 1.0);
-			problem_builder.setObjective(variable, W->operator[](variable));
-		}
-		else
-		{
-			problem_builder.setColBounds(variable, 0.0, 1.0);
-			problem_builder.setObjective(variable, 1.0);
-			problem_builder.setInteger(variable);
-		}
-	}
-
-	// inequality constraints to ensure that every position has been seen at least once
-	for(size_t row=0; row<V.rows; ++row)
-	{
-		// gather the indices of the variables that are used in this constraint (row), i.e. where V[row][column] == 1
-		std::vector<int> variable_indices;
-		for(size_t col=0; col<V.cols; ++col)
-			if(V.at<uchar>(row, col) == 1)
-				variable_indices.push_back((int) col);
-
-		// all indices are 1 in this constraint
-		std::vector<double> variable_coefficients(variable_indices.size(), 1.0);
-
-		// add the constraint
-		problem_builder.addRow((int) variable_indices.size(), &variable_indices[0], &variable_coefficients[0], 1.0);
-	}
+	// objective and bounds of the optimization variables
+	std::vector<double> column_lower_bounds(C.size(), 0.0), column_upper_bounds(C.size(), 1.0);
+	std::vector<double> objective(C.size(), 1.0);
+	if(W != NULL) // if a weight-vector is provided, use it to set the weights for the variables
+		for(size_t variable=0; variable<C.size(); ++variable)
+			objective[variable] = W->operator[](variable);
+
+	// inequality constraints to ensure that every position has been seen at least once, the row ordered constraint
+	// matrix is taken directly from the sparse rows of V, all indices are 1 in the constraints
+	std::vector<double> row_lower_bounds(V.rows(), 1.0), row_upper_bounds(V.rows(), COIN_DBL_MAX);
+	std::vector<double> coefficients(V.nonZeros(), 1.0);
+	std::vector<CoinBigIndex> row_starts(V.getRowStarts().begin(), V.getRowStarts().end());
+	std::vector<int> row_lengths(V.rows());
+	for(int row=0; row<V.rows(); ++row)
+		row_lengths[row] = V.rowSize(row);
+	const CoinPackedMatrix constraint_matrix(false, V.cols(), V.rows(), V.nonZeros(), coefficients.data(),
+			V.getColumnIndices().data(), row_starts.data(), row_lengths.data());
 
 	// load the created LP problem to the solver
 	OsiClpSolverInterface LP_solver;
 	OsiClpSolverInterface* solver_pointer = &LP_solver;
 
-	solver_pointer->loadFromCoinModel(problem_builder);
+	solver_pointer->loadProblem(constraint_matrix, column_lower_bounds.data(), column_upper_bounds.data(), objective.data(),
+			row_lower_bounds.data(), row_upper_bounds.data());
+	if(W == NULL)
+		for(size_t variable=0; variable<C.size(); ++variable)
+			solver_pointer->setInteger(variable);
 
 	// testing
 	solver_pointer->writeLp("lin_cpp_prog", "lp");
 
+	// if wanted, solve the LP relaxation of the integer problem and round it to a feasible cover that is used as start
+	// solution of the branch and bound, the basis of the relaxation is taken over by the MIP solver as warm start
+	std::vector<double> start_solution;
+	bool has_start_solution = false;
+	if(W == NULL && use_lp_rounding_start_ == true)
+	{
+		solver_pointer->initialSolve();
+		if(solver_pointer->isProvenOptimal() == true)
+			has_start_solution = roundRelaxedSolution(V, solver_pointer->getColSolution(), start_solution);
+	}
+
 	// solve the created optimization problem
 	CbcModel model(*solver_pointer);
 	model.solver()->setHintParam(OsiDoReducePrint, true, OsiHintTry);
 
 	model.initialSolve();
+	std::vector<double> relaxed_solution;
+	if(W == NULL)
+	{
+		// keep the LP relaxation in case the branch and bound is stopped by the time limit before it finds a cover
+		relaxed_solution.assign(model.solver()->getColSolution(), model.solver()->getColSolution()+C.size());
+		if(has_start_solution == true)
+		{
+			double start_objective = 0.;
+			for(size_t variable=0; variable<start_solution.size(); ++variable)
+				start_objective += start_solution[variable];
+			std::cout << "MIP start from the rounded LP relaxation with " << start_objective << " sensing poses." << std::endl;
+			model.setBestSolution(start_solution.data(), start_solution.size(), start_objective, true);
+		}
+		if(mip_time_limit_ > 0.)
+			model.setMaximumSeconds(mip_time_limit_);
+		if(mip_relative_gap_ > 0.)
+			model.setAllowableFractionGap(mip_relative_gap_);
+	}
 	model.branchAndBound();
 
-	// retrieve solution
+	// retrieve solution, if the branch and bound has been stopped by a limit the best solution found so far is taken, if it
+	// has not found any cover until then, the rounded LP relaxation is taken
 	const double * solution = model.solver()->getColSolution();
+	std::vector<double> rounded_solution;
+	if(W == NULL && model.bestSolution() != NULL)
+		solution = model.bestSolution();
+	else if(W == NULL)
+	{
+		if(roundRelaxedSolution(V, relaxed_solution.data(), rounded_solution) == false)
+			ROS_WARN("convexSPPExplorator::solveOptimizationProblem: no cover found, some cells cannot be covered by any candidate.");
+		else
+			ROS_WARN("convexSPPExplorator::solveOptimizationProblem: the MIP solver found no cover within the time limit, the rounded LP relaxation is used.");
+		solution = rounded_solution.data();
+	}
 
+	// the integer variables are rounded, the solver returns them with small tolerances
 	for(size_t res=0; res<C.size(); ++res)
 	{
-		C[res] = solution[res];
+		if(W == NULL)
+			C[res] = (solution[res] > 0.5 ? 1 : 0);
+		else
+			C[res] = solution[res];
 	}
 }
 
+// Function that rounds the solution of the LP relaxation of the set cover problem min sum C s.t. VC >= 1 to a feasible cover.
+// First the candidates with a relaxed value of at least 0.5 are chosen. Then each cell that is not covered yet is covered
+// with the candidate of the largest relaxed value among those that see the cell, for equal values the candidate that covers
+// the most uncovered cells is taken. At last the chosen candidates whose cells are all covered by other chosen candidates
+// are removed again, starting with the smallest relaxed values.
+bool convexSPPExplorator::roundRelaxedSolution(const CoverageMatrix& V, const double* relaxed_solution, std::vector<double>& cover)
+{
+	cover.assign(V.cols(), 0.);
+
+	// cells covered by each candidate and number of chosen candidates that cover each cell
+	std::vector<std::vector<int> > covered_cells_of_candidates;
+	V.getColumns(covered_cells_of_candidates);
+	std::vector<int> cover_counts(V.rows(), 0);
+	std::vector<int> uncovered_cells_of_candidates(V.cols());
+	for(int candidate=0; candidate<V.cols(); ++candidate)
+		uncovered_cells_of_candidates[candidate] = covered_cells_of_candidates[candidate].size();
+	auto chooseCandidate = [&](const int candidate)
+	{
+		cover[candidate] = 1.;
+		for(std::vector<int>::const_iterator cell=covered_cells_of_candidates[candidate].begin(); cell!=covered_cells_of_candidates[candidate].end(); ++cell)
+			if(cover_counts[*cell]++ == 0)
+				for(const int* covering_candidate=V.rowBegin(*cell); covering_candidate!=V.rowBegin(*cell)+V.rowSize(*cell); ++covering_candidate)
+					--uncovered_cells_of_candidates[*covering_candidate];
+	};
+
+	// round
+	for(int candidate=0; candidate<V.cols(); ++candidate)
+		if(relaxed_solution[candidate] >= 0.5)
+			chooseCandidate(candidate);
+
+	// repair
+	for(int cell=0; cell<V.rows(); ++cell)
+	{
+		if(cover_counts[cell] > 0)
+			continue;
+		if(V.rowSize(cell) == 0)
+			return false;
+		int best_candidate = V.rowBegin(cell)[0];
+		for(const int* candidate=V.rowBegin(cell)+1; candidate!=V.rowBegin(cell)+V.rowSize(cell); ++candidate)
+			if(relaxed_solution[*candidate] > relaxed_solution[best_candidate] || (relaxed_solution[*candidate] == relaxed_solution[best_candidate]
+					&& uncovered_cells_of_candidates[*candidate] > uncovered_cells_of_candidates[best_candidate]))
+				best_candidate = *candidate;
+		chooseCandidate(best_candidate);
+	}
+
+	// remove redundant candidates
+	std::vector<int> chosen_candidates;
+	for(int candidate=0; candidate<V.cols(); ++candidate)
+		if(cover[candidate] == 1.)
+			chosen_candidates.push_back(candidate);
+	std::stable_sort(chosen_candidates.begin(), chosen_candidates.end(),
+			[&](const int a, const int b) { return relaxed_solution[a] < relaxed_solution[b]; });
+	for(std::vector<int>::iterator candidate=chosen_candidates.begin(); candidate!=chosen_candidates.end(); ++candidate)
+	{
+		const std::vector<int>& cells = covered_cells_of_candidates[*candidate];
+		bool redundant = true;
+		for(std::vector<int>::const_iterator cell=cells.begin(); cell!=cells.end() && redundant==true; ++cell)
+			if(cover_counts[*cell] < 2)
+				redundant = false;
+		if(redundant == true)
+		{
+			cover[*candidate] = 0.;
+			for(std::vector<int>::const_iterator cell=cells.begin(); cell!=cells.end(); ++cell)
+				--cover_counts[*cell];
+		}
+	}
+
+	return true;
+}
+
 // Function that is used to get a coverage path that covers the free space of the given map. It is programmed according to
 //
 //   Arain, M. A., Cirillo, M., Bennetts, V. H., Schaffernicht, E., Trincavelli, M., & Lilienthal, A. J. (2015, May).
@@ -265,8 +364,9 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 	int number_of_candidates=candidate_sensing_poses.size();
 	std::vector<double> W(number_of_candidates, 1.0); // initial weights
 
-	// construct V
-	cv::Mat V = cv::Mat::zeros(cell_centers.size(), number_of_candidates, CV_8U); // binary variables
+	// construct V, for each candidate pose the cells that can be observed from it are gathered first
+	CoverageMatrix V; // binary variables
+	std::vector<std::vector<int> > observed_cells_of_candidates(number_of_candidates);
 
 	// check observable cells from each candidate pose
 	const double map_resolution_inverse = 1./map_resolution;
@@ -326,14 +426,8 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 							hit_obstacle = true;
 
 					if(hit_obstacle == false)
-					{
-						V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 1;
-					}
-					else	// neighbor cell not observable
-						V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 0;
+						observed_cells_of_candidates[pose-candidate_sensing_poses.begin()].push_back(neighbor-cell_centers.begin());
 				}
-				else	// neighbor cell outside the field of view
-					V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 0;
 			}
 			// check if neighbor is covered by footprint when planning for it
 			else if(plan_for_footprint==true && (distance+cell_outcircle_radius_pixel)<=largest_robot_to_footprint_distance_pixel)
@@ -345,14 +439,11 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 					if(room_map.at<uchar>(border_line.pos()) == 0)
 						hit_obstacle = true;
 				if(hit_obstacle == false)
-					V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 1;
-				else	// neighbor cell not observable
-					V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 0;
+					observed_cells_of_candidates[pose-candidate_sensing_poses.begin()].push_back(neighbor-cell_centers.begin());
 			}
-			else // point not in the right range to be inside the fov
-				V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 0;
 		}
 	}
+	V.setFromColumns(cell_centers.size(), observed_cells_of_candidates);
 	std::cout << "number of optimization variables: " << W.size() << std::endl;
 
 //	testing
@@ -360,9 +451,9 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 //	{
 //		cv::Mat black_map = cv::Mat(room_map.rows, room_map.cols, room_map.type(), cv::Scalar(0));
 //		cv::circle(black_map, cell_centers[i], 2, cv::Scalar(127), CV_FILLED);
-//		for(size_t j=0; j<V.cols; ++j)
+//		for(size_t j=0; j<V.cols(); ++j)
 //		{
-//			if(V.at<uchar>(i, j) == 1)
+//			if(V.at(i, j) == true)
 //			{
 //				cv::circle(black_map, cv::Point(candidate_sensing_poses[j].x, candidate_sensing_poses[j].y), 2, cv::Scalar(100), CV_FILLED);
 //				cv::imshow("candidates", black_map);
@@ -425,7 +516,7 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 	// 2. Reduce the optimization problem by discarding the candidate poses that correspond to an optimization variable
 	//	  equal to 0, i.e. those that are not considered any further.
 	uint new_number_of_variables = 0;
-	cv::Mat V_reduced = cv::Mat(cell_centers.size(), 1, CV_8U); // initialize one column because opencv wants it this way, add other columns later
+	std::vector<int> reduced_candidate_indices;
 	std::vector<geometry_msgs::Pose2D> reduced_sensing_candidates;
 	for(std::vector<double>::iterator result=C.begin(); result!=C.end(); ++result)
 	{
@@ -434,17 +525,17 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 			// increase number of optimization variables
 			++new_number_of_variables;
 
-			// gather column corresponding to this candidate pose and add it to the new observability matrix
-			cv::Mat column = V.col(result-C.begin());
-			cv::hconcat(V_reduced, column, V_reduced);
+			// remember the column corresponding to this candidate pose for the new observability matrix
+			reduced_candidate_indices.push_back(result-C.begin());
 
 			// save the new possible sensing candidate
 			reduced_sensing_candidates.push_back(candidate_sensing_poses[result-C.begin()]);
 		}
 	}
 
-	// remove the first initial column
-	V_reduced = V_reduced.colRange(1, V_reduced.cols);
+	// gather the columns of the remaining candidate poses
+	CoverageMatrix V_reduced;
+	V.selectColumns(reduced_candidate_indices, V_reduced);
 
 	// solve the final optimization problem
 	std::cout << "new_number_of_variables=" << new_number_of_variables << std::endl;
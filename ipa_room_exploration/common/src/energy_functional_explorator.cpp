@@ -42,6 +42,65 @@ double EnergyFunctionalExplorator::E(const EnergyExploratorNode& location, const
 	return energy_functional;
 }
 
+// Function that searches the best next node in the whole grid. The blocks are checked ring by ring around the block of the location.
+// Because the energy functional of a node is at least its translational distance, a block only has to be checked if its distance to
+// the location is not larger than the best energy found so far, and the search stops when a whole ring of blocks is too far away.
+EnergyExploratorNode* EnergyFunctionalExplorator::findBestNode(std::vector<std::vector<EnergyExploratorNode> >& nodes, const EnergyExploratorNodeBlocks& node_blocks,
+		const EnergyExploratorNode& location, const double cell_size_in_pixel, const double previous_travel_angle)
+{
+	// the energy functional is accumulated in float precision, so the distance bound gets a small tolerance
+	const double tolerance = 1e-5;
+
+	double min_energy = 1e10;
+	EnergyExploratorNode* best_node = 0;
+	const int location_block_x = location.column_/node_blocks.block_size_;
+	const int location_block_y = location.row_/node_blocks.block_size_;
+	const int max_ring = std::max(std::max(location_block_x, node_blocks.blocks_x_-1-location_block_x),
+			std::max(location_block_y, node_blocks.blocks_y_-1-location_block_y));
+	for (int ring=0; ring<=max_ring; ++ring)
+	{
+		// the nodes of this ring are at least (ring-1) blocks away from the location
+		const double ring_distance = std::max(0, ring-1)*node_blocks.block_size_*node_blocks.grid_spacing_/cell_size_in_pixel;
+		if (ring_distance > min_energy*(1.+tolerance))
+			break;
+
+		for (int block_y=std::max(0, location_block_y-ring); block_y<=std::min(node_blocks.blocks_y_-1, location_block_y+ring); ++block_y)
+		{
+			for (int block_x=std::max(0, location_block_x-ring); block_x<=std::min(node_blocks.blocks_x_-1, location_block_x+ring); ++block_x)
+			{
+				// only check the blocks on the ring that contain unvisited nodes and are close enough
+				if (std::max(std::abs(block_x-location_block_x), std::abs(block_y-location_block_y)) != ring
+						|| node_blocks.unvisited_nodes_[block_y*node_blocks.blocks_x_+block_x] == 0
+						|| node_blocks.getMinDistance(location.center_, block_x, block_y)/cell_size_in_pixel > min_energy*(1.+tolerance))
+					continue;
+
+				const int max_row = std::min((int)nodes.size(), (block_y+1)*node_blocks.block_size_);
+				for (int row=block_y*node_blocks.block_size_; row<max_row; ++row)
+				{
+					const int max_column = std::min((int)nodes[row].size(), (block_x+1)*node_blocks.block_size_);
+					for (int column=block_x*node_blocks.block_size_; column<max_column; ++column)
+					{
+						// only check free nodes and not visited ones
+						EnergyExploratorNode& node = nodes[row][column];
+						if (node.obstacle_==true || node.visited_==true)
+							continue;
+
+						// check if current node has a better energy, on a tie take the first node in row-major order like a scan of the whole grid
+						const double current_energy = E(location, node, cell_size_in_pixel, previous_travel_angle);
+						if (current_energy < min_energy || (current_energy == min_energy && best_node != 0
+								&& (node.row_ < best_node->row_ || (node.row_ == best_node->row_ && node.column_ < best_node->column_))))
+						{
+							min_energy = current_energy;
+							best_node = &node;
+						}
+					}
+				}
+			}
+		}
+	}
+	return best_node;
+}
+
 // Function that plans a coverage path trough the given map, using the method proposed in
 //
 //	Bormann Richard, Joshua Hampp, and Martin Hägele. "New brooms sweep clean-an autonomous robotic cleaning assistant for
@@ -133,6 +192,8 @@ void EnergyFunctionalExplorator::getExplorationPath(const cv::Mat& room_map, std
 			// create node if the current point is in the free space
 			EnergyExploratorNode current_node;
 			current_node.center_ = cv::Point(x,y);
+			current_node.row_ = nodes.size();
+			current_node.column_ = current_row.size();
 			//if(rotated_room_map.at<uchar>(y,x) == 255)				// could make sense to test all pixels of the cell, not only the center
 			if (GridGenerator::completeCellTest(inflated_rotated_room_map, current_node.center_, grid_spacing_as_int) == true)
 			{
@@ -243,7 +304,9 @@ void EnergyFunctionalExplorator::getExplorationPath(const cv::Mat& room_map, std
 	// insert start node into coverage path
 	std::vector<cv::Point2f> fov_coverage_path;
 	fov_coverage_path.push_back(cv::Point2f(start_node->center_.x, start_node->center_.y));
+	EnergyExploratorNodeBlocks node_blocks(nodes, cv::Point(min_room.x+half_grid_spacing_as_int, min_room.y+half_grid_spacing_as_int), grid_spacing_as_int);
 	start_node->visited_ = true;	// mark visited nodes as obstacles
+	node_blocks.removeNode(*start_node);
 
 	// ii. starting at the start node, find the coverage path, by choosing the node that min. the energy functional
 	EnergyExploratorNode* last_node = start_node;
@@ -301,23 +364,7 @@ void EnergyFunctionalExplorator::getExplorationPath(const cv::Mat& room_map, std
 		else
 		{
 			// find best next node
-			for (size_t row=0; row<nodes.size(); ++row)
-			{
-				for (size_t col=0; col<nodes[row].size(); ++col)
-				{
-					// only check free nodes and not visited ones
-					if (nodes[row][col].obstacle_==false && nodes[row][col].visited_==false)
-					{
-						// check if current node has a better energy
-						const double current_energy = E(*last_node, nodes[row][col], grid_spacing_in_pixel, previous_travel_angle);
-						if (current_energy < min_energy)
-						{
-							min_energy = current_energy;
-							next_node = &nodes[row][col];
-						}
-					}
-				}
-			}
+			next_node = findBestNode(nodes, node_blocks, *last_node, grid_spacing_in_pixel, previous_travel_angle);
 			if (next_node == 0)
 				break;				// stop if all nodes have been visited
 		}
@@ -325,6 +372,7 @@ void EnergyFunctionalExplorator::getExplorationPath(const cv::Mat& room_map, std
 		previous_travel_angle = std::atan2(next_node->center_.y-last_node->center_.y, next_node->center_.x-last_node->center_.x);
 		fov_coverage_path.push_back(cv::Point2f(next_node->center_.x, next_node->center_.y));
 		next_node->visited_ = true;	// mark visited nodes as obstacles
+		node_blocks.removeNode(*next_node);
 
 //		cv::circle(path_map, next_node->center_, 2, cv::Scalar(100), CV_FILLED);
 //		cv::line(path_map, next_node->center_, last_node->center_, cv::Scalar(127));
@@ -10,7 +10,7 @@ FlowNetworkExplorator::FlowNetworkExplorator()
 // ansatz, that takes an initial step going from the start node and then a coverage stage assuming that the number of
 // flows into and out of a node must be the same. At last a final stage is gone, that terminates the path in one of the
 // possible nodes.
-void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 			const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 			const std::vector<uint>& start_arcs)
 {
@@ -29,21 +29,21 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 		++number_of_variables;
 //		}
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // coverage stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // coverage stage
 	{
 		problem_builder.setColBounds(number_of_variables, 0.0, 1.0);
 		problem_builder.setObjective(number_of_variables, weights[variable]);
 //		problem_builder.setInteger(number_of_variables);
 		++number_of_variables;
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // final stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // final stage
 	{
 		problem_builder.setColBounds(number_of_variables, 0.0, 1.0);
 		problem_builder.setObjective(number_of_variables, weights[variable]);
 		problem_builder.setInteger(number_of_variables);
 		++number_of_variables;
 	}
-	for(size_t aux_flow=0; aux_flow<V.cols+start_arcs.size(); ++aux_flow) // auxiliary flow variables for initial and coverage stage
+	for(size_t aux_flow=0; aux_flow<V.cols()+start_arcs.size(); ++aux_flow) // auxiliary flow variables for initial and coverage stage
 	{
 		problem_builder.setColBounds(number_of_variables, 0.0, COIN_DBL_MAX); // auxiliary flow at least 0
 		problem_builder.setObjective(number_of_variables, 0.0); // no additional part in the objective
@@ -61,22 +61,20 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 
 	// inequality constraints to ensure that every position has been seen at least once:
 	//		for each center that should be covered, find the arcs of the three stages that cover it
-	for(size_t row=0; row<V.rows; ++row)
+	for(int row=0; row<V.rows(); ++row)
 	{
 		std::vector<int> variable_indices;
 
 		for(size_t col=0; col<start_arcs.size(); ++col)
-			if(V.at<uchar>(row, start_arcs[col])==1)
+			if(V.at(row, start_arcs[col])==true)
 				variable_indices.push_back((int) col);
 
-		// coverage and final stage
-		for(size_t col=0; col<V.cols; ++col)
+		// coverage and final stage, the arcs that cover this cell are the entries of V in this row
+		const int* covering_arcs = V.rowBegin(row);
+		for(int entry=0; entry<V.rowSize(row); ++entry)
 		{
-			if(V.at<uchar>(row, col)==1)
-			{
-				variable_indices.push_back((int) col + start_arcs.size()); // coverage stage
-				variable_indices.push_back((int) col + start_arcs.size() + V.cols); // final stage
-			}
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size()); // coverage stage
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size() + V.cols()); // final stage
 		}
 
 		// all indices are 1 in this constraint
@@ -131,7 +129,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 				variable_indices.push_back(std::find(start_arcs.begin(), start_arcs.end(), flows_into_nodes[node][inflow])-start_arcs.begin());
 				variable_coefficients.push_back(1.0);
 				// decreasing flow
-				flow_decrease_indices.push_back(variable_indices.back() + start_arcs.size() + 2.0*V.cols);
+				flow_decrease_indices.push_back(variable_indices.back() + start_arcs.size() + 2.0*V.cols());
 				flow_decrease_coefficients.push_back(1.0);
 				// node indicator
 				indicator_indices.push_back(variable_indices.back());
@@ -142,7 +140,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 			variable_indices.push_back(flows_into_nodes[node][inflow] + start_arcs.size());
 			variable_coefficients.push_back(1.0);
 			// decreasing flow
-			flow_decrease_indices.push_back(variable_indices.back() + start_arcs.size() + 2.0*V.cols);
+			flow_decrease_indices.push_back(variable_indices.back() + start_arcs.size() + 2.0*V.cols());
 			flow_decrease_coefficients.push_back(1.0);
 			// node indicator
 			indicator_indices.push_back(flows_into_nodes[node][inflow] + start_arcs.size());
@@ -157,10 +155,10 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size());
 			variable_coefficients.push_back(-1.0);
 			// flow decreasing
-			flow_decrease_indices.push_back(flows_out_of_nodes[node][outflow] + 2.0*(start_arcs.size()+V.cols));
+			flow_decrease_indices.push_back(flows_out_of_nodes[node][outflow] + 2.0*(start_arcs.size()+V.cols()));
 			flow_decrease_coefficients.push_back(-1.0);
 			// final stage variable
-			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols);
+			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols());
 			variable_coefficients.push_back(-1.0);
 		}
 
@@ -173,7 +171,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 		problem_builder.addRow((int) variable_indices.size(), &variable_indices[0], &variable_coefficients[0], 0.0, 0.0);
 
 		// add node indicator variable to flow decreasing constraint
-		flow_decrease_indices.push_back(node + 2.0*start_arcs.size() + 3.0*V.cols);
+		flow_decrease_indices.push_back(node + 2.0*start_arcs.size() + 3.0*V.cols());
 		flow_decrease_coefficients.push_back(-1.0);
 
 		// add flow decreasing constraint
@@ -182,7 +180,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 
 		// get node indicator variable for the indicator constraint
 //		std::cout << "indicator constraint" << std::endl;
-		indicator_indices.push_back(node + 2.0*start_arcs.size() + 3.0*V.cols);
+		indicator_indices.push_back(node + 2.0*start_arcs.size() + 3.0*V.cols());
 		indicator_coefficients.push_back(-1.0);
 
 		// add node indicator constraint
@@ -190,12 +188,12 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 	}
 
 	// equality constraint to ensure that the path only once goes to the final stage
-	std::vector<int> final_indices(V.cols);
+	std::vector<int> final_indices(V.cols());
 	std::vector<double> final_coefficients(final_indices.size());
 	// gather indices
 	for(size_t node=0; node<final_indices.size(); ++node)
 	{
-		final_indices[node] = node + start_arcs.size() + V.cols;
+		final_indices[node] = node + start_arcs.size() + V.cols();
 		final_coefficients[node] = 1.0;
 	}
 	// add constraint
@@ -203,7 +201,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 
 	// inequality constraints changing the maximal flow along an arc, if this arc is gone in the path
 	std::cout << "max flow constraints" << std::endl;
-	for(size_t node=0; node<V.cols+start_arcs.size(); ++node)
+	for(size_t node=0; node<V.cols()+start_arcs.size(); ++node)
 	{
 		// size of two, because each auxiliary flow corresponds to exactly one arc indication variable
 		std::vector<int> aux_flow_indices(2);
@@ -214,7 +212,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 		aux_flow_coefficients[0] = flows_into_nodes.size()-1; // allow a high flow if the arc is chosen in the path
 
 		// second entry shows the flow variable
-		aux_flow_indices[1] = node+start_arcs.size()+2.0*V.cols;
+		aux_flow_indices[1] = node+start_arcs.size()+2.0*V.cols();
 		aux_flow_coefficients[1] = -1.0;
 
 		// add constraint
@@ -227,12 +225,12 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 	std::vector<double> start_flow_coefficients(start_flow_indices.size());
 	for(size_t node=0; node<start_arcs.size(); ++node) // start arcs
 	{
-		start_flow_indices[node] = node+start_arcs.size()+2.0*V.cols;
+		start_flow_indices[node] = node+start_arcs.size()+2.0*V.cols();
 		start_flow_coefficients[node] = 1.0;
 	}
 	for(size_t indicator=0; indicator<flows_into_nodes.size(); ++indicator) // node indicator variables
 	{
-		start_flow_indices[indicator+start_arcs.size()] = indicator+2.0*start_arcs.size()+3.0*V.cols;
+		start_flow_indices[indicator+start_arcs.size()] = indicator+2.0*start_arcs.size()+3.0*V.cols();
 		start_flow_coefficients[indicator+start_arcs.size()] = -1.0;
 	}
 	problem_builder.addRow((int) start_flow_indices.size(), &start_flow_indices[0], &start_flow_coefficients[0], 0.0, 0.0);
@@ -275,7 +273,7 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 // then additional constraints are added and a new solution is determined. This procedure gets repeated until no cycle
 // is detected in the solution or the only cycle contains all visited nodes, because such a solution is a traveling
 // salesman like solution, which is a valid solution.
-void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 		const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 		const std::vector<uint>& start_arcs)
 {
@@ -300,13 +298,13 @@ void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>&
 		optimization_variables.push_back(current_variable);
 		++number_of_variables;
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // coverage stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // coverage stage
 	{
 		GRBVar current_variable = model.addVar(0.0, 1.0, weights[variable], GRB_BINARY);
 		optimization_variables.push_back(current_variable);
 		++number_of_variables;
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // final stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // final stage
 	{
 		GRBVar current_variable = model.addVar(0.0, 1.0, weights[variable], GRB_BINARY);
 		optimization_variables.push_back(current_variable);
@@ -316,22 +314,20 @@ void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>&
 
 	// inequality constraints to ensure that every position has been seen at least once:
 	//		for each center that should be covered, find the arcs of the three stages that cover it
-	for(size_t row=0; row<V.rows; ++row)
+	for(int row=0; row<V.rows(); ++row)
 	{
 		std::vector<int> variable_indices;
 
 		for(size_t col=0; col<start_arcs.size(); ++col)
-			if(V.at<uchar>(row, start_arcs[col])==1)
+			if(V.at(row, start_arcs[col])==true)
 				variable_indices.push_back((int) col);
 
-		// coverage and final stage
-		for(size_t col=0; col<V.cols; ++col)
+		// coverage and final stage, the arcs that cover this cell are the entries of V in this row
+		const int* covering_arcs = V.rowBegin(row);
+		for(int entry=0; entry<V.rowSize(row); ++entry)
 		{
-			if(V.at<uchar>(row, col)==1)
-			{
-				variable_indices.push_back((int) col + start_arcs.size()); // coverage stage
-				variable_indices.push_back((int) col + start_arcs.size() + V.cols); // final stage
-			}
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size()); // coverage stage
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size() + V.cols()); // final stage
 		}
 
 		// add the constraint, if the current cell can be covered by the given arcs, indices=1 in this constraint
@@ -385,7 +381,7 @@ void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>&
 			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size());
 			variable_coefficients.push_back(-1.0);
 			// final stage variable
-			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols);
+			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols());
 			variable_coefficients.push_back(-1.0);
 		}
 
@@ -403,12 +399,12 @@ void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>&
 
 	// equality constraint to ensure that the path only once goes to the final stage
 	GRBLinExpr final_stage_constraint;
-	for(size_t node=0; node<V.cols; ++node)
-		final_stage_constraint += optimization_variables[node + start_arcs.size() + V.cols];
+	for(size_t node=0; node<V.cols(); ++node)
+		final_stage_constraint += optimization_variables[node + start_arcs.size() + V.cols()];
 	model.addConstr(final_stage_constraint==1);
 
 	// add the lazy constraint callback object that adds a lazy constraint if it gets violated after solving the problem
-	CyclePreventionCallbackClass callback_object = CyclePreventionCallbackClass(&optimization_variables, V.cols, flows_out_of_nodes, flows_into_nodes, start_arcs);
+	CyclePreventionCallbackClass callback_object = CyclePreventionCallbackClass(&optimization_variables, V.cols(), flows_out_of_nodes, flows_into_nodes, start_arcs);
 	model.setCallback(&callback_object);
 
 	// solve the optimization
@@ -458,7 +454,7 @@ void FlowNetworkExplorator::solveGurobiOptimizationProblem(std::vector<double>&
 // then additional constraints are added and a new solution is determined. This procedure gets repeated until no cycle
 // is detected in the solution or the only cycle contains all visited nodes, because such a solution is a traveling
 // salesman like solution, which is a valid solution.
-void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<double>& C, const cv::Mat& V, const std::vector<double>& weights,
+void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<double>& C, const CoverageMatrix& V, const std::vector<double>& weights,
 		const std::vector<std::vector<uint> >& flows_into_nodes, const std::vector<std::vector<uint> >& flows_out_of_nodes,
 		const std::vector<uint>& start_arcs)
 {
@@ -477,14 +473,14 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 		++number_of_variables;
 //		}
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // coverage stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // coverage stage
 	{
 		problem_builder.setColBounds(number_of_variables, 0.0, 1.0);
 		problem_builder.setObjective(number_of_variables, weights[variable]);
 		problem_builder.setInteger(number_of_variables);
 		++number_of_variables;
 	}
-	for(size_t variable=0; variable<V.cols; ++variable) // final stage
+	for(size_t variable=0; variable<V.cols(); ++variable) // final stage
 	{
 		problem_builder.setColBounds(number_of_variables, 0.0, 1.0);
 		problem_builder.setObjective(number_of_variables, weights[variable]);
@@ -495,22 +491,20 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 
 	// inequality constraints to ensure that every position has been seen at least once:
 	//		for each center that should be covered, find the arcs of the three stages that cover it
-	for(size_t row=0; row<V.rows; ++row)
+	for(int row=0; row<V.rows(); ++row)
 	{
 		std::vector<int> variable_indices;
 
 		for(size_t col=0; col<start_arcs.size(); ++col)
-			if(V.at<uchar>(row, start_arcs[col])==1)
+			if(V.at(row, start_arcs[col])==true)
 				variable_indices.push_back((int) col);
 
-		// coverage and final stage
-		for(size_t col=0; col<V.cols; ++col)
+		// coverage and final stage, the arcs that cover this cell are the entries of V in this row
+		const int* covering_arcs = V.rowBegin(row);
+		for(int entry=0; entry<V.rowSize(row); ++entry)
 		{
-			if(V.at<uchar>(row, col)==1)
-			{
-				variable_indices.push_back((int) col + start_arcs.size()); // coverage stage
-				variable_indices.push_back((int) col + start_arcs.size() + V.cols); // final stage
-			}
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size()); // coverage stage
+			variable_indices.push_back(covering_arcs[entry] + start_arcs.size() + V.cols()); // final stage
 		}
 
 		// all indices are 1 in this constraint
@@ -566,7 +560,7 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size());
 			variable_coefficients.push_back(-1.0);
 			// final stage variable
-			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols);
+			variable_indices.push_back(flows_out_of_nodes[node][outflow] + start_arcs.size() + V.cols());
 			variable_coefficients.push_back(-1.0);
 		}
 
@@ -580,12 +574,12 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 	}
 
 	// equality constraint to ensure that the path only once goes to the final stage
-	std::vector<int> final_indices(V.cols);
+	std::vector<int> final_indices(V.cols());
 	std::vector<double> final_coefficients(final_indices.size());
 	// gather indices
 	for(size_t node=0; node<final_indices.size(); ++node)
 	{
-		final_indices[node] = node + start_arcs.size() + V.cols;
+		final_indices[node] = node + start_arcs.size() + V.cols();
 		final_coefficients[node] = 1.0;
 	}
 	// add constraint
@@ -644,7 +638,7 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 		}
 
 		// go trough the coverage stage
-		for(size_t arc=start_arcs.size(); arc<start_arcs.size()+V.cols; ++arc)
+		for(size_t arc=start_arcs.size(); arc<start_arcs.size()+V.cols(); ++arc)
 		{
 			if(solution[arc]!=0)
 			{
@@ -654,12 +648,12 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 		}
 
 		 // go trough the final stage and find the remaining used arcs
-		 for(uint flow=start_arcs.size()+V.cols; flow<start_arcs.size()+2*V.cols; ++flow)
+		 for(uint flow=start_arcs.size()+V.cols(); flow<start_arcs.size()+2*V.cols(); ++flow)
 		 {
 			 if(solution[flow]>0)
 			 {
 				 // insert saved outgoing flow index
-				 used_arcs.insert(flow-start_arcs.size()-V.cols);
+				 used_arcs.insert(flow-start_arcs.size()-V.cols());
 			 }
 		}
 //		 go trough the final stage and find the remaining used arcs
@@ -667,7 +661,7 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 //		{
 //			for(size_t flow=0; flow<flows_out_of_nodes[node].size(); ++flow)
 //			{
-//				if(solution[flows_out_of_nodes[node][flow]+start_arcs.size()+V.cols]!=0)
+//				if(solution[flows_out_of_nodes[node][flow]+start_arcs.size()+V.cols()]!=0)
 //				{
 //					// insert saved outgoing flow index
 //					used_arcs.insert(flows_out_of_nodes[node][flow]);
@@ -953,19 +947,37 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 	}
 }
 
-// This Function checks if the given cv::Point is close enough to one cv::Point in the given vector. If one point gets found
-// that this Point is nearer than the defined min_distance the function returns false to stop it immediately.
-bool FlowNetworkExplorator::pointClose(const std::vector<cv::Point>& points, const cv::Point& point, const double min_distance)
+// This function finds the cells whose centers are within min_distance to at least one point of the given path. Instead of
+// checking every cell against every path point, only the grid positions in the square of min_distance around each path point
+// are looked up in the label grid of the cells.
+void FlowNetworkExplorator::getCoveredCells(const std::vector<cv::Point>& points, const cv::Mat& cell_labels, const cv::Point& grid_origin,
+		const int cell_size, const double min_distance, std::vector<int>& covered_cells)
 {
-	double square_distance = min_distance * min_distance;
-	for(std::vector<cv::Point>::const_iterator current_point = points.begin(); current_point != points.end(); ++current_point)
+	covered_cells.clear();
+	const double square_distance = min_distance * min_distance;
+	std::set<int> found_cells;
+	for(std::vector<cv::Point>::const_iterator point = points.begin(); point != points.end(); ++point)
 	{
-		double dx = current_point->x - point.x;
-		double dy = current_point->y - point.y;
-		if( ((dx*dx + dy*dy)) <= square_distance)
-			return true;
+		// grid positions in the square around the point, the distance check below decides at the border of the square
+		const int min_u = std::max(0, (int)std::floor((point->x - min_distance - grid_origin.x)/cell_size));
+		const int max_u = std::min(cell_labels.cols-1, (int)std::ceil((point->x + min_distance - grid_origin.x)/cell_size));
+		const int min_v = std::max(0, (int)std::floor((point->y - min_distance - grid_origin.y)/cell_size));
+		const int max_v = std::min(cell_labels.rows-1, (int)std::ceil((point->y + min_distance - grid_origin.y)/cell_size));
+		for(int v=min_v; v<=max_v; ++v)
+		{
+			for(int u=min_u; u<=max_u; ++u)
+			{
+				const int cell = cell_labels.at<int>(v, u);
+				if(cell < 0)
+					continue;
+				double dx = grid_origin.x + u*cell_size - point->x;
+				double dy = grid_origin.y + v*cell_size - point->y;
+				if( ((dx*dx + dy*dy)) <= square_distance)
+					found_cells.insert(cell);
+			}
+		}
 	}
-	return false;
+	covered_cells.assign(found_cells.begin(), found_cells.end());
 }
 
 // Function that uses the flow network based method to determine a coverage path. To do so the following steps are done
@@ -1196,49 +1208,100 @@ void FlowNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::vec
 //	cv::waitKey();
 
 	// create the arcs for the flow network
-	std::cout << "Constructing distance matrix" << std::endl;
-	cv::Mat distance_matrix; // determine weights
-	DistanceMatrix distance_matrix_computation;
-	distance_matrix_computation.constructDistanceMatrix(distance_matrix, rotated_room_map, edges, 0.25, 0.0, map_resolution, path_planner_);
-	std::cout << "Constructed distance matrix, defining arcs" << std::endl;
-	std::vector<arcStruct> arcs;
+	std::cout << "Defining arcs" << std::endl;
 	double max_distance = max_y - min_y; // arcs should at least go the maximal room distance to allow straight arcs
 	if(max_x-min_x>max_distance)
 		max_distance=max_x-min_x;
-	for(size_t start=0; start<distance_matrix.rows; ++start)
+
+	// label grid that stores the index of the cell center at each grid position (-1 if there is no cell), used to find the cells
+	// that are covered along an arc
+	const cv::Point grid_origin(min_x, min_y);
+	cv::Mat cell_labels((max_y-min_y)/cell_size+1, (max_x-min_x)/cell_size+1, CV_32SC1, cv::Scalar(-1));
+	for(std::vector<cv::Point>::iterator cell=cell_centers.begin(); cell!=cell_centers.end(); ++cell)
+		cell_labels.at<int>((cell->y-min_y)/cell_size, (cell->x-min_x)/cell_size) = cell-cell_centers.begin();
+
+	// the paths of all arcs starting at one edge and their lengths, which are the weights of the arcs, are read from one search
+	// on the original map, every path provides the forward and the backward arc, the threads take the next start edge until
+	// all are done
+	cv::Mat arc_planning_map;
+	path_planner_.downsampleMap(rotated_room_map, arc_planning_map, 1.0, 0.0, map_resolution);
+	std::vector<std::vector<arcStruct> > arcs_of_edges(edges.size());
+	std::vector<std::vector<std::vector<int> > > covered_cells_of_edges(edges.size());	// cells covered by each pair of arcs
+	size_t next_edge = 0;
+	boost::mutex next_edge_mutex;
+	const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)edges.size()));
+	boost::thread_group threads;
+	for (int t=0; t<number_of_threads; ++t)
 	{
-		for(size_t end=0; end<distance_matrix.cols; ++end)
+		threads.create_thread([&]()
 		{
-			// don't add arc from node to itself, only consider upper triangle of the distance matrix, one path from edge
-			// to edge provides both arcs
-			if(start!=end && end>start)
+			AStarPlanner path_planner;
+			while (true)
 			{
-				arcStruct current_forward_arc;
-				current_forward_arc.start_point = edges[start];
-				current_forward_arc.end_point = edges[end];
-				current_forward_arc.weight = distance_matrix.at<double>(start, end);
-				arcStruct current_backward_arc;
-				current_backward_arc.start_point = edges[end];
-				current_backward_arc.end_point = edges[start];
-				current_backward_arc.weight = distance_matrix.at<double>(end, start);
-				cv::Point vector = current_forward_arc.start_point - current_forward_arc.end_point;
-				// don't add too long arcs to reduce dimensionality, because they certainly won't get chosen anyway
-				// also don't add arcs that are too far away from the straight line (start-end) because they are likely
-				// to go completely around obstacles and are not good
-				if(current_forward_arc.weight <= max_distance_factor*max_distance && current_forward_arc.weight <= curvature_factor*cv::norm(vector))
+				size_t start = 0;
+				{
+					boost::mutex::scoped_lock lock(next_edge_mutex);
+					start = next_edge++;
+				}
+				if (start >= edges.size())
+					return;
+
+				// don't add arc from node to itself, only consider the following edges, one path from edge to edge provides
+				// both arcs
+				if(start+1 >= edges.size())
+					continue;
+				const std::vector<cv::Point> end_points(edges.begin()+start+1, edges.end());
+				std::vector<double> path_lengths;
+				std::vector<std::vector<cv::Point> > paths;
+				path_planner.planPathsToTargets(arc_planning_map, edges[start], end_points, 1.0, path_lengths, &paths);
+
+				for(size_t k=0; k<end_points.size(); ++k)
 				{
-					std::vector<cv::Point> astar_path;
-					path_planner_.planPath(rotated_room_map, current_forward_arc.start_point, current_forward_arc.end_point, 1.0, 0.0, map_resolution, 0, &astar_path);
-					current_forward_arc.edge_points = astar_path;
+					// the weight is the length of the straight line if it is free (like in the distance matrix of the
+					// path planner), otherwise the length of the path, unreachable edges have a length of 1e100
+					double weight = path_lengths[k];
+					if(weight < 1e90)
+					{
+						cv::LineIterator it(rotated_room_map, edges[start], end_points[k]);
+						bool direct_connection = true;
+						for(int i=0; i<it.count && direct_connection==true; ++i, ++it)
+							if(**it < 250)
+								direct_connection = false;
+						if(direct_connection == true)
+							weight = cv::norm(edges[start]-end_points[k]);
+					}
+
+					// don't add too long arcs to reduce dimensionality, because they certainly won't get chosen anyway
+					// also don't add arcs that are too far away from the straight line (start-end) because they are likely
+					// to go completely around obstacles and are not good
+					if(weight > max_distance_factor*max_distance || weight > curvature_factor*cv::norm(edges[start]-end_points[k]))
+						continue;
+
+					const size_t end = start+1+k;
+					arcStruct current_forward_arc;
+					current_forward_arc.start_point = edges[start];
+					current_forward_arc.end_point = edges[end];
+					current_forward_arc.weight = weight;
+					current_forward_arc.edge_points = paths[k];
+					arcStruct current_backward_arc;
+					current_backward_arc.start_point = edges[end];
+					current_backward_arc.end_point = edges[start];
+					current_backward_arc.weight = weight;
 					// reverse path for backward arc
-					std::reverse(astar_path.begin(), astar_path.end());
-					current_backward_arc.edge_points = astar_path;
-					arcs.push_back(current_forward_arc);
-					arcs.push_back(current_backward_arc);
+					current_backward_arc.edge_points.assign(paths[k].rbegin(), paths[k].rend());
+					arcs_of_edges[start].push_back(current_forward_arc);
+					arcs_of_edges[start].push_back(current_backward_arc);
+
+					covered_cells_of_edges[start].push_back(std::vector<int>());
+					getCoveredCells(paths[k], cell_labels, grid_origin, cell_size, 1.1*coverage_radius, covered_cells_of_edges[start].back());
 				}
 			}
-		}
+		});
 	}
+	threads.join_all();
+	std::vector<arcStruct> arcs;
+	for(size_t start=0; start<edges.size(); ++start)
+		arcs.insert(arcs.end(), arcs_of_edges[start].begin(), arcs_of_edges[start].end());
 	// TODO: exclude nodes that aren't connected to the rest of the edges
 	std::cout << "arcs: " << arcs.size() << std::endl;
 
@@ -1262,19 +1325,20 @@ void FlowNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::vec
 		w[arc-arcs.begin()] = arc->weight;
 
 	// 2. visibility matrix, storing which call can be covered when going along the arc
-	//		remark: a cell counts as covered, when the center of each cell is in the coverage radius around the arc
-	cv::Mat V = cv::Mat(cell_centers.size(), number_of_candidates, CV_8U); // binary variables
-	for(std::vector<arcStruct>::iterator arc=arcs.begin(); arc!=arcs.end(); ++arc)
+	//		remark: a cell counts as covered, when the center of each cell is in the coverage radius around the arc, the forward
+	//		and the backward arc cover the same cells
+	std::vector<std::vector<int> > covered_cells_of_arcs;
+	covered_cells_of_arcs.reserve(number_of_candidates);
+	for(size_t start=0; start<edges.size(); ++start)
 	{
-		// use the pointClose function to check if a cell can be covered along the path
-		for(std::vector<cv::Point>::iterator cell=cell_centers.begin(); cell!=cell_centers.end(); ++cell)
+		for(size_t pair=0; pair<covered_cells_of_edges[start].size(); ++pair)
 		{
-			if(pointClose(arc->edge_points, *cell, 1.1*coverage_radius) == true)
-				V.at<uchar>(cell-cell_centers.begin(), arc-arcs.begin()) = 1;
-			else
-				V.at<uchar>(cell-cell_centers.begin(), arc-arcs.begin()) = 0;
+			covered_cells_of_arcs.push_back(covered_cells_of_edges[start][pair]);
+			covered_cells_of_arcs.push_back(covered_cells_of_edges[start][pair]);
 		}
 	}
+	CoverageMatrix V; // binary variables
+	V.setFromColumns(cell_centers.size(), covered_cells_of_arcs);
 
 	// 3. set of arcs (indices) that are going into and out of one node
 	std::vector<std::vector<uint> > flows_into_nodes(edges.size());
@@ -1326,13 +1390,9 @@ void FlowNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::vec
 
 	// print out warning if a defined cell is not coverable with the chosen arcs
 	bool all_cells_covered = true;
-	for(size_t row=0; row<V.rows; ++row)
+	for(int row=0; row<V.rows(); ++row)
 	{
-		int number_of_paths = 0;
-		for(size_t col=0; col<V.cols; ++col)
-			if(V.at<uchar>(row, col)==1)
-				++number_of_paths;
-		if(number_of_paths==0)
+		if(V.rowSize(row)==0)
 		{
 			std::cout << "!!!!!!!! EMPTY ROW OF VISIBILITY MATRIX !!!!!!!!!!!!!" << std::endl << "cell " << row << " not coverable" << std::endl;
 			all_cells_covered = false;
@@ -1431,8 +1491,8 @@ void FlowNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::vec
 		if(C[final_arc]>0.01)
 		{
 			// insert saved outgoing flow index
-//			used_arcs.insert(final_arc-flows_out_of_nodes[start_index].size()-V.cols);
-			path_end = final_arc-flows_out_of_nodes[start_index].size()-V.cols;
+//			used_arcs.insert(final_arc-flows_out_of_nodes[start_index].size()-V.cols());
+			path_end = final_arc-flows_out_of_nodes[start_index].size()-V.cols();
 
 //			std::vector<cv::Point> path=arcs[final_arc-flows_out_of_nodes[start_index].size()-arcs.size()].edge_points;
 //			for(size_t j=0; j<path.size(); ++j)
@@ -1446,7 +1506,7 @@ void FlowNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::vec
 //	{
 //		for(size_t flow=0; flow<flows_out_of_nodes[node].size(); ++flow)
 //		{
-//			if(C[flows_out_of_nodes[node][flow]+flows_out_of_nodes[start_index].size()+V.cols]>0.01) // taking integer precision in solver into account
+//			if(C[flows_out_of_nodes[node][flow]+flows_out_of_nodes[start_index].size()+V.cols()]>0.01) // taking integer precision in solver into account
 //			{
 //				// insert saved outgoing flow index
 //				used_arcs.insert(flows_out_of_nodes[node][flow]);
@@ -1837,6 +1897,15 @@ void FlowNetworkExplorator::testFunc()
 		std::cout << std::endl;
 	}
 
+	// convert the test matrix into the sparse coverage matrix of the solvers
+	std::vector<std::vector<int> > covered_cells_of_arcs(V.cols);
+	for(size_t row=0; row<V.rows; ++row)
+		for(size_t col=0; col<V.cols; ++col)
+			if(V.at<uchar>(row, col)==1)
+				covered_cells_of_arcs[col].push_back(row);
+	CoverageMatrix V_sparse;
+	V_sparse.setFromColumns(V.rows, covered_cells_of_arcs);
+
 	std::vector<double> W(C.size(), 1.0);
 	w[10] = 0.25;
 	w[11] = 0.25;
@@ -1848,7 +1917,7 @@ void FlowNetworkExplorator::testFunc()
 	{
 
 //		solveThreeStageOptimizationProblem(C, V, w, flows_in_nodes, flows_out_of_nodes, flows_out_of_nodes[0]);//, &W);
-		solveGurobiOptimizationProblem(C, V, w, flows_in_nodes, flows_out_of_nodes, flows_out_of_nodes[0]);
+		solveGurobiOptimizationProblem(C, V_sparse, w, flows_in_nodes, flows_out_of_nodes, flows_out_of_nodes[0]);
 		for(size_t c=0; c<C.size(); ++c)
 			std::cout << C[c] << std::endl;
 		std::cout << std::endl;
@@ -61,6 +61,11 @@ void GridPointExplorator::tsp_solver_thread(const int tsp_solver, std::vector<in
 			ConcordeTSPSolver tsp_solve;
 			optimal_order = tsp_solve.solveConcordeTSP(original_map, points, downsampling_factor, robot_radius, map_resolution, start_node, 0);
 		}
+		else if (tsp_solver == TSP_LIN_KERNIGHAN)
+		{
+			LinKernighanTSPSolver tsp_solve;
+			optimal_order = tsp_solve.solveLinKernighanTSP(original_map, points, downsampling_factor, robot_radius, map_resolution, start_node, 0);
+		}
 		else
 		{
 			std::cout << "GridPointExplorator::tsp_solver_thread: Error: tsp_solver " << tsp_solver << " is undefined." << std::endl;
@@ -202,6 +207,16 @@ void GridPointExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 			finished = true;
 		t.join();
 	}
+	else if (tsp_solver == TSP_LIN_KERNIGHAN)
+	{
+		// the Lin-Kernighan solver returns its best tour when the time is up, so it does not need a fallback
+		LinKernighanTSPSolver tsp_solve;
+		if (tsp_solver_timeout > 0)
+			tsp_solve.setMaximumComputationTime(tsp_solver_timeout);
+		optimal_order = tsp_solve.solveLinKernighanTSPWithCleanedDistanceMatrix(distance_matrix_cleaned, cleaned_index_to_original_index_mapping, min_index);
+		finished = true;
+		std::cout << "GridPointExplorator::getExplorationPath: finished TSP with solver 4=Lin-Kernighan and optimal_order.size=" << optimal_order.size() << std::endl;
+	}
 	// fall back to nearest neighbor TSP if the other approach was timed out
 	if (tsp_solver==TSP_NEAREST_NEIGHBOR || finished==false)
 	{
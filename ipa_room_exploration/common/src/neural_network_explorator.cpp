@@ -11,6 +11,120 @@ NeuralNetworkExplorator::NeuralNetworkExplorator()
 	E_ = 80; // E >> B, 80
 	mu_ = 1.03; // 1.03
 	delta_theta_weight_ = 0.15; // 0.15
+
+	network_rows_ = 0;
+	network_columns_ = 0;
+	network_stride_ = 2;
+	current_states_ = 0;
+
+	number_of_update_threads_ = 1;
+	posted_updates_ = 0;
+}
+
+// Function that updates the activities of all neurons number_of_updates times. All neurons are updated synchronously from
+// the previous activities, so the rows of the network can be updated independently by several threads, which only have
+// to wait for each other after each update. The calling thread updates the first rows and the worker threads of
+// startUpdateThreads the others, the workers are woken up by the first wait at the barrier.
+void NeuralNetworkExplorator::updateStates(const int number_of_updates)
+{
+	if (number_of_update_threads_ == 1)
+	{
+		updateStatesOfRows(0, network_rows_, number_of_updates, 0);
+	}
+	else
+	{
+		posted_updates_ = number_of_updates;
+		update_barrier_->wait();
+		updateStatesOfRows(0, network_rows_/number_of_update_threads_, number_of_updates, update_barrier_.get());
+	}
+	current_states_ = (current_states_+number_of_updates)%2;
+}
+
+// Function that starts the worker threads of updateStates, every thread gets a fixed block of rows.
+void NeuralNetworkExplorator::startUpdateThreads()
+{
+	number_of_update_threads_ = std::max(1, std::min((int)boost::thread::hardware_concurrency(),
+			std::min(network_rows_, network_rows_*network_columns_/4096)));
+	if (number_of_update_threads_ == 1)
+		return;
+
+	update_barrier_.reset(new boost::barrier(number_of_update_threads_));
+	for (int t=1; t<number_of_update_threads_; ++t)
+	{
+		const int first_row = network_rows_*t/number_of_update_threads_;
+		const int last_row = network_rows_*(t+1)/number_of_update_threads_;
+		update_threads_.create_thread([=]() { runUpdateThread(first_row, last_row); });
+	}
+}
+
+// Function that stops the worker threads of updateStates.
+void NeuralNetworkExplorator::stopUpdateThreads()
+{
+	if (number_of_update_threads_ > 1)
+	{
+		posted_updates_ = -1;
+		update_barrier_->wait();
+		update_threads_.join_all();
+		update_barrier_.reset();
+	}
+	number_of_update_threads_ = 1;
+}
+
+// Function of the worker threads of updateStates: the barrier wait after the posted number of updates has been set is the
+// signal to start the updates, a negative number stops the thread. posted_updates_ and current_states_ are only changed
+// by the calling thread while all workers wait at the barrier.
+void NeuralNetworkExplorator::runUpdateThread(const int first_row, const int last_row)
+{
+	while (true)
+	{
+		update_barrier_->wait();
+		if (posted_updates_ < 0)
+			return;
+		updateStatesOfRows(first_row, last_row, posted_updates_, update_barrier_.get());
+	}
+}
+
+// Function that updates the activities of the given rows with the euler discretization of the shunting equation, see the
+// stated paper, which is applied to the whole row at once. The border of the network has zero
+// activity, so it does not contribute to the weighted sum of the neighbors.
+void NeuralNetworkExplorator::updateStatesOfRows(const int first_row, const int last_row, const int number_of_updates, boost::barrier* barrier)
+{
+	const int stride = network_stride_;
+	const double A = A_, B = B_, D = D_, step_size = step_size_;
+	const double* input = &external_input_[0];
+	const double* w[8];
+	for (int k=0; k<8; ++k)
+		w[k] = &neighbor_weights_[k][0];
+	for (int update=0; update<number_of_updates; ++update)
+	{
+		const double* previous_states = &states_[(current_states_+update)%2][0];
+		double* states = &states_[(current_states_+update+1)%2][0];
+		for (int row=first_row; row<last_row; ++row)
+		{
+			const int row_begin = (row+1)*stride + 1;
+			for (int neuron=row_begin; neuron<row_begin+network_columns_; ++neuron)
+			{
+				// get the current sum of weights times the state of the neighbor
+				double weight_sum = w[0][neuron]*std::max(previous_states[neuron-stride-1], 0.0);
+				weight_sum += w[1][neuron]*std::max(previous_states[neuron-stride], 0.0);
+				weight_sum += w[2][neuron]*std::max(previous_states[neuron-stride+1], 0.0);
+				weight_sum += w[3][neuron]*std::max(previous_states[neuron-1], 0.0);
+				weight_sum += w[4][neuron]*std::max(previous_states[neuron+1], 0.0);
+				weight_sum += w[5][neuron]*std::max(previous_states[neuron+stride-1], 0.0);
+				weight_sum += w[6][neuron]*std::max(previous_states[neuron+stride], 0.0);
+				weight_sum += w[7][neuron]*std::max(previous_states[neuron+stride+1], 0.0);
+
+				// calculate current gradient and update the state
+				const double state = previous_states[neuron];
+				const double gradient = -A*state + (B-state)*(std::max(input[neuron], 0.0) + weight_sum) - (D+state)*std::max(-1.0*input[neuron], 0.0);
+				states[neuron] = state + step_size*gradient;
+			}
+		}
+
+		// wait until all rows have been updated before they are used as previous states
+		if (barrier != 0)
+			barrier->wait();
+	}
 }
 
 // Function that calculates an exploration path trough the given map s.t. everything has been covered by the robot-footprint
@@ -21,7 +135,7 @@ NeuralNetworkExplorator::NeuralNetworkExplorator()
 // and uses a artificial neural network to produce the path. For this the following steps are done:
 // I. 	Construct the neural network by sampling the given map, using the given fitting circle radius as step size. This is
 //		done because it allows that when all neurons (the samples) are covered the whole space have been cleaned/inspected.
-// II.	Starting with the given robot pose go trough the found network. At every time-step choose the next Neuron by
+// II.	Starting with the given robot pose go trough the found network. At every time-step choose the next neuron by
 //		solving x_n = max(x_j + c*y_j), with c as a positive scalar and y_j a function penalizing movements of the robot
 //		into a direction he is currently not pointing at. At every time-step an update of the states of the neurons is done.
 //		After this step a path consisting of poses for the fov middlepoint is obtained. If the plan should be planned for
@@ -65,161 +179,129 @@ void NeuralNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::v
 	cv::erode(rotated_room_map, inflated_rotated_room_map, cv::Mat(), cv::Point(-1, -1), half_grid_spacing_as_int);
 
 	// ****************** II. Create the neural network ******************
-	// reset previously computed neurons
-	neurons_.clear();
-
-	// go trough the map and create the neurons
-	int number_of_free_neurons = 0;
+	// go trough the map and create the neurons, the network is surrounded by a border of inactive neurons
+	network_rows_ = 0;
 	for(int y=min_room.y+half_grid_spacing_as_int; y<max_room.y; y+=grid_spacing_as_int)
+		++network_rows_;
+	network_columns_ = 0;
+	for(int x=min_room.x+half_grid_spacing_as_int; x<max_room.x; x+=grid_spacing_as_int)
+		++network_columns_;
+	network_stride_ = network_columns_+2;
+	const int network_size = (network_rows_+2)*network_stride_;
+	states_[0].assign(network_size, 0.);
+	states_[1].assign(network_size, 0.);
+	current_states_ = 0;
+	external_input_.assign(network_size, 0.);
+	std::vector<bool> obstacle_neurons(network_size, true);
+	std::vector<cv::Point> neuron_positions(network_size);
+	int number_of_free_neurons = 0;
+	for(int row=0; row<network_rows_; ++row)
 	{
-		// for the current row create a new set of neurons to span the network over time
-		std::vector<Neuron> current_network_row;
-		for(int x=min_room.x+half_grid_spacing_as_int; x<max_room.x; x+=grid_spacing_as_int)
+		for(int column=0; column<network_columns_; ++column)
 		{
-			// create free neuron
-			cv::Point cell_center(x,y);
-			if (GridGenerator::completeCellTest(inflated_rotated_room_map, cell_center, grid_spacing_as_int) == true)
+			const int neuron = (row+1)*network_stride_ + column+1;
+			cv::Point cell_center(min_room.x+half_grid_spacing_as_int+column*grid_spacing_as_int, min_room.y+half_grid_spacing_as_int+row*grid_spacing_as_int);
+			const bool free_cell = GridGenerator::completeCellTest(inflated_rotated_room_map, cell_center, grid_spacing_as_int);
+			neuron_positions[neuron] = cell_center;
+			if (free_cell == true)
 			//if(rotated_room_map.at<uchar>(y,x) == 255)
 			{
-				Neuron current_neuron(cell_center, A_, B_, D_, E_, mu_, step_size_, false);
-				current_network_row.push_back(current_neuron);
+				// free neuron
+				obstacle_neurons[neuron] = false;
+				external_input_[neuron] = E_;
 				++number_of_free_neurons;
 			}
 			else // obstacle neuron
 			{
-				Neuron current_neuron(cell_center, A_, B_, D_, E_, mu_, step_size_, true);
-				current_network_row.push_back(current_neuron);
+				external_input_[neuron] = -1.0*E_;
 			}
 		}
-
-		// insert the current row into the network
-		neurons_.push_back(current_network_row);
 	}
 
 	// todo: do not limit to direct neighbors but cycle through all neurons for finding the best next
-	// go trough the found neurons and get the direct neighbors of each
-	for(size_t row=0; row<neurons_.size(); ++row)
+	// the direct neighbors of each neuron are the 8 surrounding neurons of the grid, the weights to them depend on the distance
+	// of the (possibly shifted) cell centers, the border of the network gets no weight
+	int k = 0;
+	for(int dy=-1; dy<=1; ++dy)
+		for(int dx=-1; dx<=1; ++dx)
+			if(dy != 0 || dx != 0)
+				neighbor_offsets_[k++] = dy*network_stride_ + dx;
+	for(k=0; k<8; ++k)
 	{
-		for(size_t column=0; column<neurons_[row].size(); ++column)
+		neighbor_weights_[k].assign(network_size, 0.);
+		for(int row=0; row<network_rows_; ++row)
 		{
-			for(int dy=-1; dy<=1; ++dy)
+			for(int column=0; column<network_columns_; ++column)
 			{
-				// don't exceed the current row
-				if(row+dy < 0 || row+dy >= neurons_.size())
-					continue;
-
-				// get the neighbors left from the current neuron
-				if(column > 0)
-					neurons_[row][column].addNeighbor(&neurons_[row+dy][column-1]);
-
-				// get the neurons on the same column as the current neuron
-				if(dy != 0)
-					neurons_[row][column].addNeighbor(&neurons_[row+dy][column]);
-
-				// get the neurons right from the current neuron
-				if(column < neurons_[row].size()-1)
-					neurons_[row][column].addNeighbor(&neurons_[row+dy][column+1]);
+				const int neuron = (row+1)*network_stride_ + column+1;
+				const int neighbor = neuron + neighbor_offsets_[k];
+				if(isInNetwork(neighbor) == true)
+					neighbor_weights_[k][neuron] = mu_/cv::norm(neuron_positions[neuron] - neuron_positions[neighbor]);
 			}
 		}
 	}
 
-//	testing
-//	cv::Mat black_map = cv::Mat(rotated_room_map.rows, rotated_room_map.cols, rotated_room_map.type(), cv::Scalar(0));
-//	for(size_t i=0; i<neurons_.size(); ++i)
-//	{
-//		for(size_t j=0; j<neurons_[i].size(); ++j)
-//		{
-//			std::vector<Neuron*> neighbors;
-//			neurons_[i][j].getNeighbors(neighbors);
-//			for(size_t k=0; k<neighbors.size(); ++k)
-//			{
-//				cv::circle(black_map, neighbors[k]->getPosition(), 2, cv::Scalar(127), CV_FILLED);
-//			}
-//		}
-//	}
-//	cv::imshow("neighbors", black_map);
-//	cv::waitKey();
-
 	// ****************** III. Find the coverage path ******************
 	// mark the first non-obstacle neuron as starting node
-	Neuron* starting_neuron = 0;
-	bool found = false;
-	for(size_t row=0; row<neurons_.size(); ++row)
+	int starting_neuron = -1;
+	for(int row=0; row<network_rows_ && starting_neuron<0; ++row)
 	{
-		for(size_t column=0; column<neurons_[row].size(); ++column)
+		for(int column=0; column<network_columns_; ++column)
 		{
-			if(neurons_[row][column].isObstacle() == false && found == false)
+			const int neuron = (row+1)*network_stride_ + column+1;
+			if(obstacle_neurons[neuron] == false)
 			{
-				found = true;
-				starting_neuron = &neurons_[row][column];
+				starting_neuron = neuron;
 				break;
 			}
 		}
-
-		if(found == true)
-			break;
 	}
-	if (starting_neuron==0)
+	if (starting_neuron<0)
 	{
 		std::cout << "Warning: there are no accessible points in this room." << std::endl;
 		return;
 	}
-	starting_neuron->markAsVisited();
-
-	// initial updates of the states to mark obstacles and unvisited free neurons as such
-	for(size_t init=1; init<=100; ++init)
-	{
-		for(size_t row=0; row<neurons_.size(); ++row)
-			for(size_t column=0; column<neurons_[row].size(); ++column)
-				neurons_[row][column].saveState();
-		for(size_t row=0; row<neurons_.size(); ++row)
-			for(size_t column=0; column<neurons_[row].size(); ++column)
-				neurons_[row][column].updateState();
-	}
+	external_input_[starting_neuron] = 0.;
 
-//	testing
-//	cv::Mat black_map = cv::Mat(rotated_room_map.rows, rotated_room_map.cols, CV_32F, cv::Scalar(0));
-//	for(size_t row=0; row<neurons_.size(); ++row)
-//	{
-//		for(size_t column=0; column<neurons_[row].size(); ++column)
-//		{
-//			std::cout << neurons_[row][column].getState(false) << " ";
-//			black_map.at<float>(row*fitting_radius_as_int, column*fitting_radius_as_int) = (float) 1000.0*neurons_[row][column].getState(false);
-//		}
-//		std::cout << std::endl;
-//	}
-//	std::cout << std::endl;
-//	cv::namedWindow("states", cv::WINDOW_NORMAL);
-//	cv::imshow("states", black_map);
-//	cv::resizeWindow("states", 600, 600);
-//	cv::waitKey();
+	// initial updates of the states to mark obstacles and unvisited free neurons as such, the worker threads of the updates
+	// are kept until the path is found
+	startUpdateThreads();
+	updateStates(100);
 
 	// iteratively choose the next neuron until all neurons have been visited or the algorithm is stuck in a
-	// limit cycle like path (i.e. the same neurons get visited over and over)
+	// limit cycle like path (i.e. the same neurons get visited over and over), for detecting the cycles the
+	// positions of each neuron in the path are stored
 	int visited_neurons = 1;
 	bool stuck_in_cycle = false;
 	std::vector<cv::Point> fov_coverage_path;
-	fov_coverage_path.push_back(cv::Point(starting_neuron->getPosition().x, starting_neuron->getPosition().y));
+	fov_coverage_path.push_back(neuron_positions[starting_neuron]);
+	std::vector<int> neuron_path(1, starting_neuron);
+	std::vector<std::vector<int> > path_indices_of_neurons(network_size);
+	path_indices_of_neurons[starting_neuron].push_back(0);
 	double previous_traveling_angle = 0.0; // save the travel direction to the current neuron to determine the next neuron
 	cv::Mat black_map = rotated_room_map.clone();
-	Neuron* previous_neuron = starting_neuron;
+	int previous_neuron = starting_neuron;
 	int loop_counter = 0;
 	do
 	{
-		//std::cout << "Point: " << previous_neuron->getPosition() << std::endl;
+		//std::cout << "Point: " << neuron_positions[previous_neuron] << std::endl;
 		++loop_counter;
 
-		// get the current neighbors and choose the next out of them
-		std::vector<Neuron*> neighbors;
-		previous_neuron->getNeighbors(neighbors);
-		Neuron* next_neuron = 0;
-
-		// go through the neighbors and find the next one
+		// go through the neighbors of the current neuron and find the next one
+		const std::vector<double>& states = states_[current_states_];
+		const cv::Point& previous_position = neuron_positions[previous_neuron];
+		int next_neuron = -1;
 		double max_value = -1e10, travel_angle = 0.0, best_angle = 0.0;
-		for(size_t neighbor=0; neighbor<neighbors.size(); ++neighbor)
+		for(int k=0; k<8; ++k)
 		{
+			// skip the border of the network
+			const int neighbor = previous_neuron + neighbor_offsets_[k];
+			if(isInNetwork(neighbor) == false)
+				continue;
+
 			// get travel angle to this neuron
-			travel_angle = std::atan2(neighbors[neighbor]->getPosition().y-previous_neuron->getPosition().y, neighbors[neighbor]->getPosition().x-previous_neuron->getPosition().x);
+			const cv::Point& neighbor_position = neuron_positions[neighbor];
+			travel_angle = std::atan2(neighbor_position.y-previous_position.y, neighbor_position.x-previous_position.x);
 
 			// compute penalizing function y_j
 			double diff_angle = travel_angle - previous_traveling_angle;
@@ -230,19 +312,18 @@ void NeuralNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::v
 			double y = 1 - (std::abs(diff_angle)/PI);
 
 			// compute transition function value
-			//std::cout << " Neighbor: " << neighbors[neighbor]->getPosition() << "   " << neighbors[neighbor]->getState(false) << ", " << delta_theta_weight_ * y << std::endl;
-			double trans_fct_value = neighbors[neighbor]->getState(false) + delta_theta_weight_ * y;
+			double trans_fct_value = states[neighbor] + delta_theta_weight_ * y;
 
 			// check if neighbor is next neuron to be visited
-			if(trans_fct_value > max_value && rotated_room_map.at<uchar>(neighbors[neighbor]->getPosition()) != 0)
+			if(trans_fct_value > max_value && rotated_room_map.at<uchar>(neighbor_position) != 0)
 			{
 				max_value = trans_fct_value;
-				next_neuron = neighbors[neighbor];
+				next_neuron = neighbor;
 				best_angle = travel_angle;
 			}
 		}
 		// catch errors
-		if (next_neuron == 0)
+		if (next_neuron < 0)
 		{
 			if (loop_counter <= 20)
 				continue;
@@ -252,42 +333,31 @@ void NeuralNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::v
 		loop_counter = 0;
 
 		// if the next neuron was previously uncleaned, increase number of visited neurons
-		if(next_neuron->visitedNeuron() == false)
+		if(path_indices_of_neurons[next_neuron].empty() == true)
 			++visited_neurons;
 
-		// mark next neuron as visited
-		next_neuron->markAsVisited();
+		// mark next neuron as visited, obstacles keep their negative input
+		if(obstacle_neurons[next_neuron] == false)
+			external_input_[next_neuron] = 0.;
 		previous_traveling_angle = best_angle;
 
 		// add neuron to path
-		const cv::Point current_pose(next_neuron->getPosition().x, next_neuron->getPosition().y);
-		fov_coverage_path.push_back(current_pose);
+		path_indices_of_neurons[next_neuron].push_back(neuron_path.size());
+		neuron_path.push_back(next_neuron);
+		fov_coverage_path.push_back(neuron_positions[next_neuron]);
 
-		// check the fov path for a limit cycle by searching the path for the next neuron, if it occurs too often
-		// and the previous/following neuron is always the same the algorithm probably is stuck in a cycle
-		int number_of_neuron_in_path = 0;
-		for(std::vector<cv::Point>::iterator pose=fov_coverage_path.begin(); pose!=fov_coverage_path.end(); ++pose)
-			if(*pose==current_pose)
-				++number_of_neuron_in_path;
-
-		if(number_of_neuron_in_path >= 20)
+		// check the fov path for a limit cycle, if the next neuron occurs too often in the path and the previous/following
+		// neuron is always the same the algorithm probably is stuck in a cycle
+		if(path_indices_of_neurons[next_neuron].size() >= 20)
 		{
-			// check number of previous neuron
-			cv::Point previous_pose = fov_coverage_path[fov_coverage_path.size()-2];
+			// count the occurrences of the previous neuron next to the current neuron, the first and the last neuron of the
+			// path are not checked
 			int number_of_previous_neuron_in_path = 0;
-			for(std::vector<cv::Point>::iterator pose=fov_coverage_path.begin()+1; pose!=fov_coverage_path.end()-1; ++pose)
-			{
-				// check if the the previous pose always has the current pose as neighbor
-				if(*pose==previous_pose)
-				{
-					if(*(pose+1)==current_pose)
-						++number_of_previous_neuron_in_path;
-					else if(*(pose-1)==current_pose)
-						++number_of_previous_neuron_in_path;
-				}
-			}
+			const std::vector<int>& previous_indices = path_indices_of_neurons[previous_neuron];
+			for(std::vector<int>::const_iterator index=previous_indices.begin(); index!=previous_indices.end(); ++index)
+				if(*index > 0 && *index+1 < (int)neuron_path.size() && (neuron_path[*index+1]==next_neuron || neuron_path[*index-1]==next_neuron))
+					++number_of_previous_neuron_in_path;
 
-			//if(number_of_previous_neuron_in_path >= number_of_neuron_in_path)
 			if(number_of_previous_neuron_in_path >= 20)
 			{
 				std::cout << "Warning: the algorithm is probably stuck in a cycle. Aborting." << std::endl;
@@ -296,21 +366,13 @@ void NeuralNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::v
 		}
 
 		// update the states of the network
-		for (int i=0; i<100; ++i)
-		{
-			for(size_t row=0; row<neurons_.size(); ++row)
-				for(size_t column=0; column<neurons_[row].size(); ++column)
-					neurons_[row][column].saveState();
-			for(size_t row=0; row<neurons_.size(); ++row)
-				for(size_t column=0; column<neurons_[row].size(); ++column)
-					neurons_[row][column].updateState();
-		}
+		updateStates(100);
 
 //		printing of the path computation
 		if(show_path_computation == true)
 		{
-			cv::circle(black_map, next_neuron->getPosition(), 2, cv::Scalar((visited_neurons*5)%250), CV_FILLED);
-			cv::line(black_map, previous_neuron->getPosition(), next_neuron->getPosition(), cv::Scalar(128), 1);
+			cv::circle(black_map, neuron_positions[next_neuron], 2, cv::Scalar((visited_neurons*5)%250), CV_FILLED);
+			cv::line(black_map, neuron_positions[previous_neuron], neuron_positions[next_neuron], cv::Scalar(128), 1);
 			cv::imshow("next_neuron", black_map);
 			cv::waitKey();
 		}
@@ -318,6 +380,7 @@ void NeuralNetworkExplorator::getExplorationPath(const cv::Mat& room_map, std::v
 		// save neuron that has been visited
 		previous_neuron = next_neuron;
 	} while (visited_neurons < number_of_free_neurons && stuck_in_cycle == false); //TODO: test terminal condition
+	stopUpdateThreads();
 
 	// transform the calculated path back to the originally rotated map
 	std::vector<geometry_msgs::Pose2D> fov_poses;
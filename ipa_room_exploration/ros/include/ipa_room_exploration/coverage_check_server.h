@@ -9,10 +9,16 @@
 // c++ standard libraries
 #include <iostream>
 #include <list>
+#include <set>
+#include <functional>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <climits>
+// Boost
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
 // services
 #include <ipa_building_msgs/CheckCoverage.h>
 
@@ -23,20 +29,78 @@
 // which the number of observations (or coverages) is assigned to each pixel (32 bit image in this case).
 class CoverageCheckServer
 {
+public:
+	// obstacle contours of a map as axis-parallel segments along the borders between free and occupied cells (the area outside of
+	// the map counts as occupied), in cell corner coordinates, i.e. cell (u,v) covers [u,u+1]x[v,v+1], the segments are
+	// sorted into square buckets of the map to find the segments of an area quickly
+	struct ObstacleSegments
+	{
+		std::vector<cv::Vec4i> segments;			// (x1,y1,x2,y2) with x1<=x2 and y1<=y2
+		int bucket_size;							// side length of a bucket, in [cells]
+		int buckets_x;
+		int buckets_y;
+		std::vector<std::vector<int> > buckets;	// indices of the segments that touch each bucket, index = bucket_y*buckets_x + bucket_x
+	};
+
+	// extracts the obstacle contours of the map, see ObstacleSegments
+	static void extractObstacleSegments(const cv::Mat& map, ObstacleSegments& obstacle_segments);
+
 protected:
 	// node handle
 	ros::NodeHandle node_handle_;
 
+	// hands out the robot poses to the threads of drawCoveredPointsPolygon
+	struct PoseQueue
+	{
+		PoseQueue() : next_pose(0) {}
+
+		size_t next_pose;
+		boost::mutex mutex;
+	};
+
 	// Function to draw the covered areas into the given map. This is done by going through all given robot-poses and calculating
 	// the field of view. The field of view is given in robot base coordinates (x-axis shows to the front and y-axis to left side).
 	// The function then calculates the field_of_view in the global frame by using the given robot pose.
-	// After this the function does a ray casting from the field of view origin (i.e. the camera location expressed in the robot base coordinate system)
-	// to each cell of the field of view in order to verify whether the cell has been obstructed by an obstacle and could not be observed.
-	// This ensures that no point is wrongly classified as seen.
+	// After this the function checks for each cell of the field of view whether the line of sight from the field of view origin
+	// (i.e. the camera location expressed in the robot base coordinate system) to the cell is obstructed by an obstacle, so that
+	// no point is wrongly classified as seen. Only the bounding box of the field of view and its origin is processed for each
+	// pose and the poses are distributed over several threads.
+	// Only the bounding box of the fields of view of all poses is counted and merged into the map.
+	// If obstacle_segments (the obstacle contours of the map) is provided, the visible area of each pose is the visibility polygon
+	// of the field of view origin among the obstacle contours instead, which is clipped with the field of view and drawn into the map.
 	// @param fov_origin The mounting position of the camera spanning the field of view, given in robot base coordinates, in [m]
 	void drawCoveredPointsPolygon(cv::Mat& reachable_areas_map, const std::vector<cv::Point3d>& robot_poses,
 			const std::vector<Eigen::Matrix<float, 2, 1>>& field_of_view_points, const Eigen::Matrix<float, 2, 1>& fov_origin,
-			const float map_resolution, const cv::Point2d map_origin, cv::Mat* number_of_coverages_image=NULL);
+			const float map_resolution, const cv::Point2d map_origin, cv::Mat* number_of_coverages_image=NULL,
+			const ObstacleSegments* obstacle_segments=NULL);
+
+	// Function that takes the next pose from pose_queue and counts the cells that are seen from it in coverage_counts (CV_32SC1,
+	// covering counts_area of the map) until all poses are done. Each thread has its own coverage_counts. If obstacle_segments is provided, the
+	// visible cells are determined with computeVisibilityPolygon, otherwise with computeVisibility.
+	void countCoveredPointsPolygon(const cv::Mat& map, const std::vector<cv::Point3d>& robot_poses,
+			const std::vector<Eigen::Matrix<float, 2, 1>>& field_of_view_points, const Eigen::Matrix<float, 2, 1>& fov_origin,
+			const float map_resolution, const cv::Point2d map_origin, cv::Mat& coverage_counts, const cv::Rect& counts_area,
+			PoseQueue& pose_queue, const ObstacleSegments* obstacle_segments);
+
+	// transforms the field of view and its origin to the given robot pose, fov_points receives the field of view in map cells
+	// (clamped to the map), origin the exact origin and origin_point the cell of the origin, returns the bounding box of both
+	cv::Rect transformFieldOfView(const cv::Point3d& pose, const std::vector<Eigen::Matrix<float, 2, 1>>& field_of_view_points,
+			const Eigen::Matrix<float, 2, 1>& fov_origin, const float map_resolution_inverse, const cv::Point2d& map_origin, const int rows,
+			const int cols, std::vector<cv::Point>& fov_points, cv::Point2d& origin, cv::Point& origin_point);
+
+	// Computes for each cell of area (in map coordinates) whether it can be seen from origin (which has to lie inside area), the
+	// result is written into visibility (CV_8UC1, size of area, 255 = visible). The cells are visited in rings of growing distance
+	// around the origin and a cell is visible if it is free and the cell before it on the line from the origin is visible, so
+	// every cell is checked only once instead of casting a ray to each cell.
+	static void computeVisibility(const cv::Mat& map, const cv::Point& origin, const cv::Rect& area, cv::Mat& visibility);
+
+	// Computes the visibility polygon of origin (in cell corner coordinates) inside area (in map cells) with an angular sweep:
+	// the segments that touch the area are clipped to it, their end points are sorted by angle around the origin and the
+	// segments that the sweep ray crosses are kept in a set ordered by their distance along the ray, the polygon gets a corner
+	// whenever the closest segment changes, so an area with S segments takes O(S log S).
+	// segment_stamps (one entry per segment) and stamp are used to take each segment only once and are kept between calls.
+	static void computeVisibilityPolygon(const ObstacleSegments& obstacle_segments, const cv::Point2d& origin, const cv::Rect& area,
+			std::vector<int>& segment_stamps, int& stamp, std::vector<cv::Point2d>& visibility_polygon);
 
 	// Function that takes the given robot poses and draws the circular footprint with coverage_radius at these positions into the given map.
 	// Used when the server should plan a coverage path for the robot coverage area (a circle). This drawing function does not test occlusions
@@ -61,6 +125,17 @@ public:
 	// ROS-independent coverage check library interface
 	bool checkCoverage(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin, const std::vector<cv::Point3d>& path,
 			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin, const float coverage_radius,
-			const bool check_for_footprint, const bool check_number_of_coverages, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image);
+			const bool check_for_footprint, const bool check_number_of_coverages, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image,
+			const bool check_exact_visibility=false);
+
+	// ROS-independent incremental interface: adds the coverage of the given path to a coverage_map that has been created by
+	// checkCoverage (or is a copy of the map) and, if number_of_coverage_image is not empty, to the number of coverages, so a
+	// trajectory can be checked piece by piece without processing the previous poses again. For the exact visibility check, the
+	// obstacle contours of the map can be extracted once with extractObstacleSegments and passed as obstacle_segments, otherwise
+	// they are extracted from coverage_map in each call.
+	bool updateCoverage(const float map_resolution, const cv::Point2d& map_origin, const std::vector<cv::Point3d>& path,
+			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin, const float coverage_radius,
+			const bool check_for_footprint, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image, const bool check_exact_visibility=false,
+			const ObstacleSegments* obstacle_segments=NULL);
 
 };
@@ -97,6 +97,7 @@
 #include <sensor_msgs/image_encodings.h>
 // specific from this package
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
 #include <ipa_room_exploration/RoomExplorationConfig.h>
 #include <ipa_room_exploration/grid_point_explorator.h>
 #include <ipa_room_exploration/boustrophedon_explorator.h>
@@ -181,6 +182,14 @@ protected:
 	int cell_visiting_order_;		// cell visiting order
 									//   1 = optimal visiting order of the cells determined as TSP problem
 									//   2 = alternative ordering from left to right (measured on y-coordinates of the cells), visits the cells in a more obvious fashion to the human observer (though it is not optimal)
+	std::vector<double> rotation_offsets_;	// in [rad], rotations of the map that are tried for the cell decomposition, added to the rotation of the room's main direction
+	int decomposition_score_;		// criterion for choosing the cell decomposition among the rotation_offsets
+									//   1 = lowest number of cells
+									//   2 = shortest estimated coverage path
+	int search_strategy_;			// search of the paths between the tracks of a cell
+									//   0 = A*
+									//   1 = Jump Point Search (same path lengths, faster in open areas)
+	bool smooth_transition_paths_;	// if true, the paths between the tracks of a cell are shortened to straight lines between their corners
 
 
 	// parameters specific for the neural network explorator, see "A Neural Network Approach to Complete Coverage Path Planning" from Simon X. Yang and Chaomin Luo
@@ -195,6 +204,9 @@ protected:
 	// parameters specific for the convexSPP explorator
 	int cell_size_;				// size of one cell that is used to discretize the free space
 	double delta_theta_;			// sampling angle when creating possible sensing poses in the convexSPP explorator
+	bool use_lp_rounding_start_;	// if true, the rounded LP relaxation of the final set cover problem is used as start solution of the MIP solver
+	double mip_time_limit_;			// maximal time for the branch and bound of the final set cover problem in [s], 0 = no limit
+	double mip_relative_gap_;		// relative gap between the best solution and the lower bound at which the MIP solver stops, 0 = solve to optimality
 
 	// parameters specific for the flowNetwork explorator
 	double curvature_factor_; // double that shows the factor, an arc can be longer than a straight arc when using the flowNetwork explorator
@@ -41,7 +41,8 @@ bool CoverageCheckServer::checkCoverage(ipa_building_msgs::CheckCoverageRequest&
 
 	cv::Mat coverage_map, number_of_coverage_image;
 	bool return_value = checkCoverage(map, request.map_resolution, cv::Point2d(request.map_origin.position.x, request.map_origin.position.y), path,
-			field_of_view, fov_origin, request.coverage_radius, request.check_for_footprint, request.check_number_of_coverages, coverage_map, number_of_coverage_image);
+			field_of_view, fov_origin, request.coverage_radius, request.check_for_footprint, request.check_number_of_coverages, coverage_map, number_of_coverage_image,
+			request.check_exact_visibility);
 
 	// convert the map with the covered area back to the sensor_msgs format
 	ros::Time now = ros::Time::now();
@@ -65,30 +66,52 @@ bool CoverageCheckServer::checkCoverage(ipa_building_msgs::CheckCoverageRequest&
 }
 bool CoverageCheckServer::checkCoverage(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin, const std::vector<cv::Point3d>& path,
 		const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin, const float coverage_radius,
-		const bool check_for_footprint, const bool check_number_of_coverages, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image)
+		const bool check_for_footprint, const bool check_number_of_coverages, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image,
+		const bool check_exact_visibility)
 {
 	// create a map that stores the number of coverages during the execution, if wanted
-	cv::Mat* image_pointer = NULL;
 	if(check_number_of_coverages==true)
 	{
 		number_of_coverage_image = cv::Mat::zeros(map.rows, map.cols, CV_32SC1);
-		image_pointer = &number_of_coverage_image;
 		ROS_INFO("Checking number of coverages.");
 	}
+	else
+		number_of_coverage_image = cv::Mat();
 
-	// check if the coverage check should be done for the footprint or the field of view
 	coverage_map = map.clone();
+	const bool return_value = updateCoverage(map_resolution, map_origin, path, field_of_view, fov_origin, coverage_radius, check_for_footprint,
+			coverage_map, number_of_coverage_image, check_exact_visibility);
+	ROS_INFO("Finished coverage check.");
+
+	return return_value;
+}
+
+bool CoverageCheckServer::updateCoverage(const float map_resolution, const cv::Point2d& map_origin, const std::vector<cv::Point3d>& path,
+		const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin, const float coverage_radius,
+		const bool check_for_footprint, cv::Mat& coverage_map, cv::Mat& number_of_coverage_image, const bool check_exact_visibility,
+		const ObstacleSegments* obstacle_segments)
+{
+	cv::Mat* image_pointer = (number_of_coverage_image.empty()==false ? &number_of_coverage_image : NULL);
+
+	// check if the coverage check should be done for the footprint or the field of view
 	if(check_for_footprint==false)
 	{
-		ROS_INFO("Checking coverage for FOV.");
-		drawCoveredPointsPolygon(coverage_map, path, field_of_view, fov_origin, map_resolution, map_origin, image_pointer);
+		ROS_INFO("Checking coverage for FOV%s.", (check_exact_visibility==true ? " with exact visibility" : ""));
+		// the obstacle contours are extracted once for all poses if they are not provided
+		ObstacleSegments extracted_obstacle_segments;
+		if (check_exact_visibility==true && obstacle_segments==NULL)
+		{
+			extractObstacleSegments(coverage_map, extracted_obstacle_segments);
+			obstacle_segments = &extracted_obstacle_segments;
+		}
+		drawCoveredPointsPolygon(coverage_map, path, field_of_view, fov_origin, map_resolution, map_origin, image_pointer,
+				(check_exact_visibility==true ? obstacle_segments : NULL));
 	}
 	else
 	{
 		ROS_INFO("Checking coverage for footprint.");
 		drawCoveredPointsCircle(coverage_map, path, coverage_radius, map_resolution, map_origin, image_pointer);
 	}
-	ROS_INFO("Finished coverage check.");
 
 	return true;
 }
@@ -96,78 +119,453 @@ bool CoverageCheckServer::checkCoverage(const cv::Mat& map, const float map_reso
 
 void CoverageCheckServer::drawCoveredPointsPolygon(cv::Mat& reachable_areas_map, const std::vector<cv::Point3d>& robot_poses,
 			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
-			const float map_resolution, const cv::Point2d map_origin, cv::Mat* number_of_coverages_image)
+			const float map_resolution, const cv::Point2d map_origin, cv::Mat* number_of_coverages_image, const ObstacleSegments* obstacle_segments)
 {
+	if (robot_poses.size() == 0)
+		return;
+
+	// only the bounding box of the fields of view of all poses is counted and merged, so that a few new poses do not cost the
+	// whole map
 	const float map_resolution_inverse = 1./map_resolution;
+	std::vector<cv::Point> fov_points;
+	cv::Point2d origin;
+	cv::Point origin_point;
+	cv::Rect counts_area = transformFieldOfView(robot_poses[0], field_of_view, fov_origin, map_resolution_inverse, map_origin,
+			reachable_areas_map.rows, reachable_areas_map.cols, fov_points, origin, origin_point);
+	for (size_t i=1; i<robot_poses.size(); ++i)
+		counts_area |= transformFieldOfView(robot_poses[i], field_of_view, fov_origin, map_resolution_inverse, map_origin,
+				reachable_areas_map.rows, reachable_areas_map.cols, fov_points, origin, origin_point);
 
-	// go trough each given robot pose
-	for(std::vector<cv::Point3d>::const_iterator current_pose = robot_poses.begin(); current_pose != robot_poses.end(); ++current_pose)
+	// count the coverages of each pose in parallel, every thread has its own count image, which are summed up afterwards
+	const int number_of_threads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)robot_poses.size()/16));
+	std::vector<cv::Mat> coverage_counts(number_of_threads);
+	PoseQueue pose_queue;
+	for (int t=0; t<number_of_threads; ++t)
+		coverage_counts[t] = cv::Mat::zeros(counts_area.height, counts_area.width, CV_32SC1);
+	if (number_of_threads == 1)
+		countCoveredPointsPolygon(reachable_areas_map, robot_poses, field_of_view, fov_origin, map_resolution, map_origin,
+				coverage_counts[0], counts_area, pose_queue, obstacle_segments);
+	else
 	{
-		// get the rotation matrix
-		float sin_theta = std::sin(current_pose->z);
-		float cos_theta = std::cos(current_pose->z);
-		Eigen::Matrix<float, 2, 2> R;
-		R << cos_theta, -sin_theta, sin_theta, cos_theta;
-
-		// current pose as Eigen matrix
-		Eigen::Matrix<float, 2, 1> pose_as_matrix;
-		pose_as_matrix << current_pose->x, current_pose->y;
+		boost::thread_group threads;
+		for (int t=0; t<number_of_threads; ++t)
+			threads.create_thread([&, t]() { countCoveredPointsPolygon(reachable_areas_map, robot_poses, field_of_view, fov_origin, map_resolution, map_origin,
+					coverage_counts[t], counts_area, pose_queue, obstacle_segments); });
+		threads.join_all();
+		for (int t=1; t<number_of_threads; ++t)
+			coverage_counts[0] += coverage_counts[t];
+	}
 
-		// transform field of view points
-		std::vector<cv::Point> transformed_fov_points;
-		for(size_t point = 0; point < field_of_view.size(); ++point)
+	// mark the visible points in the map and, if wanted, count the coverages
+	for (int v=0; v<counts_area.height; ++v)
+	{
+		const int* count_row = coverage_counts[0].ptr<int>(v);
+		for (int u=0; u<counts_area.width; ++u)
 		{
-			// linear transformation
-			const Eigen::Matrix<float, 2, 1> transformed_fov_point = pose_as_matrix + R * field_of_view[point];
+			const int count = count_row[u];
+			if (count == 0)
+				continue;
+			reachable_areas_map.at<uchar>(v+counts_area.y, u+counts_area.x) = 127;
+			if(number_of_coverages_image!=NULL)
+				number_of_coverages_image->at<int>(v+counts_area.y, u+counts_area.x) += count;
+		}
+	}
+}
+
+
+cv::Rect CoverageCheckServer::transformFieldOfView(const cv::Point3d& pose, const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view,
+		const Eigen::Matrix<float, 2, 1>& fov_origin, const float map_resolution_inverse, const cv::Point2d& map_origin, const int rows,
+		const int cols, std::vector<cv::Point>& fov_points, cv::Point2d& origin, cv::Point& origin_point)
+{
+	// get the rotation matrix
+	float sin_theta = std::sin(pose.z);
+	float cos_theta = std::cos(pose.z);
+	Eigen::Matrix<float, 2, 2> R;
+	R << cos_theta, -sin_theta, sin_theta, cos_theta;
+
+	// current pose as Eigen matrix
+	Eigen::Matrix<float, 2, 1> pose_as_matrix;
+	pose_as_matrix << pose.x, pose.y;
+
+	// transform field of view points
+	fov_points.clear();
+	for(size_t point = 0; point < field_of_view.size(); ++point)
+	{
+		// linear transformation
+		const Eigen::Matrix<float, 2, 1> transformed_fov_point = pose_as_matrix + R * field_of_view[point];
+
+		// save the transformed point as cv::Point, also check if map borders are satisfied and transform it into pixel values
+		fov_points.push_back(clampImageCoordinates(cv::Point((transformed_fov_point(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_point(1, 0)-map_origin.y)*map_resolution_inverse), rows, cols));
+	}
+
+	// transform field of view origin
+	const Eigen::Matrix<float, 2, 1> transformed_fov_origin = pose_as_matrix + R * fov_origin;
+	origin = cv::Point2d((transformed_fov_origin(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_origin(1, 0)-map_origin.y)*map_resolution_inverse);
+	origin_point = clampImageCoordinates(cv::Point(origin.x, origin.y), rows, cols);
+
+	// area that contains the field of view and its origin
+	std::vector<cv::Point> area_points = fov_points;
+	area_points.push_back(origin_point);
+	return cv::boundingRect(area_points);
+}
+
 
-			// save the transformed point as cv::Point, also check if map borders are satisfied and transform it into pixel values
-			transformed_fov_points.push_back(clampImageCoordinates(cv::Point((transformed_fov_point(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_point(1, 0)-map_origin.y)*map_resolution_inverse), reachable_areas_map.rows, reachable_areas_map.cols));
+void CoverageCheckServer::countCoveredPointsPolygon(const cv::Mat& map, const std::vector<cv::Point3d>& robot_poses,
+			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
+			const float map_resolution, const cv::Point2d map_origin, cv::Mat& coverage_counts, const cv::Rect& counts_area,
+			PoseQueue& pose_queue, const ObstacleSegments* obstacle_segments)
+{
+	const float map_resolution_inverse = 1./map_resolution;
+
+	// scratch buffers of this thread, they grow to the largest area that has been processed and are reused for all poses
+	cv::Mat fov_buffer, visibility_buffer;
+	std::vector<int> segment_stamps;
+	int stamp = 0;
+	std::vector<cv::Point2d> visibility_polygon;
+
+	while (true)
+	{
+		size_t pose_index = 0;
+		{
+			boost::mutex::scoped_lock lock(pose_queue.mutex);
+			pose_index = pose_queue.next_pose++;
 		}
+		if (pose_index >= robot_poses.size())
+			return;
 
-		// transform field of view origin
-		const Eigen::Matrix<float, 2, 1> transformed_fov_origin = pose_as_matrix + R * fov_origin;
-		const cv::Point transformed_fov_origin_point = clampImageCoordinates(cv::Point((transformed_fov_origin(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_origin(1, 0)-map_origin.y)*map_resolution_inverse), reachable_areas_map.rows, reachable_areas_map.cols);
+		// field of view of the pose in map cells and the area that contains it and its origin
+		std::vector<cv::Point> transformed_fov_points;
+		cv::Point2d origin;
+		cv::Point transformed_fov_origin_point;
+		const cv::Rect area = transformFieldOfView(robot_poses[pose_index], field_of_view, fov_origin, map_resolution_inverse, map_origin,
+				map.rows, map.cols, transformed_fov_points, origin, transformed_fov_origin_point);
+		if (fov_buffer.rows < area.height || fov_buffer.cols < area.width)
+		{
+			fov_buffer.create(std::max(fov_buffer.rows, area.height), std::max(fov_buffer.cols, area.width), CV_8UC1);
+			visibility_buffer.create(fov_buffer.rows, fov_buffer.cols, CV_8UC1);
+		}
+		cv::Mat fov_mat = fov_buffer(cv::Rect(0, 0, area.width, area.height));
+		cv::Mat visibility = visibility_buffer(cv::Rect(0, 0, area.width, area.height));
 
-		// draw current field of view in map
-		cv::Mat fov_mat = cv::Mat::zeros(reachable_areas_map.rows, reachable_areas_map.cols, reachable_areas_map.type());
+		// draw current field of view into the area
+		fov_mat.setTo(cv::Scalar(0));
 		std::vector<std::vector<cv::Point> > contours(1, transformed_fov_points);
-		cv::drawContours(fov_mat, contours, 0, cv::Scalar(255), CV_FILLED);
+		cv::drawContours(fov_mat, contours, 0, cv::Scalar(255), CV_FILLED, 8, cv::noArray(), INT_MAX, -area.tl());
 
-		// check visibility for each pixel of the fov area
-		for (int v=0; v<fov_mat.rows; ++v)
+		// check visibility for each pixel of the fov area and count the visible ones
+		if (obstacle_segments == NULL)
+			computeVisibility(map, transformed_fov_origin_point, area, visibility);
+		else
 		{
-			for (int u=0; u<fov_mat.cols; ++u)
-			{
-				if (fov_mat.at<uchar>(v,u)==0)
-					continue;
+			// exact field of view origin in cell corner coordinates (inside the origin cell, not on a cell border)
+			origin.x = std::min(std::max(origin.x, transformed_fov_origin_point.x+1e-3), transformed_fov_origin_point.x+1.-1e-3);
+			origin.y = std::min(std::max(origin.y, transformed_fov_origin_point.y+1e-3), transformed_fov_origin_point.y+1.-1e-3);
 
-				// create a line iterator from fov_origin to current fov point and verify visibility
-				bool point_visible = true;
-				const cv::Point current_goal(u,v);
-				cv::LineIterator ray_points(reachable_areas_map, transformed_fov_origin_point, current_goal, 8, false);
-				for(size_t point = 0; point < ray_points.count; ++point, ++ray_points)
+			// draw the visibility polygon, the cells whose centers lie inside are visible, cells of the polygon in pixel
+			// center coordinates of the area with 8 fractional bits
+			visibility.setTo(cv::Scalar(0));
+			if (map.at<uchar>(transformed_fov_origin_point) != 0)
+			{
+				computeVisibilityPolygon(*obstacle_segments, origin, area, segment_stamps, stamp, visibility_polygon);
+				std::vector<cv::Point> polygon_points(visibility_polygon.size());
+				for (size_t i=0; i<visibility_polygon.size(); ++i)
+					polygon_points[i] = cv::Point(cvRound((visibility_polygon[i].x-area.x-0.5)*256.), cvRound((visibility_polygon[i].y-area.y-0.5)*256.));
+				std::vector<std::vector<cv::Point> > polygons(1, polygon_points);
+				cv::fillPoly(visibility, polygons, cv::Scalar(255), 8, 8);
+				// the border of the polygon may touch occupied cells
+				for (int v=0; v<area.height; ++v)
 				{
-					if (reachable_areas_map.at<uchar>(ray_points.pos()) == 0)
-					{
-						point_visible = false;
-						break;
-					}
+					uchar* visibility_row = visibility.ptr<uchar>(v);
+					const uchar* map_row = map.ptr<uchar>(v+area.y) + area.x;
+					for (int u=0; u<area.width; ++u)
+						if (map_row[u] == 0)
+							visibility_row[u] = 0;
 				}
+			}
+		}
+		for (int v=0; v<area.height; ++v)
+		{
+			const uchar* fov_row = fov_mat.ptr<uchar>(v);
+			const uchar* visibility_row = visibility.ptr<uchar>(v);
+			int* count_row = coverage_counts.ptr<int>(v+area.y-counts_area.y) + area.x-counts_area.x;
+			for (int u=0; u<area.width; ++u)
+				if (fov_row[u]!=0 && visibility_row[u]!=0)
+					++count_row[u];
+		}
+	}
+}
 
-				// mark visible point in map
-				if (point_visible == true)
-				{
-					reachable_areas_map.at<uchar>(current_goal) = 127;
 
-					// if wanted, count the coverage
-					if(number_of_coverages_image!=NULL)
-					{
-						number_of_coverages_image->at<int>(current_goal) = number_of_coverages_image->at<int>(current_goal)+1;
-					}
-				}
+void CoverageCheckServer::computeVisibility(const cv::Mat& map, const cv::Point& origin, const cv::Rect& area, cv::Mat& visibility)
+{
+	// origin in area coordinates
+	const int ox = origin.x - area.x;
+	const int oy = origin.y - area.y;
+	visibility.at<uchar>(oy, ox) = (map.at<uchar>(origin) != 0 ? 255 : 0);
+
+	// a cell is visible if it is free and the cell before it on the line from the origin is visible, this cell is one step back
+	// along the major axis with the minor coordinate rounded from the line
+	auto update_cell = [&](const int x, const int y, const int d)
+	{
+		const int dx = x-ox, dy = y-oy;
+		int px = x, py = y;
+		if (std::abs(dx) >= std::abs(dy))
+		{
+			px = x - (dx>0 ? 1 : -1);
+			py = oy + (int)std::floor((double)dy*(d-1)/d + 0.5);
+		}
+		else
+		{
+			py = y - (dy>0 ? 1 : -1);
+			px = ox + (int)std::floor((double)dx*(d-1)/d + 0.5);
+		}
+		visibility.at<uchar>(y, x) = (visibility.at<uchar>(py, px)!=0 && map.at<uchar>(y+area.y, x+area.x)!=0 ? 255 : 0);
+	};
+
+	// visit the rings of growing (chessboard) distance d around the origin, the cell before a cell lies on the previous ring
+	const int max_distance = std::max(std::max(ox, area.width-1-ox), std::max(oy, area.height-1-oy));
+	for (int d=1; d<=max_distance; ++d)
+	{
+		const int min_x = std::max(0, ox-d), max_x = std::min(area.width-1, ox+d);
+		const int min_y = std::max(0, oy-d+1), max_y = std::min(area.height-1, oy+d-1);
+		// top and bottom row of the ring
+		if (oy-d >= 0)
+			for (int x=min_x; x<=max_x; ++x)
+				update_cell(x, oy-d, d);
+		if (oy+d < area.height)
+			for (int x=min_x; x<=max_x; ++x)
+				update_cell(x, oy+d, d);
+		// left and right column of the ring
+		if (ox-d >= 0)
+			for (int y=min_y; y<=max_y; ++y)
+				update_cell(ox-d, y, d);
+		if (ox+d < area.width)
+			for (int y=min_y; y<=max_y; ++y)
+				update_cell(ox+d, y, d);
+	}
+}
+
+
+void CoverageCheckServer::extractObstacleSegments(const cv::Mat& map, ObstacleSegments& obstacle_segments)
+{
+	obstacle_segments.segments.clear();
+
+	// occupancy of a cell, the area outside of the map is occupied
+	auto occupied = [&map](const int u, const int v) -> bool
+	{
+		return (u<0 || v<0 || u>=map.cols || v>=map.rows || map.at<uchar>(v,u)==0);
+	};
+
+	// horizontal segments: borders between the cells (u,v-1) and (u,v), neighboring borders are joined to one segment, a
+	// segment is split where a vertical border crosses it (diagonal cells), so that no two segments cross each other
+	for (int v=0; v<=map.rows; ++v)
+	{
+		int start = -1;
+		for (int u=0; u<=map.cols; ++u)
+		{
+			const bool border = (u<map.cols && occupied(u,v-1)!=occupied(u,v));
+			if (border==true && start<0)
+				start = u;
+			else if (border==false && start>=0)
+			{
+				obstacle_segments.segments.push_back(cv::Vec4i(start, v, u, v));
+				start = -1;
+			}
+			else if (border==true && occupied(u-1,v-1)!=occupied(u,v-1) && occupied(u-1,v)!=occupied(u,v))
+			{
+				obstacle_segments.segments.push_back(cv::Vec4i(start, v, u, v));
+				start = u;
+			}
+		}
+	}
+
+	// vertical segments: borders between the cells (u-1,v) and (u,v)
+	for (int u=0; u<=map.cols; ++u)
+	{
+		int start = -1;
+		for (int v=0; v<=map.rows; ++v)
+		{
+			const bool border = (v<map.rows && occupied(u-1,v)!=occupied(u,v));
+			if (border==true && start<0)
+				start = v;
+			else if (border==false && start>=0)
+			{
+				obstacle_segments.segments.push_back(cv::Vec4i(u, start, u, v));
+				start = -1;
+			}
+		}
+	}
+
+	// sort the segments into the buckets that they touch
+	obstacle_segments.bucket_size = 32;
+	obstacle_segments.buckets_x = map.cols/obstacle_segments.bucket_size + 1;
+	obstacle_segments.buckets_y = map.rows/obstacle_segments.bucket_size + 1;
+	obstacle_segments.buckets.assign(obstacle_segments.buckets_x*obstacle_segments.buckets_y, std::vector<int>());
+	for (size_t i=0; i<obstacle_segments.segments.size(); ++i)
+	{
+		const cv::Vec4i& segment = obstacle_segments.segments[i];
+		for (int by=segment[1]/obstacle_segments.bucket_size; by<=std::min(segment[3]/obstacle_segments.bucket_size, obstacle_segments.buckets_y-1); ++by)
+			for (int bx=segment[0]/obstacle_segments.bucket_size; bx<=std::min(segment[2]/obstacle_segments.bucket_size, obstacle_segments.buckets_x-1); ++bx)
+				obstacle_segments.buckets[by*obstacle_segments.buckets_x + bx].push_back(i);
+	}
+}
+
+
+void CoverageCheckServer::computeVisibilityPolygon(const ObstacleSegments& obstacle_segments, const cv::Point2d& origin, const cv::Rect& area,
+		std::vector<int>& segment_stamps, int& stamp, std::vector<cv::Point2d>& visibility_polygon)
+{
+	visibility_polygon.clear();
+	if (segment_stamps.size() != obstacle_segments.segments.size())
+	{
+		segment_stamps.assign(obstacle_segments.segments.size(), 0);
+		stamp = 0;
+	}
+	++stamp;
+
+	// collect the segments of the area, clipped to the area, and the borders of the area, the obstacle segments on the border
+	// lines of the area are covered by the borders
+	const int min_x = area.x, max_x = area.x+area.width, min_y = area.y, max_y = area.y+area.height;
+	std::vector<cv::Vec4i> segments;
+	segments.push_back(cv::Vec4i(min_x, min_y, max_x, min_y));
+	segments.push_back(cv::Vec4i(min_x, max_y, max_x, max_y));
+	segments.push_back(cv::Vec4i(min_x, min_y, min_x, max_y));
+	segments.push_back(cv::Vec4i(max_x, min_y, max_x, max_y));
+	for (int by=min_y/obstacle_segments.bucket_size; by<=std::min(max_y/obstacle_segments.bucket_size, obstacle_segments.buckets_y-1); ++by)
+	{
+		for (int bx=min_x/obstacle_segments.bucket_size; bx<=std::min(max_x/obstacle_segments.bucket_size, obstacle_segments.buckets_x-1); ++bx)
+		{
+			const std::vector<int>& bucket = obstacle_segments.buckets[by*obstacle_segments.buckets_x + bx];
+			for (size_t i=0; i<bucket.size(); ++i)
+			{
+				if (segment_stamps[bucket[i]] == stamp)
+					continue;
+				segment_stamps[bucket[i]] = stamp;
+				const cv::Vec4i& segment = obstacle_segments.segments[bucket[i]];
+				const cv::Vec4i clipped(std::max(segment[0], min_x), std::max(segment[1], min_y), std::min(segment[2], max_x), std::min(segment[3], max_y));
+				if (clipped[0] > clipped[2] || clipped[1] > clipped[3])
+					continue;
+				if (clipped[1] == clipped[3] && clipped[0] < clipped[2] && clipped[1] != min_y && clipped[1] != max_y)
+					segments.push_back(clipped);
+				else if (clipped[0] == clipped[2] && clipped[1] < clipped[3] && clipped[0] != min_x && clipped[0] != max_x)
+					segments.push_back(clipped);
 			}
 		}
 	}
+
+	// every segment covers an angle interval [start_angle, end_angle] as seen from the origin, the sweep runs from -pi to pi, so
+	// the vertical segments that cross the ray in negative x direction are split at this ray (the origin lies inside a cell, so
+	// no other segment touches this ray and no segment lies on a line through the origin)
+	struct SweepSegment
+	{
+		cv::Point2d start, end;		// end points at start_angle and end_angle
+		double start_angle, end_angle;
+		bool horizontal;
+	};
+	std::vector<SweepSegment> sweep_segments;
+	sweep_segments.reserve(segments.size()+1);
+	auto add_sweep_segment = [&](const cv::Point2d& p1, const double angle1, const cv::Point2d& p2, const double angle2, const bool horizontal)
+	{
+		SweepSegment segment;
+		segment.horizontal = horizontal;
+		if (angle1 <= angle2)
+		{
+			segment.start = p1; segment.start_angle = angle1;
+			segment.end = p2; segment.end_angle = angle2;
+		}
+		else
+		{
+			segment.start = p2; segment.start_angle = angle2;
+			segment.end = p1; segment.end_angle = angle1;
+		}
+		if (segment.end_angle-segment.start_angle > 1e-12)
+			sweep_segments.push_back(segment);
+	};
+	for (size_t s=0; s<segments.size(); ++s)
+	{
+		const cv::Point2d p1(segments[s][0], segments[s][1]), p2(segments[s][2], segments[s][3]);
+		const bool horizontal = (segments[s][1] == segments[s][3]);
+		if (horizontal==false && p1.x<origin.x && p1.y<origin.y && p2.y>origin.y)
+		{
+			const cv::Point2d split(p1.x, origin.y);
+			add_sweep_segment(split, -CV_PI, p1, std::atan2(p1.y-origin.y, p1.x-origin.x), false);
+			add_sweep_segment(p2, std::atan2(p2.y-origin.y, p2.x-origin.x), split, CV_PI, false);
+		}
+		else
+			add_sweep_segment(p1, std::atan2(p1.y-origin.y, p1.x-origin.x), p2, std::atan2(p2.y-origin.y, p2.x-origin.x), horizontal);
+	}
+
+	// events of the sweep: the start (first) and the end (second = true) of each segment, sorted by angle
+	std::vector<std::pair<double, std::pair<bool, int> > > events;
+	events.reserve(2*sweep_segments.size());
+	for (size_t s=0; s<sweep_segments.size(); ++s)
+	{
+		events.push_back(std::make_pair(sweep_segments[s].start_angle, std::make_pair(false, (int)s)));
+		events.push_back(std::make_pair(sweep_segments[s].end_angle, std::make_pair(true, (int)s)));
+	}
+	std::sort(events.begin(), events.end());
+
+	// the segments that the current ray crosses, ordered by their distance along the ray, the segments do not cross each other
+	// (see extractObstacleSegments), so this order is the same for all rays that cross them and it is evaluated on the ray
+	// between the current and the next event angle, where all active segments are crossed
+	double ray_cos = 1., ray_sin = 0.;
+	auto ray_distance = [&](const int s) -> double
+	{
+		const SweepSegment& segment = sweep_segments[s];
+		return (segment.horizontal==true ? (segment.start.y-origin.y)/ray_sin : (segment.start.x-origin.x)/ray_cos);
+	};
+	auto closer = [&](const int a, const int b) -> bool
+	{
+		const double distance_a = ray_distance(a), distance_b = ray_distance(b);
+		return (distance_a < distance_b || (distance_a == distance_b && a < b));
+	};
+	std::set<int, std::function<bool(const int, const int)> > active_segments(closer);
+	std::vector<std::set<int, std::function<bool(const int, const int)> >::iterator> active_positions(sweep_segments.size());
+
+	// point of segment s on the ray with the given angle
+	auto hit_point = [&](const int s, const double angle) -> cv::Point2d
+	{
+		const SweepSegment& segment = sweep_segments[s];
+		const double dx = std::cos(angle), dy = std::sin(angle);
+		if (segment.horizontal == true)
+		{
+			const double x = origin.x + (segment.start.y-origin.y)/dy*dx;
+			return cv::Point2d(std::min(std::max(x, std::min(segment.start.x, segment.end.x)), std::max(segment.start.x, segment.end.x)), segment.start.y);
+		}
+		const double y = origin.y + (segment.start.x-origin.x)/dx*dy;
+		return cv::Point2d(segment.start.x, std::min(std::max(y, std::min(segment.start.y, segment.end.y)), std::max(segment.start.y, segment.end.y)));
+	};
+
+	// sweep over the events, the visibility polygon gets a corner wherever the closest segment changes: the end of the visible
+	// part of the previous closest segment and the beginning of the visible part of the new one
+	size_t event = 0;
+	while (event < events.size())
+	{
+		const double angle = events[event].first;
+		size_t group_end = event;
+		while (group_end<events.size() && events[group_end].first-angle<1e-12)
+			++group_end;
+		const int closest_before = (active_segments.empty()==true ? -1 : *active_segments.begin());
+
+		for (size_t e=event; e<group_end; ++e)
+			if (events[e].second.first == true)
+				active_segments.erase(active_positions[events[e].second.second]);
+		const double ray_angle = 0.5*(angle + (group_end<events.size() ? events[group_end].first : CV_PI));
+		ray_cos = std::cos(ray_angle);
+		ray_sin = std::sin(ray_angle);
+		for (size_t e=event; e<group_end; ++e)
+			if (events[e].second.first == false)
+				active_positions[events[e].second.second] = active_segments.insert(events[e].second.second).first;
+
+		const int closest_after = (active_segments.empty()==true ? -1 : *active_segments.begin());
+		if (closest_before != closest_after)
+		{
+			if (closest_before >= 0)
+				visibility_polygon.push_back(hit_point(closest_before, angle));
+			if (closest_after >= 0)
+				visibility_polygon.push_back(hit_point(closest_after, angle));
+		}
+		event = group_end;
+	}
 }
 
 
@@ -177,29 +575,57 @@ void CoverageCheckServer::drawCoveredPointsCircle(cv::Mat& reachable_areas_map,
 {
 	const float map_resolution_inverse = 1./map_resolution;
 
-	cv::Mat map_copy = reachable_areas_map.clone(); // copy to draw positions that get later drawn into free space of the original map
 	const int coverage_radius_pixel = coverage_radius*map_resolution_inverse;
-	// iterate trough all poses and draw them into the given map
-	for(std::vector<cv::Point3d>::const_iterator pose=robot_poses.begin(); pose!=robot_poses.end(); ++pose)
+	const cv::Rect map_area(0, 0, reachable_areas_map.cols, reachable_areas_map.rows);
+
+	// only the bounding box of the footprints is drawn and merged into the map
+	std::vector<cv::Point> points(robot_poses.size());
+	std::vector<cv::Rect> areas(robot_poses.size());
+	cv::Rect covered_area;
+	for (size_t i=0; i<robot_poses.size(); ++i)
+	{
+		points[i] = cv::Point((robot_poses[i].x-map_origin.x)*map_resolution_inverse, (robot_poses[i].y-map_origin.y)*map_resolution_inverse);
+		areas[i] = cv::Rect(points[i].x-coverage_radius_pixel, points[i].y-coverage_radius_pixel, 2*coverage_radius_pixel+1, 2*coverage_radius_pixel+1) & map_area;
+		if (areas[i].width<=0 || areas[i].height<=0)
+			continue;
+		if (covered_area.width<=0 || covered_area.height<=0)
+			covered_area = areas[i];
+		else
+			covered_area |= areas[i];
+	}
+	if (covered_area.width<=0 || covered_area.height<=0)
+		return;
+
+	// iterate trough all poses and draw them into the footprint image of the covered area
+	cv::Mat footprints = cv::Mat::zeros(covered_area.height, covered_area.width, CV_8UC1);
+	for (size_t i=0; i<robot_poses.size(); ++i)
 	{
 		// draw the transformed robot footprint
-		cv::Point current_point((pose->x-map_origin.x)*map_resolution_inverse, (pose->y-map_origin.y)*map_resolution_inverse);
-		cv::circle(map_copy, current_point, coverage_radius_pixel, cv::Scalar(127), -1);
+		cv::circle(footprints, points[i]-covered_area.tl(), coverage_radius_pixel, cv::Scalar(127), -1);
 
-		// update the number of visits at this location, if wanted
+		// update the number of visits at this location, if wanted, only the bounding box of the circle is drawn and counted
 		if(number_of_coverages_image!=NULL)
 		{
-			cv::Mat coverage_area = cv::Mat::zeros(map_copy.rows, map_copy.cols, CV_32SC1);
-			cv::circle(coverage_area, current_point, coverage_radius_pixel, cv::Scalar(1), -1);
-			*number_of_coverages_image = *number_of_coverages_image + coverage_area;
+			const cv::Rect& area = areas[i];
+			if (area.width<=0 || area.height<=0)
+				continue;
+			cv::Mat coverage_area = cv::Mat::zeros(area.height, area.width, CV_8UC1);
+			cv::circle(coverage_area, points[i]-area.tl(), coverage_radius_pixel, cv::Scalar(1), -1);
+			for (int v=0; v<area.height; ++v)
+				for (int u=0; u<area.width; ++u)
+					number_of_coverages_image->at<int>(v+area.y, u+area.x) += coverage_area.at<uchar>(v,u);
 		}
 	}
 
 	// draw visited areas into free space of the original map
-	for(size_t y=0; y<map_copy.rows; ++y)
-		for(size_t x=0; x<map_copy.cols; ++x)
-			if(reachable_areas_map.at<uchar>(y, x) == 255)
-				reachable_areas_map.at<uchar>(y, x) = map_copy.at<uchar>(y, x);
+	for (int v=0; v<covered_area.height; ++v)
+	{
+		const uchar* footprints_row = footprints.ptr<uchar>(v);
+		uchar* map_row = reachable_areas_map.ptr<uchar>(v+covered_area.y) + covered_area.x;
+		for (int u=0; u<covered_area.width; ++u)
+			if (map_row[u] == 255 && footprints_row[u] != 0)
+				map_row[u] = 127;
+	}
 }
 
 
@@ -83,6 +83,43 @@
 #include <opencv2/opencv.hpp>
 
 
+// Trajectory with a bounded number of poses: a pose is only stored if the robot has moved at least min_distance or turned at
+// least min_angle since the last stored pose, and if max_size poses are stored every second pose is dropped, so the trajectory
+// keeps its full extent with a lower resolution.
+struct DecimatedTrajectory
+{
+	DecimatedTrajectory() : min_distance(0.05), min_angle(0.1), max_size(100000) {}
+
+	// returns true if pose has been stored
+	bool add(const tf::StampedTransform& pose)
+	{
+		if (poses.size() > 0)
+		{
+			const tf::StampedTransform& last_pose = poses.back();
+			const double distance = (pose.getOrigin()-last_pose.getOrigin()).length();
+			const double angle = std::fabs(tf::getYaw(pose.getRotation()) - tf::getYaw(last_pose.getRotation()));
+			if (distance < min_distance && std::min(angle, 2.*CV_PI-angle) < min_angle)
+				return false;
+		}
+		if (poses.size() >= max_size && max_size > 1)
+		{
+			// keep every second pose, starting with the first one
+			size_t kept = 1;
+			for (size_t i=2; i<poses.size(); i+=2, ++kept)
+				poses[kept] = poses[i];
+			poses.resize(kept);
+		}
+		poses.push_back(pose);
+		return true;
+	}
+
+	std::vector<tf::StampedTransform> poses;
+	double min_distance;		// in [m]
+	double min_angle;			// in [rad]
+	size_t max_size;
+};
+
+
 class CoverageMonitor
 {
 public:
@@ -109,6 +146,16 @@ public:
 			coverage_circle_offset_transform_.setOrigin(tf::Vector3(0.29035, -0.114, 0.));
 		node_handle_.param("robot_trajectory_recording_active", robot_trajectory_recording_active_, false);
 		std::cout << "coverage_monitor/robot_trajectory_recording_active = " << robot_trajectory_recording_active_ << std::endl;
+		double trajectory_min_distance = 0.05, trajectory_min_angle = 0.1;
+		int trajectory_max_size = 100000;
+		node_handle_.param("trajectory_min_distance", trajectory_min_distance, trajectory_min_distance);
+		std::cout << "coverage_monitor/trajectory_min_distance = " << trajectory_min_distance << std::endl;
+		node_handle_.param("trajectory_min_angle", trajectory_min_angle, trajectory_min_angle);
+		std::cout << "coverage_monitor/trajectory_min_angle = " << trajectory_min_angle << std::endl;
+		node_handle_.param("trajectory_max_size", trajectory_max_size, trajectory_max_size);
+		std::cout << "coverage_monitor/trajectory_max_size = " << trajectory_max_size << std::endl;
+		setTrajectoryDecimation(trajectory_min_distance, trajectory_min_angle, trajectory_max_size);
+		coverage_images_available_ = false;
 
 		// setup publishers and subscribers
 		coverage_marker_pub_ = node_handle_.advertise<visualization_msgs::Marker>("coverage_marker", 1);
@@ -239,10 +286,16 @@ public:
 				{
 					tf::StampedTransform transform;
 					transform_listener_.lookupTransform(map_frame_, robot_frame_, time, transform);
+
+					// store the pose and add its coverage to the coverage images, if they have already been requested
+					boost::mutex::scoped_lock coverage_lock(coverage_mutex_);
+					bool pose_stored = false;
 					{
 						boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
-						robot_trajectory_vector_.push_back(transform);
+						pose_stored = robot_trajectory_.add(transform);
 					}
+					if (pose_stored == true && coverage_images_available_ == true)
+						updateCoverageImages(std::vector<tf::StampedTransform>(1, transform));
 				}
 //				// this can be used for testing if no data is available
 //				tf::StampedTransform transform(tf::Transform(tf::Quaternion(0, 0, 0, 1), tf::Vector3(0.1*index, 0., 0.)), ros::Time::now(), map_frame_, robot_frame_);
@@ -253,10 +306,15 @@ public:
 			}
 
 			// update and publish coverage_marker_msg
-			coverage_marker_msg.header.stamp = ros::Time::now();
-			coverage_marker_msg.points.resize(robot_trajectory_vector_.size());
-			for (size_t i=0; i<robot_trajectory_vector_.size(); ++i)
-				tf::pointTFToMsg((robot_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), coverage_marker_msg.points[i]);
+			{
+				// secure this access with a mutex
+				boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
+
+				coverage_marker_msg.header.stamp = ros::Time::now();
+				coverage_marker_msg.points.resize(robot_trajectory_.poses.size());
+				for (size_t i=0; i<robot_trajectory_.poses.size(); ++i)
+					tf::pointTFToMsg((robot_trajectory_.poses[i]*coverage_circle_offset_transform_).getOrigin(), coverage_marker_msg.points[i]);
+			}
 			coverage_marker_pub_.publish(coverage_marker_msg);
 
 			// update and publish computed_trajectory_marker_msg
@@ -265,9 +323,9 @@ public:
 				boost::mutex::scoped_lock lock(robot_computed_trajectory_vector_mutex_);
 
 				computed_trajectory_marker_msg.header.stamp = ros::Time::now();
-				computed_trajectory_marker_msg.points.resize(robot_computed_trajectory_vector_.size());
-				for (size_t i=0; i<robot_computed_trajectory_vector_.size(); ++i)
-					tf::pointTFToMsg((robot_computed_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), computed_trajectory_marker_msg.points[i]);
+				computed_trajectory_marker_msg.points.resize(robot_computed_trajectory_.poses.size());
+				for (size_t i=0; i<robot_computed_trajectory_.poses.size(); ++i)
+					tf::pointTFToMsg((robot_computed_trajectory_.poses[i]*coverage_circle_offset_transform_).getOrigin(), computed_trajectory_marker_msg.points[i]);
 			}
 			computed_trajectory_marker_pub_.publish(computed_trajectory_marker_msg);
 
@@ -277,9 +335,9 @@ public:
 				boost::mutex::scoped_lock lock(robot_commanded_trajectory_vector_mutex_);
 
 				commanded_trajectory_marker_msg.header.stamp = ros::Time::now();
-				commanded_trajectory_marker_msg.points.resize(robot_commanded_trajectory_vector_.size());
-				for (size_t i=0; i<robot_commanded_trajectory_vector_.size(); ++i)
-					tf::pointTFToMsg((robot_commanded_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), commanded_trajectory_marker_msg.points[i]);
+				commanded_trajectory_marker_msg.points.resize(robot_commanded_trajectory_.poses.size());
+				for (size_t i=0; i<robot_commanded_trajectory_.poses.size(); ++i)
+					tf::pointTFToMsg((robot_commanded_trajectory_.poses[i]*coverage_circle_offset_transform_).getOrigin(), commanded_trajectory_marker_msg.points[i]);
 			}
 			commanded_trajectory_marker_pub_.publish(commanded_trajectory_marker_msg);
 
@@ -295,7 +353,7 @@ public:
 		{
 			// secure this access with a mutex
 			boost::mutex::scoped_lock lock(robot_computed_trajectory_vector_mutex_);
-			robot_computed_trajectory_vector_.push_back(transform);
+			robot_computed_trajectory_.add(transform);
 		}
 	}
 
@@ -307,7 +365,7 @@ public:
 		{
 			// secure this access with a mutex
 			boost::mutex::scoped_lock lock(robot_commanded_trajectory_vector_mutex_);
-			robot_commanded_trajectory_vector_.push_back(transform);
+			robot_commanded_trajectory_.add(transform);
 		}
 	}
 
@@ -368,55 +426,129 @@ public:
 		robot_trajectory_recording_active_ = config.robot_trajectory_recording_active;
 		std::cout << "coverage_monitor/robot_trajectory_recording_active_ = " << robot_trajectory_recording_active_ << std::endl;
 
+		setTrajectoryDecimation(config.trajectory_min_distance, config.trajectory_min_angle, config.trajectory_max_size);
+		std::cout << "coverage_monitor/trajectory_min_distance = " << config.trajectory_min_distance << std::endl;
+		std::cout << "coverage_monitor/trajectory_min_angle = " << config.trajectory_min_angle << std::endl;
+		std::cout << "coverage_monitor/trajectory_max_size = " << config.trajectory_max_size << std::endl;
+
 		std::cout << "######################################################################################" << std::endl;
 	}
 
+	// sets the decimation of all stored trajectories
+	void setTrajectoryDecimation(const double min_distance, const double min_angle, const int max_size)
+	{
+		DecimatedTrajectory* trajectories[3] = {&robot_trajectory_, &robot_computed_trajectory_, &robot_commanded_trajectory_};
+		boost::mutex* mutexes[3] = {&robot_trajectory_vector_mutex_, &robot_computed_trajectory_vector_mutex_, &robot_commanded_trajectory_vector_mutex_};
+		for (int i=0; i<3; ++i)
+		{
+			boost::mutex::scoped_lock lock(*mutexes[i]);
+			trajectories[i]->min_distance = min_distance;
+			trajectories[i]->min_angle = min_angle;
+			trajectories[i]->max_size = std::max(2, max_size);
+		}
+	}
+
+	// The coverage of the robot trajectory is accumulated in coverage_map_ and number_of_coverage_image_ while the poses arrive, so
+	// a request only has to copy the images. The images are (re)computed from the stored trajectory when the map or the coverage
+	// settings of a request differ from the previous request.
 	bool getCoverageImageCallback(ipa_building_msgs::CheckCoverage::Request &req, ipa_building_msgs::CheckCoverage::Response &res)
 	{
 		std::cout << "req.input_map.encoding:" << req.input_map.encoding << std::endl;
 		std::cout << "CoverageMonitor::getCoverageImageCallback." << std::endl;
 
-		// insert path to request message
+		boost::mutex::scoped_lock coverage_lock(coverage_mutex_);
+		if (coverage_images_available_ == false || isSameCoverageSetup(req) == false)
 		{
-			boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
-			req.path.resize(robot_trajectory_vector_.size());
-			for (size_t i=0; i<robot_trajectory_vector_.size(); ++i)
+			std::cout << "CoverageMonitor::getCoverageImageCallback: new map or coverage settings, computing the coverage of the stored trajectory." << std::endl;
+			setCoverageSetup(req);
+			std::vector<tf::StampedTransform> robot_trajectory;
 			{
-				req.path[i].x = robot_trajectory_vector_[i].getOrigin().getX();
-				req.path[i].y = robot_trajectory_vector_[i].getOrigin().getY();
-				req.path[i].theta = tf::getYaw(robot_trajectory_vector_[i].getRotation());
+				boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
+				robot_trajectory = robot_trajectory_.poses;
 			}
+			updateCoverageImages(robot_trajectory);
+			coverage_images_available_ = true;
 		}
 
-		// call coverage check server
-		CoverageCheckServer coverage_checker;
-		coverage_checker.checkCoverage(req, res);
-
-		std::cout << "res.coverage_map.encoding=" << res.coverage_map.encoding << std::endl;
 		// simplify returned coverage_map (remove room pixels [255] and remap the covered pixels from 127 to 255)
-		cv_bridge::CvImagePtr cv_ptr_obj;
-		cv_ptr_obj = cv_bridge::toCvCopy(res.coverage_map, res.coverage_map.encoding);	//sensor_msgs::image_encodings::MONO8);
-		cv::Mat coverage_map = cv_ptr_obj->image;
-
+		cv::Mat coverage_map(coverage_map_.rows, coverage_map_.cols, CV_8UC1);
 		for (int v=0; v<coverage_map.rows; ++v)
-		{
 			for (int u=0; u<coverage_map.cols; ++u)
-			{
-				if (coverage_map.at<uchar>(v,u) == 255)
-					coverage_map.at<uchar>(v,u) = 0;
-				else if (coverage_map.at<uchar>(v,u) == 127)
-					coverage_map.at<uchar>(v,u) = 255;
-			}
-		}
+				coverage_map.at<uchar>(v,u) = (coverage_map_.at<uchar>(v,u)==127 ? 255 : 0);
+
+		const ros::Time now = ros::Time::now();
 		cv_bridge::CvImage cv_image;
-		cv_image.header.stamp = res.coverage_map.header.stamp;
-		cv_image.encoding = res.coverage_map.encoding;
+		cv_image.header.stamp = now;
+		cv_image.encoding = sensor_msgs::image_encodings::MONO8;
 		cv_image.image = coverage_map;
 		cv_image.toImageMsg(res.coverage_map);
+		if (req.check_number_of_coverages == true)
+		{
+			cv_bridge::CvImage number_image;
+			number_image.header.stamp = now;
+			number_image.encoding = sensor_msgs::image_encodings::TYPE_32SC1;
+			number_image.image = number_of_coverage_image_;
+			number_image.toImageMsg(res.number_of_coverage_image);
+		}
+
+		return true;
+	}
 
+	// returns true if the coverage images have been computed with the map and the coverage settings of req,
+	// coverage_mutex_ has to be locked
+	bool isSameCoverageSetup(const ipa_building_msgs::CheckCoverage::Request& req) const
+	{
+		const ipa_building_msgs::CheckCoverage::Request& setup = coverage_setup_;
+		if (req.input_map.width != setup.input_map.width || req.input_map.height != setup.input_map.height || req.input_map.data != setup.input_map.data
+				|| req.map_resolution != setup.map_resolution || req.map_origin.position.x != setup.map_origin.position.x
+				|| req.map_origin.position.y != setup.map_origin.position.y || req.coverage_radius != setup.coverage_radius
+				|| req.check_for_footprint != setup.check_for_footprint || req.check_exact_visibility != setup.check_exact_visibility
+				|| req.field_of_view_origin.x != setup.field_of_view_origin.x || req.field_of_view_origin.y != setup.field_of_view_origin.y
+				|| req.field_of_view.size() != setup.field_of_view.size())
+			return false;
+		for (size_t i=0; i<req.field_of_view.size(); ++i)
+			if (req.field_of_view[i].x != setup.field_of_view[i].x || req.field_of_view[i].y != setup.field_of_view[i].y)
+				return false;
 		return true;
 	}
 
+	// stores the map and the coverage settings of req and resets the coverage images to the empty map,
+	// coverage_mutex_ has to be locked
+	void setCoverageSetup(const ipa_building_msgs::CheckCoverage::Request& req)
+	{
+		coverage_setup_ = req;
+		coverage_setup_.path.clear();
+
+		cv_bridge::CvImagePtr cv_ptr_obj = cv_bridge::toCvCopy(req.input_map, sensor_msgs::image_encodings::MONO8);
+		coverage_map_ = cv_ptr_obj->image.clone();
+		number_of_coverage_image_ = cv::Mat::zeros(coverage_map_.rows, coverage_map_.cols, CV_32SC1);
+
+		field_of_view_.clear();
+		for (size_t i=0; i<req.field_of_view.size(); ++i)
+		{
+			Eigen::Matrix<float, 2, 1> current_vector;
+			current_vector << req.field_of_view[i].x, req.field_of_view[i].y;
+			field_of_view_.push_back(current_vector);
+		}
+		field_of_view_origin_ << req.field_of_view_origin.x, req.field_of_view_origin.y;
+
+		// the obstacle contours for the exact visibility check are extracted only once for the map
+		obstacle_segments_ = CoverageCheckServer::ObstacleSegments();
+		if (req.check_for_footprint == false && req.check_exact_visibility == true)
+			CoverageCheckServer::extractObstacleSegments(coverage_map_, obstacle_segments_);
+	}
+
+	// adds the coverage of the given robot poses to the coverage images, coverage_mutex_ has to be locked
+	void updateCoverageImages(const std::vector<tf::StampedTransform>& robot_poses)
+	{
+		std::vector<cv::Point3d> path(robot_poses.size());
+		for (size_t i=0; i<robot_poses.size(); ++i)
+			path[i] = cv::Point3d(robot_poses[i].getOrigin().getX(), robot_poses[i].getOrigin().getY(), tf::getYaw(robot_poses[i].getRotation()));
+		coverage_checker_.updateCoverage(coverage_setup_.map_resolution, cv::Point2d(coverage_setup_.map_origin.position.x, coverage_setup_.map_origin.position.y),
+				path, field_of_view_, field_of_view_origin_, coverage_setup_.coverage_radius, coverage_setup_.check_for_footprint, coverage_map_,
+				number_of_coverage_image_, coverage_setup_.check_exact_visibility, &obstacle_segments_);
+	}
+
 protected:
 	ros::NodeHandle node_handle_;
 
@@ -442,12 +574,22 @@ protected:
 
 	bool robot_trajectory_recording_active_;		// the robot trajectory is only recorded if this is true (can be set from outside)
 
-	boost::mutex robot_trajectory_vector_mutex_;				// secures read and write operations on robot_trajectory_vector_
-	std::vector<tf::StampedTransform> robot_trajectory_vector_;				// vector of actual robot trajectory
-	std::vector<tf::StampedTransform> robot_computed_trajectory_vector_;	// vector of computed target robot trajectory
-	boost::mutex robot_computed_trajectory_vector_mutex_;		// secures read and write operations on robot_computed_trajectory_vector_
-	std::vector<tf::StampedTransform> robot_commanded_trajectory_vector_;	// vector of commanded target robot trajectory
-	boost::mutex robot_commanded_trajectory_vector_mutex_;		// secures read and write operations on robot_commanded_trajectory_vector_
+	boost::mutex robot_trajectory_vector_mutex_;				// secures read and write operations on robot_trajectory_
+	DecimatedTrajectory robot_trajectory_;						// actual robot trajectory
+	DecimatedTrajectory robot_computed_trajectory_;				// computed target robot trajectory
+	boost::mutex robot_computed_trajectory_vector_mutex_;		// secures read and write operations on robot_computed_trajectory_
+	DecimatedTrajectory robot_commanded_trajectory_;			// commanded target robot trajectory
+	boost::mutex robot_commanded_trajectory_vector_mutex_;		// secures read and write operations on robot_commanded_trajectory_
+
+	boost::mutex coverage_mutex_;					// secures read and write operations on the coverage images and their setup, locked before the trajectory mutexes
+	bool coverage_images_available_;				// the coverage images have been computed for coverage_setup_ and are updated with each new robot pose
+	ipa_building_msgs::CheckCoverage::Request coverage_setup_;	// map and coverage settings of the last coverage request (without path)
+	std::vector<Eigen::Matrix<float, 2, 1> > field_of_view_;	// field of view of coverage_setup_
+	Eigen::Matrix<float, 2, 1> field_of_view_origin_;			// field of view origin of coverage_setup_
+	cv::Mat coverage_map_;							// map of coverage_setup_ with the covered cells of the robot trajectory drawn in as 127
+	cv::Mat number_of_coverage_image_;				// number of coverages of each cell by the robot trajectory (CV_32SC1)
+	CoverageCheckServer::ObstacleSegments obstacle_segments_;	// obstacle contours of the map of coverage_setup_ for the exact visibility check
+	CoverageCheckServer coverage_checker_;
 };
 
 
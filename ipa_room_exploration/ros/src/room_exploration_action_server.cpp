@@ -144,6 +144,23 @@ RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string nam
 		std::cout << "room_exploration/max_deviation_from_track_ = " << max_deviation_from_track_ << std::endl;
 		node_handle_.param("cell_visiting_order", cell_visiting_order_, 1);
 		std::cout << "room_exploration/cell_visiting_order = " << cell_visiting_order_ << std::endl;
+		std::vector<double> rotation_offsets_deg;
+		if (node_handle_.getParam("rotation_offsets", rotation_offsets_deg) == false || rotation_offsets_deg.size() == 0)
+			rotation_offsets_deg.assign(1, 0.);
+		rotation_offsets_.resize(rotation_offsets_deg.size());
+		std::cout << "room_exploration/rotation_offsets = ";
+		for (size_t i=0; i<rotation_offsets_deg.size(); ++i)
+		{
+			rotation_offsets_[i] = rotation_offsets_deg[i]*CV_PI/180.;
+			std::cout << rotation_offsets_deg[i] << " ";
+		}
+		std::cout << std::endl;
+		node_handle_.param("decomposition_score", decomposition_score_, 1);
+		std::cout << "room_exploration/decomposition_score = " << decomposition_score_ << std::endl;
+		node_handle_.param("search_strategy", search_strategy_, 0);
+		std::cout << "room_exploration/search_strategy = " << search_strategy_ << std::endl;
+		node_handle_.param("smooth_transition_paths", smooth_transition_paths_, false);
+		std::cout << "room_exploration/smooth_transition_paths = " << smooth_transition_paths_ << std::endl;
 	}
 	else if (room_exploration_algorithm_ == 3) // set neural network explorator parameters
 	{
@@ -168,6 +185,12 @@ RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string nam
 		std::cout << "room_exploration/cell_size_ = " << cell_size_ << std::endl;
 		node_handle_.param("delta_theta", delta_theta_, 1.570796);
 		std::cout << "room_exploration/delta_theta = " << delta_theta_ << std::endl;
+		node_handle_.param("use_lp_rounding_start", use_lp_rounding_start_, false);
+		std::cout << "room_exploration/use_lp_rounding_start = " << use_lp_rounding_start_ << std::endl;
+		node_handle_.param("mip_time_limit", mip_time_limit_, 0.0);
+		std::cout << "room_exploration/mip_time_limit = " << mip_time_limit_ << std::endl;
+		node_handle_.param("mip_relative_gap", mip_relative_gap_, 0.0);
+		std::cout << "room_exploration/mip_relative_gap = " << mip_relative_gap_ << std::endl;
 	}
 	else if (room_exploration_algorithm_ == 5) // set flowNetwork explorator parameters
 	{
@@ -260,6 +283,12 @@ void RoomExplorationServer::dynamic_reconfigure_callback(ipa_room_exploration::R
 		std::cout << "room_exploration/max_deviation_from_track_ = " << max_deviation_from_track_ << std::endl;
 		cell_visiting_order_ = config.cell_visiting_order;
 		std::cout << "room_exploration/cell_visiting_order = " << cell_visiting_order_ << std::endl;
+		decomposition_score_ = config.decomposition_score;
+		std::cout << "room_exploration/decomposition_score = " << decomposition_score_ << std::endl;
+		search_strategy_ = config.search_strategy;
+		std::cout << "room_exploration/search_strategy = " << search_strategy_ << std::endl;
+		smooth_transition_paths_ = config.smooth_transition_paths;
+		std::cout << "room_exploration/smooth_transition_paths = " << smooth_transition_paths_ << std::endl;
 	}
 	else if (room_exploration_algorithm_ == 3) // set neural network explorator parameters
 	{
@@ -284,6 +313,12 @@ void RoomExplorationServer::dynamic_reconfigure_callback(ipa_room_exploration::R
 		std::cout << "room_exploration/cell_size_ = " << cell_size_ << std::endl;
 		delta_theta_ = config.delta_theta;
 		std::cout << "room_exploration/delta_theta_ = " << delta_theta_ << std::endl;
+		use_lp_rounding_start_ = config.use_lp_rounding_start;
+		std::cout << "room_exploration/use_lp_rounding_start_ = " << use_lp_rounding_start_ << std::endl;
+		mip_time_limit_ = config.mip_time_limit;
+		std::cout << "room_exploration/mip_time_limit_ = " << mip_time_limit_ << std::endl;
+		mip_relative_gap_ = config.mip_relative_gap;
+		std::cout << "room_exploration/mip_relative_gap_ = " << mip_relative_gap_ << std::endl;
 	}
 	else if (room_exploration_algorithm_ == 5) // set flowNetwork explorator parameters
 	{
@@ -409,11 +444,12 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	}
 	else if (room_exploration_algorithm_ == 2) // use boustrophedon explorator
 	{
+		boustrophedon_explorer_.setPathPlanningParameters(search_strategy_, smooth_transition_paths_);
 		// plan path
 		if(planning_mode_ == PLAN_FOR_FOV)
-			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
+			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_, rotation_offsets_, decomposition_score_);
 		else
-			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
+			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_, rotation_offsets_, decomposition_score_);
 	}
 	else if (room_exploration_algorithm_ == 3) // use neural network explorator
 	{
@@ -426,6 +462,7 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	}
 	else if (room_exploration_algorithm_ == 4) // use convexSPP explorator
 	{
+		convex_SPP_explorator_.setSolverParameters(use_lp_rounding_start_, mip_time_limit_, mip_relative_gap_);
 		// plan coverage path
 		if(planning_mode_ == PLAN_FOR_FOV)
 			convex_SPP_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size_, delta_theta_, fov_corners_meter, fitting_circle_center_point_in_meter, 0., 7, false);
@@ -500,8 +537,7 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 			//mapPath(room_map, exploration_path, fov_path, fitting_circle_center_point_in_meter, map_resolution, map_origin, start_pos);
 			ROS_INFO("Starting to map from field of view pose to robot pose");
 			cv::Point robot_starting_position = (fov_path.size()>0 ? cv::Point(fov_path[0].x, fov_path[0].y) : starting_position);
-			cv::Mat inflated_room_map;
-			cv::erode(room_map, inflated_room_map, cv::Mat(), cv::Point(-1, -1), (int)std::floor(goal->robot_radius/map_resolution));
+			const cv::Mat inflated_room_map = MapPreprocessingCache::getInstance().getErodedMap(room_map, (int)std::floor(goal->robot_radius/map_resolution));
 			mapPath(inflated_room_map, exploration_path, fov_path, fitting_circle_center_point_in_meter, map_resolution, map_origin, robot_starting_position);
 		}
 		else
@@ -536,11 +572,12 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	}
 	else if (room_exploration_algorithm_ == 8) // use boustrophedon variant explorator
 	{
+		boustrophedon_variant_explorer_.setPathPlanningParameters(search_strategy_, smooth_transition_paths_);
 		// plan path
 		if(planning_mode_ == PLAN_FOR_FOV)
-			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
+			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_, rotation_offsets_, decomposition_score_);
 		else
-			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
+			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_, rotation_offsets_, decomposition_score_);
 	}
 
 	// display finally planned path
@@ -68,6 +68,7 @@
 #include <iostream>
 #include <fstream>
 #include <numeric>
+#include <limits>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -714,9 +715,12 @@ public:
 		std::vector<double> room_areas;		// in [m^2], the area of each room
 		std::vector<double> area_covered_percentages;	// in [0,1], the ratio of coverage for each room
 		std::vector<double> numbers_of_coverages;		// counts how often a map cell has been covered
+		std::vector<double> area_covered_percentages_exact;	// in [0,1], the ratio of coverage for each room with exact visibility (field of view only)
+		std::vector<double> coverage_differences_exact;		// in [0,1], ratio of room cells that are covered with only one of both visibility checks (field of view only)
 		cv::Mat map_coverage;
 		cv::Mat map_path_coverage;
-		statisticsCoverageArea(data, map, path_map, map_coverage, map_path_coverage, paths, interpolated_paths, room_areas, area_covered_percentages, numbers_of_coverages);
+		statisticsCoverageArea(data, map, path_map, map_coverage, map_path_coverage, paths, interpolated_paths, room_areas, area_covered_percentages, numbers_of_coverages,
+				area_covered_percentages_exact, coverage_differences_exact);
 		// save the map with the drawn in coverage areas
 		const std::string coverage_image_path = data_storage_path + configuration_folder_name + data.map_name_ + "_coverage_eval.png";
 		cv::imwrite(coverage_image_path.c_str(), map_coverage);
@@ -729,6 +733,21 @@ public:
 		const double coverage_percentage_stddev = stddev(area_covered_percentages, coverage_percentage_mean);
 		const double coverage_number_mean = std::accumulate(numbers_of_coverages.begin(), numbers_of_coverages.end(), 0.0) / std::max(1.0, (double)numbers_of_coverages.size());
 		const double coverage_number_stddev = stddev(numbers_of_coverages, coverage_number_mean);
+		// save the comparison of the coverage check by ray casting with the exact visibility check for each room
+		if (area_covered_percentages_exact.size() > 0)
+		{
+			std::stringstream accuracy_output;
+			accuracy_output << "covered area [0,1]\t" << "covered area with exact visibility [0,1]\t" << "differently covered area [0,1]" << std::endl;
+			for (size_t i=0; i<area_covered_percentages_exact.size(); ++i)
+				accuracy_output << area_covered_percentages[i] << "\t" << area_covered_percentages_exact[i] << "\t" << coverage_differences_exact[i] << std::endl;
+			const std::string accuracy_filename = data_storage_path + configuration_folder_name + data.map_name_ + "_coverage_accuracy_eval.txt";
+			std::ofstream accuracy_file(accuracy_filename.c_str(), std::ofstream::out);
+			if (accuracy_file.is_open())
+				accuracy_file << accuracy_output.str();
+			else
+				ROS_ERROR("Could not write to file '%s'.", accuracy_filename.c_str());
+			accuracy_file.close();
+		}
 		std::cout << "Checked coverage for all rooms." << std::endl;
 
 
@@ -1172,7 +1191,8 @@ public:
 
 	void statisticsCoverageArea(const ExplorationData& data, const cv::Mat& map, const cv::Mat& path_map, cv::Mat& map_coverage, cv::Mat& map_path_coverage,
 			const std::vector<std::vector<geometry_msgs::Pose2D> >& paths, const std::vector<std::vector<geometry_msgs::Pose2D> >& interpolated_paths,
-			std::vector<double>& room_areas, std::vector<double>& area_covered_percentages, std::vector<double>& numbers_of_coverages)
+			std::vector<double>& room_areas, std::vector<double>& area_covered_percentages, std::vector<double>& numbers_of_coverages,
+			std::vector<double>& area_covered_percentages_exact, std::vector<double>& coverage_differences_exact)
 	{
 		map_coverage = map.clone();
 		for(size_t room=0; room<paths.size(); ++room)
@@ -1267,6 +1287,35 @@ public:
 			const double room_area = data.map_resolution_ * data.map_resolution_ * (double) white_room_pixels;
 			room_areas.push_back(room_area);
 
+			// compare the coverage check with the exact visibility check of the field of view
+			if (data.planning_mode_ == FIELD_OF_VIEW)
+			{
+				cv::Mat coverage_map_exact, number_of_coverage_image_exact;
+				if (coverage_checker.checkCoverage(data.room_maps_[room], data.map_resolution_, cv::Point2d(data.map_origin_.position.x, data.map_origin_.position.y),
+						path, field_of_view, fov_origin, data.coverage_radius_, false, false, coverage_map_exact, number_of_coverage_image_exact, true) == true)
+				{
+					int covered_pixels_exact = 0, differently_covered_pixels = 0;
+					for (int v=0; v<coverage_map_exact.rows; ++v)
+					{
+						for (int u=0; u<coverage_map_exact.cols; ++u)
+						{
+							if (coverage_map_exact.at<uchar>(v,u)==127)
+								++covered_pixels_exact;
+							if ((coverage_map_exact.at<uchar>(v,u)==127) != (coverage_map.at<uchar>(v,u)==127))
+								++differently_covered_pixels;
+						}
+					}
+					area_covered_percentages_exact.push_back((double)covered_pixels_exact/(double)std::max(1, white_room_pixels));
+					coverage_differences_exact.push_back((double)differently_covered_pixels/(double)std::max(1, white_room_pixels));
+				}
+				else
+				{
+					// keep one entry per room, so that the entries stay aligned with area_covered_percentages
+					area_covered_percentages_exact.push_back(std::numeric_limits<double>::quiet_NaN());
+					coverage_differences_exact.push_back(std::numeric_limits<double>::quiet_NaN());
+				}
+			}
+
 			// get the covered area of the room
 			cv::threshold(coverage_map, coverage_map, 150, 255, cv::THRESH_BINARY); // covered area drawn in as 127 --> find still white pixels
 			const int not_covered_pixels = cv::countNonZero(coverage_map);
@@ -60,6 +60,14 @@ protected:
 	//	3. It returns the map that has the generalized voronoi-graph drawn in.
 	void createVoronoiGraph(cv::Mat& map_for_voronoi_generation);
 
+	// Function to get the voronoi-diagram of the given map from the map preprocessing cache.
+	// The generalized voronoi-graph of a map is computed only once per process with createVoronoiGraph and shared by all
+	// algorithms that use it. voronoi_map receives a copy that can be modified.
+	void getVoronoiGraph(const cv::Mat& map, cv::Mat& voronoi_map);
+
+	// helper for getVoronoiGraph that computes the artifact for the cache
+	void computeVoronoiGraph(const cv::Mat& map, cv::Mat& voronoi_map);
+
 	// This function prunes the generalized Voronoi-graph in the given map.
 	// It reduces the graph down to the nodes in the graph. A node is a point on the Voronoi graph, that has at least 3
 	// neighbors. This deletes errors from the approximate generation of the graph that hasn't been eliminated from
@@ -6,6 +6,9 @@
 #include <ipa_room_segmentation/timer.h>
 #include <set>
 
+#include <boost/bind.hpp>
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
 
 
 AbstractVoronoiSegmentation::AbstractVoronoiSegmentation()
@@ -97,6 +100,20 @@ void AbstractVoronoiSegmentation::drawVoronoi(cv::Mat &img, const std::vector<st
 	}
 }
 
+// This function returns the generalized voronoi-graph of the given map. The graph only depends on the map, so it is taken
+// from the map preprocessing cache if it has already been computed for this map in this process.
+void AbstractVoronoiSegmentation::getVoronoiGraph(const cv::Mat& map, cv::Mat& voronoi_map)
+{
+	voronoi_map = MapPreprocessingCache::getInstance().getArtifact(map, "voronoi_graph",
+			boost::bind(&AbstractVoronoiSegmentation::computeVoronoiGraph, this, _1, _2)).clone();
+}
+
+void AbstractVoronoiSegmentation::computeVoronoiGraph(const cv::Mat& map, cv::Mat& voronoi_map)
+{
+	voronoi_map = map.clone();
+	createVoronoiGraph(voronoi_map);
+}
+
 //****************Create the Generalized Voronoi-Diagram**********************
 // This function is here to create the generalized voronoi-graph in the given map. It does following steps:
 //	1. It finds every discretized contour in the given map (they are saved as vector<Point>). Then it takes these
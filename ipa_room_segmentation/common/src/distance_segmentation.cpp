@@ -3,6 +3,8 @@
 #include <ipa_room_segmentation/wavefront_region_growing.h>
 #include <ipa_room_segmentation/contains.h>
 
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
 DistanceSegmentation::DistanceSegmentation()
 {
 
@@ -13,8 +15,6 @@ void DistanceSegmentation::segmentMap(const cv::Mat& map_to_be_labeled, cv::Mat&
 	//variables for energy maximization
 	double optimal_room_area = 50; //variable that sets the desired optimal room area
 	double constant_additional_value = optimal_room_area * optimal_room_area; //variable that sets the energy function higher so that it is 0 for the lower limit
-	//variables for distance transformation
-	cv::Mat temporary_map = map_to_be_labeled.clone();
 	//variables for thresholding and finding the room-areas
 	cv::Mat thresh_map;
 	std::vector < std::vector<cv::Point> > contours;
@@ -28,10 +28,9 @@ void DistanceSegmentation::segmentMap(const cv::Mat& map_to_be_labeled, cv::Mat&
 	//
 
 	//1. Get the distance-transformed map and make it an 8-bit single-channel image
-	cv::erode(temporary_map, temporary_map, cv::Mat());
-	cv::Mat distance_map;	//variable for the distance-transformed map, type: CV_32FC1
-	cv::distanceTransform(temporary_map, distance_map, CV_DIST_L2, 5);
-	cv::convertScaleAbs(distance_map, distance_map);	// conversion to 8 bit image
+	//	(the distance transform of the map is shared with the other algorithms through the map preprocessing cache)
+	cv::Mat distance_map;	//variable for the distance-transformed map, converted to 8 bit
+	cv::convertScaleAbs(MapPreprocessingCache::getInstance().getDistanceTransform(map_to_be_labeled, 1), distance_map);	// conversion to 8 bit image
 
 	//2. Threshold the map and find the contours of the rooms. Change the threshold and repeat steps until last possible threshold.
 	//Then take the contours from the threshold with the most contours between the roomfactors and draw it in the map with a random color.
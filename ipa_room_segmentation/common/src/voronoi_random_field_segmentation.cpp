@@ -63,6 +63,8 @@
 
 #include <ipa_room_segmentation/timer.h>
 
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
 // This function is the optimization function L(w) = -1 * sum(i)(log(p(y_i|MB(y_i, w), x)) + ((w - w_r)^T (w - w_r)) / 2 * sigma^2)
 // to find the optimal weights for the given prelabeled map. to find these the function has to be minimized.
 // i indicates the labeled example
@@ -965,8 +967,7 @@ void VoronoiRandomFieldSegmentation::trainAlgorithms(const std::vector<cv::Mat>&
 		// read in a fully labeled map (not only points) and generate current_nodes accordingly
 		// find the conditional random field nodes for the current map
 		cv::Mat distance_map; //distance-map of the original-map (used to check the distance of each point to nearest black pixel)
-		cv::distanceTransform(original_maps[current_map_index], distance_map, CV_DIST_L2, 5);
-		cv::convertScaleAbs(distance_map, distance_map);
+		cv::convertScaleAbs(MapPreprocessingCache::getInstance().getDistanceTransform(original_maps[current_map_index]), distance_map);
 
 		// find all nodes for the conditional random field
 		findConditonalNodes(current_nodes, voronoi_maps[current_map_index], distance_map, current_voronoi_nodes, epsilon_for_neighborhood, max_iterations, min_neighborhood_size, min_node_distance);
@@ -1009,7 +1010,7 @@ void VoronoiRandomFieldSegmentation::trainAlgorithms(const std::vector<cv::Mat>&
 void VoronoiRandomFieldSegmentation::createPrunedVoronoiGraph(cv::Mat& map_for_voronoi_generation, std::set<cv::Point, cv_Point_comp>& node_points)
 {
 	//********************1. Create the Voronoi graph******************************
-	createVoronoiGraph(map_for_voronoi_generation);
+	getVoronoiGraph(map_for_voronoi_generation, map_for_voronoi_generation);
 
 	//********************2. Reduce the graph until its nodes******************************
 	pruneVoronoiGraph(map_for_voronoi_generation, node_points);
@@ -1307,8 +1308,7 @@ void VoronoiRandomFieldSegmentation::segmentMap(const cv::Mat& original_map, cv:
 
 	// get the distance transformed map, which shows the distance of every white pixel to the closest zero-pixel
 	cv::Mat distance_map; //distance-map of the original-map (used to check the distance of each point to nearest black pixel)
-	cv::distanceTransform(original_map, distance_map, CV_DIST_L2, 5);
-	cv::convertScaleAbs(distance_map, distance_map);
+	cv::convertScaleAbs(MapPreprocessingCache::getInstance().getDistanceTransform(original_map), distance_map);
 
 	// find all nodes for the conditional random field
 	timer.start();
@@ -1537,9 +1537,8 @@ void VoronoiRandomFieldSegmentation::segmentMap(const cv::Mat& original_map, cv:
 	//	  applied.
 
 	// erode the map to close small gaps and remove errors --> also done when producing the voronoi-graph.
-	cv::Mat map_copy, eroded_map;
-	cv::Point anchor(-1, -1);
-	cv::erode(original_image, eroded_map, cv::Mat(), anchor, 2);
+	cv::Mat map_copy;
+	const cv::Mat eroded_map = MapPreprocessingCache::getInstance().getErodedMap(original_image, 2);
 	map_copy = eroded_map.clone();
 
 	// find the layout of the map and discretize it to get possible base points
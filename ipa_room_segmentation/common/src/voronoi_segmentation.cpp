@@ -6,6 +6,8 @@
 #include <ipa_room_segmentation/timer.h>
 #include <set>
 
+#include <ipa_building_navigation/map_preprocessing_cache.h>
+
 
 
 VoronoiSegmentation::VoronoiSegmentation()
@@ -52,8 +54,8 @@ void VoronoiSegmentation::segmentMap(const cv::Mat& map_to_be_labeled, cv::Mat&
 
 	//*********************I. Calculate and draw the Voronoi-Diagram in the given map*****************
 
-	cv::Mat voronoi_map = map_to_be_labeled.clone();
-	createVoronoiGraph(voronoi_map); //voronoi-map for the segmentation-algorithm
+	cv::Mat voronoi_map;
+	getVoronoiGraph(map_to_be_labeled, voronoi_map); //voronoi-map for the segmentation-algorithm
 
 	//***************************II. extract the possible candidates for critical Points****************************
 	// 1.extract the node-points that have at least three neighbors on the voronoi diagram
@@ -70,8 +72,7 @@ void VoronoiSegmentation::segmentMap(const cv::Mat& map_to_be_labeled, cv::Mat&
 
 	//get the distance transformed map, which shows the distance of every white pixel to the closest zero-pixel
 	cv::Mat distance_map; //distance-map of the original-map (used to check the distance of each point to nearest black pixel)
-	cv::distanceTransform(map_to_be_labeled, distance_map, CV_DIST_L2, 5);
-	cv::convertScaleAbs(distance_map, distance_map);
+	cv::convertScaleAbs(MapPreprocessingCache::getInstance().getDistanceTransform(map_to_be_labeled), distance_map);
 
 	std::vector<cv::Point> critical_points; //saving-variable for the critical points found on the Voronoi-graph
 	for (int v = 0; v < voronoi_map.rows; v++)